@@ -35,7 +35,9 @@ namespace elle
       cbc,
       ecb,
       cfb,
-      ofb
+      ofb,
+      /// Galois/counter mode: authenticated encryption, AES only.
+      gcm
     };
 
     /*----------.
@@ -3,6 +3,7 @@
 #include <elle/cryptography/Cipher.hh>
 #include <elle/cryptography/cryptography.hh>
 #include <elle/cryptography/raw.hh>
+#include <elle/cryptography/Error.hh>
 
 #include <elle/serialization/Serializer.hh>
 #include <elle/log.hh>
@@ -51,20 +52,48 @@ namespace elle
     | Methods |
     `--------*/
 
+    namespace
+    {
+      elle::Buffer
+      _read(std::istream& stream)
+      {
+        auto res = elle::Buffer();
+        {
+          auto out = elle::IOStream(res.ostreambuf());
+          out << stream.rdbuf();
+        }
+        if (stream.bad())
+          throw Error(
+            elle::sprintf("unable to read the input stream: %s",
+                          stream.rdstate()));
+        return res;
+      }
+
+      /// The mode legacy codes are deciphered with when asked for an
+      /// authenticated one.
+      Mode
+      _legacy(Mode const mode)
+      {
+        return mode == Mode::gcm ? SecretKey::defaults::mode : mode;
+      }
+    }
+
     elle::Buffer
     SecretKey::encipher(elle::ConstWeakBuffer const& plain,
                         Cipher const cipher,
                         Mode const mode,
                         Oneway const oneway) const
     {
-      auto in = elle::IOStream(plain.istreambuf());
-      auto res = elle::Buffer();
-      res.capacity(plain.size() + 1024);
-      {
-        auto out = elle::IOStream(res.ostreambuf());
-        this->encipher(in, out, cipher, mode, oneway);
-      }
-      return res;
+      if (mode == Mode::gcm)
+        return raw::aead::encipher(this->_password,
+                                   cipher::resolve(cipher, mode),
+                                   oneway::resolve(oneway),
+                                   plain);
+      else
+        return raw::symmetric::encipher(this->_password,
+                                        cipher::resolve(cipher, mode),
+                                        oneway::resolve(oneway),
+                                        plain);
     }
 
     elle::Buffer
@@ -73,14 +102,49 @@ namespace elle
                         Mode const mode,
                         Oneway const oneway) const
     {
-      auto in = elle::IOStream(code.istreambuf());
-      auto res = elle::Buffer();
-      res.capacity(code.size());
-      {
-        auto out = elle::IOStream(res.ostreambuf());
-        this->decipher(in, out, cipher, mode, oneway);
-      }
-      return res;
+      // Authenticated codes are recognized by their magic, whatever the
+      // requested mode, so that peers may switch modes independently.
+      if (raw::aead::authenticated(code))
+        return raw::aead::decipher(this->_password,
+                                   cipher::resolve(cipher, Mode::gcm),
+                                   oneway::resolve(oneway),
+                                   code);
+      else
+        return raw::symmetric::decipher(this->_password,
+                                        cipher::resolve(cipher, _legacy(mode)),
+                                        oneway::resolve(oneway),
+                                        code);
+    }
+
+    void
+    SecretKey::encipher_in_place(elle::Buffer& data,
+                                 Cipher const cipher,
+                                 Mode const mode,
+                                 Oneway const oneway) const
+    {
+      if (mode == Mode::gcm)
+        data = this->encipher(data, cipher, mode, oneway);
+      else
+        raw::symmetric::encipher_in_place(this->_password,
+                                          cipher::resolve(cipher, mode),
+                                          oneway::resolve(oneway),
+                                          data);
+    }
+
+    void
+    SecretKey::decipher_in_place(elle::Buffer& data,
+                                 Cipher const cipher,
+                                 Mode const mode,
+                                 Oneway const oneway) const
+    {
+      if (raw::aead::authenticated(data))
+        data = this->decipher(data, cipher, mode, oneway);
+      else
+        raw::symmetric::decipher_in_place(
+          this->_password,
+          cipher::resolve(cipher, _legacy(mode)),
+          oneway::resolve(oneway),
+          data);
     }
 
     void
@@ -90,6 +154,20 @@ namespace elle
                         Mode const mode,
                         Oneway const oneway) const
     {
+      // The tag covers the whole code: buffer it.
+      if (mode == Mode::gcm)
+      {
+        auto const input = _read(plain);
+        auto const code_ = this->encipher(input, cipher, mode, oneway);
+        code.write(reinterpret_cast<char const*>(code_.contents()),
+                   code_.size());
+        if (!code.good())
+          throw Error(
+            elle::sprintf("unable to write the encrypted data to the "
+                          "code's output stream: %s",
+                          code.rdstate()));
+        return;
+      }
       raw::symmetric::encipher(this->_password,
                                cipher::resolve(cipher, mode),
                                oneway::resolve(oneway),
@@ -104,6 +182,19 @@ namespace elle
                         Mode const mode,
                         Oneway const oneway) const
     {
+      if (mode == Mode::gcm)
+      {
+        auto const input = _read(code);
+        auto const plain_ = this->decipher(input, cipher, mode, oneway);
+        plain.write(reinterpret_cast<char const*>(plain_.contents()),
+                    plain_.size());
+        if (!plain.good())
+          throw Error(
+            elle::sprintf("unable to write the decrypted data to the "
+                          "plain's output stream: %s",
+                          plain.rdstate()));
+        return;
+      }
       raw::symmetric::decipher(this->_password,
                                cipher::resolve(cipher, mode),
                                oneway::resolve(oneway),
@@ -181,6 +272,32 @@ namespace elle
       {
         return random::generate<elle::Buffer>(length / 8);
       }
+
+      bool
+      authenticated(elle::ConstWeakBuffer const& code)
+      {
+        return raw::aead::authenticated(code);
+      }
+
+      elle::Buffer
+      seal(elle::ConstWeakBuffer const& key,
+           elle::ConstWeakBuffer const& aad,
+           elle::ConstWeakBuffer const& plain,
+           Cipher const cipher)
+      {
+        return raw::aead::seal(key, cipher::resolve(cipher, Mode::gcm),
+                               aad, plain);
+      }
+
+      elle::Buffer
+      open(elle::ConstWeakBuffer const& key,
+           elle::ConstWeakBuffer const& aad,
+           elle::ConstWeakBuffer const& code,
+           Cipher const cipher)
+      {
+        return raw::aead::open(key, cipher::resolve(cipher, Mode::gcm),
+                               aad, code);
+      }
     }
   }
 }
@@ -56,17 +56,33 @@ namespace elle
       `--------*/
     public:
       /// Encipher a given plain text and return the cipher text.
+      ///
+      /// With Mode::gcm, the cipher text is authenticated in the same pass.
       elle::Buffer
       encipher(elle::ConstWeakBuffer const& plain,
                Cipher const cipher = defaults::cipher,
                Mode const mode = defaults::mode,
                Oneway const oneway = defaults::oneway) const;
       /// Decipher a given code and return the original plain text.
+      ///
+      /// Authenticated codes are detected and checked whatever the mode.
       elle::Buffer
       decipher(elle::ConstWeakBuffer const& code,
                Cipher const cipher = defaults::cipher,
                Mode const mode = defaults::mode,
                Oneway const oneway = defaults::oneway) const;
+      /// Replace a plain text by its cipher text, reusing its storage.
+      void
+      encipher_in_place(elle::Buffer& data,
+                        Cipher const cipher = defaults::cipher,
+                        Mode const mode = defaults::mode,
+                        Oneway const oneway = defaults::oneway) const;
+      /// Replace a code by its plain text, reusing its storage.
+      void
+      decipher_in_place(elle::Buffer& data,
+                        Cipher const cipher = defaults::cipher,
+                        Mode const mode = defaults::mode,
+                        Oneway const oneway = defaults::oneway) const;
       /// Encipher an input stream and put the cipher text in the
       /// output stream.
       virtual
@@ -144,6 +160,26 @@ namespace elle
       /// A freshly generated secret key of the given length (in bits).
       SecretKey
       generate(uint32_t const length);
+      /// Whether the code was enciphered in an authenticated mode.
+      bool
+      authenticated(elle::ConstWeakBuffer const& code);
+      /// Seal `plain` with AES-GCM under `key`, used as is rather than
+      /// derived, authenticating `aad` along.
+      ///
+      /// For callers holding a proper key already, e.g. out of a KDF.
+      elle::Buffer
+      seal(elle::ConstWeakBuffer const& key,
+           elle::ConstWeakBuffer const& aad,
+           elle::ConstWeakBuffer const& plain,
+           Cipher const cipher = Cipher::aes256);
+      /// Open a code sealed with the same `key` and `aad`.
+      ///
+      /// @throws Error if the code, or `aad`, was tampered with.
+      elle::Buffer
+      open(elle::ConstWeakBuffer const& key,
+           elle::ConstWeakBuffer const& aad,
+           elle::ConstWeakBuffer const& code,
+           Cipher const cipher = Cipher::aes256);
     }
   }
 }
@@ -21,6 +21,7 @@
 #include <openssl/evp.h>
 
 
+#include <limits>
 #include <thread>
 
 #if defined(ELLE_CRYPTOGRAPHY_ROTATION)
@@ -538,6 +539,131 @@ namespace elle
         /// text so for the decryption process to know that the text
         /// has been salted.
         static char const magic[] = "Salted__";
+        /// The size of the magic and salt preceding the cipher text.
+        static int const header_size = sizeof (magic) - 1 + PKCS5_SALT_LEN;
+
+        /*--------.
+        | Helpers |
+        `--------*/
+
+        /// Generate a key/IV tuple based on the salt.
+        static
+        void
+        _derive(elle::ConstWeakBuffer const& secret,
+                ::EVP_CIPHER const* cipher,
+                ::EVP_MD const* oneway,
+                unsigned char const* salt,
+                unsigned char* key,
+                unsigned char* iv)
+        {
+          // EVP_BytesToKey() is non-deterministic with a null secret.
+          ELLE_ASSERT(secret.contents());
+          if (::EVP_BytesToKey(cipher,
+                               oneway,
+                               salt,
+                               secret.contents(),
+                               secret.size(),
+                               1,
+                               key,
+                               iv) > EVP_MAX_KEY_LENGTH)
+            throw Error("the generated key size is too large");
+        }
+
+        /// Encipher or decipher `size` bytes from `input` to `output` in a
+        /// single update/final pass, and return the number of bytes written.
+        ///
+        /// `input` and `output` may be the same, but must not otherwise
+        /// overlap. `output` must have room for `size` plus a cipher block.
+        static
+        int
+        _apply(::EVP_CIPHER const* cipher,
+               unsigned char const* key,
+               unsigned char const* iv,
+               bool encrypt,
+               unsigned char const* input,
+               elle::Buffer::Size size,
+               unsigned char* output)
+        {
+          if (size > static_cast<elle::Buffer::Size>(
+                std::numeric_limits<int>::max() - EVP_MAX_BLOCK_LENGTH))
+            throw Error(elle::sprintf("the text is too large: %s", size));
+
+          ::EVP_CIPHER_CTX context;
+
+          ::EVP_CIPHER_CTX_init(&context);
+
+          ELLE_CRYPTOGRAPHY_FINALLY_ACTION_CLEANUP_CIPHER_CONTEXT(context);
+
+          if (::EVP_CipherInit_ex(&context,
+                                  cipher,
+                                  nullptr,
+                                  key,
+                                  iv,
+                                  encrypt ? 1 : 0) <= 0)
+            throw Error(
+              elle::sprintf("unable to initialize the %s process: %s",
+                            encrypt ? "encryption" : "decryption",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          int size_update(0);
+
+          if (::EVP_CipherUpdate(&context,
+                                 output,
+                                 &size_update,
+                                 input,
+                                 static_cast<int>(size)) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the %s function: %s",
+                            encrypt ? "encryption" : "decryption",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          int size_final(0);
+
+          if (::EVP_CipherFinal_ex(&context,
+                                   output + size_update,
+                                   &size_final) <= 0)
+            throw Error(
+              elle::sprintf("unable to finalize the %s process: %s",
+                            encrypt ? "encryption" : "decryption",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          if (::EVP_CIPHER_CTX_cleanup(&context) <= 0)
+            throw Error(
+              elle::sprintf("unable to clean the cipher context: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          ELLE_CRYPTOGRAPHY_FINALLY_ABORT(context);
+
+          return size_update + size_final;
+        }
+
+        /// Write the magic and a fresh salt at `header`.
+        static
+        void
+        _header(unsigned char* header)
+        {
+          ::memcpy(header, magic, sizeof (magic) - 1);
+          if (::RAND_pseudo_bytes(header + sizeof (magic) - 1,
+                                  PKCS5_SALT_LEN) <= 0)
+            throw Error(elle::sprintf("unable to pseudo-randomly generate "
+                                      "a salt: %s",
+                                      ::ERR_error_string(ERR_get_error(),
+                                                         nullptr)));
+        }
+
+        /// Check the magic at the start of `code`.
+        static
+        void
+        _check(elle::ConstWeakBuffer const& code)
+        {
+          if (code.size() < static_cast<std::size_t>(header_size))
+            throw Error("unable to read the magic and salt from the code");
+          if (::memcmp(code.contents(),
+                       magic,
+                       sizeof (magic) - 1) != 0)
+            throw Error("the code was produced without any or an invalid "
+                        "salt");
+        }
 
         /*----------.
         | Functions |
@@ -826,6 +952,446 @@ namespace elle
 
           ELLE_CRYPTOGRAPHY_FINALLY_ABORT(context);
         }
+
+        elle::Buffer
+        encipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& plain)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          auto res = elle::Buffer(
+            header_size + plain.size() + ::EVP_CIPHER_block_size(cipher));
+          auto const output = res.mutable_contents();
+          _header(output);
+          unsigned char key[EVP_MAX_KEY_LENGTH];
+          unsigned char iv[EVP_MAX_IV_LENGTH];
+          _derive(secret, cipher, oneway,
+                  output + sizeof (magic) - 1, key, iv);
+          res.size(header_size +
+                   _apply(cipher, key, iv, true,
+                          plain.contents(), plain.size(),
+                          output + header_size));
+          return res;
+        }
+
+        elle::Buffer
+        decipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& code)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          _check(code);
+          unsigned char key[EVP_MAX_KEY_LENGTH];
+          unsigned char iv[EVP_MAX_IV_LENGTH];
+          _derive(secret, cipher, oneway,
+                  code.contents() + sizeof (magic) - 1, key, iv);
+          auto const size = code.size() - header_size;
+          auto res = elle::Buffer(size + ::EVP_CIPHER_block_size(cipher));
+          res.size(_apply(cipher, key, iv, false,
+                          code.contents() + header_size, size,
+                          res.mutable_contents()));
+          return res;
+        }
+
+        void
+        encipher_in_place(elle::ConstWeakBuffer const& secret,
+                          ::EVP_CIPHER const* cipher,
+                          ::EVP_MD const* oneway,
+                          elle::Buffer& data)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          // Make room for the header and the padding, and encipher the text
+          // where it lands.
+          auto const size = data.size();
+          data.size(header_size + size + ::EVP_CIPHER_block_size(cipher));
+          auto const output = data.mutable_contents();
+          ::memmove(output + header_size, output, size);
+          _header(output);
+          unsigned char key[EVP_MAX_KEY_LENGTH];
+          unsigned char iv[EVP_MAX_IV_LENGTH];
+          _derive(secret, cipher, oneway,
+                  output + sizeof (magic) - 1, key, iv);
+          data.size(header_size +
+                    _apply(cipher, key, iv, true,
+                           output + header_size, size,
+                           output + header_size));
+        }
+
+        void
+        decipher_in_place(elle::ConstWeakBuffer const& secret,
+                          ::EVP_CIPHER const* cipher,
+                          ::EVP_MD const* oneway,
+                          elle::Buffer& data)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          _check(data);
+          unsigned char key[EVP_MAX_KEY_LENGTH];
+          unsigned char iv[EVP_MAX_IV_LENGTH];
+          _derive(secret, cipher, oneway,
+                  data.contents() + sizeof (magic) - 1, key, iv);
+          // The plain text is never larger than the code, decipher it over
+          // the code then drop the header.
+          auto const text = data.mutable_contents() + header_size;
+          auto const size = _apply(cipher, key, iv, false,
+                                   text, data.size() - header_size, text);
+          data.size(header_size + size);
+          data.pop_front(header_size);
+        }
+      }
+    }
+  }
+}
+
+//
+// ---------- AEAD ------------------------------------------------------------
+//
+
+namespace elle
+{
+  namespace cryptography
+  {
+    namespace raw
+    {
+      namespace aead
+      {
+        /*----------.
+        | Constants |
+        `----------*/
+
+        /// Define the magic distinguishing authenticated codes from the
+        /// symmetric ones, which start with "Salted__".
+        static char const magic[] = "Sealed__";
+        /// The size of the GCM nonce, the one size it is specified for.
+        static int const iv_size = 12;
+        /// The size of the magic and nonce, authenticated along the code.
+        static int const header_size = sizeof (magic) - 1 + iv_size;
+        /// The size of the authentication tag appended to the code.
+        static int const tag_size = 16;
+        /// Separate the AEAD key from any other use of the secret.
+        static char const label[] = "elle.cryptography.aead";
+
+        /*--------.
+        | Helpers |
+        `--------*/
+
+        /// Derive the key of a secret, the same for every code: the nonce
+        /// alone makes each code unique.
+        static
+        void
+        _derive(elle::ConstWeakBuffer const& secret,
+                ::EVP_CIPHER const* cipher,
+                ::EVP_MD const* oneway,
+                unsigned char* key)
+        {
+          unsigned char digest[EVP_MAX_MD_SIZE];
+          unsigned int size = 0;
+          if (!::HMAC(oneway,
+                      secret.contents(), secret.size(),
+                      reinterpret_cast<unsigned char const*>(label),
+                      sizeof (label) - 1,
+                      digest, &size))
+            throw Error(
+              elle::sprintf("unable to derive the key: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+          if (static_cast<int>(size) < ::EVP_CIPHER_key_length(cipher))
+            throw Error("the digest is too short for the cipher's key");
+          ::memcpy(key, digest, ::EVP_CIPHER_key_length(cipher));
+        }
+
+        /// Encipher `plain` into `output`, authenticating `aad` along, and
+        /// append the tag.  Return the size written.
+        static
+        int
+        _seal(::EVP_CIPHER const* cipher,
+              unsigned char const* key,
+              unsigned char const* iv,
+              elle::ConstWeakBuffer const& aad,
+              elle::ConstWeakBuffer const& plain,
+              unsigned char* output)
+        {
+          ::EVP_CIPHER_CTX context;
+
+          ::EVP_CIPHER_CTX_init(&context);
+
+          ELLE_CRYPTOGRAPHY_FINALLY_ACTION_CLEANUP_CIPHER_CONTEXT(context);
+
+          if (::EVP_EncryptInit_ex(&context, cipher, nullptr, nullptr,
+                                   nullptr) <= 0 ||
+              ::EVP_CIPHER_CTX_ctrl(&context, EVP_CTRL_GCM_SET_IVLEN,
+                                    iv_size, nullptr) <= 0 ||
+              ::EVP_EncryptInit_ex(&context, nullptr, nullptr, key, iv) <= 0)
+            throw Error(
+              elle::sprintf("unable to initialize the encryption process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          int size_update(0);
+
+          if (aad.size() &&
+              ::EVP_EncryptUpdate(&context,
+                                  nullptr,
+                                  &size_update,
+                                  aad.contents(),
+                                  aad.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to authenticate the header: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          if (::EVP_EncryptUpdate(&context,
+                                  output,
+                                  &size_update,
+                                  plain.contents(),
+                                  plain.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the encryption function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          int size_final(0);
+
+          if (::EVP_EncryptFinal_ex(&context,
+                                    output + size_update,
+                                    &size_final) <= 0)
+            throw Error(
+              elle::sprintf("unable to finalize the encryption process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          auto const size = size_update + size_final;
+          if (::EVP_CIPHER_CTX_ctrl(&context,
+                                    EVP_CTRL_GCM_GET_TAG,
+                                    tag_size,
+                                    output + size) <= 0)
+            throw Error(
+              elle::sprintf("unable to retrieve the authentication tag: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          if (::EVP_CIPHER_CTX_cleanup(&context) <= 0)
+            throw Error(
+              elle::sprintf("unable to clean the cipher context: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          ELLE_CRYPTOGRAPHY_FINALLY_ABORT(context);
+
+          return size + tag_size;
+        }
+
+        /// Decipher and authenticate `code`, tag included, along with
+        /// `aad`.
+        static
+        elle::Buffer
+        _open(::EVP_CIPHER const* cipher,
+              unsigned char const* key,
+              unsigned char const* iv,
+              elle::ConstWeakBuffer const& aad,
+              elle::ConstWeakBuffer const& code)
+        {
+          if (code.size() < static_cast<std::size_t>(tag_size))
+            throw Error("the code is too short to be authenticated");
+          auto const size = int(code.size()) - tag_size;
+
+          ::EVP_CIPHER_CTX context;
+
+          ::EVP_CIPHER_CTX_init(&context);
+
+          ELLE_CRYPTOGRAPHY_FINALLY_ACTION_CLEANUP_CIPHER_CONTEXT(context);
+
+          if (::EVP_DecryptInit_ex(&context, cipher, nullptr, nullptr,
+                                   nullptr) <= 0 ||
+              ::EVP_CIPHER_CTX_ctrl(&context, EVP_CTRL_GCM_SET_IVLEN,
+                                    iv_size, nullptr) <= 0 ||
+              ::EVP_DecryptInit_ex(&context, nullptr, nullptr, key, iv) <= 0)
+            throw Error(
+              elle::sprintf("unable to initialize the decryption process: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          int size_update(0);
+
+          if (aad.size() &&
+              ::EVP_DecryptUpdate(&context,
+                                  nullptr,
+                                  &size_update,
+                                  aad.contents(),
+                                  aad.size()) <= 0)
+            throw Error(
+              elle::sprintf("unable to authenticate the header: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          auto res = elle::Buffer(size);
+          auto output = res.mutable_contents();
+
+          if (::EVP_DecryptUpdate(&context,
+                                  output,
+                                  &size_update,
+                                  code.contents(),
+                                  size) <= 0)
+            throw Error(
+              elle::sprintf("unable to apply the decryption function: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          // OpenSSL wants a mutable tag.
+          unsigned char tag[tag_size];
+          ::memcpy(tag, code.contents() + size, tag_size);
+          if (::EVP_CIPHER_CTX_ctrl(&context,
+                                    EVP_CTRL_GCM_SET_TAG,
+                                    tag_size,
+                                    tag) <= 0)
+            throw Error(
+              elle::sprintf("unable to set the authentication tag: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          int size_final(0);
+
+          if (::EVP_DecryptFinal_ex(&context,
+                                    output + size_update,
+                                    &size_final) <= 0)
+            throw Error("the code failed authentication");
+          res.size(size_update + size_final);
+
+          if (::EVP_CIPHER_CTX_cleanup(&context) <= 0)
+            throw Error(
+              elle::sprintf("unable to clean the cipher context: %s",
+                            ::ERR_error_string(ERR_get_error(), nullptr)));
+
+          ELLE_CRYPTOGRAPHY_FINALLY_ABORT(context);
+
+          return res;
+        }
+
+        /*----------.
+        | Functions |
+        `----------*/
+
+        elle::Buffer
+        encipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& plain)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          ELLE_ASSERT_EQ(EVP_CIPHER_mode(cipher), EVP_CIPH_GCM_MODE);
+          ELLE_ASSERT(secret.contents());
+
+          unsigned char key[EVP_MAX_KEY_LENGTH];
+          _derive(secret, cipher, oneway, key);
+
+          auto res = elle::Buffer(header_size + plain.size() + tag_size);
+          auto output = res.mutable_contents();
+
+          // Embed the magic and a fresh nonce.
+          ::memcpy(output, magic, sizeof (magic) - 1);
+          unsigned char* iv = output + sizeof (magic) - 1;
+          if (::RAND_bytes(iv, iv_size) <= 0)
+            throw Error(elle::sprintf("unable to randomly generate "
+                                      "a nonce: %s",
+                                      ::ERR_error_string(ERR_get_error(),
+                                                         nullptr)));
+
+          // Authenticate the header along with the cipher text.
+          auto const size = _seal(
+            cipher, key, iv,
+            elle::ConstWeakBuffer(output, header_size),
+            plain,
+            output + header_size);
+          res.size(header_size + size);
+
+          return res;
+        }
+
+        elle::Buffer
+        decipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& code)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          ELLE_ASSERT_EQ(EVP_CIPHER_mode(cipher), EVP_CIPH_GCM_MODE);
+
+          if (!authenticated(code))
+            throw Error("the code was not produced by an authenticated "
+                        "cipher");
+          if (code.size() < static_cast<std::size_t>(header_size + tag_size))
+            throw Error("the code is too short to be authenticated");
+
+          unsigned char key[EVP_MAX_KEY_LENGTH];
+          _derive(secret, cipher, oneway, key);
+
+          auto const input = code.contents();
+          return _open(
+            cipher, key, input + sizeof (magic) - 1,
+            elle::ConstWeakBuffer(input, header_size),
+            elle::ConstWeakBuffer(input + header_size,
+                                  code.size() - header_size));
+        }
+
+        bool
+        authenticated(elle::ConstWeakBuffer const& code)
+        {
+          return code.size() >= sizeof (magic) - 1 &&
+            ::memcmp(code.contents(), magic, sizeof (magic) - 1) == 0;
+        }
+
+        elle::Buffer
+        seal(elle::ConstWeakBuffer const& key,
+             ::EVP_CIPHER const* cipher,
+             elle::ConstWeakBuffer const& aad,
+             elle::ConstWeakBuffer const& plain)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          ELLE_ASSERT_EQ(EVP_CIPHER_mode(cipher), EVP_CIPH_GCM_MODE);
+          if (key.size() != static_cast<std::size_t>(
+                ::EVP_CIPHER_key_length(cipher)))
+            throw Error(elle::sprintf("the key size %s does not match the "
+                                      "cipher's", key.size()));
+
+          auto res = elle::Buffer(iv_size + plain.size() + tag_size);
+          auto output = res.mutable_contents();
+          if (::RAND_bytes(output, iv_size) <= 0)
+            throw Error(elle::sprintf("unable to randomly generate "
+                                      "a nonce: %s",
+                                      ::ERR_error_string(ERR_get_error(),
+                                                         nullptr)));
+          auto const size = _seal(cipher, key.contents(), output, aad, plain,
+                                  output + iv_size);
+          res.size(iv_size + size);
+
+          return res;
+        }
+
+        elle::Buffer
+        open(elle::ConstWeakBuffer const& key,
+             ::EVP_CIPHER const* cipher,
+             elle::ConstWeakBuffer const& aad,
+             elle::ConstWeakBuffer const& code)
+        {
+          // Make sure the cryptographic system is set up.
+          cryptography::require();
+
+          ELLE_ASSERT_EQ(EVP_CIPHER_mode(cipher), EVP_CIPH_GCM_MODE);
+          if (key.size() != static_cast<std::size_t>(
+                ::EVP_CIPHER_key_length(cipher)))
+            throw Error(elle::sprintf("the key size %s does not match the "
+                                      "cipher's", key.size()));
+          if (code.size() < static_cast<std::size_t>(iv_size + tag_size))
+            throw Error("the code is too short to be authenticated");
+
+          return _open(cipher, key.contents(), code.contents(), aad,
+                       elle::ConstWeakBuffer(code.contents() + iv_size,
+                                             code.size() - iv_size));
+        }
       }
     }
   }
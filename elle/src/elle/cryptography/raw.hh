@@ -119,6 +119,88 @@ namespace elle
                  std::ostream& plain,
                  std::function<void (::EVP_CIPHER_CTX*)> prolog = nullptr,
                  std::function<void (::EVP_CIPHER_CTX*)> epilog = nullptr);
+        /// Encipher the plain text in a single pass, producing the same code
+        /// as the stream version.
+        elle::Buffer
+        encipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& plain);
+        /// Decipher the code in a single pass.
+        elle::Buffer
+        decipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& code);
+        /// Replace the plain text by its code, reusing its storage.
+        void
+        encipher_in_place(elle::ConstWeakBuffer const& secret,
+                          ::EVP_CIPHER const* cipher,
+                          ::EVP_MD const* oneway,
+                          elle::Buffer& data);
+        /// Replace the code by its plain text, reusing its storage.
+        void
+        decipher_in_place(elle::ConstWeakBuffer const& secret,
+                          ::EVP_CIPHER const* cipher,
+                          ::EVP_MD const* oneway,
+                          elle::Buffer& data);
+      }
+    }
+  }
+}
+
+//
+// ---------- AEAD ------------------------------------------------------------
+//
+
+namespace elle
+{
+  namespace cryptography
+  {
+    namespace raw
+    {
+      /// Contain the authenticated symmetric operations.
+      ///
+      /// The code embeds its own magic, a random 96-bit nonce and the
+      /// authentication tag, so that tampering is detected on decipher
+      /// rather than producing garbage.  The key is derived once from the
+      /// secret with an HMAC, the nonce alone making codes unique.  These
+      /// functions operate on buffers since the tag can only be checked once
+      /// the whole code has been processed.
+      namespace aead
+      {
+        /// Encipher the plain text according to the given secret and
+        /// authenticated cipher, e.g. AES-GCM.
+        elle::Buffer
+        encipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& plain);
+        /// Decipher and authenticate the code according to the given secret
+        /// and authenticated cipher.
+        elle::Buffer
+        decipher(elle::ConstWeakBuffer const& secret,
+                 ::EVP_CIPHER const* cipher,
+                 ::EVP_MD const* oneway,
+                 elle::ConstWeakBuffer const& code);
+        /// Whether the code was produced by aead::encipher.
+        bool
+        authenticated(elle::ConstWeakBuffer const& code);
+        /// Encipher the plain text with `key`, used as is, authenticating
+        /// `aad` along.  The code is a random nonce, the cipher text and
+        /// the tag; it carries no magic.
+        elle::Buffer
+        seal(elle::ConstWeakBuffer const& key,
+             ::EVP_CIPHER const* cipher,
+             elle::ConstWeakBuffer const& aad,
+             elle::ConstWeakBuffer const& plain);
+        /// Decipher and authenticate a code produced by seal with the same
+        /// key and `aad`.
+        elle::Buffer
+        open(elle::ConstWeakBuffer const& key,
+             ::EVP_CIPHER const* cipher,
+             elle::ConstWeakBuffer const& aad,
+             elle::ConstWeakBuffer const& code);
       }
     }
   }
@@ -0,0 +1,54 @@
+#include <zlib.h>
+
+#include <elle/err.hh>
+#include <elle/format/deflate.hh>
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("elle.format.deflate");
+
+namespace elle
+{
+  namespace format
+  {
+    namespace deflate
+    {
+      Buffer
+      compress(ConstWeakBuffer data, int level)
+      {
+        ELLE_DEBUG_SCOPE("compress %s bytes at level %s", data.size(), level);
+        auto size = compressBound(data.size());
+        auto res = Buffer(size);
+        auto const err = compress2(res.mutable_contents(), &size,
+                                   data.contents(), data.size(), level);
+        if (err == Z_MEM_ERROR)
+          throw std::bad_alloc();
+        else if (err != Z_OK)
+          elle::err("ZLIB compress error: %s", err);
+        res.size(size);
+        res.shrink_to_fit();
+        ELLE_DUMP("compressed to %s bytes", res.size());
+        return res;
+      }
+
+      Buffer
+      decompress(ConstWeakBuffer data, Buffer::Size size)
+      {
+        ELLE_DEBUG_SCOPE("decompress %s bytes to %s", data.size(), size);
+        auto res = Buffer(size);
+        auto actual = uLongf(size);
+        auto const err = uncompress(res.mutable_contents(), &actual,
+                                    data.contents(), data.size());
+        if (err == Z_MEM_ERROR)
+          throw std::bad_alloc();
+        else if (err == Z_BUF_ERROR)
+          elle::err("ZLIB data decompresses beyond %s bytes", size);
+        else if (err != Z_OK)
+          elle::err("ZLIB uncompress error: %s", err);
+        if (actual != size)
+          elle::err("ZLIB data decompresses to %s bytes instead of %s",
+                    actual, size);
+        return res;
+      }
+    }
+  }
+}
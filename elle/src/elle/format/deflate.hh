@@ -0,0 +1,32 @@
+#pragma once
+
+#include <elle/Buffer.hh>
+
+namespace elle
+{
+  namespace format
+  {
+    /// One-shot ZLIB compression of whole buffers.
+    ///
+    /// Unlike gzip::Stream, the output carries no GZIP header and can be
+    /// decompressed back.
+    namespace deflate
+    {
+      /// Compress `data` to the ZLIB format.
+      ///
+      /// \param data  The data to compress.
+      /// \param level The compression level, from 1 (fastest) to 9 (smallest),
+      ///              -1 for the ZLIB default.
+      ELLE_API
+      Buffer
+      compress(ConstWeakBuffer data, int level = -1);
+      /// Decompress ZLIB `data` of `size` bytes once decompressed.
+      ///
+      /// \throw elle::Error if the data is corrupted or does not decompress to
+      ///                    exactly `size` bytes.
+      ELLE_API
+      Buffer
+      decompress(ConstWeakBuffer data, Buffer::Size size);
+    }
+  }
+}
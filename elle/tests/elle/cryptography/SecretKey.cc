@@ -2,6 +2,7 @@
 
 #include <elle/cryptography/SecretKey.hh>
 #include <elle/cryptography/Cipher.hh>
+#include <elle/cryptography/Error.hh>
 #include <elle/cryptography/Oneway.hh>
 #include <elle/cryptography/random.hh>
 
@@ -219,12 +220,128 @@ _test_operate_idea()
   BOOST_CHECK_EQUAL(input, output);
 }
 
+static
+void
+_test_operate_gcm()
+{
+  using elle::cryptography::Cipher;
+  using elle::cryptography::Mode;
+  auto const key = test_generate_x<256>();
+  auto const input = "Ouistiti!"s;
+  auto code = key.encipher(input, Cipher::aes256, Mode::gcm);
+  // Magic, nonce, text and tag: no padding.
+  BOOST_CHECK_EQUAL(code.size(), 8 + 12 + input.size() + 16);
+  // Every code gets its own nonce.
+  BOOST_CHECK_NE(key.encipher(input, Cipher::aes256, Mode::gcm), code);
+  BOOST_CHECK_EQUAL(key.decipher(code, Cipher::aes256, Mode::gcm).string(),
+                    input);
+  // Authenticated codes are detected whatever the requested mode.
+  BOOST_CHECK_EQUAL(key.decipher(code).string(), input);
+  // Legacy codes remain readable when asking for GCM.
+  auto const legacy = key.encipher(input);
+  BOOST_CHECK_EQUAL(key.decipher(legacy, Cipher::aes256, Mode::gcm).string(),
+                    input);
+  // Streams.
+  {
+    std::stringstream plain(input);
+    std::stringstream code;
+    key.encipher(plain, code, Cipher::aes256, Mode::gcm);
+    std::stringstream output;
+    key.decipher(code, output, Cipher::aes256, Mode::gcm);
+    BOOST_CHECK_EQUAL(output.str(), input);
+  }
+  // Tampering with the nonce, the text or the tag is detected.
+  for (auto i: {12, 20, int(code.size()) - 1})
+  {
+    code[i] ^= 1;
+    BOOST_CHECK_THROW(key.decipher(code, Cipher::aes256, Mode::gcm),
+                      elle::cryptography::Error);
+    code[i] ^= 1;
+  }
+  // As is the wrong key.
+  BOOST_CHECK_THROW(
+    test_generate_x<256>().decipher(code, Cipher::aes256, Mode::gcm),
+    elle::cryptography::Error);
+  // And truncation.
+  BOOST_CHECK_THROW(
+    key.decipher(elle::ConstWeakBuffer(code.contents(), 20),
+                 Cipher::aes256, Mode::gcm),
+    elle::cryptography::Error);
+}
+
+/// Check `plain` holds exactly the bytes of `input`.
+static
+void
+_check_plain(elle::Buffer const& plain,
+             elle::Buffer const& input)
+{
+  BOOST_CHECK_EQUAL(plain.size(), input.size());
+  BOOST_CHECK_EQUAL_COLLECTIONS(plain.contents(),
+                                plain.contents() + plain.size(),
+                                input.contents(),
+                                input.contents() + input.size());
+}
+
+static
+void
+_test_operate_buffer(elle::cryptography::Cipher cipher,
+                     elle::cryptography::Mode mode)
+{
+  auto const key = test_generate_x<256>();
+  for (auto size: {0, 1, 15, 16, 17, 1000, 600000})
+  {
+    auto input = elle::Buffer(size);
+    for (int i = 0; i < size; ++i)
+      input[i] = i * 7;
+    // Buffer and stream codes are interchangeable.
+    auto const code = key.encipher(input, cipher, mode);
+    std::stringstream stream_code;
+    {
+      auto in = elle::IOStream(input.istreambuf());
+      key.encipher(in, stream_code, cipher, mode);
+    }
+    auto const stream = elle::Buffer(stream_code.str());
+    BOOST_CHECK_EQUAL(code.size(), stream.size());
+    _check_plain(key.decipher(code, cipher, mode), input);
+    _check_plain(key.decipher(stream, cipher, mode), input);
+    {
+      auto in = elle::IOStream(code.istreambuf());
+      std::stringstream plain;
+      key.decipher(in, plain, cipher, mode);
+      _check_plain(elle::Buffer(plain.str()), input);
+    }
+    // In place.
+    auto data = elle::Buffer(input);
+    key.encipher_in_place(data, cipher, mode);
+    BOOST_CHECK_EQUAL(data.size(), code.size());
+    _check_plain(key.decipher(data, cipher, mode), input);
+    key.decipher_in_place(data, cipher, mode);
+    _check_plain(data, input);
+    data = elle::Buffer(stream);
+    key.decipher_in_place(data, cipher, mode);
+    _check_plain(data, input);
+  }
+}
+
 static
 void
 test_operate()
 {
   // IDEA.
   _test_operate_idea();
+  // AES256-GCM.
+  _test_operate_gcm();
+  // Buffer and in place operations.
+  _test_operate_buffer(elle::cryptography::Cipher::aes256,
+                       elle::cryptography::Mode::cbc);
+  _test_operate_buffer(elle::cryptography::Cipher::aes128,
+                       elle::cryptography::Mode::ecb);
+  _test_operate_buffer(elle::cryptography::Cipher::aes256,
+                       elle::cryptography::Mode::cfb);
+  _test_operate_buffer(elle::cryptography::Cipher::des3,
+                       elle::cryptography::Mode::ofb);
+  _test_operate_buffer(elle::cryptography::Cipher::aes256,
+                       elle::cryptography::Mode::gcm);
 }
 
 /*----------.
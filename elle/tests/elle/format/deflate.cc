@@ -0,0 +1,66 @@
+#include <elle/format/deflate.hh>
+#include <elle/test.hh>
+
+static
+std::string
+content()
+{
+  auto res = std::string{};
+  for (int i = 0; i < 256; ++i)
+    res +=
+      "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Etiam velit"
+      "tortor, facilisis eget nisl ac, convallis mattis dui.";
+  return res;
+}
+
+static
+void
+round_trip()
+{
+  auto const data = content();
+  for (auto level: {-1, 1, 9})
+  {
+    auto const compressed =
+      elle::format::deflate::compress(elle::ConstWeakBuffer(data), level);
+    BOOST_CHECK_LT(compressed.size(), data.size() / 10);
+    BOOST_CHECK_EQUAL(
+      elle::format::deflate::decompress(compressed, data.size()), data);
+  }
+}
+
+static
+void
+empty()
+{
+  auto const compressed =
+    elle::format::deflate::compress(elle::ConstWeakBuffer());
+  BOOST_CHECK_EQUAL(
+    elle::format::deflate::decompress(compressed, 0).size(), 0);
+}
+
+static
+void
+corrupted()
+{
+  auto const data = content();
+  auto compressed =
+    elle::format::deflate::compress(elle::ConstWeakBuffer(data));
+  BOOST_CHECK_THROW(
+    elle::format::deflate::decompress(compressed, data.size() - 1),
+    elle::Error);
+  BOOST_CHECK_THROW(
+    elle::format::deflate::decompress(compressed, data.size() + 1),
+    elle::Error);
+  compressed[compressed.size() / 2] ^= 0xff;
+  BOOST_CHECK_THROW(
+    elle::format::deflate::decompress(compressed, data.size()),
+    elle::Error);
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& suite = boost::unit_test::framework::master_test_suite();
+  suite.add(BOOST_TEST_CASE(round_trip));
+  suite.add(BOOST_TEST_CASE(empty));
+  suite.add(BOOST_TEST_CASE(corrupted));
+}
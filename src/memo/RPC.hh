@@ -5,6 +5,7 @@
 #include <elle/os/environ.hh>
 #include <elle/log.hh>
 #include <elle/bench.hh>
+#include <elle/err.hh>
 
 #include <elle/cryptography/SecretKey.hh>
 
@@ -401,6 +402,16 @@ namespace memo
       auto request = channel.read();
       ELLE_TRACE_SCOPE("%s: process RPC", this);
       bool had_key = !!_key;
+      // Answer in the mode the caller picked, so that nodes that do not
+      // support authenticated encryption keep working.  Once the caller
+      // agreed to authenticated encryption, refuse anything else.
+      auto const authenticated =
+        had_key && elle::cryptography::secretkey::authenticated(request);
+      if (had_key && this->_aead && !authenticated)
+        elle::err("%s: unauthenticated request on an AEAD connection", *this);
+      auto const mode = authenticated ?
+        elle::cryptography::Mode::gcm :
+        elle::cryptography::SecretKey::defaults::mode;
       if (had_key)
       {
         ELLE_DEBUG_SCOPE("decipher RPC");
@@ -414,12 +425,12 @@ namespace memo
             auto& key = this->_key.get();
             elle::With<elle::reactor::Thread::NonInterruptible>() << [&] {
               elle::reactor::background([&] {
-                  request = key.decipher(request);
+                  key.decipher_in_place(request);
               });
             };
           }
           else
-            request = this->_key->decipher(request);
+            this->_key->decipher_in_place(request);
         }
         catch(std::exception const& e)
         {
@@ -475,15 +486,18 @@ namespace memo
           auto& key = this->_key.get();
           elle::With<elle::reactor::Thread::NonInterruptible>() << [&] {
             elle::reactor::background([&] {
-                response = key.encipher(
-	          elle::ConstWeakBuffer(response.contents(),
-	            response.size()));
+                key.encipher_in_place(
+                  response,
+                  elle::cryptography::SecretKey::defaults::cipher,
+                  mode);
               });
           };
         }
         else
-          response = _key->encipher(
-            elle::ConstWeakBuffer(response.contents(), response.size()));
+          this->_key->encipher_in_place(
+            response,
+            elle::cryptography::SecretKey::defaults::cipher,
+            mode);
       }
       channel.write(response);
     }
@@ -502,6 +516,8 @@ namespace memo
     std::unordered_map<std::string, std::unique_ptr<RPCHandler>> _rpcs;
     elle::serialization::Context _context;
     boost::optional<elle::cryptography::SecretKey> _key;
+    /// Whether the caller agreed to authenticated encryption.
+    bool _aead = false;
     boost::signals2::signal<void()> _destroying;
     ELLE_ATTRIBUTE(elle::Version, version);
   };
@@ -531,6 +547,7 @@ namespace memo
       , _channels(channels)
       , _key(std::move(key))
       , _version(version)
+      , _mode(elle::cryptography::SecretKey::defaults::mode)
     {}
 
     /// Return the credentials, if applicable.
@@ -565,6 +582,9 @@ namespace memo
     ELLE_ATTRIBUTE_RX(
       boost::optional<elle::cryptography::SecretKey>, key, protected);
     ELLE_ATTRIBUTE_R(elle::Version, version, protected);
+    /// The mode to encipher requests with, responses being deciphered
+    /// whatever their mode.
+    ELLE_ATTRIBUTE_RW(elle::cryptography::Mode, mode);
   };
 
   template <typename Proto>
@@ -722,14 +742,18 @@ namespace memo
             {
               elle::With<elle::reactor::Thread::NonInterruptible>() << [&] {
                 elle::reactor::background([&] {
-                    call = self.key()->encipher(
-                      elle::ConstWeakBuffer(call.contents(), call.size()));
+                    self.key()->encipher_in_place(
+                      call,
+                      elle::cryptography::SecretKey::defaults::cipher,
+                      self.mode());
                   });
               };
             }
             else
-              call = self.key()->encipher(
-                elle::ConstWeakBuffer(call.contents(), call.size()));
+              self.key()->encipher_in_place(
+                call,
+                elle::cryptography::SecretKey::defaults::cipher,
+                self.mode());
         }
         ELLE_DEBUG("send request")
           channel.write(call);
@@ -746,14 +770,12 @@ namespace memo
           {
             elle::With<elle::reactor::Thread::NonInterruptible>() << [&] {
               elle::reactor::background([&] {
-                  response = self.key()->decipher(
-                    elle::ConstWeakBuffer(response.contents(), response.size()));
+                  self.key()->decipher_in_place(response);
               });
             };
           }
           else
-            response = self.key()->decipher(
-              elle::ConstWeakBuffer(response.contents(), response.size()));
+            self.key()->decipher_in_place(response);
         }
         auto ins = elle::IOStream(response.istreambuf());
         auto input
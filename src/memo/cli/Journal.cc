@@ -1,11 +1,13 @@
 #include <memo/cli/Journal.hh>
 
+#include <elle/IOStream.hh>
 #include <elle/bytes.hh>
 #include <elle/printf.hh>
 
 #include <memo/cli/Memo.hh>
 #include <memo/model/doughnut/ACB.hh>
 #include <memo/model/doughnut/Async.hh>
+#include <memo/model/doughnut/Journal.hh>
 #include <memo/model/doughnut/OKB.hh>
 
 ELLE_LOG_COMPONENT("cli.journal");
@@ -19,6 +21,7 @@ namespace memo
     using Error = elle::das::cli::Error;
 
     using Async = memo::model::doughnut::consensus::Async;
+    using AsyncJournal = memo::model::doughnut::consensus::Journal;
 
     Journal::Journal(Memo& memo)
       : Object(memo)
@@ -42,13 +45,16 @@ namespace memo
     namespace
     {
       Async::Op
-      get_operation(memo::Memo& ifnt,
-                    memo::User const& owner,
+      get_operation(memo::User const& owner,
                     memo::Network& network,
-                    bfs::path const& path, std::string const& id)
+                    AsyncJournal const& journal,
+                    int id)
       {
-        bfs::ifstream f;
-        ifnt._open_read(f, path, id, "operation");
+        if (!journal.contains(id))
+          elle::err<MissingLocalResource>("operation \"%s\" does not exist",
+                                          id);
+        auto const data = journal.read(id);
+        elle::IOStream f(data.istreambuf());
         auto dht = network.run(owner);
         auto ctx = elle::serialization::Context
           {
@@ -71,13 +77,13 @@ namespace memo
       auto network = memo.network_get(network_name, owner);
       auto dht = network.run(owner);
       auto const async_path = memo._network_cache_dir(network.name, owner) / "async";
-      auto report = [&] (bfs::path const& path)
+      AsyncJournal const journal(async_path, true);
+      auto report = [&] (int id)
         {
-          auto name = path.filename().string();
-          std::cout << name << ": ";
+          std::cout << id << ": ";
           try
           {
-            auto op = get_operation(memo, owner, network, path, name);
+            auto op = get_operation(owner, network, journal, id);
             if (op.resolver)
               std::cout << op.resolver->description();
             else
@@ -90,10 +96,10 @@ namespace memo
           std::cout << std::endl;
         };
       if (operation)
-        report(async_path / elle::sprintf("%s", *operation));
+        report(*operation);
       else
-        for (auto const& path: Async::entries(async_path))
-          report(path);
+        for (auto id: journal.indexes())
+          report(id);
     }
 
     /*---------------.
@@ -109,9 +115,9 @@ namespace memo
       auto& memo = cli.backend();
       auto owner = cli.as_user();
       auto network = memo.network_get(network_name, owner);
-      auto id = std::to_string(operation);
-      auto path = memo._network_cache_dir(network.name, owner) / "async" / id;
-      auto op = get_operation(memo, owner, network, path, id);
+      AsyncJournal const journal(
+        memo._network_cache_dir(network.name, owner) / "async", true);
+      auto op = get_operation(owner, network, journal, operation);
       elle::serialization::json::serialize(op, std::cout);
     }
 
@@ -135,15 +141,12 @@ namespace memo
       for (auto const& network: networks)
       {
         auto const async_path = memo._network_cache_dir(network.name, owner) / "async";
-        int operation_count = 0;
+        AsyncJournal const journal(async_path, true);
+        auto const indexes = journal.indexes();
+        int operation_count = indexes.size();
         int64_t data_size = 0;
-        if (bfs::exists(async_path))
-          for (auto const& p: bfs::directory_iterator(async_path))
-            if (is_visible_file(p))
-            {
-              operation_count++;
-              data_size += bfs::file_size(p);
-            }
+        for (auto id: indexes)
+          data_size += journal.size(id);
         if (cli.script())
           res[network.name] = elle::json::Json
             {
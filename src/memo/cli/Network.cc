@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstdio>
 
 #include <memo/cli/Network.hh>
 
@@ -27,6 +28,7 @@
 #include <memo/model/blocks/MutableBlock.hh>
 #include <memo/model/doughnut/Doughnut.hh>
 #include <memo/model/doughnut/NB.hh>
+#include <memo/model/doughnut/consensus/Erasure.hh>
 #include <memo/model/doughnut/consensus/Paxos.hh>
 #include <memo/overlay/Kalimero.hh>
 #include <memo/overlay/kelips/Kelips.hh>
@@ -60,6 +62,7 @@ namespace memo
                cli::port = boost::none,
                cli::replication_factor = 1,
                cli::eviction_delay = boost::none,
+               cli::erasure_coding = boost::none,
                cli::output = boost::none,
                cli::push_network = false,
                cli::push = false,
@@ -83,7 +86,8 @@ namespace memo
                cli::tcp_heartbeat = boost::none,
                cli::disable_encrypt_at_rest = false,
                cli::disable_encrypt_rpc = false,
-               cli::disable_signature = false)
+               cli::disable_signature = false,
+               cli::disable_aead = false)
       , delete_(*this,
                 "Delete a network locally",
                 cli::name,
@@ -290,7 +294,8 @@ namespace memo
       make_consensus_config(bool paxos,
                             bool no_consensus,
                             int replication_factor,
-                            boost::optional<std::string> const& eviction_delay)
+                            boost::optional<std::string> const& eviction_delay,
+                            boost::optional<std::string> const& erasure_coding)
         -> std::unique_ptr<dnut::consensus::Configuration>
       {
         if (replication_factor < 1)
@@ -299,21 +304,38 @@ namespace memo
           paxos = true;
         if (1 < no_consensus + paxos)
           elle::err<CLIError>("more than one consensus specified");
-        if (paxos)
-          return std::make_unique<
-            dnut::consensus::Paxos::Configuration>(
-              replication_factor,
-              eviction_delay
-              ? std::chrono::duration_from_string<std::chrono::seconds>(
-                *eviction_delay)
-              : std::chrono::seconds(10 * 60));
-        else
+        auto res = [&] () -> std::unique_ptr<dnut::consensus::Configuration>
         {
-          if (replication_factor != 1)
-            elle::err("without consensus, replication factor must be 1");
-          return std::make_unique<
-            dnut::consensus::Configuration>();
+          if (paxos)
+            return std::make_unique<
+              dnut::consensus::Paxos::Configuration>(
+                replication_factor,
+                eviction_delay
+                ? std::chrono::duration_from_string<std::chrono::seconds>(
+                  *eviction_delay)
+                : std::chrono::seconds(10 * 60));
+          else
+          {
+            if (replication_factor != 1)
+              elle::err("without consensus, replication factor must be 1");
+            return std::make_unique<
+              dnut::consensus::Configuration>();
+          }
+        }();
+        if (erasure_coding)
+        {
+          auto data = 0;
+          auto parity = 0;
+          auto end = 0;
+          if (std::sscanf(erasure_coding->c_str(), "%d+%d%n",
+                          &data, &parity, &end) != 2
+              || end != signed(erasure_coding->size())
+              || data < 1 || parity < 0 || 256 < data + parity)
+            elle::err<CLIError>("invalid erasure coding: %s", *erasure_coding);
+          res = std::make_unique<dnut::consensus::Erasure::Configuration>(
+            std::move(res), data, parity);
         }
+        return res;
       }
 
       auto
@@ -349,6 +371,7 @@ namespace memo
       boost::optional<int> port,
       int replication_factor,
       boost::optional<std::string> const& eviction_delay,
+      boost::optional<std::string> const& erasure_coding,
       boost::optional<std::string> const& output_name,
       bool push_network,
       bool push,
@@ -371,7 +394,8 @@ namespace memo
       elle::DurationOpt tcp_heartbeat,
       bool disable_encrypt_at_rest,
       bool disable_encrypt_rpc,
-      bool disable_signature)
+      bool disable_signature,
+      bool disable_aead)
     {
       ELLE_TRACE_SCOPE("create");
       auto& cli = this->cli();
@@ -395,12 +419,13 @@ namespace memo
       auto const encrypt_options = memo::model::doughnut::EncryptOptions{
         !disable_encrypt_at_rest,
         !disable_encrypt_rpc,
-        !disable_signature};
+        !disable_signature,
+        !disable_aead};
       auto dht =
         std::make_unique<dnut::Configuration>(
           memo::model::Address::random(0),
           make_consensus_config(paxos, no_consensus, replication_factor,
-                                eviction_delay),
+                                eviction_delay, erasure_coding),
           std::move(overlay_config),
           make_silo_config(memo, silos_names),
           owner.keypair(),
@@ -876,9 +901,12 @@ namespace memo
         main_log_family(elle::print("%s/%s", owner.name, network.name));
         if (paxos_rebalancing_auto_expand || paxos_rebalancing_inspect)
         {
+          auto consensus = network.dht()->consensus.get();
+          if (auto erasure = dynamic_cast<
+                dnut::consensus::Erasure::Configuration*>(consensus))
+            consensus = erasure->backend().get();
           auto paxos = dynamic_cast<
-            dnut::consensus::Paxos::Configuration*>(
-              network.dht()->consensus.get());
+            dnut::consensus::Paxos::Configuration*>(consensus);
           if (!paxos)
             elle::err<CLIError>("paxos options on non-paxos consensus");
           if (paxos_rebalancing_auto_expand)
@@ -53,6 +53,7 @@ namespace memo
                  decltype(cli::port = boost::optional<int>()),
                  decltype(cli::replication_factor = 1),
                  decltype(cli::eviction_delay = boost::optional<std::string>()),
+                 decltype(cli::erasure_coding = boost::optional<std::string>()),
                  decltype(cli::output = boost::optional<std::string>()),
                  decltype(cli::push_network = false),
                  decltype(cli::push = false),
@@ -75,7 +76,8 @@ namespace memo
                  decltype(cli::tcp_heartbeat = elle::DurationOpt{}),
                  decltype(cli::disable_encrypt_at_rest = false),
                  decltype(cli::disable_encrypt_rpc = false),
-                 decltype(cli::disable_signature = false)),
+                 decltype(cli::disable_signature = false),
+                 decltype(cli::disable_aead = false)),
            decltype(modes::mode_create)>
       create;
       void
@@ -86,6 +88,7 @@ namespace memo
         boost::optional<int> port,
         int replication_factor,
         boost::optional<std::string> const& eviction_delay,
+        boost::optional<std::string> const& erasure_coding,
         boost::optional<std::string> const& output_name,
         bool push_network,
         bool push,
@@ -109,7 +112,8 @@ namespace memo
         elle::DurationOpt tcp_heartbeat,
         bool disable_encrypt_at_rest,
         bool disable_encrypt_rpc,
-        bool disable_signature);
+        bool disable_signature,
+        bool disable_aead);
 
       /*---------------.
       | Mode: delete.  |
@@ -49,6 +49,7 @@ namespace memo
     ELLE_DAS_CLI_SYMBOL(deny_storage, '\0', "deny user ability to contribute storage to the network", false);
     ELLE_DAS_CLI_SYMBOL(deny_write, '\0', "deny user write access to the network", false);
     ELLE_DAS_CLI_SYMBOL(description, '\0', "{object} description", false);
+    ELLE_DAS_CLI_SYMBOL(disable_aead, 0, "disable authenticated encryption of RPCs and blocks, for nodes older than it", false);
     ELLE_DAS_CLI_SYMBOL(disable_UTF_8_conversion, 0, "disable FUSE conversion of UTF-8 to native format", false);
     ELLE_DAS_CLI_SYMBOL(disable_encrypt_at_rest, 0, "disable at-rest encryption", false);
     ELLE_DAS_CLI_SYMBOL(disable_encrypt_rpc, 0, "disable RPC encryption", false);
@@ -69,6 +70,7 @@ namespace memo
     ELLE_DAS_CLI_SYMBOL(encrypt, 0,  "use encryption: no, lazy, yes (default: yes)", false);
     ELLE_DAS_CLI_SYMBOL(endpoint, '\0', "S3 endpoint", false);
     ELLE_DAS_CLI_SYMBOL(endpoints_file, 0, "write node listening endpoints to file (format: host:port)", false);
+    ELLE_DAS_CLI_SYMBOL(erasure_coding, 0, "store immutable blocks as DATA+PARITY erasure-coded fragments (e.g. 4+2)", false);
     ELLE_DAS_CLI_SYMBOL(eviction_delay, 'e', "missing servers eviction delay (default: 10min)", false);
     ELLE_DAS_CLI_SYMBOL(fallback_xattrs, '\0', "use fallback special file if extended attributes are not supported", false);
     ELLE_DAS_CLI_SYMBOL(fetch, 'f', "fetch {object} from {hub}", false);
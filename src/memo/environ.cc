@@ -21,22 +21,33 @@ namespace
     static auto const res = Vars
     {
 
+      {"ASYNC_JOURNAL_SEGMENT_SIZE", ""},
+      {"ASYNC_JOURNAL_SPARE_SEGMENTS", ""},
+      {"ASYNC_JOURNAL_SYNC_DELAY", ""},
       {"ASYNC_NOPOP", ""},
       {"ASYNC_POP_DELAY", ""},
       {"ASYNC_SQUASH", ""},
+      {"ASYNC_WINDOW", ""},
       {"BACKGROUND_DECODE", ""},
       {"BACKTRACE", ""},
       {"BALANCED_TRANSFERS", ""},
       {"BEYOND", ""},
+      {"BLOCK_COMPRESSION", ""},
       {"CACHE_HOME", ""},
+      {"CACHE_NEGATIVE_TTL", ""},
+      {"CACHE_PREFETCH_CONCURRENCY", ""},
+      {"CACHE_PUSH_INVALIDATION", ""},
       {"CACHE_REFRESH_BATCH_SIZE", ""},
+      {"CACHE_WINDOW_PERCENT", ""},
       {"CONFIG_HOME", ""},
       {"CONNECT_TIMEOUT", ""},
       {"CRASH", "Generate a crash"},
       {"CRASH_REPORT", "Activate crash-reporting"},
       {"CRASH_REPORT_HOST", ""},
+      {"CRYPTO_THREADS", ""},
       {"DATA_HOME", ""},
       {"DATA_HOME", ""},
+      {"FETCH_HEDGE_PERCENTILE", ""},
       {"FIRST_BLOCK_DATA_SIZE", ""},
       {"HOME", ""},
       {"HOME_OVERRIDE", ""},
@@ -48,6 +59,7 @@ namespace
       {"KELIPS_COMPRESSION", ""},
       {"KELIPS_SNUB", ""},
       {"KEY_HASH", ""},
+      {"KEY_PREFETCH", ""},
       {"KOUNCIL_WATCHER_INTERVAL", ""},
       {"KOUNCIL_WATCHER_MAX_RETRY", ""},
       {"LOG_DIR", "Where logs are stored [~/.cache/infinit/memo/logs]"},
@@ -57,8 +69,18 @@ namespace
       {"LOOKAHEAD_THREADS", ""},
       {"MAX_EMBED_SIZE", ""},
       {"MAX_SQUASH_SIZE", ""},
+      {"OBJECT_CHUNK_SIZE", ""},
+      {"OBJECT_FANOUT", ""},
+      {"OBJECT_READERS", ""},
+      {"OBJECT_SESSION_TIMEOUT", ""},
+      {"OBJECT_WINDOW", ""},
+      {"PAXOS_ANTI_ENTROPY_INTERVAL", ""},
       {"PAXOS_CACHE_SIZE", ""},
+      {"PAXOS_DELTA", ""},
+      {"PAXOS_DELTA_CACHE_SIZE", ""},
       {"PAXOS_LENIENT_FETCH", ""},
+      {"PAXOS_TRANSFER_BATCH", ""},
+      {"PAXOS_TRANSFER_WINDOW", ""},
       {"PREEMPT_DECODE", ""},
       {"PREFETCH_DEPTH", ""},
       {"PREFETCH_GROUP", ""},
@@ -71,7 +93,10 @@ namespace
       {"RPC_DISABLE_CRYPTO", ""},
       {"RPC_SERVE_THREADS", ""},
       {"RUNTIME_DIR", ""},
+      {"SECRET_CACHE_SIZE", ""},
+      {"SESSION_TICKET_TTL", ""},
       {"SIGNAL_HANDLER", ""},
+      {"SIGNATURE_CACHE_SIZE", ""},
       {"SOFTFAIL_RUNNING", ""},
       {"SOFTFAIL_TIMEOUT", ""},
       {"STATE_HOME", ""},
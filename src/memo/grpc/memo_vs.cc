@@ -352,6 +352,8 @@ namespace memo
       auto ptr = std::make_unique<Service>(server);
       ptr->AddMethod<::memo::vs::FetchRequest, ::memo::vs::FetchResponse>
         (dht.fetch, dht, "/memo.vs.ValueStore/Fetch");
+      ptr->AddMethod<::memo::vs::PrefetchRequest, ::memo::vs::PrefetchResponse>
+        (dht.prefetch, dht, "/memo.vs.ValueStore/Prefetch");
       ptr->AddMethod<::memo::vs::InsertRequest, ::memo::vs::InsertResponse>
         (dht.insert, dht, "/memo.vs.ValueStore/Insert");
       Update update = dht.update.function();
@@ -370,6 +372,16 @@ namespace memo
         (dht.insert_immutable_block, dht,"/memo.vs.ValueStore/InsertImmutableBlock");
       ptr->AddMethod<::memo::vs::InsertMutableBlockRequest, ::memo::vs::InsertMutableBlockResponse, true>
         (dht.insert_mutable_block, dht,"/memo.vs.ValueStore/InsertMutableBlock");
+      ptr->AddMethod<::memo::vs::InsertObjectRequest, ::memo::vs::InsertObjectResponse, true>
+        (dht.insert_object, dht,"/memo.vs.ValueStore/InsertObject");
+      ptr->AddMethod<::memo::vs::ReadObjectRequest, ::memo::vs::ReadObjectResponse>
+        (dht.read_object, dht, "/memo.vs.ValueStore/ReadObject");
+      ptr->AddMethod<::memo::vs::BeginObjectRequest, ::memo::vs::BeginObjectResponse, true>
+        (dht.begin_object, dht, "/memo.vs.ValueStore/BeginObject");
+      ptr->AddMethod<::memo::vs::AppendObjectRequest, ::memo::vs::AppendObjectResponse, true>
+        (dht.append_object, dht, "/memo.vs.ValueStore/AppendObject");
+      ptr->AddMethod<::memo::vs::CommitObjectRequest, ::memo::vs::CommitObjectResponse, true>
+        (dht.commit_object, dht, "/memo.vs.ValueStore/CommitObject");
       ptr->AddMethod<::memo::vs::DeleteRequest, ::memo::vs::DeleteResponse>
         (dht.remove, dht, "/memo.vs.ValueStore/Delete");
       ptr->AddMethod<::memo::vs::MakeNamedBlockRequest, ::memo::vs::Block, true>
@@ -86,6 +86,18 @@ namespace memo
       return Address(Address::random().value(), flags, true);
     }
 
+    bool
+    Address::has_flags(Flags flags) const
+    {
+      return (this->_value[flag_byte] & flags) == flags;
+    }
+
+    Address
+    Address::with_flags(Flags flags) const
+    {
+      return Address(this->_value, this->_value[flag_byte] | flags, true);
+    }
+
     Address const Address::null;
 
     int
@@ -19,6 +19,10 @@ namespace memo
     {
       static const uint8_t mutable_block = 0;
       static const uint8_t immutable_block = 1;
+      /// Immutable block stored as erasure-coded fragments.
+      static const uint8_t erasure_coded = 2;
+      /// Immutable block addressed by the tree hash of its payload.
+      static const uint8_t tree_hash = 4;
     }
 
     class Address
@@ -51,6 +55,12 @@ namespace memo
       static
       Address
       random(Flags flags);
+      /// Whether all of `flags` are set in the flag byte.
+      bool
+      has_flags(Flags flags) const;
+      /// This address with `flags` added to its flag byte.
+      Address
+      with_flags(Flags flags) const;
       /// A default initialized Address.
       static Address const null;
     private:
@@ -1,8 +1,16 @@
+#include <algorithm>
+#include <list>
+
+#include <elle/With.hh>
 #include <elle/log.hh>
+#include <elle/print.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
 
 #include <memo/model/Conflict.hh>
 #include <memo/model/MissingBlock.hh>
 #include <memo/model/Model.hh>
+#include <memo/model/Object.hh>
 #include <memo/model/blocks/ACLBlock.hh>
 #include <memo/model/blocks/ImmutableBlock.hh>
 #include <memo/model/blocks/MutableBlock.hh>
@@ -43,6 +51,13 @@ namespace memo
         address,
         local_version = boost::optional<int>(),
         decrypt_data = boost::optional<bool>())
+      , prefetch([this] (std::vector<Address> const& addresses)
+                 {
+                   ELLE_TRACE_SCOPE("%s: prefetch %s blocks",
+                                    this, addresses.size());
+                   this->_prefetch(addresses);
+                 },
+                 addresses)
       , insert([this] (std::unique_ptr<blocks::Block> block,
                        std::unique_ptr<ConflictResolver> resolver)
                {
@@ -74,6 +89,76 @@ namespace memo
         },
         data,
         owner = Address::null)
+      , insert_object([this] (elle::Buffer data, Address owner)
+        {
+          ELLE_TRACE_SCOPE("%s: insert object of %s bytes with owner %f",
+                           this, data.size(), owner);
+          ObjectWriter writer(*this, owner);
+          writer.write(data);
+          return writer.close();
+        },
+        data,
+        owner = Address::null)
+      , read_object([this] (Address address, int64_t offset, int64_t length)
+        {
+          ELLE_TRACE_SCOPE("%s: read %s bytes of object %f at %s",
+                           this, length, address, offset);
+          return this->_object_reader(address)->read(offset, length);
+        },
+        address,
+        offset = int64_t(0),
+        length = int64_t(-1))
+      , begin_object([this] (Address owner)
+        {
+          auto const now = elle::Clock::now();
+          for (auto it = this->_object_sessions.begin();
+               it != this->_object_sessions.end();)
+            if (now - it->second->used > object::session_timeout())
+            {
+              ELLE_TRACE("%s: drop idle object session %s", this, it->first);
+              it = this->_object_sessions.erase(it);
+            }
+            else
+              ++it;
+          auto const id = ++this->_object_session_next;
+          ELLE_TRACE_SCOPE("%s: begin object session %s with owner %f",
+                           this, id, owner);
+          this->_object_sessions.emplace(
+            id, std::make_shared<object::Session>(*this, owner));
+          return id;
+        },
+        owner = Address::null)
+      , append_object([this] (int64_t id, elle::Buffer data)
+        {
+          ELLE_TRACE_SCOPE("%s: append %s bytes to object session %s",
+                           this, data.size(), id);
+          auto const s = this->_object_session(id);
+          elle::reactor::Lock lock(s->mutex);
+          try
+          {
+            s->writer.write(data);
+          }
+          catch (...)
+          {
+            // The writer may hold part of the data: the object is lost.
+            this->_object_sessions.erase(id);
+            throw;
+          }
+          s->used = elle::Clock::now();
+          return s->writer.size();
+        },
+        session,
+        data)
+      , commit_object([this] (int64_t id)
+        {
+          ELLE_TRACE_SCOPE("%s: commit object session %s", this, id);
+          auto const s = this->_object_session(id);
+          // Forget the session first, so no append slips in after closing.
+          this->_object_sessions.erase(id);
+          elle::reactor::Lock lock(s->mutex);
+          return s->writer.close();
+        },
+        session)
       , update([this] (std::unique_ptr<blocks::Block> block,
                        std::unique_ptr<ConflictResolver> resolver,
                        bool decypher)
@@ -109,6 +194,9 @@ namespace memo
                },
                address,
                signature = boost::none)
+      , _object_sessions()
+      , _object_session_next(0)
+      , _object_readers()
     {
       ELLE_LOG_COMPONENT("memo.model.Model");
       ELLE_LOG("%s: compatibility version %s", this, this->_version);
@@ -118,6 +206,40 @@ namespace memo
           this->_version, memo::version());
     }
 
+    /*--------.
+    | Objects |
+    `--------*/
+
+    std::shared_ptr<ObjectReader const>
+    Model::_object_reader(Address address)
+    {
+      auto& readers = this->_object_readers;
+      auto it = std::find_if(
+        readers.begin(), readers.end(),
+        [&] (auto const& r) { return r->address() == address; });
+      if (it != readers.end())
+      {
+        readers.splice(readers.begin(), readers, it);
+        return readers.front();
+      }
+      // Objects are immutable: the index read once stays valid.
+      auto res = std::make_shared<ObjectReader const>(*this, address);
+      readers.push_front(res);
+      while (readers.size() > std::size_t(std::max(object::readers(), 0)))
+        readers.pop_back();
+      return res;
+    }
+
+    std::shared_ptr<object::Session>
+    Model::_object_session(int64_t id)
+    {
+      auto const it = this->_object_sessions.find(id);
+      if (it == this->_object_sessions.end())
+        elle::err("unknown object session %s", id);
+      it->second->used = elle::Clock::now();
+      return it->second;
+    }
+
     /*-------.
     | Blocks |
     `-------*/
@@ -245,16 +367,36 @@ namespace memo
                       ReceiveBlock res) const
     {
       ELLE_TRACE_SCOPE("%s: fetch %s blocks", this, addresses.size());
-      this->_fetch(addresses, [&](Address addr,
-                                  std::unique_ptr<blocks::Block> block,
-                                  std::exception_ptr exception)
-        {
-          if (block && !block->validate(*this, false))
-            res(addr, {},
-                std::make_exception_ptr(elle::Error("invalid block")));
-          else
-            res(addr, std::move(block), exception);
-        });
+      // Validate blocks concurrently, so their signature checks run in
+      // parallel in the background pool.
+      auto fetched =
+        std::list<std::pair<Address, std::unique_ptr<blocks::Block>>>{};
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+      {
+        this->_fetch(addresses, [&](Address addr,
+                                    std::unique_ptr<blocks::Block> block,
+                                    std::exception_ptr exception)
+          {
+            if (!block)
+            {
+              res(addr, {}, exception);
+              return;
+            }
+            fetched.emplace_back(addr, std::move(block));
+            auto it = std::prev(fetched.end());
+            scope.run_background(
+              elle::print("validate {}", addr),
+              [&, it]
+              {
+                if (it->second->validate(*this, false))
+                  res(it->first, std::move(it->second), {});
+                else
+                  res(it->first, {},
+                      std::make_exception_ptr(elle::Error("invalid block")));
+              });
+          });
+        elle::reactor::wait(scope);
+      };
     }
 
     void
@@ -275,6 +417,10 @@ namespace memo
       }
     }
 
+    void
+    Model::_prefetch(std::vector<Address> const&) const
+    {}
+
     void
     Model::seal_and_insert(blocks::Block& block,
                            std::unique_ptr<ConflictResolver> resolver)
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <list>
 #include <memory>
+#include <unordered_map>
 
 #include <boost/filesystem.hpp>
 
@@ -22,16 +24,26 @@ namespace memo
   namespace model
   {
     ELLE_DAS_SYMBOL(address);
+    ELLE_DAS_SYMBOL(addresses);
     ELLE_DAS_SYMBOL(block);
     ELLE_DAS_SYMBOL(conflict_resolver);
     ELLE_DAS_SYMBOL(data);
     ELLE_DAS_SYMBOL(decrypt_data);
     ELLE_DAS_SYMBOL(key);
+    ELLE_DAS_SYMBOL(length);
     ELLE_DAS_SYMBOL(local_version);
+    ELLE_DAS_SYMBOL(offset);
     ELLE_DAS_SYMBOL(owner);
+    ELLE_DAS_SYMBOL(session);
     ELLE_DAS_SYMBOL(signature);
     ELLE_DAS_SYMBOL(version);
 
+    class ObjectReader;
+    namespace object
+    {
+      struct Session;
+    }
+
     enum StoreMode
     {
       STORE_INSERT,
@@ -202,6 +214,16 @@ namespace memo
       multifetch(std::vector<AddressVersion> const& addresses,
                  ReceiveBlock res) const;
 
+      /// Fetch blocks in the background, in anticipation of reads.
+      ///
+      /// Best effort: nothing is fetched by models without a cache, and
+      /// failures are ignored.
+      ///
+      /// @param addresses Addresses of the blocks to fetch.
+      elle::das::named::Function<
+        void (decltype(addresses)::Formal<std::vector<Address>>)>
+      prefetch;
+
       /// Insert a new block.
       ///
       /// @param block             New block to insert.
@@ -233,6 +255,60 @@ namespace memo
           decltype(owner = Address::null))>
       insert_mutable_block;
 
+      /// Insert a large object from data.
+      ///
+      /// The payload is split in immutable blocks, see ObjectWriter.
+      ///
+      /// @param data  Payload of the object.
+      /// @param owner Optional owning mutable block to restrict deletion.
+      /// @return The address of the object.
+      elle::das::named::Function<
+        Address(
+          decltype(data)::Formal<elle::Buffer>,
+          decltype(owner = Address::null))>
+      insert_object;
+
+      /// Read a range of a large object.
+      ///
+      /// @param address Address of the object.
+      /// @param offset  Offset of the first byte to read.
+      /// @param length  Number of bytes to read, up to the end if not positive.
+      elle::das::named::Function<
+        elle::Buffer(
+          decltype(address)::Formal<Address>,
+          decltype(offset = int64_t(0)),
+          decltype(length = int64_t(-1)))>
+      read_object;
+
+      /// Start writing a large object piecewise.
+      ///
+      /// Sessions idle for `object::session_timeout()` are dropped.
+      ///
+      /// @param owner Optional owning mutable block to restrict deletion.
+      /// @return The session to pass to append_object and commit_object.
+      elle::das::named::Function<
+        int64_t(decltype(owner = Address::null))>
+      begin_object;
+
+      /// Append data to an object being written.
+      ///
+      /// @param session Session returned by begin_object.
+      /// @param data    Next bytes of the object.
+      /// @return The number of bytes written so far.
+      elle::das::named::Function<
+        int64_t(
+          decltype(session)::Formal<int64_t>,
+          decltype(data)::Formal<elle::Buffer>)>
+      append_object;
+
+      /// Store the remaining blocks of an object being written.
+      ///
+      /// @param session Session returned by begin_object.
+      /// @return The address of the object.
+      elle::das::named::Function<
+        Address(decltype(session)::Formal<int64_t>)>
+      commit_object;
+
       void
       seal_and_insert(blocks::Block& block,
                       std::unique_ptr<ConflictResolver> = {});
@@ -258,6 +334,20 @@ namespace memo
       remove;
 
     private:
+      /// Reader of the object at `address`, reusing recently opened ones.
+      std::shared_ptr<ObjectReader const>
+      _object_reader(Address address);
+      /// Session `id`, refreshed.
+      std::shared_ptr<object::Session>
+      _object_session(int64_t id);
+      /// Objects being written, by session.
+      ELLE_ATTRIBUTE(
+        (std::unordered_map<int64_t, std::shared_ptr<object::Session>>),
+        object_sessions);
+      ELLE_ATTRIBUTE(int64_t, object_session_next);
+      /// Recently read objects, most recently used first.
+      ELLE_ATTRIBUTE(std::list<std::shared_ptr<ObjectReader const>>,
+                     object_readers);
       std::unique_ptr<blocks::Block>
       _fetch_impl(Address address,
                   boost::optional<int> local_version,
@@ -299,6 +389,9 @@ namespace memo
              ReceiveBlock res) const;
       virtual
       void
+      _prefetch(std::vector<Address> const& addresses) const;
+      virtual
+      void
       _insert(std::unique_ptr<blocks::Block> block,
               std::unique_ptr<ConflictResolver> resolver) = 0;
       virtual
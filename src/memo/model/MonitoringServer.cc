@@ -9,7 +9,10 @@
 #include <elle/reactor/network/Error.hh>
 #include <elle/reactor/Scope.hh>
 
+#include <memo/model/doughnut/Compression.hh>
 #include <memo/model/doughnut/Doughnut.hh>
+#include <memo/model/doughnut/SignatureCache.hh>
+#include <memo/model/doughnut/crypto.hh>
 
 ELLE_LOG_COMPONENT("memo.model.MonitoringServer");
 
@@ -207,11 +210,16 @@ namespace memo
               case Query::Stats:
               {
                 auto res = elle::json::Json{
+                  {"compression", doughnut::compression::stats()},
                   {"consensus", this->_owner.consensus()->stats()},
+                  {"crypto", doughnut::crypto_stats()},
+                  {"handshakes", this->_owner.dock().handshake_stats()},
                   {"overlay", this->_owner.overlay()->stats()},
                   {"peers", this->_owner.overlay()->peer_list()},
                   {"protocol", elle::sprintf("%s", this->_owner.protocol())},
                   {"redundancy", this->_owner.consensus()->redundancy()},
+                  {"secrets", this->_owner.secret_cache().stats()},
+                  {"signatures", doughnut::SignatureCache::instance().stats()},
                 };
                 return std::make_unique<MonitorResponse>(true, boost::none, res);
               }
@@ -0,0 +1,458 @@
+#include <memo/model/Object.hh>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <elle/With.hh>
+#include <elle/finally.hh>
+#include <elle/log.hh>
+#include <elle/print.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/signal.hh>
+#include <elle/serialization/binary.hh>
+
+#include <memo/environ.hh>
+#include <memo/model/MissingBlock.hh>
+#include <memo/model/blocks/ImmutableBlock.hh>
+
+ELLE_LOG_COMPONENT("memo.model.Object");
+
+namespace memo
+{
+  namespace model
+  {
+    namespace object
+    {
+      int
+      chunk_size()
+      {
+        static auto const res =
+          memo::getenv("OBJECT_CHUNK_SIZE", 1024 * 1024);
+        return res;
+      }
+
+      int
+      fanout()
+      {
+        static auto const res = memo::getenv("OBJECT_FANOUT", 1024);
+        return res;
+      }
+
+      int
+      window()
+      {
+        static auto const res = memo::getenv("OBJECT_WINDOW", 8);
+        return res;
+      }
+
+      int
+      readers()
+      {
+        static auto const res = memo::getenv("OBJECT_READERS", 16);
+        return res;
+      }
+
+      elle::Duration
+      session_timeout()
+      {
+        static auto const res = std::chrono::seconds(
+          memo::getenv("OBJECT_SESSION_TIMEOUT", 600));
+        return res;
+      }
+
+      Session::Session(Model& model, Address owner)
+        : writer(model, owner)
+        , used(elle::Clock::now())
+      {}
+
+      Entry::Entry(Address address_, int64_t size_, bool index_)
+        : address(address_)
+        , size(size_)
+        , index(index_)
+      {}
+
+      Entry::Entry(elle::serialization::SerializerIn& s)
+        : address()
+        , size(0)
+        , index(false)
+      {
+        this->serialize(s);
+      }
+
+      void
+      Entry::serialize(elle::serialization::Serializer& s)
+      {
+        s.serialize("address", this->address);
+        s.serialize("size", this->size);
+        s.serialize("index", this->index);
+      }
+
+      Index::Index(std::vector<Entry> entries_)
+        : entries(std::move(entries_))
+      {}
+
+      Index::Index(elle::serialization::SerializerIn& s)
+      {
+        this->serialize(s);
+      }
+
+      void
+      Index::serialize(elle::serialization::Serializer& s)
+      {
+        s.serialize("entries", this->entries);
+      }
+
+      int64_t
+      Index::size() const
+      {
+        auto res = int64_t(0);
+        for (auto const& e: this->entries)
+          res += e.size;
+        return res;
+      }
+
+      namespace
+      {
+        Index
+        decode(blocks::Block const& block)
+        {
+          try
+          {
+            return elle::serialization::binary::deserialize<Index>(
+              block.data(), false);
+          }
+          catch (elle::Error const& e)
+          {
+            elle::err("%f is not an object index: %s", block.address(), e);
+          }
+        }
+      }
+    }
+
+    /*-------------.
+    | ObjectWriter |
+    `-------------*/
+
+    ObjectWriter::ObjectWriter(Model& model,
+                               Address owner,
+                               int chunk_size,
+                               int window,
+                               int fanout)
+      : _model(model)
+      , _owner(owner)
+      , _chunk_size(chunk_size)
+      , _fanout(fanout)
+      , _size(0)
+      , _address()
+      , _chunk()
+      , _entries()
+      , _window(window)
+      , _inserts()
+      , _error()
+    {
+      if (chunk_size < 1)
+        elle::err("invalid object chunk size: %s", chunk_size);
+      if (fanout < 2)
+        elle::err("invalid object index fanout: %s", fanout);
+      if (window < 1)
+        elle::err("invalid object window: %s", window);
+    }
+
+    ObjectWriter::~ObjectWriter()
+    {
+      if (!this->_address)
+        ELLE_TRACE("%s: discard unfinished object of %s bytes",
+                   this, this->_size);
+    }
+
+    void
+    ObjectWriter::write(elle::ConstWeakBuffer data)
+    {
+      if (this->_address)
+        elle::err("%s: write after close", this);
+      ELLE_DEBUG_SCOPE("%s: write %s bytes", this, data.size());
+      auto p = data.contents();
+      auto left = data.size();
+      while (left)
+      {
+        if (this->_chunk.capacity() < std::size_t(this->_chunk_size))
+          this->_chunk.capacity(this->_chunk_size);
+        auto const n = std::min<std::size_t>(
+          left, this->_chunk_size - this->_chunk.size());
+        this->_chunk.append(p, n);
+        p += n;
+        left -= n;
+        this->_size += n;
+        if (this->_chunk.size() == std::size_t(this->_chunk_size))
+          this->_flush();
+      }
+    }
+
+    void
+    ObjectWriter::_flush()
+    {
+      auto const size = int64_t(this->_chunk.size());
+      auto chunk = std::move(this->_chunk);
+      this->_chunk = elle::Buffer();
+      this->_entries.emplace_back(this->_insert(std::move(chunk)), size, false);
+    }
+
+    Address
+    ObjectWriter::_insert(elle::Buffer data)
+    {
+      this->_check();
+      while (!this->_window.acquire())
+        elle::reactor::wait(this->_window);
+      this->_check();
+      auto block = std::shared_ptr<blocks::ImmutableBlock>(
+        this->_model.make_immutable_block(std::move(data), this->_owner));
+      auto const address = block->address();
+      this->_inserts.erase(
+        std::remove_if(this->_inserts.begin(), this->_inserts.end(),
+                       [] (elle::reactor::Thread::unique_ptr const& t)
+                       {
+                         return t->done();
+                       }),
+        this->_inserts.end());
+      this->_inserts.emplace_back(
+        new elle::reactor::Thread(
+          elle::print("{}: insert {}", this, address),
+          [this, block]
+          {
+            elle::SafeFinally release([this] { this->_window.release(); });
+            try
+            {
+              this->_model.insert(block->clone());
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("%s: unable to insert %f: %s",
+                        this, block->address(), e);
+              if (!this->_error)
+                this->_error = std::current_exception();
+            }
+          }));
+      return address;
+    }
+
+    void
+    ObjectWriter::_check() const
+    {
+      if (this->_error)
+        std::rethrow_exception(this->_error);
+    }
+
+    Address
+    ObjectWriter::close()
+    {
+      if (this->_address)
+        return *this->_address;
+      ELLE_TRACE_SCOPE("%s: close object of %s bytes", this, this->_size);
+      if (this->_chunk.size())
+        this->_flush();
+      auto entries = std::move(this->_entries);
+      while (entries.size() > std::size_t(this->_fanout))
+      {
+        auto next = std::vector<object::Entry>{};
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+          auto const end = it + std::min<std::ptrdiff_t>(
+            this->_fanout, entries.end() - it);
+          auto const index = object::Index({it, end});
+          next.emplace_back(
+            this->_insert(
+              elle::serialization::binary::serialize(index, false)),
+            index.size(), true);
+          it = end;
+        }
+        entries = std::move(next);
+      }
+      // Insert the root last, so the object is only reachable once complete.
+      for (auto const& t: this->_inserts)
+        elle::reactor::wait(*t);
+      this->_inserts.clear();
+      this->_check();
+      auto root = this->_model.make_immutable_block(
+        elle::serialization::binary::serialize(
+          object::Index(std::move(entries)), false),
+        this->_owner);
+      auto const address = root->address();
+      this->_model.insert(std::unique_ptr<blocks::Block>(std::move(root)));
+      this->_address = address;
+      ELLE_DEBUG("%s: stored as %f", this, address);
+      return address;
+    }
+
+    void
+    ObjectWriter::print(std::ostream& out) const
+    {
+      elle::fprintf(out, "ObjectWriter(%x)",
+                    reinterpret_cast<void const*>(this));
+    }
+
+    /*-------------.
+    | ObjectReader |
+    `-------------*/
+
+    ObjectReader::ObjectReader(Model const& model,
+                               Address address,
+                               int window)
+      : _model(model)
+      , _address(address)
+      , _window(std::max(window, 1))
+      , _size(0)
+      , _chunks()
+      , _offsets()
+    {
+      ELLE_TRACE_SCOPE("%s: open", this);
+      {
+        auto root = this->_model.fetch(address);
+        this->_chunks = object::decode(*root).entries;
+      }
+      // Expand index blocks level by level, fetching each level at once.
+      while (true)
+      {
+        auto indexes = std::vector<Model::AddressVersion>{};
+        for (auto const& e: this->_chunks)
+          if (e.index)
+            indexes.emplace_back(e.address, boost::none);
+        if (indexes.empty())
+          break;
+        ELLE_DEBUG("fetch %s index blocks", indexes.size());
+        auto loaded = std::unordered_map<Address, object::Index>{};
+        auto error = std::exception_ptr{};
+        this->_model.multifetch(
+          indexes,
+          [&] (Address addr,
+               std::unique_ptr<blocks::Block> block,
+               std::exception_ptr exception)
+          {
+            if (!block)
+            {
+              if (!error)
+                error = exception ? exception :
+                  std::make_exception_ptr(MissingBlock(addr));
+              return;
+            }
+            try
+            {
+              loaded.emplace(addr, object::decode(*block));
+            }
+            catch (elle::Error const&)
+            {
+              if (!error)
+                error = std::current_exception();
+            }
+          });
+        if (error)
+          std::rethrow_exception(error);
+        auto expanded = std::vector<object::Entry>{};
+        for (auto& e: this->_chunks)
+          if (e.index)
+          {
+            auto const& index = loaded.at(e.address);
+            if (index.size() != e.size)
+              elle::err("index %f holds %s bytes instead of %s",
+                        e.address, index.size(), e.size);
+            expanded.insert(
+              expanded.end(), index.entries.begin(), index.entries.end());
+          }
+          else
+            expanded.emplace_back(std::move(e));
+        this->_chunks = std::move(expanded);
+      }
+      this->_offsets.reserve(this->_chunks.size());
+      for (auto const& c: this->_chunks)
+      {
+        this->_offsets.emplace_back(this->_size);
+        this->_size += c.size;
+      }
+      ELLE_DEBUG("%s bytes in %s chunks", this->_size, this->_chunks.size());
+    }
+
+    void
+    ObjectReader::read(Consumer const& consume,
+                       int64_t offset,
+                       int64_t length) const
+    {
+      if (offset < 0 || offset > this->_size)
+        elle::err("offset %s is out of object of %s bytes",
+                  offset, this->_size);
+      // Compare to the remaining size, offset + length may overflow.
+      auto const end = length <= 0 || length >= this->_size - offset ?
+        this->_size : offset + length;
+      ELLE_TRACE_SCOPE("%s: read [%s, %s)", this, offset, end);
+      if (end <= offset)
+        return;
+      auto const first = std::upper_bound(
+        this->_offsets.begin(), this->_offsets.end(), offset) -
+        this->_offsets.begin() - 1;
+      auto const last = std::lower_bound(
+        this->_offsets.begin(), this->_offsets.end(), end) -
+        this->_offsets.begin();
+      // Chunks are released as soon as consumed, the window bounding the
+      // number of chunks fetched ahead of the consumer.
+      auto fetched = std::vector<boost::optional<elle::Buffer>>(last - first);
+      auto window = elle::reactor::Semaphore(this->_window);
+      auto arrived = elle::reactor::Signal();
+      elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+      {
+        scope.run_background(
+          elle::print("{}: fetch chunks", this),
+          [&]
+          {
+            for (auto i = first; i < last; ++i)
+            {
+              while (!window.acquire())
+                elle::reactor::wait(window);
+              auto const& chunk = this->_chunks[i];
+              scope.run_background(
+                elle::print("{}: fetch {}", this, chunk.address),
+                [&, i]
+                {
+                  auto const& chunk = this->_chunks[i];
+                  auto data = this->_model.fetch(chunk.address)->take_data();
+                  if (int64_t(data.size()) != chunk.size)
+                    elle::err("chunk %f holds %s bytes instead of %s",
+                              chunk.address, data.size(), chunk.size);
+                  fetched[i - first] = std::move(data);
+                  arrived.signal();
+                });
+            }
+          });
+        for (auto i = first; i < last; ++i)
+        {
+          auto& data = fetched[i - first];
+          while (!data)
+            elle::reactor::wait(arrived);
+          auto const start = this->_offsets[i];
+          auto const from = std::max(offset, start) - start;
+          auto const to = std::min(end, start + this->_chunks[i].size) - start;
+          consume(elle::ConstWeakBuffer(data->contents() + from, to - from));
+          data.reset();
+          window.release();
+        }
+        elle::reactor::wait(scope);
+      };
+    }
+
+    elle::Buffer
+    ObjectReader::read(int64_t offset, int64_t length) const
+    {
+      auto res = elle::Buffer{};
+      this->read([&] (elle::ConstWeakBuffer data)
+                 {
+                   res.append(data.contents(), data.size());
+                 },
+                 offset, length);
+      return res;
+    }
+
+    void
+    ObjectReader::print(std::ostream& out) const
+    {
+      elle::fprintf(out, "ObjectReader(%f)", this->_address);
+    }
+  }
+}
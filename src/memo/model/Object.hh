@@ -0,0 +1,182 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <elle/Buffer.hh>
+#include <elle/Duration.hh>
+#include <elle/attribute.hh>
+#include <elle/reactor/mutex.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/semaphore.hh>
+
+#include <memo/model/Address.hh>
+#include <memo/model/Model.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    /// Large objects, stored as trees of immutable blocks.
+    ///
+    /// Payloads are split in fixed-size chunks, each stored in its own
+    /// immutable block.  Index blocks list the chunks in order along with
+    /// their size, and are themselves listed by upper index blocks when
+    /// there are more than `fanout` of them.  The address of an object is
+    /// the address of its root index block, which is inserted last: an
+    /// object is only reachable once all its blocks are stored.
+    namespace object
+    {
+      /// Default chunk size, from MEMO_OBJECT_CHUNK_SIZE.
+      int
+      chunk_size();
+      /// Default number of entries per index block, from MEMO_OBJECT_FANOUT.
+      int
+      fanout();
+      /// Default number of chunks in flight, from MEMO_OBJECT_WINDOW.
+      int
+      window();
+      /// Number of opened objects kept by Model::read_object, from
+      /// MEMO_OBJECT_READERS.
+      int
+      readers();
+      /// Time after which idle write sessions are dropped, from
+      /// MEMO_OBJECT_SESSION_TIMEOUT in seconds.
+      elle::Duration
+      session_timeout();
+
+      /// Entry of an index block.
+      struct Entry
+      {
+        Entry(Address address, int64_t size, bool index);
+        Entry(elle::serialization::SerializerIn& s);
+        void
+        serialize(elle::serialization::Serializer& s);
+        /// Address of the chunk or of the index block.
+        Address address;
+        /// Number of bytes of the object under this entry.
+        int64_t size;
+        /// Whether this entry is an index block.
+        bool index;
+      };
+
+      /// Content of an index block.
+      struct Index
+      {
+        Index(std::vector<Entry> entries = {});
+        Index(elle::serialization::SerializerIn& s);
+        void
+        serialize(elle::serialization::Serializer& s);
+        /// Number of bytes of the object under this index.
+        int64_t
+        size() const;
+        std::vector<Entry> entries;
+      };
+    }
+
+    /// Write a large object piecewise.
+    ///
+    /// Chunks are inserted in the background as soon as they are complete,
+    /// with at most `window` of them in flight: writes block when the
+    /// window is full.
+    class ObjectWriter
+      : public elle::Printable
+    {
+    public:
+      ObjectWriter(Model& model,
+                   Address owner = Address::null,
+                   int chunk_size = object::chunk_size(),
+                   int window = object::window(),
+                   int fanout = object::fanout());
+      ~ObjectWriter();
+      /// Append `data` to the object.
+      void
+      write(elle::ConstWeakBuffer data);
+      /// Store the remaining blocks and return the object address.
+      Address
+      close();
+      ELLE_ATTRIBUTE_R(Model&, model);
+      ELLE_ATTRIBUTE_R(Address, owner);
+      ELLE_ATTRIBUTE_R(int, chunk_size);
+      ELLE_ATTRIBUTE_R(int, fanout);
+      /// Number of bytes written so far.
+      ELLE_ATTRIBUTE_R(int64_t, size);
+      ELLE_ATTRIBUTE_R(boost::optional<Address>, address);
+    private:
+      /// Insert `data` in the background, returning its address.
+      Address
+      _insert(elle::Buffer data);
+      /// Insert the current chunk.
+      void
+      _flush();
+      /// Rethrow the first insertion failure.
+      void
+      _check() const;
+      ELLE_ATTRIBUTE(elle::Buffer, chunk);
+      ELLE_ATTRIBUTE(std::vector<object::Entry>, entries);
+      ELLE_ATTRIBUTE(elle::reactor::Semaphore, window);
+      ELLE_ATTRIBUTE(std::vector<elle::reactor::Thread::unique_ptr>, inserts);
+      ELLE_ATTRIBUTE(std::exception_ptr, error);
+
+    public:
+      void
+      print(std::ostream& out) const override;
+    };
+
+    /// Read a large object.
+    ///
+    /// Opening the object fetches its index blocks.  Reads then fetch the
+    /// chunks they span in parallel, with at most `window` chunks fetched
+    /// ahead of the one being consumed.
+    class ObjectReader
+      : public elle::Printable
+    {
+    public:
+      /// Function receiving the object content, in order.
+      using Consumer = std::function<auto (elle::ConstWeakBuffer) -> void>;
+      ObjectReader(Model const& model,
+                   Address address,
+                   int window = object::window());
+      /// Pass `length` bytes from `offset` to `consume`, chunk by chunk.
+      ///
+      /// @param length Number of bytes to read, up to the end if not positive.
+      void
+      read(Consumer const& consume,
+           int64_t offset = 0,
+           int64_t length = -1) const;
+      /// Read `length` bytes from `offset`.
+      ///
+      /// @param length Number of bytes to read, up to the end if not positive.
+      elle::Buffer
+      read(int64_t offset = 0, int64_t length = -1) const;
+      ELLE_ATTRIBUTE_R(Model const&, model);
+      ELLE_ATTRIBUTE_R(Address, address);
+      ELLE_ATTRIBUTE_R(int, window);
+      /// Object size in bytes.
+      ELLE_ATTRIBUTE_R(int64_t, size);
+      /// Chunks, in order.
+      ELLE_ATTRIBUTE_R(std::vector<object::Entry>, chunks);
+    private:
+      /// Offset of every chunk.
+      ELLE_ATTRIBUTE(std::vector<int64_t>, offsets);
+
+    public:
+      void
+      print(std::ostream& out) const override;
+    };
+
+    namespace object
+    {
+      /// Object written piecewise through Model::append_object.
+      struct Session
+      {
+        Session(Model& model, Address owner);
+        ObjectWriter writer;
+        /// Serialize appends, so data is written in order.
+        elle::reactor::Mutex mutex;
+        /// Last use, to drop abandoned sessions.
+        elle::Time used;
+      };
+    }
+  }
+}
@@ -45,7 +45,9 @@ namespace memo
       std::unique_ptr<Block>
       Block::clone() const
       {
-        return std::make_unique<Block>(this->address(), this->data());
+        auto res = std::make_unique<Block>(this->address());
+        res->_data = this->_data;
+        return res;
       }
 
       /*--------.
@@ -55,7 +57,13 @@ namespace memo
       elle::Buffer
       Block::take_data()
       {
-        return std::move(this->_data);
+        return this->_data.take();
+      }
+
+      elle::Buffer const&
+      Block::data() const
+      {
+        return this->_data;
       }
 
       bool
@@ -64,6 +72,12 @@ namespace memo
         return rhs._address == this->_address && rhs._data == this->_data;
       }
 
+      std::size_t
+      Block::footprint() const
+      {
+        return sizeof(*this) + this->_data.size();
+      }
+
       /*-----------.
       | Validation |
       `-----------*/
@@ -166,7 +180,7 @@ namespace memo
                        elle::Version const&)
       {
         s.serialize("address", this->_address);
-        s.serialize("data", this->_data);
+        this->_data.serialize(s, "data");
         s.serialize("owner", this->_owner);
       }
 
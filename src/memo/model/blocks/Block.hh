@@ -7,6 +7,7 @@
 #include <elle/cryptography/rsa/PublicKey.hh>
 
 #include <memo/model/Address.hh>
+#include <memo/model/blocks/SharedBuffer.hh>
 #include <memo/model/blocks/ValidationResult.hh>
 #include <memo/model/fwd.hh>
 #include <memo/model/prometheus.hh>
@@ -136,10 +137,20 @@ namespace memo
         virtual
         bool
         operator ==(Block const& rhs) const;
+        /// Move the payload out.
+        virtual
         elle::Buffer
         take_data();
+        /// Approximate memory used by the block, without decoding it.
+        virtual
+        std::size_t
+        footprint() const;
         ELLE_ATTRIBUTE_R(Address, address, protected);
-        ELLE_ATTRIBUTE_R(elle::Buffer, data, protected, virtual);
+        ELLE_attribute_r(elle::Buffer, data, virtual);
+      protected:
+        /// Shared with clones until either modifies it.
+        SharedBuffer _data;
+      public:
         ELLE_ATTRIBUTE_R(Address, owner);
 
       /*-----------.
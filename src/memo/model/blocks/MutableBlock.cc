@@ -25,7 +25,7 @@ namespace memo
       void
       MutableBlock::data(std::function<void (elle::Buffer&)> transformation)
       {
-        transformation(this->_data);
+        transformation(this->_data.mutate());
         this->_data_changed = true;
       }
 
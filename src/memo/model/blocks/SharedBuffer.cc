@@ -0,0 +1,97 @@
+#include <memo/model/blocks/SharedBuffer.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace blocks
+    {
+      SharedBuffer::SharedBuffer(elle::Buffer buffer)
+        : _buffer(std::make_shared<elle::Buffer>(std::move(buffer)))
+      {}
+
+      SharedBuffer&
+      SharedBuffer::operator =(elle::Buffer buffer)
+      {
+        // Don't write through to other copies.
+        this->_buffer = std::make_shared<elle::Buffer>(std::move(buffer));
+        return *this;
+      }
+
+      elle::Buffer const&
+      SharedBuffer::get() const
+      {
+        return *this->_buffer;
+      }
+
+      SharedBuffer::operator elle::Buffer const&() const
+      {
+        return *this->_buffer;
+      }
+
+      elle::Buffer&
+      SharedBuffer::mutate()
+      {
+        if (this->shared())
+          this->_buffer = std::make_shared<elle::Buffer>(*this->_buffer);
+        return *this->_buffer;
+      }
+
+      elle::Buffer
+      SharedBuffer::take()
+      {
+        auto res = this->shared()
+          ? elle::Buffer(*this->_buffer)
+          : std::move(*this->_buffer);
+        this->_buffer = std::make_shared<elle::Buffer>();
+        return res;
+      }
+
+      elle::Buffer::Size
+      SharedBuffer::size() const
+      {
+        return this->_buffer->size();
+      }
+
+      bool
+      SharedBuffer::empty() const
+      {
+        return this->_buffer->empty();
+      }
+
+      bool
+      SharedBuffer::shared() const
+      {
+        return this->_buffer.use_count() > 1;
+      }
+
+      bool
+      SharedBuffer::operator ==(SharedBuffer const& other) const
+      {
+        return this->_buffer == other._buffer
+          || *this->_buffer == *other._buffer;
+      }
+
+      void
+      SharedBuffer::serialize(elle::serialization::Serializer& s,
+                              std::string const& name)
+      {
+        if (s.in())
+        {
+          auto buffer = elle::Buffer{};
+          s.serialize(name, buffer);
+          *this = std::move(buffer);
+        }
+        else
+          // Serializing out leaves the buffer untouched, no need to detach.
+          s.serialize(name, *this->_buffer);
+      }
+
+      std::ostream&
+      operator <<(std::ostream& output, SharedBuffer const& buffer)
+      {
+        return output << buffer.get();
+      }
+    }
+  }
+}
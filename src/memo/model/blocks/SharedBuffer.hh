@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+
+#include <elle/Buffer.hh>
+#include <elle/serialization/Serializer.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace blocks
+    {
+      /// Reference-counted buffer, copied on write.
+      ///
+      /// Copies share the same bytes until one of them is mutated, so blocks
+      /// can be cloned without duplicating their payload.
+      class SharedBuffer
+      {
+      public:
+        SharedBuffer(elle::Buffer buffer = {});
+        SharedBuffer&
+        operator =(elle::Buffer buffer);
+        /// The contents.
+        elle::Buffer const&
+        get() const;
+        operator elle::Buffer const&() const;
+        /// The contents, to be modified, copying them first if shared.
+        elle::Buffer&
+        mutate();
+        /// Move the contents out, copying them if shared.
+        elle::Buffer
+        take();
+        elle::Buffer::Size
+        size() const;
+        bool
+        empty() const;
+        /// Whether the contents are shared with another copy.
+        bool
+        shared() const;
+        bool
+        operator ==(SharedBuffer const& other) const;
+        /// Serialize as a plain buffer under `name`.
+        void
+        serialize(elle::serialization::Serializer& s, std::string const& name);
+
+      private:
+        std::shared_ptr<elle::Buffer> _buffer;
+      };
+
+      std::ostream&
+      operator <<(std::ostream& output, SharedBuffer const& buffer);
+    }
+  }
+}
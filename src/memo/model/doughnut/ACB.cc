@@ -25,8 +25,11 @@
 #include <memo/model/MissingBlock.hh>
 #include <memo/model/blocks/ImmutableBlock.hh>
 #include <memo/model/blocks/GroupBlock.hh>
+#include <memo/model/doughnut/Compression.hh>
 #include <memo/model/doughnut/Doughnut.hh>
 #include <memo/model/doughnut/Group.hh>
+#include <memo/model/doughnut/crypto.hh>
+#include <memo/model/doughnut/SignatureCache.hh>
 #include <memo/model/doughnut/ValidationFailed.hh>
 #include <memo/model/doughnut/User.hh>
 #include <memo/model/doughnut/UB.hh>
@@ -189,6 +192,18 @@ namespace memo
         return this->_data_version;
       }
 
+      template <typename Block>
+      std::size_t
+      BaseACB<Block>::footprint() const
+      {
+        auto res = this->Super::footprint() + this->_owner_token.size();
+        for (auto const& e: this->_acl_entries)
+          res += sizeof(e) + e.token.size();
+        for (auto const& e: this->_acl_group_entries)
+          res += sizeof(e) + e.token.size();
+        return res;
+      }
+
       static
       void
       background_open(elle::Buffer & target,
@@ -199,12 +214,9 @@ namespace memo
         static bool bg = memo::getenv("BACKGROUND_DECODE", true);
         if (bg)
         {
-          elle::With<elle::reactor::Thread::NonInterruptible>() << [&]
-          {
-            elle::reactor::background([&] {
-                target = use_encrypt ? k.decrypt(src, acb_padding) : k.open(src);
-              });
-          };
+          crypto_background([&] {
+              target = use_encrypt ? k.decrypt(src, acb_padding) : k.open(src);
+            });
         }
         else
           target = use_encrypt ? k.decrypt(src, acb_padding) : k.open(src);
@@ -214,29 +226,49 @@ namespace memo
       elle::Buffer
       BaseACB<Block>::_decrypt_data(elle::Buffer const& data) const
       {
+        auto const packed = compression::packed(this->_seal_version);
         if (this->world_readable())
-          return this->_data;
+          return packed ?
+            compression::unpack(this->_data.get()) : this->_data.get();
         bool use_encrypt = this->_seal_version >= elle::Version(0, 7, 0);
         elle::Buffer secret_buffer;
+        auto& secrets = this->doughnut()->secret_cache();
+        auto const cached = [&] (elle::Buffer const& token)
+          {
+            if (auto secret = secrets.find(this->address(), token))
+            {
+              secret_buffer = std::move(*secret);
+              return true;
+            }
+            return false;
+          };
+        auto const open = [&] (elle::Buffer const& token,
+                               elle::cryptography::rsa::PrivateKey const& k)
+          {
+            if (cached(token))
+              return;
+            background_open(secret_buffer, token, k, use_encrypt);
+            secrets.add(this->address(), token, secret_buffer);
+          };
         if (this->owner_private_key())
         {
           ELLE_DEBUG("%s: we are owner", *this);
-          background_open(secret_buffer, this->_owner_token,
-                          *this->owner_private_key(), use_encrypt);
+          open(this->_owner_token, *this->owner_private_key());
         }
         else if (!this->_acl_entries.empty())
         {
           // FIXME: factor searching the token
           for (auto const& e: this->_acl_entries)
             if (e.key == this->doughnut()->keys().K())
-              background_open(secret_buffer, e.token,
-                              this->doughnut()->keys().k(), use_encrypt);
+              open(e.token, this->doughnut()->keys().k());
         }
         if (secret_buffer.empty())
         {
           int idx = 0;
           for (auto const& e: this->_acl_group_entries)
           {
+            // Check we still hold the group key before serving its token
+            // from the cache: members removed from the group lose it.
             try
             {
               Group g(*this->doughnut(), e.key);
@@ -249,7 +281,9 @@ namespace memo
                 ++idx;
                 continue;
               }
-              background_open(secret_buffer, e.token, keys[v].k(), use_encrypt);
+              open(e.token, keys[v].k());
+              if (!secret_buffer.empty())
+                break;
             }
             catch (elle::Error const& e)
             {
@@ -271,7 +305,8 @@ namespace memo
                <elle::cryptography::SecretKey>(secret_buffer);
         }();
         ELLE_DUMP("%s: secret: %s", *this, secret);
-        return secret.decipher(this->_data);
+        auto plain = secret.decipher(this->_data.get());
+        return packed ? compression::unpack(plain) : plain;
       }
 
       /*------------.
@@ -659,7 +694,9 @@ namespace memo
                   return blocks::ValidationResult::failure("group key out of range");
                 auto& key = pubkeys[key_index];
                 ELLE_DEBUG("validating with group key %s: %s", key_index, key);
-                if (!key.verify(this->data_signature(), *this->_data_sign()))
+                if (!SignatureCache::instance().verify(
+                      this->address(), this->_data_version, key,
+                      this->data_signature(), *this->_data_sign()))
                 {
                   ELLE_DEBUG("%s: group author signature invalid", *this);
                   return blocks::ValidationResult::failure("Invalid group key signature");
@@ -674,7 +711,9 @@ namespace memo
             else
             {
               auto& key = entry ? entry->key : *this->owner_key();
-              if (!key.verify(this->data_signature(), *this->_data_sign()))
+              if (!SignatureCache::instance().verify(
+                    this->address(), this->_data_version, key,
+                    this->data_signature(), *this->_data_sign()))
               {
                 ELLE_DEBUG("%s: author signature invalid", *this);
                 return blocks::ValidationResult::failure
@@ -806,6 +845,7 @@ namespace memo
           auto scope = bench.scoped();
           ELLE_TRACE_SCOPE("ACL changed, seal");
           this->_acl_changed = false;
+          this->doughnut()->secret_cache().invalidate(this->address());
           if (this->owner_private_key())
           {
             sign_key = this->owner_private_key();
@@ -854,11 +894,20 @@ namespace memo
           this->_owner_token = use_encrypt ?
             this->owner_key()->encrypt(secret_buffer, acb_padding)
             : this->owner_key()->seal(secret_buffer);
+          // Tokens of the previous secret are gone, spare unwrapping ours.
+          auto& secrets = this->doughnut()->secret_cache();
+          secrets.invalidate(this->address());
+          if (this->owner_private_key())
+            secrets.add(this->address(), this->_owner_token, secret_buffer);
           int idx = 0;
           for (auto& e: this->_acl_entries)
           {
             if (e.read)
+            {
               e.token = use_encrypt ? e.key.encrypt(secret_buffer, acb_padding) : e.key.seal(secret_buffer);
+              if (e.key == this->doughnut()->keys().K())
+                secrets.add(this->address(), e.token, secret_buffer);
+            }
             if (!sign_key && e.key == this->doughnut()->keys().K())
             {
               ELLE_DEBUG("we are editor %s", idx);
@@ -906,11 +955,17 @@ namespace memo
             ELLE_DEBUG("block is world writable");
             sign_key = this->doughnut()->keys().private_key();
           }
+          // Compress before enciphering, ciphertext being incompressible.
+          auto plain = compression::packed(seal_version) ?
+            compression::pack(this->data_plain()) : this->data_plain();
           if (!this->_world_readable)
             this->blocks::MutableBlock::data(
-              key->encipher(this->data_plain()));
+              key->encipher(
+                plain,
+                elle::cryptography::SecretKey::defaults::cipher,
+                this->doughnut()->encrypt_options().mode()));
           else
-            this->blocks::MutableBlock::data(this->data_plain());
+            this->blocks::MutableBlock::data(std::move(plain));
           this->_data_changed = false;
         }
         else
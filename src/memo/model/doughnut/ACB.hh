@@ -109,6 +109,9 @@ namespace memo
         _stored() override;
         bool
         operator ==(blocks::Block const& rhs) const override;
+      public:
+        std::size_t
+        footprint() const override;
 
       /*------------.
       | Permissions |
@@ -1,14 +1,12 @@
-#include <fstream>
-
 #include <boost/filesystem.hpp>
-#include <boost/filesystem/fstream.hpp>
-#include <boost/range/algorithm/sort.hpp>
 
+#include <elle/IOStream.hh>
 #include <elle/os/environ.hh>
 #include <elle/serialization/binary.hh>
 #include <elle/serialization/json.hh>
 #include <elle/bench.hh>
 #include <elle/ScopedAssignment.hh>
+#include <elle/With.hh>
 
 #include <elle/das/model.hh>
 #include <elle/das/serializer.hh>
@@ -28,6 +26,57 @@
 
 ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Async");
 
+namespace
+{
+#if MEMO_ENABLE_PROMETHEUS
+  memo::prometheus::Labels
+  labels(memo::model::doughnut::Doughnut const& dht)
+  {
+    return {{"id", elle::sprintf("%f", dht.id())}};
+  }
+
+  /// A gauge to track the number of pending asynchronous operations.
+  memo::prometheus::GaugePtr
+  make_queued_gauge(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_gauge_family(
+      "memo_async_queued_operations",
+      "How many asynchronous operations are pending");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// A gauge to track the number of asynchronous operations in flight.
+  memo::prometheus::GaugePtr
+  make_in_flight_gauge(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_gauge_family(
+      "memo_async_in_flight_operations",
+      "How many asynchronous operations are being processed");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// A counter of processed asynchronous operations.
+  memo::prometheus::CounterPtr
+  make_processed_counter(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_counter_family(
+      "memo_async_processed_operations",
+      "How many asynchronous operations were processed");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// A counter of the time spent processing asynchronous operations.
+  memo::prometheus::CounterPtr
+  make_latency_counter(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_counter_family(
+      "memo_async_processing_seconds",
+      "How long asynchronous operations took to process");
+    return memo::prometheus::make(family, labels(dht));
+  }
+#endif
+}
+
 namespace memo
 {
   namespace model
@@ -81,6 +130,16 @@ namespace memo
                                 }))
           , _in_push(false)
           , _processed_op_count(0)
+          , _window(std::max(memo::getenv("ASYNC_WINDOW", 8), 1))
+          , _dispatched(0)
+          , _completed_op_count(0)
+          , _processing_time(0)
+#if MEMO_ENABLE_PROMETHEUS
+          , _queued_gauge(make_queued_gauge(this->doughnut()))
+          , _in_flight_gauge(make_in_flight_gauge(this->doughnut()))
+          , _processed_counter(make_processed_counter(this->doughnut()))
+          , _latency_counter(make_latency_counter(this->doughnut()))
+#endif
         {
           if (!this->_journal_dir.empty())
           {
@@ -102,20 +161,6 @@ namespace memo
             this->_init_barrier.open();
         }
 
-        std::vector<fs::path>
-        Async::entries(fs::path const& root)
-        {
-          auto paths = std::vector<fs::path>
-            {fs::directory_iterator(root), fs::directory_iterator()};
-          boost::sort(paths,
-                    [] (fs::path const& a, fs::path const& b)
-                    {
-                      return std::stoi(a.filename().string()) <
-                        std::stoi(b.filename().string());
-                    });
-          return paths;
-        }
-
         void
         Async::_init()
         {
@@ -124,9 +169,9 @@ namespace memo
             });
           ELLE_TRACE_SCOPE("%s: restore journal from %s",
                            *this, this->_journal_dir);
-          for (auto const& p: Async::entries(_journal_dir))
+          this->_journal = std::make_unique<Journal>(this->_journal_dir);
+          for (auto id: this->_journal->indexes())
           {
-            auto id = std::stoi(p.filename().string());
             Op op;
             try
             {
@@ -167,6 +212,7 @@ namespace memo
           // Wake up the thread if needed.
           if (this->_queue.size() == 0)
             this->_queue.put(0);
+          this->_window_available.signal();
           if (!elle::reactor::wait(*this->_process_thread, 10s)
             || !elle::reactor::wait(*this->_init_thread, 10s))
             ELLE_WARN("forcefully kiling async process loop");
@@ -232,9 +278,9 @@ namespace memo
         }
 
         Async::Op
-        Async::_load_op(fs::path const& p, bool signature)
+        Async::_load_op(elle::Buffer const& data, bool signature)
         {
-          fs::ifstream is(p, std::ios::binary);
+          elle::IOStream is(data.istreambuf());
           elle::serialization::binary::SerializerIn sin(is);
           sin.set_context<Model*>(&this->doughnut()); // FIXME: needed ?
           sin.set_context<Doughnut*>(&this->doughnut());
@@ -255,11 +301,29 @@ namespace memo
         Async::Op
         Async::_load_op(int id, bool signature)
         {
-          auto op = this->_load_op(this->_journal_dir / std::to_string(id), signature);
+          if (!this->_journal)
+            elle::err("unable to reload operation %s without journal", id);
+          auto op = this->_load_op(this->_journal->read(id), signature);
           op.index = id;
           return op;
         }
 
+        void
+        Async::_write_op(Op const& op)
+        {
+          if (!this->_journal)
+            return;
+          auto data = elle::Buffer{};
+          {
+            elle::IOStream os(data.ostreambuf());
+            elle::serialization::binary::SerializerOut sout(os);
+            sout.set_context(ACBDontWaitForSignature{});
+            sout.set_context(OKBDontWaitForSignature{});
+            sout.serialize_forward(op);
+          }
+          this->_journal->write(op.index, data);
+        }
+
         void
         Async::_push_op(Op op)
         {
@@ -273,11 +337,10 @@ namespace memo
             SquashOperation last_candidate_order = std::make_pair(
               Squash::stop, SquashConflictResolverOptions(0));
             // Check for squashability: we need resolvers, and we can't touch
-            // the head of the queue since it's currently being processed
-            int current = this->_operations.get<1>().begin()->index;
+            // operations currently being processed.
             std::vector<int> candidates;
             for (auto it = its.first; it != its.second; ++it)
-              if (it->index != current)
+              if (!this->_processing.count(it->index))
                 candidates.push_back(it->index);
             std::sort(candidates.begin(), candidates.end(),
               [](int x, int y) { return x > y;});
@@ -342,16 +405,8 @@ namespace memo
                       o.remove_signature = std::move(op.remove_signature);
                       o.resolver = std::move(cr);
                     });
-                  if (!this->_journal_dir.empty())
-                  {
-                    auto path =
-                      _journal_dir / std::to_string(last_candidate_index);
-                    fs::ofstream os(path, std::ios::binary);
-                    elle::serialization::binary::SerializerOut sout(os);
-                    sout.set_context(ACBDontWaitForSignature{});
-                    sout.set_context(OKBDontWaitForSignature{});
-                    sout.serialize_forward(*copit);
-                  }
+                  // Supersede the journaled operation in place.
+                  this->_write_op(*copit);
                   return;
               }
               else
@@ -361,11 +416,8 @@ namespace memo
                 int lastidx = this->_operations.get<1>().rbegin()->index;
                 ELLE_DEBUG("Erasing op at %s", last_candidate_index);
                 this->_operations.get<1>().erase(last_candidate_index);
-                if (!this->_journal_dir.empty())
-                {
-                  auto path = this->_journal_dir / std::to_string(idx);
-                  fs::remove(path);
-                }
+                if (this->_journal)
+                  this->_journal->remove(idx);
                 if (this->_first_disk_index
                   && this->_first_disk_index.get() == idx)
                 {
@@ -380,15 +432,7 @@ namespace memo
           auto in_push = elle::scoped_assignment(this->_in_push, true);
           op.index = ++this->_next_index;
           ELLE_TRACE_SCOPE("%s: push %s", *this, op);
-          if (!this->_journal_dir.empty())
-          {
-            auto path = _journal_dir / std::to_string(op.index);
-            fs::ofstream os(path, std::ios::binary);
-            elle::serialization::binary::SerializerOut sout(os);
-            sout.set_context(ACBDontWaitForSignature{});
-            sout.set_context(OKBDontWaitForSignature{});
-            sout.serialize_forward(op);
-          }
+          this->_write_op(op);
           if (reentered)
           {
             this->_reentered_ops.emplace_back(std::move(op));
@@ -417,6 +461,7 @@ namespace memo
           for (auto& op: this->_reentered_ops)
             queue(std::move(op));
           this->_reentered_ops.clear();
+          this->_update_metrics();
         }
 
         void
@@ -523,46 +568,128 @@ namespace memo
         Async::_process_loop()
         {
           elle::reactor::wait(this->_init_barrier);
-          while (!this->_exit_requested)
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
           {
-            try
+            while (!this->_exit_requested)
             {
-              if (this->_queue.size() <= this->_queue.max_size() / 2 &&
-                  this->_first_disk_index)
-                ELLE_TRACE(
-                  "%s: restore additional operations from disk at index %s",
-                  *this, *this->_first_disk_index)
-                  this->_load_operations();
-              int index = this->_queue.get();
-              if (this->_exit_requested)
-                break;
-              auto it = this->_operations.get<1>().begin();
-              while (it == this->_operations.get<1>().end() || it->index > index)
+              try
+              {
+                if (this->_queue.size() <= this->_queue.max_size() / 2 &&
+                    this->_first_disk_index)
+                  ELLE_TRACE(
+                    "%s: restore additional operations from disk at index %s",
+                    *this, *this->_first_disk_index)
+                    this->_load_operations();
+                while (this->_dispatched >= this->_window &&
+                       !this->_exit_requested)
+                  elle::reactor::wait(this->_window_available);
+                if (this->_exit_requested)
+                  break;
+                int index = this->_queue.get();
+                if (this->_exit_requested)
+                  break;
+                auto it = this->_operations.get<1>().find(index);
+                if (it == this->_operations.get<1>().end())
+                {
+                  ELLE_DEBUG("index %s in queue not in ops", index);
+                  continue;
+                }
+                ++this->_dispatched;
+                auto const address = it->address;
+                auto busy = this->_busy.find(address);
+                if (busy != this->_busy.end())
+                {
+                  // Preserve the order of operations on a same address.
+                  ELLE_DEBUG("park %s behind operations on %f",
+                             index, address);
+                  busy->second.emplace_back(index);
+                  continue;
+                }
+                this->_busy.emplace(address, std::deque<int>{});
+                scope.run_background(
+                  elle::sprintf("%s: process %f", this, address),
+                  [this, address, index]
+                  {
+                    this->_process_address(address, index);
+                  });
+              }
+              catch (elle::Error const& e)
               {
-                ELLE_DEBUG("index %s in queue not in ops (have %s)", index,
-                           it->index);
-                index = this->_queue.get();
-                it = this->_operations.get<1>().begin();
+                ELLE_ABORT("%s: async loop killed: %s\n",
+                           this, e.what(), e.backtrace());
               }
+            }
+            scope.terminate_now();
+          };
+          ELLE_TRACE("exiting loop");
+        }
 
-              elle::generic_unique_ptr<Op const> op(&*it, [] (Op const*) {});
-              ELLE_ASSERT_EQ(op->index, index);
-              this->_process_operation(std::move(op));
-              if (!this->_journal_dir.empty())
+        void
+        Async::_process_address(Address address, int index)
+        {
+          static auto bench =
+            elle::Bench<>{"bench.async.process", 10000s};
+          while (true)
+          {
+            auto it = this->_operations.get<1>().find(index);
+            // Squashed operations may have been erased while parked.
+            if (it != this->_operations.get<1>().end())
+            {
+              this->_processing.emplace(index);
+              this->_update_metrics();
+              auto const start = std::chrono::steady_clock::now();
               {
-                auto path = this->_journal_dir / std::to_string(index);
-                fs::remove(path);
-                this->_last_processed_index = index;
+                auto bs = bench.scoped();
+                elle::generic_unique_ptr<Op const> op(&*it, [] (Op const*) {});
+                ELLE_ASSERT_EQ(op->index, index);
+                this->_process_operation(std::move(op));
               }
-              this->_operations.get<1>().erase(it);
+              auto const latency = std::chrono::steady_clock::now() - start;
+              this->_processing.erase(index);
+              if (this->_journal)
+                this->_journal->remove(index);
+              this->_operations.get<1>().erase(index);
+              // Operations complete out of order: everything before the first
+              // pending one is processed.
+              this->_last_processed_index = std::max(
+                this->_last_processed_index,
+                this->_operations.empty()
+                ? index
+                : this->_operations.get<1>().begin()->index - 1);
+              ++this->_completed_op_count;
+              this->_processing_time +=
+                std::chrono::duration_cast<elle::Duration>(latency);
+#if MEMO_ENABLE_PROMETHEUS
+              if (this->_processed_counter)
+                this->_processed_counter->Increment();
+              if (this->_latency_counter)
+                this->_latency_counter->Increment(
+                  std::chrono::duration<double>(latency).count());
+#endif
+              this->_update_metrics();
             }
-            catch (elle::Error const& e)
+            --this->_dispatched;
+            this->_window_available.signal();
+            auto& parked = this->_busy.at(address);
+            if (parked.empty())
             {
-              ELLE_ABORT("%s: async loop killed: %s\n",
-                         this, e.what(), e.backtrace());
+              this->_busy.erase(address);
+              return;
             }
+            index = parked.front();
+            parked.pop_front();
           }
-          ELLE_TRACE("exiting loop");
+        }
+
+        void
+        Async::_update_metrics()
+        {
+#if MEMO_ENABLE_PROMETHEUS
+          if (this->_queued_gauge)
+            this->_queued_gauge->Set(this->_operations.size());
+          if (this->_in_flight_gauge)
+            this->_in_flight_gauge->Set(this->_processing.size());
+#endif
         }
 
         void
@@ -669,7 +796,22 @@ namespace memo
         elle::json::Json
         Async::stats()
         {
-          return this->_backend->stats();
+          auto res = this->_backend->stats();
+          // Operations being processed are only counted once complete.
+          auto const processed = this->_completed_op_count;
+          res["async"] = {
+            {"queued", this->_operations.size()},
+            {"in_flight", this->_processing.size()},
+            {"window", this->_window},
+            {"processed", processed},
+            {"mean_latency_ms", processed
+             ? std::chrono::duration_cast<std::chrono::milliseconds>(
+               this->_processing_time).count() / double(processed)
+             : 0.},
+          };
+          if (this->_journal)
+            res["journal"] = this->_journal->stats();
+          return res;
         }
 
         /*----------.
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <deque>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
@@ -9,11 +11,15 @@
 #include <boost/multi_index/ordered_index.hpp>
 
 #include <elle/reactor/Channel.hh>
+#include <elle/reactor/Scope.hh>
 #include <elle/reactor/Thread.hh>
+#include <elle/reactor/signal.hh>
 
 #include <elle/optional.hh>
 
 #include <memo/model/doughnut/Consensus.hh>
+#include <memo/model/doughnut/Journal.hh>
+#include <memo/model/prometheus.hh>
 
 namespace memo
 {
@@ -67,11 +73,6 @@ namespace memo
           elle::json::Json
           stats() override;
 
-        public:
-          static
-          std::vector<fs::path>
-          entries(fs::path const& root);
-
           /*----------.
           | Operation |
           `----------*/
@@ -114,6 +115,10 @@ namespace memo
                        bool& hit);
           void
           _process_loop();
+          /// Process the operation at `index`, then those parked behind it
+          /// for the same address.
+          void
+          _process_address(Address address, int index);
           void
           _process_operation(elle::generic_unique_ptr<Op const> op);
           void
@@ -121,9 +126,12 @@ namespace memo
           void
           _push_op(Op op);
           Async::Op
-          _load_op(fs::path const& path, bool signature = true);
+          _load_op(elle::Buffer const& data, bool signature = true);
           Async::Op
           _load_op(int id, bool signature = true);
+          /// Write `op` to the journal at its index.
+          void
+          _write_op(Op const& op);
           void
           _load_operations();
           using Operations = bmi::multi_index_container<
@@ -139,6 +147,7 @@ namespace memo
           ELLE_ATTRIBUTE(int, next_index);
           ELLE_ATTRIBUTE(int, last_processed_index);
           ELLE_ATTRIBUTE(fs::path, journal_dir);
+          ELLE_ATTRIBUTE(std::unique_ptr<Journal>, journal);
           /// Index of the first operation stored on disk because memory is at
           /// capacity.
           ELLE_ATTRIBUTE(boost::optional<int>, first_disk_index);
@@ -150,6 +159,37 @@ namespace memo
           ELLE_ATTRIBUTE(bool, in_push);
           ELLE_ATTRIBUTE(std::vector<Op>, reentered_ops);
           ELLE_ATTRIBUTE_R(unsigned long, processed_op_count);
+
+        /*------------.
+        | Concurrency |
+        `------------*/
+        private:
+          /// Maximum number of operations dispatched at once.
+          ELLE_ATTRIBUTE_R(int, window);
+          /// Number of dispatched operations, processing or parked.
+          ELLE_ATTRIBUTE(int, dispatched);
+          /// Indexes of the operations being processed.
+          ELLE_ATTRIBUTE(std::unordered_set<int>, processing);
+          /// Addresses being processed, with the operations parked behind.
+          ELLE_ATTRIBUTE((std::unordered_map<Address, std::deque<int>>),
+                         busy);
+          ELLE_ATTRIBUTE(elle::reactor::Signal, window_available);
+          /// Number of operations processed to completion.
+          ELLE_ATTRIBUTE_R(int64_t, completed_op_count);
+          /// Time spent processing completed operations.
+          ELLE_ATTRIBUTE(elle::Duration, processing_time);
+          void
+          _update_metrics();
+#if MEMO_ENABLE_PROMETHEUS
+          /// Gauge on the number of pending operations.
+          ELLE_ATTRIBUTE(prometheus::GaugePtr, queued_gauge);
+          /// Gauge on the number of operations being processed.
+          ELLE_ATTRIBUTE(prometheus::GaugePtr, in_flight_gauge);
+          /// Counter of processed operations.
+          ELLE_ATTRIBUTE(prometheus::CounterPtr, processed_counter);
+          /// Counter of the time spent processing operations, in seconds.
+          ELLE_ATTRIBUTE(prometheus::CounterPtr, latency_counter);
+#endif
           void
           print_queue();
         };
@@ -1,4 +1,5 @@
 #include <elle/bench.hh>
+#include <elle/err.hh>
 #include <elle/log.hh>
 
 #include <elle/cryptography/hash.hh>
@@ -8,8 +9,11 @@
 
 #include <memo/model/doughnut/CHB.hh>
 #include <memo/model/doughnut/ACB.hh>
+#include <memo/model/doughnut/Compression.hh>
 #include <memo/model/doughnut/Doughnut.hh>
 #include <memo/model/doughnut/Group.hh>
+#include <memo/model/doughnut/TreeHash.hh>
+#include <memo/model/doughnut/consensus/Erasure.hh>
 
 ELLE_LOG_COMPONENT("memo.model.doughnut.CHB")
 
@@ -29,7 +33,10 @@ namespace memo
 
       CHB::CHB(Doughnut* d, elle::Buffer data, elle::Buffer salt, Address owner)
         : CHB(d,
-              CHB::_hash_address(data, owner, salt, d->version()),
+              CHB::_flag(
+                d,
+                CHB::_hash_address(
+                  CHB::_pack(d, data), owner, salt, d->version())),
               data,
               salt,
               std::move(owner))
@@ -44,16 +51,22 @@ namespace memo
                 std::move(data),
                 d->version() >= elle::Version(0, 4, 0) ?
                   std::move(owner) : Address::null)
+        , _packed(compression::packed(d->version()))
+        , _data_plain()
         , _salt(std::move(salt))
       {}
 
       CHB::CHB(CHB const& other)
         : Super(other)
+        , _packed(other._packed)
+        , _data_plain(other._data_plain)
         , _salt(other._salt)
       {}
 
       CHB::CHB(CHB&& other)
        : Super(std::move(other))
+       , _packed(other._packed)
+       , _data_plain(std::move(other._data_plain))
        , _salt(std::move(other._salt))
       {}
 
@@ -67,6 +80,42 @@ namespace memo
         return std::unique_ptr<blocks::Block>(new CHB(*this));
       }
 
+      /*--------.
+      | Content |
+      `--------*/
+
+      elle::Buffer const&
+      CHB::data() const
+      {
+        if (!this->_packed)
+          return Super::data();
+        if (!this->_data_plain)
+        {
+          static auto bench = elle::Bench<>{"bench.chb.unpack", 10000s};
+          auto bs = bench.scoped();
+          this->_data_plain.emplace(compression::unpack(Super::data()));
+        }
+        return this->_data_plain->get();
+      }
+
+      elle::Buffer
+      CHB::take_data()
+      {
+        if (!this->_packed)
+          return Super::take_data();
+        this->data();
+        auto res = this->_data_plain->take();
+        this->_data_plain.reset();
+        return res;
+      }
+
+      std::size_t
+      CHB::footprint() const
+      {
+        return Super::footprint()
+          + (this->_data_plain ? this->_data_plain->size() : 0);
+      }
+
       /*-----------.
       | Validation |
       `-----------*/
@@ -79,9 +128,17 @@ namespace memo
       CHB::_validate(Model const& model, bool writing) const
       {
         ELLE_DEBUG_SCOPE("%s: validate", *this);
+        // The address flags tell which scheme to check, so that blocks
+        // stored before tree hashing keep their flat address.
+        auto const tree = this->address().has_flags(flags::tree_hash) &&
+          TreeHash::applies(model.version(), Super::data().size());
         auto expected_address =
-          CHB::_hash_address(this->data(), this->owner(),
-                             this->_salt, model.version());
+          CHB::_hash_address(Super::data(), this->owner(),
+                             this->_salt, model.version(), tree);
+        // Before 0.5.0, the flag byte is part of a flat hash.
+        if (tree && !equal_unflagged(this->address(), expected_address))
+          expected_address = CHB::_hash_address(
+            Super::data(), this->owner(), this->_salt, model.version(), false);
         if (!equal_unflagged(this->address(), expected_address))
         {
           auto reason =
@@ -104,8 +161,14 @@ namespace memo
       CHB::CHB(elle::serialization::Serializer& input,
                elle::Version const& version)
         : Super(input, version)
+        , _packed(false)
+        , _data_plain()
       {
         input.serialize("salt", _salt);
+        // Stored with the block: the version it is read at says nothing of
+        // how it was written.
+        if (compression::packed(version))
+          input.serialize("packed", this->_packed);
       }
 
       void
@@ -114,6 +177,11 @@ namespace memo
       {
         Super::serialize(s, version);
         s.serialize("salt", _salt);
+        if (compression::packed(version))
+          s.serialize("packed", this->_packed);
+        else if (s.out() && this->_packed)
+          elle::err("%s: packed payload cannot be serialized at version %s",
+                    this, version);
       }
 
       /*--------.
@@ -127,6 +195,30 @@ namespace memo
             sizeof(Address::Value)};
       }
 
+      Address
+      CHB::_flag(Doughnut* d, Address address)
+      {
+        // Tell fetches to look for fragments, or not to.
+        if (d->version() >= elle::Version(0, 5, 0) &&
+            d->consensus() &&
+            consensus::StackedConsensus::find<consensus::Erasure>(
+              d->consensus().get()))
+          return address.with_flags(flags::erasure_coded);
+        return address;
+      }
+
+      elle::Buffer&
+      CHB::_pack(Doughnut* d, elle::Buffer& data)
+      {
+        if (compression::packed(d->version()))
+        {
+          static auto bench = elle::Bench<>{"bench.chb.pack", 10000s};
+          auto bs = bench.scoped();
+          data = compression::pack(data);
+        }
+        return data;
+      }
+
       blocks::RemoveSignature
       CHB::_sign_remove(Model& model) const
       {
@@ -203,29 +295,36 @@ namespace memo
       CHB::_validate_remove(Model& model,
                             blocks::RemoveSignature const& sig) const
       {
-        auto& dht = dynamic_cast<Doughnut&>(model);
         ELLE_TRACE("%s: validate_remove", *this);
-        if (!this->owner())
+        return CHB::validate_remove(model, this->address(), this->owner(), sig);
+      }
+
+      blocks::ValidationResult
+      CHB::validate_remove(Model& model, Address chb, Address owner,
+                           blocks::RemoveSignature const& sig)
+      {
+        auto& dht = dynamic_cast<Doughnut&>(model);
+        if (!owner)
           return blocks::ValidationResult::success();
         if (!sig.signature_key || !sig.signature)
           return blocks::ValidationResult::failure("Missing field in signature");
         auto& key = *sig.signature_key;
         bool ok = key.verify(*sig.signature,
-          elle::ConstWeakBuffer(this->address().value()));
+          elle::ConstWeakBuffer(chb.value()));
         if (!ok)
           return blocks::ValidationResult::failure("Invalid signature");
         // now verify that this key has access to owner
-        auto block = model.fetch(this->owner());
+        auto block = model.fetch(owner);
         if (!block)
         {
           ELLE_WARN("CHB owner %x not found, cannot validate remove request",
-            this->owner());
+            owner);
           return blocks::ValidationResult::success();
         }
         auto* acb = dynamic_cast<ACB*>(block.get());
         if (!acb)
         {
-          ELLE_WARN("CHB owner %x is not an ACB", this->owner() );
+          ELLE_WARN("CHB owner %x is not an ACB", owner);
           return blocks::ValidationResult::success();
         }
         if (acb->get_world_permissions().second)
@@ -263,15 +362,20 @@ namespace memo
       Address
       CHB::_hash_address(elle::Buffer const& content,
                          Address owner, elle::Buffer const& salt,
-                         elle::Version const& version)
+                         elle::Version const& version,
+                         bool tree)
       {
-        static auto bench = elle::Bench<>{"bench.chb.hash", 10000s};
-        auto bs = bench.scoped();
         elle::Buffer saltowner(salt);
         if (version < elle::Version(0, 4, 0))
           owner = Address::null;
         if (owner)
           saltowner.append(owner.value(), sizeof(Address::Value));
+        if (tree && TreeHash::applies(version, content.size()))
+          return Address(TreeHash(content).root(saltowner).contents(),
+                         flags::immutable_block, true)
+            .with_flags(flags::tree_hash);
+        static auto bench = elle::Bench<>{"bench.chb.hash", 10000s};
+        auto bs = bench.scoped();
         elle::IOStream stream(saltowner.istreambuf_combine(content));
         elle::Buffer hash;
         // FIXME: scheduler::run?
@@ -38,6 +38,22 @@ namespace memo
         std::unique_ptr<blocks::Block>
         clone() const override;
 
+      /*--------.
+      | Content |
+      `--------*/
+      public:
+        /// The payload, unpacked on first access.
+        ELLE_attribute_r(elle::Buffer, data, override);
+        elle::Buffer
+        take_data() override;
+        std::size_t
+        footprint() const override;
+        /// Whether the stored payload is packed, see compression.
+        ELLE_ATTRIBUTE_R(bool, packed);
+      private:
+        ELLE_ATTRIBUTE(boost::optional<blocks::SharedBuffer>, data_plain,
+                       mutable);
+
       /*-----------.
       | Validation |
       `-----------*/
@@ -58,6 +74,10 @@ namespace memo
         static
         blocks::RemoveSignature
         sign_remove(Model& model, Address chb, Address owner);
+        static
+        blocks::ValidationResult
+        validate_remove(Model& model, Address chb, Address owner,
+                        blocks::RemoveSignature const& sig);
       protected:
         blocks::RemoveSignature
         _sign_remove(Model& model) const override;
@@ -72,17 +92,28 @@ namespace memo
         static
         elle::Buffer
         _make_salt();
+        /// Flag `address` as erasure-coded if `d` stores CHBs so.
+        static
+        Address
+        _flag(Doughnut* d, Address address);
+        /// Pack `data` in place if `d` packs payloads.
+        static
+        elle::Buffer&
+        _pack(Doughnut* d, elle::Buffer& data);
+        /// Address of `content`, tree hashed if large enough at `version`
+        /// unless `tree` is false, see TreeHash.
         static
         Address
         _hash_address(elle::Buffer const& content, Address owner,
                       elle::Buffer const& salt,
-                      elle::Version const& version);
+                      elle::Version const& version,
+                      bool tree = true);
         CHB(Doughnut* d,
             Address address,
             elle::Buffer& data,
             elle::Buffer& salt,
             Address owner);
-        ELLE_ATTRIBUTE(elle::Buffer, salt);
+        ELLE_ATTRIBUTE_R(elle::Buffer, salt);
       };
     }
   }
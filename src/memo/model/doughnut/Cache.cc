@@ -1,3 +1,5 @@
+#include <list>
+
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
@@ -5,10 +7,15 @@
 #include <memo/model/doughnut/Local.hh>
 #include <memo/model/blocks/ImmutableBlock.hh>
 
+#include <elle/IOStream.hh>
+#include <elle/With.hh>
 #include <elle/bench.hh>
 #include <elle/bytes.hh>
 #include <elle/find.hh>
 #include <elle/os/environ.hh>
+#include <elle/print.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
 #include <elle/serialization/json.hh>
 #include <elle/serialization/binary.hh>
 
@@ -16,9 +23,90 @@
 #include <memo/model/doughnut/Doughnut.hh>
 #include <memo/model/doughnut/Local.hh>
 #include <memo/model/doughnut/OKB.hh>
+#include <memo/model/doughnut/consensus/Paxos.hh>
 
 ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Cache");
 
+namespace
+{
+  /// Typical block footprint, to size the frequency sketch.
+  auto constexpr sketch_block_size = 4096;
+
+  auto const disk_index = "index";
+
+  /// Prefetch requests beyond this many drop the oldest ones.
+  auto constexpr prefetch_queue_size = 4096u;
+
+  auto const eviction_names = std::array<char const*, 4>{
+    {"size", "admission", "ttl", "invalidation"},
+  };
+
+#if MEMO_ENABLE_PROMETHEUS
+  memo::prometheus::Labels
+  labels(memo::model::doughnut::Doughnut const& dht)
+  {
+    return {{"id", elle::sprintf("%f", dht.id())}};
+  }
+
+  /// A counter of RAM cache hits.
+  memo::prometheus::CounterPtr
+  make_hit_counter(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_counter_family(
+      "memo_cache_hits",
+      "How many block fetches were served from the RAM cache");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// A counter of RAM cache misses.
+  memo::prometheus::CounterPtr
+  make_miss_counter(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_counter_family(
+      "memo_cache_misses",
+      "How many block fetches missed the RAM cache");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// A gauge on the bytes used by the RAM cache.
+  memo::prometheus::GaugePtr
+  make_bytes_gauge(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_gauge_family(
+      "memo_cache_bytes",
+      "How many bytes of blocks the RAM cache holds");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// A gauge on the number of blocks in the RAM cache.
+  memo::prometheus::GaugePtr
+  make_blocks_gauge(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_gauge_family(
+      "memo_cache_blocks",
+      "How many blocks the RAM cache holds");
+    return memo::prometheus::make(family, labels(dht));
+  }
+
+  /// Counters of RAM cache evictions, by reason.
+  std::array<memo::prometheus::CounterPtr, 4>
+  make_eviction_counters(memo::model::doughnut::Doughnut const& dht)
+  {
+    static auto* family = memo::prometheus::make_counter_family(
+      "memo_cache_evictions",
+      "How many blocks were evicted from the RAM cache");
+    auto res = std::array<memo::prometheus::CounterPtr, 4>{};
+    for (auto i = 0u; i < res.size(); ++i)
+    {
+      auto l = labels(dht);
+      l["reason"] = eviction_names[i];
+      res[i] = memo::prometheus::make(family, l);
+    }
+    return res;
+  }
+#endif
+}
+
 namespace memo
 {
   namespace model
@@ -101,10 +189,41 @@ namespace memo
           , _cache_size(cache_size.value_or(64_MiB))
           , _disk_cache_path(disk_cache_path)
           , _disk_cache_size(disk_cache_size.value_or(512_MiB))
+          , _sketch(std::max(this->_cache_size / sketch_block_size, 1024))
+          , _segment_bytes{{0, 0, 0}}
+          , _window_size(
+            std::size_t(this->_cache_size) *
+            std::min(std::max(memo::getenv("CACHE_WINDOW_PERCENT", 1), 0), 100)
+            / 100)
+          , _protected_size(
+            (std::size_t(this->_cache_size) - this->_window_size) * 4 / 5)
+          , _hits(0)
+          , _misses(0)
+          , _evictions{{0, 0, 0, 0}}
+#if MEMO_ENABLE_PROMETHEUS
+          , _hit_counter(make_hit_counter(this->doughnut()))
+          , _miss_counter(make_miss_counter(this->doughnut()))
+          , _bytes_gauge(make_bytes_gauge(this->doughnut()))
+          , _blocks_gauge(make_blocks_gauge(this->doughnut()))
+          , _eviction_counters(make_eviction_counters(this->doughnut()))
+#endif
           , _disk_cache_used(0)
+          , _disk_cache_dirty(false)
+          , _disk_cache_scan(false)
+          , _disk_revalidations(0)
           , _cleanup_thread(
             new elle::reactor::Thread(elle::sprintf("%s cleanup", *this),
                                 [this] { this->_cleanup();}))
+          , _negative_ttl(
+            std::chrono::milliseconds(memo::getenv("CACHE_NEGATIVE_TTL", 1000)))
+          , _negative_hits(0)
+          , _paxos(nullptr)
+          , _invalidations(0)
+          , _prefetch_concurrency(
+            std::max(memo::getenv("CACHE_PREFETCH_CONCURRENCY", 4), 1))
+          , _prefetched(0)
+          , _prefetch_skips(0)
+          , _prefetch_failures(0)
         {
           ELLE_TRACE_SCOPE(
             "%s: create with size %s, TTL %ss and invalidation %ss",
@@ -114,13 +233,45 @@ namespace memo
             this->_disk_cache_size = 0;
           if (this->_disk_cache_size)
           {
-            bfs::create_directories(*this->_disk_cache_path);
+            bfs::create_directories(*this->_disk_cache_path / "mutable");
             this->_load_disk_cache();
+            this->_disk_write_thread.reset(
+              new elle::reactor::Thread(
+                elle::sprintf("%s disk write", *this),
+                [this] { this->_disk_cache_write_loop(); }));
           }
+          if (memo::getenv("CACHE_PUSH_INVALIDATION", false))
+            if ((this->_paxos = find<Paxos>(this->_backend.get())))
+            {
+              ELLE_TRACE("%s: enable push invalidation", this);
+              this->_invalidated = this->_paxos->invalidated().connect(
+                [this] (Address a, boost::optional<int> v)
+                {
+                  this->_invalidate(a, v);
+                });
+              this->_subscribe_thread.reset(
+                new elle::reactor::Thread(
+                  elle::sprintf("%s subscribe", *this),
+                  [this] { this->_subscribe_loop(); }));
+            }
         }
 
         Cache::~Cache()
-        {}
+        {
+          this->_prefetch_threads.clear();
+          this->_invalidated.disconnect();
+          this->_subscribe_thread.reset();
+          // Pending disk writes are dropped, the cache is best effort.
+          this->_disk_write_thread.reset();
+          try
+          {
+            this->_save_disk_cache();
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("%s: unable to save disk cache index: %s", this, e);
+          }
+        }
 
         /*--------.
         | Factory |
@@ -144,21 +295,14 @@ namespace memo
         Cache::_remove(Address address, blocks::RemoveSignature rs)
         {
           ELLE_TRACE_SCOPE("%s: remove %f", this, address);
-          if (this->_cache.erase(address) > 0)
-            ELLE_DEBUG("drop block from cache");
-          else if (auto it = elle::find(this->_disk_cache, address))
+          auto hit = this->_cache.find(address);
+          if (hit != this->_cache.end())
           {
-            ELLE_DEBUG("drop block from disk cache");
-            this->_disk_cache_used -= it->size();
-            boost::system::error_code erc;
-            auto path = *this->_disk_cache_path / elle::sprintf("%x", it->address());
-            bfs::remove(path, erc);
-            if (erc)
-              ELLE_WARN("Error pruning %s from cache: %s", path, erc);
-            this->_disk_cache.erase(it);
+            ELLE_DEBUG("drop block from cache");
+            this->_evict(hit, eviction_invalidation);
+            this->_update_metrics();
           }
-          else
-            ELLE_DEBUG("block was not in cache");
+          this->_disk_cache_drop(address);
           this->_backend->remove(address, std::move(rs));
         }
 
@@ -170,7 +314,16 @@ namespace memo
           for (auto a: addresses)
           {
             bool hit = false;
-            auto block = this->_fetch_cache(a.first, a.second, hit, true);
+            std::unique_ptr<blocks::Block> block;
+            try
+            {
+              block = this->_fetch_cache(a.first, a.second, hit, true);
+            }
+            catch (MissingBlock const&)
+            {
+              fun(a.first, {}, std::current_exception());
+              continue;
+            }
             if (hit)
             {
               ELLE_DEBUG("cache hit on %f", a);
@@ -185,16 +338,52 @@ namespace memo
           // this optimization.
           for (auto& av: missing)
             av.second.reset();
-          this->_backend->fetch(missing,
-            [&](Address addr, std::unique_ptr<blocks::Block> block,
-                std::exception_ptr exc)
-            {
-              if (block)
+          // Validate and decode blocks concurrently, so their cryptographic
+          // operations run in parallel in the background pool.
+          auto fetched =
+            std::list<std::pair<Address, std::unique_ptr<blocks::Block>>>{};
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& scope)
+          {
+            this->_backend->fetch(missing,
+              [&](Address addr, std::unique_ptr<blocks::Block> block,
+                  std::exception_ptr exc)
               {
-                this->_insert_cache(*block);
-              }
-              fun(addr, std::move(block), exc);
-            });
+                if (!block)
+                {
+                  if (exc)
+                    try
+                    {
+                      std::rethrow_exception(exc);
+                    }
+                    catch (MissingBlock const&)
+                    {
+                      this->_missing_block(addr);
+                    }
+                    catch (...)
+                    {}
+                  fun(addr, {}, exc);
+                  return;
+                }
+                fetched.emplace_back(addr, std::move(block));
+                auto it = std::prev(fetched.end());
+                scope.run_background(
+                  elle::print("insert {}", addr),
+                  [&, it]
+                  {
+                    try
+                    {
+                      this->_insert_cache(*it->second);
+                    }
+                    catch (elle::Error const&)
+                    {
+                      fun(it->first, {}, std::current_exception());
+                      return;
+                    }
+                    fun(it->first, std::move(it->second), {});
+                  });
+              });
+            elle::reactor::wait(scope);
+          };
         }
 
         std::unique_ptr<blocks::Block>
@@ -212,6 +401,7 @@ namespace memo
             ELLE_WARN("%s: invalid block received for %s", this, b.address());
             elle::err("invalid block");
           }
+          this->_forget_missing(b.address());
           static bool decode = memo::getenv("PREEMPT_DECODE", true);
           if (decode)
             try
@@ -227,9 +417,13 @@ namespace memo
           if (this->_disk_cache_size
               && dynamic_cast<blocks::ImmutableBlock*>(&b))
             this->_disk_cache_push(b);
-          else if (dynamic_cast<blocks::MutableBlock*>(&b) && this->_cache_size)
-            this->_cache.emplace(b.clone());
-
+          else if (dynamic_cast<blocks::MutableBlock*>(&b))
+          {
+            if (this->_cache_size)
+              this->_cache_block(b.clone());
+            else
+              this->_disk_cache_push(b);
+          }
         }
 
         std::unique_ptr<blocks::Block>
@@ -248,8 +442,7 @@ namespace memo
           {
             cache_hit = true;
             ELLE_DEBUG("cache hit on %f", address);
-            this->_cache.modify(
-              hit, [] (CachedBlock& b) { b.last_used(now()); });
+            this->_touch(hit);
             bench_hit.add(1);
             if (local_version)
               if (auto mb =
@@ -269,27 +462,75 @@ namespace memo
           else
           {
             bench_hit.add(0);
+            ++this->_misses;
+#if MEMO_ENABLE_PROMETHEUS
+            if (this->_miss_counter)
+              this->_miss_counter->Increment();
+#endif
             // try disk cache
             auto disk_hit = this->_disk_cache.find(address);
-            if (disk_hit != this->_disk_cache.end())
+            auto block = disk_hit != this->_disk_cache.end()
+              ? this->_disk_cache_read(disk_hit)
+              : nullptr;
+            if (block && !disk_hit->mutable_())
             {
               cache_hit = true;
               ELLE_DEBUG("disk cache hit on %f", address);
               bench_disk_hit.add(1);
-              auto path = *this->_disk_cache_path / elle::sprintf("%x", address);
-              bfs::ifstream is(path, std::ios::binary);
-              elle::serialization::binary::SerializerIn sin(is);
-              sin.set_context<Doughnut*>(&this->doughnut());
-              auto block = sin.deserialize<std::unique_ptr<blocks::Block>>();
-              this->_disk_cache.modify(disk_hit,
-                [](CachedCHB& b) { b.last_used(now());});
               return block;
             }
-            else
+            else if (block &&
+                     !(disk_hit->validated() < now() - this->_cache_invalidation))
             {
-              ELLE_DEBUG("cache miss on %f", address);
-              bench_disk_hit.add(0);
+              cache_hit = true;
+              ELLE_DEBUG("disk cache hit on %f", address);
+              bench_disk_hit.add(1);
+              this->_insert_cache(*block);
             }
+            else if (block && !cache_only)
+            {
+              auto const mb = dynamic_cast<blocks::MutableBlock*>(block.get());
+              auto const version = mb ? mb->version() : -1;
+              ELLE_DEBUG_SCOPE("disk cache hit on %f, check version %s",
+                               address, version);
+              ++this->_disk_revalidations;
+              std::unique_ptr<blocks::Block> fresh;
+              try
+              {
+                fresh = this->_backend->fetch(address, version);
+              }
+              catch (MissingBlock const&)
+              {
+                this->_disk_cache_drop(address);
+                this->_missing_block(address);
+                throw;
+              }
+              cache_hit = true;
+              bench_disk_hit.add(1);
+              if (fresh)
+              {
+                ELLE_DEBUG("disk cache version is outdated");
+                block = std::move(fresh);
+              }
+              else
+                ELLE_DEBUG("disk cache version is up to date");
+              this->_insert_cache(*block);
+              auto it = this->_disk_cache.find(address);
+              if (it != this->_disk_cache.end())
+                this->_disk_cache.modify(
+                  it, [] (CachedDiskBlock& b) { b.validated(now()); });
+            }
+            if (cache_hit)
+            {
+              auto mut = dynamic_cast<blocks::MutableBlock*>(block.get());
+              if (mut && local_version && mut->version() == *local_version)
+                return nullptr;
+              return block;
+            }
+            ELLE_DEBUG("cache miss on %f", address);
+            bench_disk_hit.add(0);
+            if (this->_known_missing(address))
+              throw MissingBlock(address);
             if (cache_only)
               return {};
             auto it = this->_pending.find(address);
@@ -312,7 +553,16 @@ namespace memo
               });
             // Don't pass local_version to fetch, prioritizing cache feed over
             // this optimization.
-            auto res = _backend->fetch(address);
+            std::unique_ptr<blocks::Block> res;
+            try
+            {
+              res = _backend->fetch(address);
+            }
+            catch (MissingBlock const&)
+            {
+              this->_missing_block(address);
+              throw;
+            }
             // FIXME: pass the whole block to fetch() so we can cache it there ?
             if (res)
             {
@@ -325,23 +575,45 @@ namespace memo
           }
         }
 
-        void
-        Cache::insert(std::unique_ptr<blocks::Block> cloned)
+        bool
+        Cache::_known_missing(Address address)
         {
-          auto hit = this->_cache.find(cloned->address());
-          if (hit != this->_cache.end())
+          auto it = this->_missing.find(address);
+          if (it == this->_missing.end())
+            return false;
+          if (it->second < now() - this->_negative_ttl)
           {
-            this->_cache.modify(
-              hit, [&] (CachedBlock& b) {
-                b.block() = std::move(cloned);
-                b.last_used(now());
-                b.last_fetched(now());
-              });
+            this->_forget_missing(address);
+            return false;
           }
+          ELLE_DEBUG("%s: %f is known to be missing", this, address);
+          ++this->_negative_hits;
+          return true;
+        }
+
+        void
+        Cache::_missing_block(Address address)
+        {
+          if (this->_negative_ttl == elle::Duration::zero())
+            return;
+          auto const inserted = this->_missing.emplace(address, now());
+          if (inserted.second)
+            this->_subscribe(address, -1);
           else
-          {
-            this->_cache.emplace(std::move(cloned));
-          }
+            inserted.first->second = now();
+        }
+
+        void
+        Cache::_forget_missing(Address address)
+        {
+          if (this->_missing.erase(address))
+            this->_unsubscribe(address);
+        }
+
+        void
+        Cache::insert(std::unique_ptr<blocks::Block> cloned)
+        {
+          this->_cache_block(std::move(cloned));
         }
 
         void
@@ -352,6 +624,7 @@ namespace memo
           static auto bench = elle::Bench<>{"bench.cache.store", 10000s};
           auto bs = bench.scoped();
           ELLE_TRACE_SCOPE("%s: store %f", this, block->address());
+          this->_forget_missing(block->address());
           auto mb = dynamic_cast<blocks::MutableBlock*>(block.get());
           std::unique_ptr<blocks::Block> cloned;
           {
@@ -387,34 +660,185 @@ namespace memo
         {
           if (!this->_disk_cache_path)
             return;
-          auto path = *this->_disk_cache_path
-            / elle::sprintf("%x", block.address());
+          auto const mb = dynamic_cast<blocks::MutableBlock*>(&block);
+          auto const version = mb ? mb->version() : -1;
+          auto existing = this->_disk_cache.find(block.address());
+          if (existing != this->_disk_cache.end() &&
+              (!mb || existing->version() == version))
+            return;
+          if (auto pending = elle::find(this->_disk_writes, block.address()))
+            if (pending->second.version == version)
+              return;
+          // Serialize right away, the block may change before it is written.
+          auto data = elle::Buffer{};
           {
-            bfs::ofstream ofs(path, std::ios::binary);
-            elle::serialization::binary::SerializerOut sout(ofs);
+            elle::IOStream os(data.ostreambuf());
+            elle::serialization::binary::SerializerOut sout(os);
             sout.set_context<Doughnut*>(&this->doughnut());
             sout.serialize_forward(&block);
           }
-          auto sz = bfs::file_size(path);
-          this->_disk_cache.emplace(CachedCHB{block.address(), sz, now()});
-          this->_disk_cache_used += sz;
-          ELLE_DEBUG("add %f to disk cache (%s bytes)", block.address(), sz);
+          ELLE_DEBUG("queue %f for the disk cache (%s bytes)",
+                     block.address(), data.size());
+          this->_disk_writes[block.address()] =
+            DiskWrite{std::move(data), version, bool(mb)};
+          this->_disk_write_barrier.open();
+        }
+
+        void
+        Cache::_disk_cache_write_loop()
+        {
+          while (true)
+          {
+            elle::reactor::wait(this->_disk_write_barrier);
+            // The queued writes may have been dropped meanwhile.
+            if (this->_disk_writes.empty())
+            {
+              this->_disk_write_barrier.close();
+              continue;
+            }
+            auto const next = this->_disk_writes.begin();
+            auto const address = next->first;
+            auto const write = std::move(next->second);
+            this->_disk_writes.erase(next);
+            if (this->_disk_writes.empty())
+              this->_disk_write_barrier.close();
+            auto const path = this->_disk_cache_file(address, write.mutable_);
+            // Write aside and rename, so readers never see partial files.
+            auto const tmp = bfs::path(path.string() + ".tmp");
+            this->_disk_writing = address;
+            try
+            {
+              elle::reactor::background(
+                [&]
+                {
+                  {
+                    bfs::ofstream ofs(tmp, std::ios::binary);
+                    ofs.write(
+                      reinterpret_cast<char const*>(write.data.contents()),
+                      write.data.size());
+                    if (!ofs.good())
+                      elle::err("unable to write %s", tmp);
+                  }
+                  bfs::rename(tmp, path);
+                });
+            }
+            catch (std::exception const& e)
+            {
+              ELLE_WARN("%s: unable to write %f to disk cache: %s",
+                        this, address, e.what());
+              this->_disk_writing.reset();
+              boost::system::error_code erc;
+              bfs::remove(tmp, erc);
+              continue;
+            }
+            if (!this->_disk_writing)
+            {
+              ELLE_DEBUG("%f was dropped while being written", address);
+              boost::system::error_code erc;
+              bfs::remove(path, erc);
+              continue;
+            }
+            this->_disk_writing.reset();
+            this->_disk_cache_add(
+              address, write.data.size(), write.version, write.mutable_);
+          }
+        }
+
+        void
+        Cache::_disk_cache_add(Address address,
+                               uint64_t size,
+                               int version,
+                               bool mutable_)
+        {
+          // The file of an older version was replaced.
+          auto existing = this->_disk_cache.find(address);
+          if (existing != this->_disk_cache.end())
+          {
+            this->_disk_cache_used -= existing->size();
+            this->_disk_cache.erase(existing);
+          }
+          auto cached = CachedDiskBlock{address, size, now(), version, mutable_};
+          cached.validated(now());
+          this->_disk_cache.emplace(std::move(cached));
+          this->_disk_cache_used += size;
+          this->_disk_cache_dirty = true;
+          ELLE_DEBUG("add %f to disk cache (%s bytes)", address, size);
           while (this->_disk_cache_used > this->_disk_cache_size)
           {
             ELLE_ASSERT(!this->_disk_cache.empty());
             auto& order = this->_disk_cache.get<1>();
             auto it = order.begin();
-            auto path = *this->_disk_cache_path / elle::sprintf("%x", it->address());
-            ELLE_DEBUG("Pruning %s of size %s from cache", path, it->size());
-            boost::system::error_code erc;
-            this->_disk_cache_used -= it->size();
-            bfs::remove(path, erc);
-            if (erc)
-              ELLE_WARN("Error pruning %s from cache: %s", path, erc);
-            order.erase(it);
+            ELLE_DEBUG("prune %f of size %s from disk cache",
+                       it->address(), it->size());
+            this->_disk_cache_erase(this->_disk_cache.project<0>(it));
+          }
+        }
+
+        std::unique_ptr<blocks::Block>
+        Cache::_disk_cache_read(DiskCache::iterator it)
+        {
+          auto path = this->_disk_cache_file(it->address(), it->mutable_());
+          try
+          {
+            bfs::ifstream is(path, std::ios::binary);
+            if (!is.good())
+              elle::err("unable to open %s", path);
+            elle::serialization::binary::SerializerIn sin(is);
+            sin.set_context<Doughnut*>(&this->doughnut());
+            auto block = sin.deserialize<std::unique_ptr<blocks::Block>>();
+            this->_disk_cache.modify(
+              it, [] (CachedDiskBlock& b) { b.last_used(now()); });
+            this->_disk_cache_dirty = true;
+            return block;
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("%s: drop unreadable %f from disk cache: %s",
+                      this, it->address(), e);
+            this->_disk_cache_erase(it);
+            return nullptr;
+          }
+        }
+
+        void
+        Cache::_disk_cache_erase(DiskCache::iterator it)
+        {
+          auto path = this->_disk_cache_file(it->address(), it->mutable_());
+          boost::system::error_code erc;
+          bfs::remove(path, erc);
+          if (erc)
+            ELLE_WARN("Error pruning %s from cache: %s", path, erc);
+          this->_disk_cache_used -= it->size();
+          this->_disk_cache.erase(it);
+          this->_disk_cache_dirty = true;
+        }
+
+        void
+        Cache::_disk_cache_drop(Address address)
+        {
+          this->_disk_writes.erase(address);
+          if (this->_disk_writes.empty())
+            this->_disk_write_barrier.close();
+          if (this->_disk_writing == address)
+            this->_disk_writing.reset();
+          auto it = this->_disk_cache.find(address);
+          if (it != this->_disk_cache.end())
+          {
+            ELLE_DEBUG("drop %f from disk cache", address);
+            this->_disk_cache_erase(it);
           }
         }
 
+        bfs::path
+        Cache::_disk_cache_file(Address address, bool mutable_) const
+        {
+          auto const name = elle::sprintf("%x", address);
+          if (mutable_)
+            return *this->_disk_cache_path / "mutable" / name;
+          else
+            return *this->_disk_cache_path / name;
+        }
+
         /*------.
         | Cache |
         `------*/
@@ -425,24 +849,96 @@ namespace memo
           if (!this->_disk_cache_path)
             return;
           ELLE_TRACE_SCOPE("%s: reload disk cache", this);
-          int count = 0;
-          for (auto const& p: bfs::directory_iterator(*this->_disk_cache_path))
+          auto const index = *this->_disk_cache_path / disk_index;
+          if (bfs::exists(index))
+            try
+            {
+              bfs::ifstream is(index, std::ios::binary);
+              auto entries = elle::serialization::binary::deserialize<
+                std::vector<CachedDiskBlock>>(is, false);
+              for (auto& e: entries)
+              {
+                this->_disk_cache_used += e.size();
+                this->_disk_cache.emplace(std::move(e));
+              }
+              // Blocks cached after the index was last saved are picked up
+              // in the background.
+              this->_disk_cache_scan = true;
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("%s: ignore invalid disk cache index: %s", this, e);
+              this->_disk_cache.clear();
+              this->_disk_cache_used = 0;
+            }
+          if (!this->_disk_cache_scan)
+            this->_scan_disk_cache();
+          ELLE_TRACE("loaded %s blocks totalling %s bytes",
+                     this->_disk_cache.size(), this->_disk_cache_used);
+        }
+
+        void
+        Cache::_scan_disk_cache()
+        {
+          ELLE_DEBUG_SCOPE("%s: scan disk cache", this);
+          this->_disk_cache_scan = false;
+          auto scan = [&] (bfs::path const& dir, bool mutable_)
+            {
+              for (auto const& p: bfs::directory_iterator(dir))
+              {
+                if (!bfs::is_regular_file(p.path()))
+                  continue;
+                auto addr = Address::null;
+                try
+                {
+                  addr = Address::from_string(p.path().filename().string());
+                }
+                catch (elle::Error const&)
+                {
+                  continue;
+                }
+                if (this->_disk_cache.find(addr) != this->_disk_cache.end())
+                  continue;
+                auto sz = bfs::file_size(p);
+                // Never used nor validated, as far as we know.
+                this->_disk_cache.emplace(
+                  CachedDiskBlock{addr, sz, elle::Time(), -1, mutable_});
+                this->_disk_cache_used += sz;
+                this->_disk_cache_dirty = true;
+              }
+            };
+          scan(*this->_disk_cache_path, false);
+          scan(*this->_disk_cache_path / "mutable", true);
+        }
+
+        void
+        Cache::_save_disk_cache()
+        {
+          if (!this->_disk_cache_dirty)
+            return;
+          ELLE_DEBUG_SCOPE("%s: save disk cache index", this);
+          auto const index = *this->_disk_cache_path / disk_index;
+          auto const tmp = bfs::path(index.string() + ".tmp");
           {
-            auto sz = bfs::file_size(p);
-            auto addr = Address::from_string(p.path().filename().string());
-            this->_disk_cache.insert(CachedCHB{addr, sz, elle::Time()});
-            this->_disk_cache_used += sz;
-            ++count;
+            auto entries = std::vector<CachedDiskBlock>(
+              this->_disk_cache.begin(), this->_disk_cache.end());
+            bfs::ofstream os(tmp, std::ios::binary);
+            elle::serialization::binary::serialize(entries, os, false);
           }
-          ELLE_TRACE("loaded %s blocks totalling %s bytes",
-                     count, this->_disk_cache_used);
+          bfs::rename(tmp, index);
+          this->_disk_cache_dirty = false;
         }
 
         void
         Cache::clear()
         {
           ELLE_TRACE_SCOPE("%s: clear", *this);
+          for (auto const& cached: this->_cache)
+            if (cached.subscribed())
+              this->_unsubscribe(cached.address());
           this->_cache.clear();
+          this->_segment_bytes = {{0, 0, 0}};
+          this->_update_metrics();
         }
 
         void
@@ -455,6 +951,26 @@ namespace memo
               auto bs = bench.scoped();
               auto const now = consensus::now();
               ELLE_DEBUG_SCOPE("%s: cleanup cache", *this);
+              if (this->_disk_cache_scan)
+                this->_scan_disk_cache();
+              try
+              {
+                this->_save_disk_cache();
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_WARN("%s: unable to save disk cache index: %s", this, e);
+              }
+              ELLE_DEBUG("forget missing blocks")
+                for (auto it = this->_missing.begin();
+                     it != this->_missing.end();)
+                  if (it->second < now - this->_negative_ttl)
+                  {
+                    this->_unsubscribe(it->first);
+                    it = this->_missing.erase(it);
+                  }
+                  else
+                    ++it;
               ELLE_DEBUG("evict unused blocks")
               {
                 auto& order = this->_cache.get<1>();
@@ -463,8 +979,11 @@ namespace memo
                 while (it != order.end() && it->last_used() < deadline)
                 {
                   ELLE_DUMP("evict %s", it->block()->address());
-                  it = order.erase(it);
+                  auto next = std::next(it);
+                  this->_evict(this->_cache.project<0>(it), eviction_ttl);
+                  it = next;
                 }
+                this->_update_metrics();
               }
               // FIXME: take cache_size in account too
               ELLE_DEBUG("refresh obsolete blocks")
@@ -472,13 +991,17 @@ namespace memo
                 auto& order = this->_cache.get<2>();
                 auto deadline = now - this->_cache_invalidation;
                 std::vector<Model::AddressVersion> need_refresh;
+                // Owners notify changes of subscribed blocks, skip them.
+                std::vector<Address> notified;
                 for (auto it = order.begin(); it != order.end(); ++it)
                 {
                   auto& cached = *it;
                   if (!(cached.last_fetched() < deadline))
                     break;
                   auto const address = cached.block()->address();
-                  if (auto mb =
+                  if (cached.subscribed())
+                    notified.push_back(address);
+                  else if (auto mb =
                       dynamic_cast<blocks::MutableBlock*>(cached.block().get()))
                   {
                     need_refresh.push_back(std::make_pair(address, mb->version()));
@@ -489,6 +1012,12 @@ namespace memo
                     break;
                   }
                 }
+                for (auto const& address: notified)
+                {
+                  auto it = this->_cache.find(address);
+                  this->_cache.modify(
+                    it, [&] (CachedBlock& b) { b.last_fetched(now); });
+                }
                 static const int batch_size =
                   memo::getenv("CACHE_REFRESH_BATCH_SIZE", 20);
                 for (int i=0; i < signed(need_refresh.size()); i+= batch_size)
@@ -506,27 +1035,32 @@ namespace memo
                     [&](Address a, std::unique_ptr<blocks::Block> b,
                       std::exception_ptr e)
                     {
+                      auto it = this->_cache.find(a);
+                      if (it == this->_cache.end())
+                        return;
                       if (e)
                       {
                         ELLE_TRACE("fetch error on %f: %s",
                                    a, elle::exception_string(e));
-                        this->_cache.erase(a);
+                        this->_evict(it, eviction_invalidation);
                       }
                       else
                       {
-                        auto it = this->_cache.find(a);
-                        if (it != this->_cache.end())
-                          this->_cache.modify(
-                            it,
-                            [&] (CachedBlock& cache)
-                            {
-                              if (b)
-                                cache.block() = std::move(b);
-                              cache.last_fetched(now);
-                            });
+                        auto const size = b ? b->footprint() : it->size();
+                        this->_cache.modify(
+                          it,
+                          [&] (CachedBlock& cache)
+                          {
+                            if (b)
+                              cache.block() = std::move(b);
+                            cache.last_fetched(now);
+                          });
+                        this->_resize(it, size);
                       }
                     });
                   }
+                // Refreshed blocks may have grown.
+                this->_balance();
                 }
               }
             // FIXME: WHAT???
@@ -536,18 +1070,43 @@ namespace memo
           }
         }
 
-        Cache::CachedCHB::CachedCHB(Address address,
-                                    uint64_t size,
-                                    elle::Time last_used)
+        Cache::CachedDiskBlock::CachedDiskBlock(Address address,
+                                                uint64_t size,
+                                                elle::Time last_used,
+                                                int version,
+                                                bool mutable_)
           : _address(address)
           , _size(size)
           , _last_used(last_used)
+          , _version(version)
+          , _mutable_(mutable_)
+          , _validated()
         {}
 
+        Cache::CachedDiskBlock::CachedDiskBlock(
+          elle::serialization::SerializerIn& s)
+          : _validated()
+        {
+          this->serialize(s);
+        }
+
+        void
+        Cache::CachedDiskBlock::serialize(elle::serialization::Serializer& s)
+        {
+          s.serialize("address", this->_address);
+          s.serialize("size", this->_size);
+          s.serialize("last_used", this->_last_used);
+          s.serialize("version", this->_version);
+          s.serialize("mutable", this->_mutable_);
+        }
+
         Cache::CachedBlock::CachedBlock(std::unique_ptr<blocks::Block> block)
           : _block(std::move(block))
+          , _size(this->_block->footprint())
+          , _segment(window)
           , _last_used(now())
           , _last_fetched(now())
+          , _subscribed(false)
         {}
 
         Address
@@ -556,6 +1115,365 @@ namespace memo
           return this->_block->address();
         }
 
+        /*----------.
+        | Admission |
+        `----------*/
+
+        void
+        Cache::_cache_block(std::unique_ptr<blocks::Block> block)
+        {
+          auto const address = block->address();
+          if (this->_disk_cache_size)
+            this->_disk_cache_push(*block);
+          this->_sketch.increment(address);
+          auto it = this->_cache.find(address);
+          if (it != this->_cache.end())
+          {
+            auto const size = block->footprint();
+            this->_cache.modify(
+              it, [&] (CachedBlock& b) {
+                b.block() = std::move(block);
+                b.last_used(now());
+                b.last_fetched(now());
+              });
+            this->_resize(it, size);
+          }
+          else
+          {
+            it = this->_cache.emplace(std::move(block)).first;
+            this->_segment_bytes[window] += it->size();
+            auto const mb =
+              dynamic_cast<blocks::MutableBlock*>(it->block().get());
+            this->_subscribe(address, mb ? mb->version() : 0);
+          }
+          this->_balance();
+        }
+
+        void
+        Cache::_touch(BlockCache::iterator it)
+        {
+          ++this->_hits;
+#if MEMO_ENABLE_PROMETHEUS
+          if (this->_hit_counter)
+            this->_hit_counter->Increment();
+#endif
+          this->_sketch.increment(it->address());
+          this->_cache.modify(it, [] (CachedBlock& b) { b.last_used(now()); });
+          if (it->segment() == probation)
+          {
+            this->_move(it, protected_);
+            while (this->_segment_bytes[protected_] > this->_protected_size)
+              this->_move(*this->_lru(protected_), probation);
+          }
+        }
+
+        void
+        Cache::_resize(BlockCache::iterator it, std::size_t size)
+        {
+          this->_segment_bytes[it->segment()] -= it->size();
+          this->_segment_bytes[it->segment()] += size;
+          this->_cache.modify(it, [&] (CachedBlock& b) { b.size(size); });
+        }
+
+        void
+        Cache::_move(BlockCache::iterator it, Segment segment)
+        {
+          this->_segment_bytes[it->segment()] -= it->size();
+          this->_segment_bytes[segment] += it->size();
+          this->_cache.modify(
+            it, [&] (CachedBlock& b) { b.segment(segment); });
+        }
+
+        void
+        Cache::_evict(BlockCache::iterator it, Eviction reason)
+        {
+          ELLE_DEBUG("%s: evict %f (%s)",
+                     this, it->address(), eviction_names[reason]);
+          if (it->subscribed())
+            this->_unsubscribe(it->address());
+          if (reason == eviction_invalidation)
+          {
+            auto disk_hit = this->_disk_cache.find(it->address());
+            if (disk_hit != this->_disk_cache.end())
+              this->_disk_cache_erase(disk_hit);
+          }
+          this->_segment_bytes[it->segment()] -= it->size();
+          ++this->_evictions[reason];
+#if MEMO_ENABLE_PROMETHEUS
+          if (auto& counter = this->_eviction_counters[reason])
+            counter->Increment();
+#endif
+          this->_cache.erase(it);
+        }
+
+        boost::optional<Cache::BlockCache::iterator>
+        Cache::_lru(Segment segment)
+        {
+          auto& order = this->_cache.get<3>();
+          auto it = order.lower_bound(boost::make_tuple(segment));
+          if (it == order.end() || it->segment() != segment)
+            return boost::none;
+          return this->_cache.project<0>(it);
+        }
+
+        void
+        Cache::_balance()
+        {
+          auto const main_size =
+            std::size_t(this->_cache_size) - this->_window_size;
+          auto main_bytes = [this]
+            {
+              return this->_segment_bytes[probation] +
+                this->_segment_bytes[protected_];
+            };
+          auto main_lru = [this]
+            {
+              auto res = this->_lru(probation);
+              return res ? res : this->_lru(protected_);
+            };
+          // Blocks leaving the window only evict less frequent ones, so that
+          // scans do not flush the main segments.
+          while (this->_segment_bytes[window] > this->_window_size)
+          {
+            auto candidate = *this->_lru(window);
+            if (candidate->size() > main_size)
+            {
+              this->_evict(candidate, eviction_size);
+              continue;
+            }
+            auto const frequency = this->_sketch.frequency(candidate->address());
+            bool admit = true;
+            while (main_bytes() + candidate->size() > main_size)
+            {
+              auto victim = main_lru();
+              if (frequency <= this->_sketch.frequency((*victim)->address()))
+              {
+                admit = false;
+                break;
+              }
+              this->_evict(*victim, eviction_size);
+            }
+            if (admit)
+              this->_move(candidate, probation);
+            else
+              this->_evict(candidate, eviction_admission);
+          }
+          while (main_bytes() > main_size)
+            this->_evict(*main_lru(), eviction_size);
+          this->_update_metrics();
+        }
+
+        void
+        Cache::_update_metrics()
+        {
+#if MEMO_ENABLE_PROMETHEUS
+          if (this->_bytes_gauge)
+            this->_bytes_gauge->Set(
+              this->_segment_bytes[window] +
+              this->_segment_bytes[probation] +
+              this->_segment_bytes[protected_]);
+          if (this->_blocks_gauge)
+            this->_blocks_gauge->Set(this->_cache.size());
+#endif
+        }
+
+        /*-------------.
+        | Invalidation |
+        `-------------*/
+
+        void
+        Cache::_subscribe(Address address, int version)
+        {
+          if (!this->_paxos)
+            return;
+          this->_to_unsubscribe.erase(address);
+          this->_to_subscribe[address] = version;
+          this->_subscribe_barrier.open();
+        }
+
+        void
+        Cache::_unsubscribe(Address address)
+        {
+          if (!this->_paxos)
+            return;
+          this->_to_subscribe.erase(address);
+          this->_to_unsubscribe.emplace(address);
+          this->_subscribe_barrier.open();
+        }
+
+        void
+        Cache::_subscribe_loop()
+        {
+          while (true)
+          {
+            this->_subscribe_barrier.wait();
+            this->_subscribe_barrier.close();
+            try
+            {
+              if (!this->_to_unsubscribe.empty())
+              {
+                auto addresses = std::vector<Address>(
+                  this->_to_unsubscribe.begin(), this->_to_unsubscribe.end());
+                this->_to_unsubscribe.clear();
+                this->_paxos->unsubscribe(addresses);
+              }
+              if (!this->_to_subscribe.empty())
+              {
+                auto versions = std::move(this->_to_subscribe);
+                this->_to_subscribe.clear();
+                for (auto const& a: this->_paxos->subscribe(versions))
+                {
+                  auto it = this->_cache.find(a);
+                  // Evicted or invalidated meanwhile: the unsubscription or the
+                  // next notification will clear the owner side.
+                  if (it != this->_cache.end())
+                    this->_cache.modify(
+                      it, [] (CachedBlock& b) { b.subscribed(true); });
+                }
+              }
+            }
+            catch (elle::Error const& e)
+            {
+              // Unsubscribed blocks are still polled.
+              ELLE_WARN("%s: unable to update subscriptions: %s", this, e);
+            }
+          }
+        }
+
+        void
+        Cache::_invalidate(Address address, boost::optional<int> version)
+        {
+          // The notification consumed the subscription.
+          this->_missing.erase(address);
+          auto it = this->_cache.find(address);
+          if (it == this->_cache.end())
+            return;
+          // Subscriptions are one-shot.
+          this->_cache.modify(it, [] (CachedBlock& b) { b.subscribed(false); });
+          if (version)
+            if (auto mb =
+                dynamic_cast<blocks::MutableBlock*>(it->block().get()))
+              if (mb->version() >= *version)
+              {
+                ELLE_DEBUG("%s: cached %f is up to date (%s)",
+                           this, address, mb->version());
+                this->_subscribe(address, mb->version());
+                return;
+              }
+          ELLE_TRACE("%s: invalidate %f", this, address);
+          this->_evict(it, eviction_invalidation);
+          this->_update_metrics();
+          ++this->_invalidations;
+        }
+
+        /*------------.
+        | Prefetching |
+        `------------*/
+
+        void
+        Cache::_prefetch(std::vector<Address> const& addresses)
+        {
+          for (auto const& a: addresses)
+          {
+            if (this->_cache.find(a) != this->_cache.end() ||
+                this->_pending.count(a) ||
+                !this->_prefetch_queued.insert(a).second)
+            {
+              ++this->_prefetch_skips;
+              continue;
+            }
+            this->_prefetch_queue.push_back(a);
+            if (this->_prefetch_queue.size() > prefetch_queue_size)
+            {
+              // The oldest hints are the likeliest to be read already.
+              this->_prefetch_queued.erase(this->_prefetch_queue.front());
+              this->_prefetch_queue.pop_front();
+              ++this->_prefetch_skips;
+            }
+          }
+          if (this->_prefetch_queue.empty())
+            return;
+          while (this->_prefetch_threads.size() <
+                 std::min(std::size_t(this->_prefetch_concurrency),
+                          this->_prefetch_queue.size()))
+            this->_prefetch_threads.emplace_back(
+              new elle::reactor::Thread(
+                elle::sprintf("%s prefetch %s",
+                              *this, this->_prefetch_threads.size()),
+                [this] { this->_prefetch_loop(); }));
+          this->_prefetch_barrier.open();
+        }
+
+        void
+        Cache::_prefetch_loop()
+        {
+          while (true)
+          {
+            this->_prefetch_barrier.wait();
+            // Let foreground fetches go first.
+            elle::reactor::yield();
+            if (this->_prefetch_queue.empty())
+            {
+              this->_prefetch_barrier.close();
+              continue;
+            }
+            auto const address = this->_prefetch_queue.front();
+            this->_prefetch_queue.pop_front();
+            this->_prefetch_queued.erase(address);
+            this->_prefetch_block(address);
+          }
+        }
+
+        void
+        Cache::_prefetch_block(Address address)
+        {
+          auto disk_hit = this->_disk_cache.find(address);
+          // Immutable blocks are only kept on disk.
+          if ((!address.mutable_block() && !this->_disk_cache_size) ||
+              this->_cache.find(address) != this->_cache.end() ||
+              this->_pending.count(address) ||
+              this->_known_missing(address) ||
+              (disk_hit != this->_disk_cache.end() &&
+               (!disk_hit->mutable_() ||
+                !(disk_hit->validated() < now() - this->_cache_invalidation))))
+          {
+            ++this->_prefetch_skips;
+            return;
+          }
+          ELLE_TRACE_SCOPE("%s: prefetch %f", this, address);
+          // Register as pending so concurrent fetches wait for this one.
+          auto b = std::make_shared<elle::reactor::Barrier>();
+          this->_pending.emplace(address, b);
+          elle::SafeFinally sf([&]
+            {
+              b->open();
+              this->_pending.erase(address);
+            });
+          try
+          {
+            if (auto block = this->_backend->fetch(address))
+            {
+              this->_insert_cache(*block);
+              auto it = this->_disk_cache.find(address);
+              if (it != this->_disk_cache.end())
+                this->_disk_cache.modify(
+                  it, [] (CachedDiskBlock& cached) { cached.validated(now()); });
+            }
+            ++this->_prefetched;
+          }
+          catch (MissingBlock const& e)
+          {
+            ELLE_TRACE("%s: unable to prefetch %f: %s", this, address, e);
+            this->_missing_block(address);
+            ++this->_prefetch_failures;
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_TRACE("%s: unable to prefetch %f: %s", this, address, e);
+            ++this->_prefetch_failures;
+          }
+        }
+
         /*-----------.
         | Monitoring |
         `-----------*/
@@ -569,7 +1487,49 @@ namespace memo
         elle::json::Json
         Cache::stats()
         {
-          return this->_backend->stats();
+          auto res = this->_backend->stats();
+          auto subscribed = std::count_if(
+            this->_cache.begin(), this->_cache.end(),
+            [] (CachedBlock const& b) { return b.subscribed(); });
+          auto evictions = elle::json::Json::object();
+          for (auto i = 0; i < eviction_count; ++i)
+            evictions[eviction_names[i]] = this->_evictions[i];
+          auto const lookups = this->_hits + this->_misses;
+          res["cache"] = {
+            {"size", this->_cache_size},
+            {"bytes", {
+                {"window", this->_segment_bytes[window]},
+                {"probation", this->_segment_bytes[probation]},
+                {"protected", this->_segment_bytes[protected_]},
+              }},
+            {"blocks", this->_cache.size()},
+            {"hits", this->_hits},
+            {"misses", this->_misses},
+            {"hit_ratio", lookups ? double(this->_hits) / lookups : 0.},
+            {"evictions", evictions},
+            {"disk", {
+                {"blocks", this->_disk_cache.size()},
+                {"bytes", this->_disk_cache_used},
+                {"revalidations", this->_disk_revalidations},
+              }},
+            {"push_invalidation", bool(this->_paxos)},
+            {"subscribed", subscribed},
+            {"invalidations", this->_invalidations},
+            {"negative", {
+                {"ttl", std::chrono::duration_cast<std::chrono::milliseconds>(
+                    this->_negative_ttl).count()},
+                {"entries", this->_missing.size()},
+                {"hits", this->_negative_hits},
+              }},
+            {"prefetch", {
+                {"concurrency", this->_prefetch_concurrency},
+                {"queued", this->_prefetch_queue.size()},
+                {"fetched", this->_prefetched},
+                {"skipped", this->_prefetch_skips},
+                {"failed", this->_prefetch_failures},
+              }},
+          };
+          return res;
         }
       }
     }
@@ -1,17 +1,27 @@
 #pragma once
 
+#include <array>
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 #include <chrono>
 
 #include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
+#include <boost/signals2.hpp>
+
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Thread.hh>
 
 #include <memo/model/blocks/MutableBlock.hh>
 #include <memo/model/doughnut/Consensus.hh>
+#include <memo/model/doughnut/FrequencySketch.hh>
+#include <memo/model/prometheus.hh>
 
 namespace memo
 {
@@ -24,6 +34,25 @@ namespace memo
       namespace consensus
       {
         namespace bmi = boost::multi_index;
+        class Paxos;
+
+        /// Cache of blocks on top of another consensus.
+        ///
+        /// Mutable blocks are kept in RAM up to `cache_size` bytes, following
+        /// W-TinyLFU: new blocks enter a small LRU window, and only make it
+        /// to the main segmented LRU if they were accessed more frequently
+        /// than the blocks they would evict.
+        ///
+        /// If a `disk_cache_path` is given, blocks are also kept on disk up to
+        /// `disk_cache_size` bytes, along with an index of them for restarts
+        /// to be warm.  Mutable blocks from the disk are checked to be up to
+        /// date through their version before use.  Blocks are written to disk
+        /// in the background.
+        ///
+        /// Addresses found missing are remembered for a short while, sparing
+        /// existence checks a trip to the backend.  With push invalidation,
+        /// they are subscribed to as well, so that their insertion elsewhere
+        /// is seen before they expire.
         class Cache
           : public StackedConsensus
         {
@@ -58,6 +87,10 @@ namespace memo
           void
           _fetch(std::vector<AddressVersion> const& addresses,
                  ReceiveBlock fun) override;
+          /// Queue blocks to be fetched in the background, at most
+          /// `MEMO_CACHE_PREFETCH_CONCURRENCY` at a time.
+          void
+          _prefetch(std::vector<Address> const& addresses) override;
           void
           _remove(Address address, blocks::RemoveSignature rs) override;
 
@@ -91,9 +124,32 @@ namespace memo
           _copy(blocks::Block& block);
           ELLE_ATTRIBUTE_R(elle::Duration, cache_invalidation);
           ELLE_ATTRIBUTE_R(elle::Duration, cache_ttl);
+          /// RAM cache budget, in bytes.
           ELLE_ATTRIBUTE_R(int, cache_size);
           ELLE_ATTRIBUTE_R(boost::optional<bfs::path>, disk_cache_path);
           ELLE_ATTRIBUTE_R(uint64_t, disk_cache_size);
+          /// W-TinyLFU segments.
+          enum Segment
+          {
+            /// Recently inserted blocks.
+            window,
+            /// Admitted blocks, accessed once since.
+            probation,
+            /// Admitted blocks, accessed several times since.
+            protected_,
+          };
+          enum Eviction
+          {
+            /// Evicted to make room.
+            eviction_size,
+            /// Denied admission in favor of a more frequent block.
+            eviction_admission,
+            /// Unused for longer than `cache_ttl`.
+            eviction_ttl,
+            /// Known to be stale.
+            eviction_invalidation,
+            eviction_count,
+          };
           class CachedBlock
           {
           public:
@@ -101,8 +157,13 @@ namespace memo
             Address
             address() const;
             ELLE_ATTRIBUTE_RX(std::unique_ptr<blocks::Block>, block);
+            /// Footprint of the block, in bytes.
+            ELLE_ATTRIBUTE_RW(std::size_t, size);
+            ELLE_ATTRIBUTE_RW(Segment, segment);
             ELLE_ATTRIBUTE_RW(elle::Time, last_used);
             ELLE_ATTRIBUTE_RW(elle::Time, last_fetched);
+            /// Whether owners notify changes, sparing refreshes.
+            ELLE_ATTRIBUTE_RW(bool, subscribed);
           };
           /// Sort mutable blocks first, ordered by last_fetched
           struct LastFetch
@@ -125,38 +186,190 @@ namespace memo
               bmi::ordered_non_unique<
                 bmi::const_mem_fun<
                   CachedBlock,
-                  elle::Time const&, &CachedBlock::last_fetched> >
+                  elle::Time const&, &CachedBlock::last_fetched> >,
+              bmi::ordered_non_unique<
+                bmi::composite_key<
+                  CachedBlock,
+                  bmi::const_mem_fun<
+                    CachedBlock, Segment, &CachedBlock::segment>,
+                  bmi::const_mem_fun<
+                    CachedBlock,
+                    elle::Time const&, &CachedBlock::last_used> > >
             > >;
           ELLE_ATTRIBUTE(BlockCache, cache);
-          class CachedCHB
+        private:
+          /// Add a fresh block in the window, or refresh a cached one.
+          void
+          _cache_block(std::unique_ptr<blocks::Block> block);
+          /// Record an access to a cached block.
+          void
+          _touch(BlockCache::iterator it);
+          void
+          _resize(BlockCache::iterator it, std::size_t size);
+          void
+          _move(BlockCache::iterator it, Segment segment);
+          void
+          _evict(BlockCache::iterator it, Eviction reason);
+          /// Least recently used block of `segment`, if any.
+          boost::optional<BlockCache::iterator>
+          _lru(Segment segment);
+          /// Admit or reject blocks out of the window and evict blocks until
+          /// budgets are met.
+          void
+          _balance();
+          void
+          _update_metrics();
+          ELLE_ATTRIBUTE(FrequencySketch, sketch);
+          /// Bytes used by each segment.
+          ELLE_ATTRIBUTE((std::array<std::size_t, 3>), segment_bytes);
+          ELLE_ATTRIBUTE(std::size_t, window_size);
+          ELLE_ATTRIBUTE(std::size_t, protected_size);
+          ELLE_ATTRIBUTE_R(int64_t, hits);
+          ELLE_ATTRIBUTE_R(int64_t, misses);
+          ELLE_ATTRIBUTE((std::array<int64_t, eviction_count>), evictions);
+#if MEMO_ENABLE_PROMETHEUS
+          ELLE_ATTRIBUTE(prometheus::CounterPtr, hit_counter);
+          ELLE_ATTRIBUTE(prometheus::CounterPtr, miss_counter);
+          ELLE_ATTRIBUTE(prometheus::GaugePtr, bytes_gauge);
+          ELLE_ATTRIBUTE(prometheus::GaugePtr, blocks_gauge);
+          ELLE_ATTRIBUTE((std::array<prometheus::CounterPtr, eviction_count>),
+                         eviction_counters);
+#endif
+          class CachedDiskBlock
           {
           public:
-            CachedCHB(Address address, uint64_t size, elle::Time last_used);
+            CachedDiskBlock(Address address,
+                            uint64_t size,
+                            elle::Time last_used,
+                            int version,
+                            bool mutable_);
+            CachedDiskBlock(elle::serialization::SerializerIn& s);
+            void
+            serialize(elle::serialization::Serializer& s);
             ELLE_ATTRIBUTE_R(Address, address);
             ELLE_ATTRIBUTE_R(uint64_t, size);
             ELLE_ATTRIBUTE_RW(elle::Time, last_used);
+            /// Version of mutable blocks, -1 if unknown.
+            ELLE_ATTRIBUTE_R(int, version);
+            ELLE_ATTRIBUTE_R(bool, mutable_);
+            /// When a mutable block was last known to be up to date.
+            ELLE_ATTRIBUTE_RW(elle::Time, validated);
           };
-          using CHBDiskCache = bmi::multi_index_container<
-            CachedCHB,
+          using DiskCache = bmi::multi_index_container<
+            CachedDiskBlock,
             bmi::indexed_by<
               bmi::hashed_unique<
                 bmi::const_mem_fun<
-                  CachedCHB,
-                  Address const&, &CachedCHB::address> >,
+                  CachedDiskBlock,
+                  Address const&, &CachedDiskBlock::address> >,
               bmi::ordered_non_unique<
                 bmi::const_mem_fun<
-                  CachedCHB,
-                  elle::Time const&, &CachedCHB::last_used> >
+                  CachedDiskBlock,
+                  elle::Time const&, &CachedDiskBlock::last_used> >
           > >;
-          ELLE_ATTRIBUTE(CHBDiskCache, disk_cache);
+          ELLE_ATTRIBUTE(DiskCache, disk_cache);
           ELLE_ATTRIBUTE(uint64_t, disk_cache_used);
+          /// Whether the index misses changes to the disk cache.
+          ELLE_ATTRIBUTE(bool, disk_cache_dirty);
+          /// Whether files missing from the index must be looked for.
+          ELLE_ATTRIBUTE(bool, disk_cache_scan);
+          ELLE_ATTRIBUTE_R(int64_t, disk_revalidations);
+          struct DiskWrite
+          {
+            elle::Buffer data;
+            /// Block version, -1 for immutable blocks.
+            int version;
+            bool mutable_;
+          };
+          /// Blocks waiting to be written to the disk cache.
+          ELLE_ATTRIBUTE((std::unordered_map<Address, DiskWrite>), disk_writes);
+          /// Block being written, reset if dropped meanwhile.
+          ELLE_ATTRIBUTE(boost::optional<Address>, disk_writing);
+          ELLE_ATTRIBUTE(elle::reactor::Barrier, disk_write_barrier);
+          ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, disk_write_thread);
           ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, cleanup_thread);
         private:
           void _load_disk_cache();
+          /// Register block files missing from the disk cache.
+          void _scan_disk_cache();
+          void _save_disk_cache();
+          /// Queue `block` to be written to the disk cache.
           void _disk_cache_push(blocks::Block& block);
+          /// Write queued blocks to the disk cache, off the reactor thread.
+          void _disk_cache_write_loop();
+          /// Index a freshly written block file of `size` bytes.
+          void _disk_cache_add(Address address,
+                               uint64_t size,
+                               int version,
+                               bool mutable_);
+          /// Read a block from the disk cache, dropping it if unreadable.
+          std::unique_ptr<blocks::Block>
+          _disk_cache_read(DiskCache::iterator it);
+          void _disk_cache_erase(DiskCache::iterator it);
+          /// Drop `address` from the disk cache, including pending writes.
+          void _disk_cache_drop(Address address);
+          bfs::path
+          _disk_cache_file(Address address, bool mutable_) const;
           using Pending
             = std::unordered_map<Address, std::shared_ptr<elle::reactor::Barrier>>;
           ELLE_ATTRIBUTE(Pending, pending);
+          /// Whether `address` was found missing less than `negative_ttl` ago.
+          bool
+          _known_missing(Address address);
+          void
+          _missing_block(Address address);
+          /// Forget `address` is missing, unsubscribing from it.
+          void
+          _forget_missing(Address address);
+          /// When addresses were last found missing.
+          ELLE_ATTRIBUTE((std::unordered_map<Address, elle::Time>), missing);
+          /// How long missing addresses are remembered, zero to disable.
+          ELLE_ATTRIBUTE_R(elle::Duration, negative_ttl);
+          ELLE_ATTRIBUTE_R(int64_t, negative_hits);
+
+        /*-------------.
+        | Invalidation |
+        `-------------*/
+        private:
+          /// Subscribe to changes of `address`, cached at `version`, -1 if
+          /// missing.
+          void
+          _subscribe(Address address, int version);
+          void
+          _unsubscribe(Address address);
+          void
+          _subscribe_loop();
+          void
+          _invalidate(Address address, boost::optional<int> version);
+          /// Paxos backend to get change notifications from, if enabled.
+          ELLE_ATTRIBUTE(Paxos*, paxos);
+          ELLE_ATTRIBUTE(boost::signals2::scoped_connection, invalidated);
+          /// Addresses to subscribe to, with their cached version.
+          ELLE_ATTRIBUTE((std::unordered_map<Address, int>), to_subscribe);
+          ELLE_ATTRIBUTE(std::unordered_set<Address>, to_unsubscribe);
+          ELLE_ATTRIBUTE(elle::reactor::Barrier, subscribe_barrier);
+          ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, subscribe_thread);
+          ELLE_ATTRIBUTE_R(int64_t, invalidations);
+
+        /*------------.
+        | Prefetching |
+        `------------*/
+        private:
+          void
+          _prefetch_loop();
+          /// Fetch and cache a block, unless cached or being fetched already.
+          void
+          _prefetch_block(Address address);
+          ELLE_ATTRIBUTE(std::deque<Address>, prefetch_queue);
+          ELLE_ATTRIBUTE(std::unordered_set<Address>, prefetch_queued);
+          ELLE_ATTRIBUTE(elle::reactor::Barrier, prefetch_barrier);
+          ELLE_ATTRIBUTE_R(int, prefetch_concurrency);
+          ELLE_ATTRIBUTE(std::vector<elle::reactor::Thread::unique_ptr>,
+                         prefetch_threads);
+          ELLE_ATTRIBUTE_R(int64_t, prefetched);
+          /// Prefetches found cached or pending, or dropped from a full queue.
+          ELLE_ATTRIBUTE_R(int64_t, prefetch_skips);
+          ELLE_ATTRIBUTE_R(int64_t, prefetch_failures);
         };
       }
     }
@@ -0,0 +1,238 @@
+#include <memo/model/doughnut/Compression.hh>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+#include <elle/err.hh>
+#include <elle/format/deflate.hh>
+#include <elle/log.hh>
+#include <elle/unreachable.hh>
+
+#include <memo/environ.hh>
+#include <memo/model/doughnut/crypto.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.Compression");
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace compression
+      {
+        namespace
+        {
+          struct Stats
+          {
+            int64_t none = 0;
+            int64_t deflate = 0;
+            int64_t plain_bytes = 0;
+            int64_t compressed_bytes = 0;
+          };
+
+          Stats&
+          _stats()
+          {
+            static auto res = Stats{};
+            return res;
+          }
+
+          bool
+          enabled()
+          {
+            static auto const res = memo::getenv("BLOCK_COMPRESSION", true);
+            return res;
+          }
+
+          /// Codec byte, then the plain size on 4 bytes.
+          auto constexpr header_size = 5;
+          /// Smaller payloads are not worth compressing.
+          auto constexpr min_size = 128;
+          /// Samples above this entropy are deemed incompressible.
+          auto constexpr max_entropy = 7.5;
+          /// Samples below this entropy are compressed harder.
+          auto constexpr low_entropy = 4.0;
+          /// Bound of the deflate compression ratio.
+          auto constexpr max_ratio = 1032;
+
+          /// Run `action` on the background pool for large payloads.
+          void
+          run(std::size_t size, std::function<void ()> const& action)
+          {
+            if (size > 65536)
+              crypto_background(action);
+            else
+              action();
+          }
+        }
+
+        elle::Version const&
+        version()
+        {
+          static auto const res = elle::Version(0, 10, 0);
+          return res;
+        }
+
+        std::ostream&
+        operator <<(std::ostream& out, Codec codec)
+        {
+          switch (codec)
+          {
+            case Codec::none:
+              return out << "none";
+            case Codec::deflate:
+              return out << "deflate";
+          }
+          elle::unreachable();
+        }
+
+        bool
+        packed(elle::Version const& v)
+        {
+          return v >= version();
+        }
+
+        double
+        entropy(elle::ConstWeakBuffer data)
+        {
+          auto counts = std::array<int64_t, 256>{};
+          auto total = int64_t(0);
+          auto const count = [&] (uint8_t const* p, std::size_t size)
+            {
+              for (auto i = 0u; i < size; ++i)
+                ++counts[p[i]];
+              total += size;
+            };
+          // Count evenly spread slices, enough to tell text from noise.
+          auto constexpr slices = 16;
+          auto constexpr slice = 256;
+          if (data.size() <= slices * slice)
+            count(data.contents(), data.size());
+          else
+          {
+            auto const stride = (data.size() - slice) / (slices - 1);
+            for (auto i = 0; i < slices; ++i)
+              count(data.contents() + i * stride, slice);
+          }
+          auto res = 0.;
+          for (auto c: counts)
+            if (c)
+            {
+              auto const p = double(c) / total;
+              res -= p * std::log2(p);
+            }
+          return res;
+        }
+
+        elle::Buffer
+        pack(elle::ConstWeakBuffer data)
+        {
+          auto& stats = _stats();
+          auto const plain = [&]
+            {
+              ++stats.none;
+              auto res = elle::Buffer{};
+              res.capacity(data.size() + 1);
+              auto const codec = uint8_t(Codec::none);
+              res.append(&codec, 1);
+              res.append(data.contents(), data.size());
+              return res;
+            };
+          if (!enabled() || data.size() < min_size ||
+              data.size() > std::numeric_limits<uint32_t>::max())
+            return plain();
+          auto const e = entropy(data);
+          if (e > max_entropy)
+          {
+            ELLE_DEBUG("keep %s bytes of entropy %.2f", data.size(), e);
+            return plain();
+          }
+          auto const level = e < low_entropy ? 6 : 1;
+          auto compressed = elle::Buffer{};
+          run(data.size(), [&]
+              {
+                compressed = elle::format::deflate::compress(data, level);
+              });
+          if (header_size + compressed.size() > data.size() - data.size() / 8)
+          {
+            ELLE_DEBUG("keep %s bytes, compressing to %s is not worth it",
+                       data.size(), compressed.size());
+            return plain();
+          }
+          ELLE_DEBUG("compress %s bytes of entropy %.2f to %s at level %s",
+                     data.size(), e, compressed.size(), level);
+          auto res = elle::Buffer(header_size + compressed.size());
+          auto const size = uint32_t(data.size());
+          res[0] = uint8_t(Codec::deflate);
+          for (auto i = 0; i < 4; ++i)
+            res[1 + i] = (size >> (8 * (3 - i))) & 0xff;
+          std::memcpy(res.mutable_contents() + header_size,
+                      compressed.contents(), compressed.size());
+          ++stats.deflate;
+          stats.plain_bytes += data.size();
+          stats.compressed_bytes += res.size();
+          return res;
+        }
+
+        Codec
+        codec(elle::ConstWeakBuffer data)
+        {
+          if (data.size() < 1)
+            elle::err("empty packed payload");
+          auto const res = Codec(data.contents()[0]);
+          if (res != Codec::none && res != Codec::deflate)
+            elle::err("unknown payload codec: %s", int(data.contents()[0]));
+          return res;
+        }
+
+        elle::Buffer
+        unpack(elle::ConstWeakBuffer data)
+        {
+          switch (codec(data))
+          {
+            case Codec::none:
+              return elle::Buffer(data.contents() + 1, data.size() - 1);
+            case Codec::deflate:
+            {
+              if (data.size() < header_size)
+                elle::err("truncated compressed payload");
+              auto size = uint32_t(0);
+              for (auto i = 1; i < header_size; ++i)
+                size = (size << 8) | data.contents()[i];
+              auto const compressed = elle::ConstWeakBuffer(
+                data.contents() + header_size, data.size() - header_size);
+              // Do not allocate more than the payload could decompress to.
+              if (size > uint64_t(compressed.size()) * max_ratio)
+                elle::err("compressed payload of %s bytes cannot hold %s",
+                          compressed.size(), size);
+              auto res = elle::Buffer{};
+              run(size, [&]
+                  {
+                    res = elle::format::deflate::decompress(compressed, size);
+                  });
+              return res;
+            }
+          }
+          elle::unreachable();
+        }
+
+        elle::json::Json
+        stats()
+        {
+          auto const& stats = _stats();
+          return {
+            {"enabled", enabled()},
+            {"none", stats.none},
+            {"deflate", stats.deflate},
+            {"plain_bytes", stats.plain_bytes},
+            {"compressed_bytes", stats.compressed_bytes},
+          };
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <iosfwd>
+
+#include <elle/Buffer.hh>
+#include <elle/Version.hh>
+#include <elle/json/json.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Compression of CHB and ACB payloads before sealing.
+      ///
+      /// Sealed payloads are encrypted, so that nothing below the block
+      /// layer can compress them.  From compatibility version `version()`,
+      /// payloads are packed before being hashed or encrypted: a header
+      /// byte gives the codec, followed for compressed payloads by the
+      /// plain size and the compressed bytes.  Whether a block's payload is
+      /// packed is stored with it: as a flag for CHBs, and as its seal
+      /// version for ACBs.
+      ///
+      /// Payloads are compressed only if a sample looks compressible and
+      /// compression saves at least an eighth of their size.
+      namespace compression
+      {
+        enum class Codec
+        {
+          none = 0,
+          deflate = 1,
+        };
+
+        std::ostream&
+        operator <<(std::ostream& out, Codec codec);
+
+        /// First compatibility version packing payloads.
+        elle::Version const&
+        version();
+        /// Whether payloads are packed at compatibility version `v`.
+        bool
+        packed(elle::Version const& v);
+        /// Shannon entropy of a sample of `data`, in bits per byte.
+        double
+        entropy(elle::ConstWeakBuffer data);
+        /// Pack `data`, compressing it unless disabled by
+        /// MEMO_BLOCK_COMPRESSION or not worth it.
+        elle::Buffer
+        pack(elle::ConstWeakBuffer data);
+        /// Codec of packed `data`.
+        Codec
+        codec(elle::ConstWeakBuffer data);
+        /// Unpack `data`, decompressing it if needed.
+        ///
+        /// @throws elle::Error if `data` is not a valid packed payload.
+        elle::Buffer
+        unpack(elle::ConstWeakBuffer data);
+        /// Packed payloads, by codec, and bytes saved.
+        elle::json::Json
+        stats();
+      }
+    }
+  }
+}
@@ -1,7 +1,9 @@
 #include <memo/model/doughnut/Consensus.hh>
 
+#include <elle/algorithm.hh>
 #include <elle/os/environ.hh>
 
+#include <memo/environ.hh>
 #include <memo/silo/MissingKey.hh>
 #include <memo/model/Conflict.hh>
 #include <memo/model/doughnut/Doughnut.hh>
@@ -26,6 +28,7 @@ namespace memo
       {
         Consensus::Consensus(Doughnut& doughnut)
           : _doughnut(doughnut)
+          , _hedged_fetches(0)
         {}
 
         void
@@ -123,6 +126,17 @@ namespace memo
           }
         }
 
+        void
+        Consensus::prefetch(std::vector<Address> const& addresses)
+        {
+          ELLE_TRACE_SCOPE("%s: prefetch %s", *this, addresses);
+          this->_prefetch(addresses);
+        }
+
+        void
+        Consensus::_prefetch(std::vector<Address> const&)
+        {}
+
         std::unique_ptr<blocks::Block>
         Consensus::_fetch(Address address, boost::optional<int> last_version)
         {
@@ -244,67 +258,120 @@ namespace memo
                                       Address address,
                                       boost::optional<int> local_version)
         {
-          bool hit = false;
-          // try connecting to all peers in parallel
-          auto connected_peers = MemberGenerator(
-            [&](MemberGenerator::yielder yield)
+          auto members = std::vector<overlay::Overlay::Member>{};
+          for (auto wp: peers)
+            if (auto p = wp.lock())
+              members.emplace_back(std::move(p));
+            else
+              ELLE_TRACE("peer was deleted while fetching");
+          // Spread the load among members we know nothing about.
+          elle::shuffle(members);
+          static bool const balance =
+            !elle::os::getenv("INFINIT_DISABLE_BALANCED_TRANSFERS", false);
+          auto const cost = [] (overlay::Overlay::Member const& p)
+          {
+            auto const rtt = p->rtt().value_or(elle::Duration::zero());
+            return balance ? rtt * (1 + p->fetching()) : rtt;
+          };
+          std::stable_sort(
+            members.begin(), members.end(),
+            [&] (overlay::Overlay::Member const& lhs,
+                 overlay::Overlay::Member const& rhs)
             {
-              elle::With<elle::reactor::Scope>() <<
-              [&peers,&yield,&hit] (elle::reactor::Scope& s)
-              {
-                for (auto wp: peers)
-                  if (auto p = wp.lock())
-                  {
-                    hit = true;
-                    s.run_background(elle::sprintf("connect to %s", *p),
-                    [p,&yield]
+              return cost(lhs) < cost(rhs);
+            });
+          ELLE_DUMP("will try members in that order: %s", members);
+          auto const delay = this->_hedge_delay();
+          auto res = std::unique_ptr<blocks::Block>{};
+          auto found = false;
+          auto running = 0;
+          auto next = 0u;
+          // Opened whenever an attempt ends.
+          elle::reactor::Barrier ended;
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+          {
+            auto const attempt = [&]
+            {
+              auto peer = members[next++];
+              ++running;
+              s.run_background(
+                elle::sprintf("fetch %f from %s", address, *peer),
+                [&, peer]
+                {
+                  elle::SafeFinally end([&]
                     {
-                      try
-                      {
-                        if (auto remote = std::dynamic_pointer_cast<Remote>(p))
-                          remote->safe_perform("connect", [&] { yield(p);});
-                        else
-                          yield(p);
-                      }
-                      catch (elle::Error const& e)
-                      {
-                        ELLE_TRACE("connect to peer %s failed: %s", p, e.what());
-                      }
+                      --running;
+                      ended.open();
                     });
+                  auto const start = std::chrono::steady_clock::now();
+                  try
+                  {
+                    ELLE_TRACE_SCOPE("fetch from %s", peer);
+                    auto block = peer->fetch(address, local_version);
+                    if (!found)
+                    {
+                      found = true;
+                      res = std::move(block);
+                    }
+                  }
+                  // Some overlays may return peers even if they don't have
+                  // the block, try the next ones.
+                  catch (elle::Error const& e)
+                  {
+                    ELLE_TRACE("attempt fetching %f from %s failed: %s",
+                               address, *peer, e.what());
+                    return;
                   }
-                  else
-                    ELLE_TRACE("peer was deleted while fetching");
-
-                elle::reactor::wait(s);
-              };
-          });
-          // try to get on all connected peers sequentially to avoid wasting
-          // bandwidth
-          int attempt = 0;
-          for (auto wpeer: connected_peers)
-            if (auto peer = wpeer.lock())
+                  this->_fetch_latencies.emplace_back(
+                    std::chrono::duration_cast<elle::Duration>(
+                      std::chrono::steady_clock::now() - start));
+                  if (this->_fetch_latencies.size() > 256)
+                    this->_fetch_latencies.pop_front();
+                });
+            };
+            // Ask members one at a time to avoid wasting bandwidth, unless
+            // the current ones are too slow.
+            while (!found && (running || next < members.size()))
             {
-              ++attempt;
-              try
+              if (!running)
+                attempt();
+              else if (!elle::reactor::wait(ended, delay) &&
+                       next < members.size())
               {
-                ELLE_TRACE_SCOPE("fetch from %s", peer);
-                return peer->fetch(address, local_version);
-              }
-              // FIXME: get rid of that
-              catch (elle::Error const& e)
-              {
-                ELLE_TRACE("attempt fetching %f from %s failed: %s",
-                           address, *peer, e.what());
+                ELLE_TRACE("fetching %f is slow, ask %s too",
+                           address, *members[next]);
+                ++this->_hedged_fetches;
+                attempt();
               }
+              ended.close();
             }
-            else
-              ELLE_TRACE("peer was deleted while fetching");
+            s.terminate_now();
+          };
+          if (found)
+            return res;
           // Some overlays may return peers even if they don't have the block,
           // so we have to return MissingBlock here.
-          ELLE_TRACE("all %s peers failed fetching %f", attempt, address);
+          ELLE_TRACE("all %s peers failed fetching %f", next, address);
           throw MissingBlock(address);
         }
 
+        elle::DurationOpt
+        Consensus::_hedge_delay() const
+        {
+          static auto const percentile =
+            memo::getenv("FETCH_HEDGE_PERCENTILE", 95);
+          if (percentile <= 0 || percentile >= 100)
+            return {};
+          // Don't hedge on too few samples, a single slow fetch would do.
+          if (this->_fetch_latencies.size() < 16)
+            return std::chrono::seconds(1);
+          auto latencies = std::vector<elle::Duration>(
+            this->_fetch_latencies.begin(), this->_fetch_latencies.end());
+          auto nth = latencies.begin() + latencies.size() * percentile / 100;
+          std::nth_element(latencies.begin(), nth, latencies.end());
+          return *nth;
+        }
+
         /*-----.
         | Stat |
         `-----*/
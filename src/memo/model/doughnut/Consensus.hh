@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+
 #include <elle/Clonable.hh>
 
 #include <memo/model/Model.hh>
@@ -45,10 +47,19 @@ namespace memo
                 ReceiveBlock res);
           std::unique_ptr<blocks::Block>
           fetch(Address address, boost::optional<int> local_version = {});
+          /// Fetch blocks in the background, if this consensus caches them.
+          void
+          prefetch(std::vector<Address> const& addresses);
           void
           remove(Address address, blocks::RemoveSignature rs);
           using MemberGenerator = overlay::Overlay::MemberGenerator;
-          static
+          /// Fetch `address` from the first of `peers` to answer.
+          ///
+          /// Peers are asked by increasing round-trip time, weighted by the
+          /// fetches they are already serving.  Should a peer take longer than
+          /// the `MEMO_FETCH_HEDGE_PERCENTILE`th percentile of recent fetches,
+          /// the next one is asked as well, and the first answer cancels the
+          /// others.
           std::unique_ptr<blocks::Block>
           fetch_from_members(MemberGenerator& peers,
                              Address address,
@@ -74,10 +85,21 @@ namespace memo
                  ReceiveBlock res);
           virtual
           void
+          _prefetch(std::vector<Address> const& addresses);
+          virtual
+          void
           _remove(Address address, blocks::RemoveSignature rs);
           virtual
           void
           _resign();
+        private:
+          /// Delay after which to ask another member, if any.
+          elle::DurationOpt
+          _hedge_delay() const;
+          /// Durations of the latest successful fetches from members.
+          ELLE_ATTRIBUTE((std::deque<elle::Duration>), fetch_latencies);
+          /// Number of fetches sent to another member after a slow one.
+          ELLE_ATTRIBUTE_R(int64_t, hedged_fetches);
 
         /*-----.
         | Stat |
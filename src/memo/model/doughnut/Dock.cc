@@ -45,6 +45,22 @@ namespace
       }
     }
   }
+
+#if MEMO_ENABLE_PROMETHEUS
+  /// A counter of completed handshakes, full or resumed.
+  memo::prometheus::CounterPtr
+  make_handshake_counter(memo::model::doughnut::Doughnut const& dht,
+                         bool resumed)
+  {
+    static auto* family = memo::prometheus::make_counter_family(
+      "memo_handshakes",
+      "How many peer handshakes completed, in full or resumed");
+    return memo::prometheus::make(
+      family,
+      {{"id", elle::sprintf("%f", dht.id())},
+       {"kind", resumed ? "resumed" : "full"}});
+  }
+#endif
 }
 
 namespace memo
@@ -70,6 +86,12 @@ namespace memo
         , _utp_server(doughnut.local() ?
                       *doughnut.local()->utp_server() :
                       *this->_local_utp_server)
+        , _full_handshakes(0)
+        , _resumed_handshakes(0)
+#if MEMO_ENABLE_PROMETHEUS
+        , _full_handshakes_counter(make_handshake_counter(doughnut, false))
+        , _resumed_handshakes_counter(make_handshake_counter(doughnut, true))
+#endif
       {
         ELLE_TRACE_SCOPE("%s: construct", this);
         ELLE_DEBUG("tcp heartbeat: %s", tcp_heartbeat);
@@ -107,6 +129,14 @@ namespace memo
         : _doughnut(source._doughnut)
         , _local_utp_server(std::move(source._local_utp_server))
         , _utp_server(source._utp_server)
+        , _tickets(std::move(source._tickets))
+        , _sessions(std::move(source._sessions))
+        , _full_handshakes(source._full_handshakes)
+        , _resumed_handshakes(source._resumed_handshakes)
+        , _full_handshakes_counter(
+          std::move(source._full_handshakes_counter))
+        , _resumed_handshakes_counter(
+          std::move(source._resumed_handshakes_counter))
       {}
 
       Dock::~Dock()
@@ -249,6 +279,7 @@ namespace memo
         : _dock(dock)
         , _location(l)
         , _socket(nullptr)
+        , _aead(false)
         , _connected(false)
         , _disconnected(false)
         , _disconnected_since(std::chrono::system_clock::now())
@@ -606,6 +637,11 @@ namespace memo
         auto& dht = this->_dock.doughnut();
         try
         {
+          if (version >= elle::Version(0, 7, 0) && this->_resume(channels))
+          {
+            this->_negotiate_aead(channels);
+            return;
+          }
           auto challenge_passport = [&]
           {
             if (version >= elle::Version(0, 7, 0))
@@ -657,9 +693,14 @@ namespace memo
             if (this->dock().doughnut().encrypt_options().encrypt_rpc)
             {
               this->_rpc_server._key.emplace(key);
+              if (version >= elle::Version(0, 7, 0))
+                this->_dock._tickets.add(
+                  this->_location.id(), elle::Buffer(password));
               this->_credentials = std::move(password);
             }
           }
+          this->_negotiate_aead(channels);
+          this->_dock.handshake(false);
         }
         catch (elle::Error& e)
         {
@@ -669,6 +710,115 @@ namespace memo
         }
       }
 
+      bool
+      Dock::Connection::_resume(elle::protocol::ChanneledStream& channels)
+      {
+        if (!this->_location.id() ||
+            !this->_dock.doughnut().encrypt_options().encrypt_rpc)
+          return false;
+        auto const ticket = this->_dock._tickets.take(this->_location.id());
+        if (!ticket)
+          return false;
+        auto const& secret = ticket->session;
+        ELLE_TRACE_SCOPE("%s: resume session", *this);
+        auto const nonce = session::nonce();
+        auto const response = [&] ()
+          -> boost::optional<std::pair<elle::Buffer, elle::Buffer>>
+          {
+            using AuthResume =
+              auto (Address, elle::Buffer const&, elle::Buffer const&,
+                    elle::Buffer const&)
+              -> std::pair<elle::Buffer, elle::Buffer>;
+            auto auth_resume = RPC<AuthResume>(
+              "auth_resume", channels, this->_dock.doughnut().version());
+            try
+            {
+              return auth_resume(this->_dock.doughnut().id(),
+                                 session::ticket(secret),
+                                 nonce,
+                                 session::proof(secret, "resume", nonce));
+            }
+            catch (elle::Error const& e)
+            {
+              // Expired, unknown to a restarted peer, or an older peer:
+              // nothing changed remotely, fall back to a full handshake.
+              ELLE_DEBUG("session resumption declined: %s", e);
+              return boost::none;
+            }
+          }();
+        if (!response)
+          return false;
+        auto const& server_nonce = response->first;
+        if (!session::verify(
+              response->second, secret, "accept", nonce, server_nonce))
+          throw HandshakeFailed(
+            elle::sprintf("session resumption proof mismatch from %f",
+                          this->_location.id()));
+        auto password = session::derive(secret, nonce, server_nonce);
+        this->_rpc_server._key.emplace(elle::Buffer(password));
+        // Keep the expiry of the full handshake: passports are verified
+        // again once it is reached.
+        this->_dock._tickets.add(
+          this->_location.id(), elle::Buffer(password), ticket->expiry);
+        this->_credentials = std::move(password);
+        this->_dock.handshake(true);
+        return true;
+      }
+
+      void
+      Dock::Connection::_negotiate_aead(
+        elle::protocol::ChanneledStream& channels)
+      {
+        using Mode = elle::cryptography::Mode;
+        if (this->_credentials.empty() ||
+            this->_dock.doughnut().encrypt_options().mode() != Mode::gcm)
+          return;
+        // Ask in the default mode, that older peers understand: they answer
+        // that they do not know the RPC, and we stay on it.
+        auto aead = RPC<bool ()>("aead", &channels,
+                                 this->_dock.doughnut().version(),
+                                 &this->_credentials);
+        try
+        {
+          this->_aead = aead();
+        }
+        catch (UnknownRPC const&)
+        {
+          this->_aead = false;
+        }
+        ELLE_DEBUG("%s: authenticated encryption: %s", this, this->_aead);
+      }
+
+      /*----------.
+      | Handshake |
+      `----------*/
+
+      void
+      Dock::handshake(bool resumed)
+      {
+        if (resumed)
+        {
+          ++this->_resumed_handshakes;
+          prometheus::increment(this->_resumed_handshakes_counter);
+        }
+        else
+        {
+          ++this->_full_handshakes;
+          prometheus::increment(this->_full_handshakes_counter);
+        }
+      }
+
+      elle::json::Json
+      Dock::handshake_stats() const
+      {
+        return {
+          {"full", this->_full_handshakes},
+          {"resumed", this->_resumed_handshakes},
+          {"tickets", this->_tickets.size()},
+          {"sessions", this->_sessions.size()},
+        };
+      }
+
       /*-----.
       | Peer |
       `-----*/
@@ -11,7 +11,9 @@
 #include <memo/model/Address.hh>
 #include <memo/model/doughnut/KeyCache.hh>
 #include <memo/model/doughnut/Peer.hh>
+#include <memo/model/doughnut/Session.hh>
 #include <memo/model/doughnut/protocol.hh>
+#include <memo/model/prometheus.hh>
 #include <memo/overlay/Overlay.hh>
 
 namespace memo
@@ -110,6 +112,8 @@ namespace memo
                            channels, protected);
           ELLE_ATTRIBUTE_RX(RPCServer, rpc_server);
           ELLE_ATTRIBUTE_R(elle::Buffer, credentials, protected);
+          /// Whether the peer agreed to authenticated encryption.
+          ELLE_ATTRIBUTE_R(bool, aead);
           ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, thread);
           /// Whether the remote has ever connected.
           ELLE_ATTRIBUTE_R(bool, connected);
@@ -122,6 +126,9 @@ namespace memo
           ELLE_ATTRIBUTE_R(elle::Time, disconnected_since);
           ELLE_ATTRIBUTE_R(std::exception_ptr, disconnected_exception);
           ELLE_ATTRIBUTE_RX(KeyCache, key_hash_cache);
+          /// Epoch of the peer key hashes, once synchronized.  Empty if the
+          /// peer cannot tell.
+          ELLE_ATTRIBUTE_RW(boost::optional<elle::Buffer>, key_hash_epoch);
           ELLE_ATTRIBUTE(std::function<void()>, cleanup_on_disconnect);
           ELLE_ATTRIBUTE_R(std::weak_ptr<Connection>, self);
           ELLE_ATTRIBUTE(boost::optional<Connected<Connection>::iterator>,
@@ -135,6 +142,13 @@ namespace memo
         private:
           void
           _key_exchange(elle::protocol::ChanneledStream& channels);
+          /// Resume our last session with the peer, if we have a ticket.
+          bool
+          _resume(elle::protocol::ChanneledStream& channels);
+          /// Agree on authenticated encryption with the peer, if it
+          /// supports it.
+          void
+          _negotiate_aead(elle::protocol::ChanneledStream& channels);
           friend class Dock;
         };
 
@@ -172,6 +186,32 @@ namespace memo
                               &weak_access<Peer, Address const&, &Peer::id>>>>>;
         ELLE_ATTRIBUTE_R(PeerCache, peer_cache);
         friend class Remote;
+
+      /*----------.
+      | Handshake |
+      `----------*/
+      public:
+        /// A session a peer that connected to us may resume.
+        struct Session
+        {
+          Address id;
+          Passport passport;
+          elle::Buffer secret;
+        };
+        /// Count a completed handshake, full or `resumed`.
+        void
+        handshake(bool resumed);
+        /// Full and resumed handshakes and known session tickets.
+        elle::json::Json
+        handshake_stats() const;
+        /// Secrets of sessions with peers we connected to, by peer id.
+        ELLE_ATTRIBUTE_RX((session::Tickets<Address, elle::Buffer>), tickets);
+        /// Sessions of peers that connected to us, by ticket.
+        ELLE_ATTRIBUTE_RX((session::Tickets<elle::Buffer, Session>), sessions);
+        ELLE_ATTRIBUTE_R(int64_t, full_handshakes);
+        ELLE_ATTRIBUTE_R(int64_t, resumed_handshakes);
+        ELLE_ATTRIBUTE(prometheus::CounterPtr, full_handshakes_counter);
+        ELLE_ATTRIBUTE(prometheus::CounterPtr, resumed_handshakes_counter);
       };
     }
   }
@@ -6,15 +6,19 @@
 #include <elle/Error.hh>
 #include <elle/IOStream.hh>
 #include <elle/cast.hh>
+#include <elle/finally.hh>
 #include <elle/format/hexadecimal.hh>
 #include <elle/log.hh>
 #include <elle/serialization/json.hh>
 
+#include <elle/cryptography/SecretKey.hh>
 #include <elle/cryptography/hash.hh>
+#include <elle/cryptography/random.hh>
 
 #include <elle/reactor/Scope.hh>
 #include <elle/reactor/exception.hh>
 #include <elle/reactor/network/utp-server.hh>
+#include <elle/reactor/scheduler.hh>
 #ifndef ELLE_WINDOWS
 # include <elle/reactor/network/unix-domain-server.hh>
 # include <elle/reactor/network/unix-domain-socket.hh>
@@ -158,6 +162,19 @@ namespace memo
   {
     namespace doughnut
     {
+      /*---------------.
+      | EncryptOptions |
+      `---------------*/
+
+      elle::cryptography::Mode
+      EncryptOptions::mode() const
+      {
+        if (this->aead.value_or(false))
+          return elle::cryptography::Mode::gcm;
+        else
+          return elle::cryptography::SecretKey::defaults::mode;
+      }
+
       /*-------------.
       | Construction |
       `-------------*/
@@ -240,6 +257,7 @@ namespace memo
         , _passport(std::move(init.passport))
         , _admin_keys(std::move(init.admin_keys))
         , _encrypt_options(std::move(init.encrypt_options))
+        , _secret_cache(memo::getenv("SECRET_CACHE_SIZE", 1024))
         , _consensus(init.consensus_builder(*this))
         , _local(init.storage
                  ? this->_consensus->make_local(init.port, init.listen_address,
@@ -261,7 +279,49 @@ namespace memo
         , _overlay(init.overlay_builder(*this, this->_local))
         , _pool([this] { return std::make_unique<ACB>(this); }, 100, 1)
         , _terminating()
+        , _key_cache()
+        , _key_cache_path(std::move(init.key_cache_path))
+        , _key_epoch()
+        , _key_cache_synced(0)
+        , _key_cache_syncing(false)
       {
+        if (this->_key_cache_path)
+        {
+          auto const path = *this->_key_cache_path / "local";
+          if (auto epoch = load_key_cache(path, this->_key_cache))
+          {
+            // Hashes are assigned in sequence, a gap means a lost update.
+            auto const size = signed(this->_key_cache.size());
+            if (std::any_of(this->_key_cache.begin(), this->_key_cache.end(),
+                            [&] (KeyHash const& k) { return k.hash >= size; }))
+            {
+              ELLE_WARN("%s: discard inconsistent key cache %s", this, path);
+              this->_key_cache.clear();
+            }
+            else
+              this->_key_epoch = std::move(*epoch);
+          }
+        }
+        if (this->_key_epoch.empty())
+        {
+          this->_key_cache.clear();
+          this->_key_epoch =
+            elle::cryptography::random::generate<elle::Buffer>(16);
+        }
+        // Rewrite the log, dropping any torn entry, before appending to it.
+        if (this->_key_cache_path)
+          try
+          {
+            save_key_cache(*this->_key_cache_path / "local",
+                           this->_key_epoch, this->_key_cache);
+          }
+          catch (std::exception const& e)
+          {
+            ELLE_WARN("%s: unable to persist key hashes: %s",
+                      this, e.what());
+            this->_key_cache_path.reset();
+          }
+        this->_key_cache_synced = signed(this->_key_cache.size());
         if (this->_local)
         {
           this->_local->initialize();
@@ -534,6 +594,12 @@ namespace memo
         this->_consensus->fetch(addresses, res);
       }
 
+      void
+      Doughnut::_prefetch(std::vector<Address> const& addresses) const
+      {
+        this->_consensus->prefetch(addresses);
+      }
+
       void
       Doughnut::_insert(std::unique_ptr<blocks::Block> block,
                         std::unique_ptr<ConflictResolver> resolver)
@@ -683,14 +749,61 @@ namespace memo
       Doughnut::ensure_key(std::shared_ptr<elle::cryptography::rsa::PublicKey> const& k)
       {
         auto it = this->_key_cache.get<0>().find(*k);
+        auto const index = it == this->_key_cache.get<0>().end() ?
+          signed(this->_key_cache.get<0>().size()) : it->hash;
         if (it == this->_key_cache.get<0>().end())
-        {
-          int index = this->_key_cache.get<0>().size();
           this->_key_cache.insert(KeyHash(index, k));
-          return index;
+        // Sync before handing out the hash: peers may keep it across our
+        // restarts.
+        this->_sync_key(index);
+        return index;
+      }
+
+      void
+      Doughnut::_sync_key(int hash)
+      {
+        while (this->_key_cache_path && hash >= this->_key_cache_synced)
+        {
+          if (this->_key_cache_syncing)
+          {
+            elle::reactor::wait(this->_key_cache_synced_signal);
+            continue;
+          }
+          // Append every hash assigned since the last sync at once.
+          auto const from = this->_key_cache_synced;
+          auto const to = signed(this->_key_cache.size());
+          auto entries = elle::Buffer{};
+          for (auto i = from; i < to; ++i)
+          {
+            auto const entry =
+              key_cache_entry(*this->_key_cache.get<1>().find(i));
+            entries.append(entry.contents(), entry.size());
+          }
+          auto const path = *this->_key_cache_path / "local";
+          this->_key_cache_syncing = true;
+          elle::SafeFinally done([&]
+            {
+              this->_key_cache_syncing = false;
+              this->_key_cache_synced_signal.signal();
+            });
+          try
+          {
+            auto const sched = elle::reactor::Scheduler::scheduler();
+            if (sched && sched->current())
+              elle::reactor::background(
+                [&] { append_key_cache(path, entries); });
+            else
+              append_key_cache(path, entries);
+            this->_key_cache_synced = to;
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("%s: stop persisting key hashes: %s", this, e);
+            auto erc = boost::system::error_code{};
+            bfs::remove(path, erc);
+            this->_key_cache_path.reset();
+          }
         }
-        else
-          return it->hash;
       }
 
       std::shared_ptr<elle::cryptography::rsa::PublicKey>
@@ -888,7 +1001,8 @@ namespace memo
           this->overlay->rpc_protocol,
           doughnut::tcp_heartbeat = this->tcp_heartbeat,
           doughnut::encrypt_options = this->encrypt_options,
-          doughnut::resign_on_shutdown = resign_on_shutdown.value_or(false));
+          doughnut::resign_on_shutdown = resign_on_shutdown.value_or(false),
+          doughnut::key_cache_path = p / "keys");
       }
 
       std::string
@@ -15,12 +15,15 @@
 #include <elle/das/model.hh>
 #include <elle/das/serializer.hh>
 #include <elle/ProducerPool.hh>
+#include <elle/cryptography/Cipher.hh>
 #include <elle/cryptography/rsa/KeyPair.hh>
+#include <elle/reactor/signal.hh>
 
 #include <memo/model/Model.hh>
 #include <memo/model/doughnut/Consensus.hh>
 #include <memo/model/doughnut/Dock.hh>
 #include <memo/model/doughnut/Passport.hh>
+#include <memo/model/doughnut/SecretCache.hh>
 #include <memo/model/prometheus.hh>
 #include <memo/overlay/Overlay.hh>
 
@@ -66,6 +69,7 @@ namespace memo
       ELLE_DAS_SYMBOL(consensus_builder);
       ELLE_DAS_SYMBOL(encrypt_options);
       ELLE_DAS_SYMBOL(id);
+      ELLE_DAS_SYMBOL(key_cache_path);
       ELLE_DAS_SYMBOL(keys);
       ELLE_DAS_SYMBOL(listen_address);
       ELLE_DAS_SYMBOL(monitoring_socket_path);
@@ -88,22 +92,32 @@ namespace memo
         // FIXME: this ctor is useless, but needed for GCC 4.9.  GCC 5
         // is fixed.
         EncryptOptions(bool at_rest = true, bool rpc = true,
-                       bool validate = true)
+                       bool validate = true,
+                       boost::optional<bool> aead = true)
           : encrypt_at_rest{at_rest}
           , encrypt_rpc{rpc}
           , validate_signatures{validate}
+          , aead{aead}
         {}
         using Model = elle::das::Model<
           EncryptOptions,
           decltype(elle::meta::list(symbols::encrypt_at_rest,
                                     symbols::encrypt_rpc,
-                                    symbols::validate_signatures))>;
+                                    symbols::validate_signatures,
+                                    symbols::aead))>;
         /// Encrypt data on storage.
         bool encrypt_at_rest = true;
         /// encrypt data in-flight.
         bool encrypt_rpc = true;
         /// Compute and validate signatures.
         bool validate_signatures = true;
+        /// Encipher RPCs and block payloads with AES-GCM, authenticating
+        /// them in the same pass.  Unset for networks that predate it, where
+        /// older nodes may not decipher it.
+        boost::optional<bool> aead = true;
+        /// The mode to encipher RPCs and block payloads with.
+        elle::cryptography::Mode
+        mode() const;
       };
 
       /// Doughnut.
@@ -154,7 +168,9 @@ namespace memo
             doughnut::soft_fail_running = std::declval<elle::Defaulted<bool>>(),
             doughnut::tcp_heartbeat = std::declval<elle::DurationOpt>(),
             doughnut::encrypt_options = EncryptOptions(),
-            doughnut::resign_on_shutdown = bool()));
+            doughnut::resign_on_shutdown = bool(),
+            doughnut::key_cache_path =
+              std::declval<boost::optional<bfs::path>>()));
         Doughnut(Init init);
         ELLE_ATTRIBUTE_R(elle::Duration, connect_timeout);
         ELLE_ATTRIBUTE_R(elle::Duration, soft_fail_timeout);
@@ -190,6 +206,7 @@ namespace memo
         ELLE_ATTRIBUTE_R(Passport, passport);
         ELLE_ATTRIBUTE_RX(AdminKeys, admin_keys);
         ELLE_ATTRIBUTE_R(EncryptOptions, encrypt_options);
+        ELLE_ATTRIBUTE_RX(SecretCache, secret_cache);
         ELLE_ATTRIBUTE_R(std::unique_ptr<consensus::Consensus>, consensus)
         ELLE_ATTRIBUTE_R(std::shared_ptr<Local>, local)
         ELLE_ATTRIBUTE_RX(Dock, dock);
@@ -208,7 +225,24 @@ namespace memo
         ELLE_ATTRIBUTE_RX(elle::reactor::Barrier, terminating);
 
       public:
+        /// Keys we assigned hashes to, persisted in `key_cache_path` if set.
         ELLE_ATTRIBUTE_R(KeyCache, key_cache);
+        /// Where to persist key hashes, ours and those of peers.
+        ELLE_ATTRIBUTE_R(boost::optional<bfs::path>, key_cache_path);
+        /// Identifier of our key hash assignments, see save_key_cache.
+        ELLE_ATTRIBUTE_R(elle::Buffer, key_epoch);
+      private:
+        /// Wait until the key hash `hash` is synced to `key_cache_path`.
+        ///
+        /// Hashes assigned meanwhile are appended and synced together, off
+        /// the reactor thread.
+        void
+        _sync_key(int hash);
+        /// Number of key hashes synced to `key_cache_path`.
+        ELLE_ATTRIBUTE(int, key_cache_synced);
+        /// Whether a thread is syncing key hashes.
+        ELLE_ATTRIBUTE(bool, key_cache_syncing);
+        ELLE_ATTRIBUTE(elle::reactor::Signal, key_cache_synced_signal);
 
       protected:
         std::unique_ptr<blocks::MutableBlock>
@@ -241,6 +275,9 @@ namespace memo
         _fetch(std::vector<AddressVersion> const& addresses,
                ReceiveBlock res) const override;
 
+        void
+        _prefetch(std::vector<Address> const& addresses) const override;
+
         void
         _insert(std::unique_ptr<blocks::Block> block,
                 std::unique_ptr<ConflictResolver> resolver) override;
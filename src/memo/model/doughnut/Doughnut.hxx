@@ -41,7 +41,8 @@ namespace memo
             doughnut::soft_fail_running = elle::defaulted(false),
             doughnut::tcp_heartbeat = boost::none,
             doughnut::encrypt_options = EncryptOptions(),
-            doughnut::resign_on_shutdown = false);
+            doughnut::resign_on_shutdown = false,
+            doughnut::key_cache_path = boost::optional<bfs::path>());
 
       template <typename ... Args>
       Doughnut::Doughnut(Args&& ... args)
@@ -66,7 +67,8 @@ namespace memo
                    elle::Defaulted<bool>,
                    elle::DurationOpt,
                    EncryptOptions,
-                   bool>(
+                   bool,
+                   boost::optional<bfs::path>>(
                      std::forward<Args>(args)...))
       {}
     }
@@ -74,6 +74,17 @@ namespace memo
           throw elle::athena::paxos::Unavailable();
         }
 
+        boost::optional<consensus::Paxos::PaxosClient::Proposal>
+        accept_delta(consensus::Paxos::PaxosServer::Quorum const& peers,
+                     Address address,
+                     consensus::Paxos::PaxosClient::Proposal const& p,
+                     int base_version,
+                     elle::Buffer const& base_digest,
+                     elle::Buffer const& delta) override
+        {
+          throw elle::athena::paxos::Unavailable();
+        }
+
         void
         confirm(consensus::Paxos::PaxosServer::Quorum const& peers,
                 Address address,
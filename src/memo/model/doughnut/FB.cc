@@ -0,0 +1,174 @@
+#include <memo/model/doughnut/FB.hh>
+
+#include <elle/log.hh>
+
+#include <elle/cryptography/hash.hh>
+
+#include <memo/model/doughnut/CHB.hh>
+#include <memo/model/doughnut/Doughnut.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.FB");
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /*-------------.
+      | Construction |
+      `-------------*/
+
+      FB::FB(Doughnut& dht,
+             Address chb,
+             Address owner,
+             int index,
+             int data_fragments,
+             int parity_fragments,
+             uint64_t size,
+             std::vector<elle::Buffer> digests,
+             elle::Buffer data)
+        : Super(FB::address(chb, index, dht.version()),
+                std::move(data),
+                std::move(owner))
+        , _chb(std::move(chb))
+        , _index(index)
+        , _data_fragments(data_fragments)
+        , _parity_fragments(parity_fragments)
+        , _size(size)
+        , _digests(std::move(digests))
+      {}
+
+      FB::FB(FB const& other)
+        : Super(other)
+        , _chb(other._chb)
+        , _index(other._index)
+        , _data_fragments(other._data_fragments)
+        , _parity_fragments(other._parity_fragments)
+        , _size(other._size)
+        , _digests(other._digests)
+      {}
+
+      Address
+      FB::address(Address chb, int index, elle::Version const& version)
+      {
+        auto hash = elle::cryptography::hash(
+          elle::sprintf("FB/%x/%s", chb, index),
+          elle::cryptography::Oneway::sha256);
+        return Address(hash.contents(), flags::immutable_block,
+                       version >= elle::Version(0, 5, 0));
+      }
+
+      elle::Buffer
+      FB::digest(elle::ConstWeakBuffer data)
+      {
+        return elle::cryptography::hash(
+          data, elle::cryptography::Oneway::sha256);
+      }
+
+      /*-------.
+      | Clone  |
+      `-------*/
+
+      std::unique_ptr<blocks::Block>
+      FB::clone() const
+      {
+        return std::unique_ptr<blocks::Block>(new FB(*this));
+      }
+
+      /*-----------.
+      | Validation |
+      `-----------*/
+
+      blocks::ValidationResult
+      FB::_validate(Model const& model, bool writing) const
+      {
+        ELLE_DEBUG_SCOPE("%s: validate", *this);
+        auto const expected_address =
+          FB::address(this->_chb, this->_index, model.version());
+        if (!equal_unflagged(this->address(), expected_address))
+        {
+          auto reason = elle::sprintf("address %x invalid, expecting %x",
+                                      this->address(), expected_address);
+          ELLE_DUMP("%s: %s", *this, reason);
+          return blocks::ValidationResult::failure(reason);
+        }
+        auto const count = this->_data_fragments + this->_parity_fragments;
+        if (this->_data_fragments < 1 || this->_parity_fragments < 0 ||
+            this->_index < 0 || this->_index >= count ||
+            signed(this->_digests.size()) != count)
+          return blocks::ValidationResult::failure(
+            elle::sprintf("invalid fragment %s of %s+%s",
+                          this->_index,
+                          this->_data_fragments, this->_parity_fragments));
+        if (FB::digest(this->data()) != this->_digests[this->_index])
+          return blocks::ValidationResult::failure("fragment digest mismatch");
+        return blocks::ValidationResult::success();
+      }
+
+      blocks::ValidationResult
+      FB::_validate(Model const& model, const Block& new_block) const
+      {
+        if (auto fb = dynamic_cast<FB const*>(&new_block))
+          if (this->_chb == fb->_chb
+              && this->_index == fb->_index
+              && this->_digests == fb->_digests
+              && this->data() == fb->data())
+            return blocks::ValidationResult::success();
+        return blocks::ValidationResult::failure("FB overwrite denied");
+      }
+
+      // Fragments are removed along with their CHB, with the CHB removal
+      // signature.
+      blocks::RemoveSignature
+      FB::_sign_remove(Model& model) const
+      {
+        if (this->owner())
+          return CHB::sign_remove(model, this->_chb, this->owner());
+        else
+          return blocks::RemoveSignature();
+      }
+
+      blocks::ValidationResult
+      FB::_validate_remove(Model& model,
+                           blocks::RemoveSignature const& sig) const
+      {
+        ELLE_TRACE("%s: validate_remove", *this);
+        return CHB::validate_remove(model, this->_chb, this->owner(), sig);
+      }
+
+      /*--------------.
+      | Serialization |
+      `--------------*/
+
+      FB::FB(elle::serialization::SerializerIn& input,
+             elle::Version const& version)
+        : Super(input, version)
+      {
+        this->_serialize(input);
+      }
+
+      void
+      FB::serialize(elle::serialization::Serializer& s,
+                    elle::Version const& version)
+      {
+        Super::serialize(s, version);
+        this->_serialize(s);
+      }
+
+      void
+      FB::_serialize(elle::serialization::Serializer& s)
+      {
+        s.serialize("chb", this->_chb);
+        s.serialize("index", this->_index);
+        s.serialize("data_fragments", this->_data_fragments);
+        s.serialize("parity_fragments", this->_parity_fragments);
+        s.serialize("size", this->_size);
+        s.serialize("digests", this->_digests);
+      }
+
+      static const elle::serialization::Hierarchy<blocks::Block>::
+      Register<FB> _register_fb_serialization("FB");
+    }
+  }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+
+#include <elle/attribute.hh>
+
+#include <memo/model/blocks/ImmutableBlock.hh>
+#include <memo/model/doughnut/fwd.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Fragment of an erasure-coded CHB.
+      ///
+      /// The data is one of the `data_fragments + parity_fragments`
+      /// fragments of the serialized CHB, and the address is derived from the
+      /// CHB address and the fragment index so that fragments can be looked up
+      /// knowing the CHB address only.
+      class FB
+        : public blocks::ImmutableBlock
+      {
+      /*------.
+      | Types |
+      `------*/
+      public:
+        using Self = FB;
+        using Super = blocks::ImmutableBlock;
+
+      /*-------------.
+      | Construction |
+      `-------------*/
+      public:
+        FB(Doughnut& dht,
+           Address chb,
+           Address owner,
+           int index,
+           int data_fragments,
+           int parity_fragments,
+           uint64_t size,
+           std::vector<elle::Buffer> digests,
+           elle::Buffer data);
+        FB(FB const& other);
+        /// The erasure-coded CHB address.
+        ELLE_ATTRIBUTE_R(Address, chb);
+        /// Index of this fragment, parity fragments coming last.
+        ELLE_ATTRIBUTE_R(int, index);
+        ELLE_ATTRIBUTE_R(int, data_fragments);
+        ELLE_ATTRIBUTE_R(int, parity_fragments);
+        /// Size of the serialized CHB.
+        ELLE_ATTRIBUTE_R(uint64_t, size);
+        /// SHA-256 of every fragment of the CHB.
+        ELLE_ATTRIBUTE_R(std::vector<elle::Buffer>, digests);
+        static
+        Address
+        address(Address chb, int index, elle::Version const& version);
+        static
+        elle::Buffer
+        digest(elle::ConstWeakBuffer data);
+        using Super::address;
+
+      /*-------.
+      | Clone  |
+      `-------*/
+      public:
+        std::unique_ptr<blocks::Block>
+        clone() const override;
+
+      /*-----------.
+      | Validation |
+      `-----------*/
+      protected:
+        blocks::ValidationResult
+        _validate(Model const& model, bool writing) const override;
+        blocks::ValidationResult
+        _validate(Model const& model, const Block& new_block) const override;
+        blocks::RemoveSignature
+        _sign_remove(Model& model) const override;
+        blocks::ValidationResult
+        _validate_remove(Model& model,
+                         blocks::RemoveSignature const& sig) const override;
+
+      /*--------------.
+      | Serialization |
+      `--------------*/
+      public:
+        FB(elle::serialization::SerializerIn& input,
+           elle::Version const& version);
+        void
+        serialize(elle::serialization::Serializer& s,
+                  elle::Version const& version) override;
+      private:
+        void
+        _serialize(elle::serialization::Serializer& s);
+      };
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#include <memo/model/doughnut/FrequencySketch.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        namespace
+        {
+          uint64_t
+          mix(uint64_t x)
+          {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+          }
+
+          /// The four hashes of an address.
+          ///
+          /// Addresses are mostly digests already, but some bits carry
+          /// flags, so mix their four words anyway.
+          std::array<uint64_t, 4>
+          hashes(Address const& address)
+          {
+            auto res = std::array<uint64_t, 4>{};
+            std::memcpy(res.data(), address.value(), sizeof(Address::Value));
+            for (auto& h: res)
+              h = mix(h);
+            return res;
+          }
+        }
+
+        FrequencySketch::FrequencySketch(std::size_t capacity)
+          : _resets(0)
+          , _table()
+          , _sample_size(0)
+          , _size(0)
+        {
+          auto words = std::size_t(64);
+          while (words < capacity)
+            words *= 2;
+          this->_table.resize(words, 0);
+          this->_sample_size = 10 * std::max(capacity, std::size_t(1));
+        }
+
+        void
+        FrequencySketch::increment(Address const& address)
+        {
+          auto const mask = this->_table.size() - 1;
+          bool added = false;
+          auto i = 0;
+          for (auto h: hashes(address))
+          {
+            // One counter among the sixteen of the word, distinct per hash.
+            auto const offset = 4 * (4 * i + int((h >> 60) & 3));
+            auto& word = this->_table[h & mask];
+            if (((word >> offset) & 0xf) != 0xf)
+            {
+              word += uint64_t(1) << offset;
+              added = true;
+            }
+            ++i;
+          }
+          if (added && ++this->_size == this->_sample_size)
+            this->_reset();
+        }
+
+        int
+        FrequencySketch::frequency(Address const& address) const
+        {
+          auto const mask = this->_table.size() - 1;
+          auto res = 0xf;
+          auto i = 0;
+          for (auto h: hashes(address))
+          {
+            auto const offset = 4 * (4 * i + int((h >> 60) & 3));
+            res = std::min(
+              res, int((this->_table[h & mask] >> offset) & 0xf));
+            ++i;
+          }
+          return res;
+        }
+
+        void
+        FrequencySketch::_reset()
+        {
+          for (auto& word: this->_table)
+            word = (word >> 1) & 0x7777777777777777ull;
+          this->_size /= 2;
+          ++this->_resets;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include <elle/attribute.hh>
+
+#include <memo/model/Address.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        /// Approximate access frequencies of addresses, for TinyLFU
+        /// admission.
+        ///
+        /// A count-min sketch of 4-bit counters, four per address.  All
+        /// counters are halved once as many increments as ten times the
+        /// capacity were recorded, so that past popularity fades away.
+        class FrequencySketch
+        {
+        public:
+          /// Create a sketch tracking about `capacity` addresses.
+          FrequencySketch(std::size_t capacity);
+          /// Record an access to `address`.
+          void
+          increment(Address const& address);
+          /// Estimated access count of `address`, at most 15.
+          int
+          frequency(Address const& address) const;
+          /// Number of times counters were halved.
+          ELLE_ATTRIBUTE_R(int64_t, resets);
+
+        private:
+          void
+          _reset();
+          ELLE_ATTRIBUTE(std::vector<uint64_t>, table);
+          ELLE_ATTRIBUTE(uint64_t, sample_size);
+          ELLE_ATTRIBUTE(uint64_t, size);
+        };
+      }
+    }
+  }
+}
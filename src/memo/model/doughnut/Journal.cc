@@ -0,0 +1,592 @@
+#include <memo/model/doughnut/Journal.hh>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#ifdef ELLE_WINDOWS
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/crc.hpp>
+
+#include <elle/bench.hh>
+#include <elle/finally.hh>
+#include <elle/log.hh>
+#include <elle/printf.hh>
+
+#include <elle/reactor/scheduler.hh>
+
+#include <memo/environ.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Journal");
+
+namespace fs = boost::filesystem;
+
+using namespace std::literals;
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        namespace
+        {
+          /// "MJNL", little endian.
+          auto constexpr magic = uint32_t(0x4c4e4a4d);
+          /// Magic, segment, kind, index, size and checksum.
+          auto constexpr header_size = 24;
+          enum Kind
+          {
+            operation = 0,
+            tombstone = 1,
+          };
+
+          void
+          put32(uint8_t* p, uint32_t v)
+          {
+            for (int i = 0; i < 4; ++i)
+              p[i] = (v >> (8 * i)) & 0xff;
+          }
+
+          uint32_t
+          get32(uint8_t const* p)
+          {
+            return
+              uint32_t(p[0]) | uint32_t(p[1]) << 8 |
+              uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+          }
+
+          uint32_t
+          checksum(uint8_t const* header, elle::ConstWeakBuffer data)
+          {
+            auto res = boost::crc_32_type{};
+            res.process_bytes(header, header_size - 4);
+            res.process_bytes(data.contents(), data.size());
+            return res.checksum();
+          }
+
+          /// Whether `name` is an operation in the one-file-per-operation
+          /// format.
+          bool
+          is_index(std::string const& name)
+          {
+            return !name.empty() &&
+              std::all_of(name.begin(), name.end(),
+                          [] (char c) { return std::isdigit(c); });
+          }
+
+          int
+          open_file(fs::path const& path, int flags)
+          {
+#ifdef ELLE_WINDOWS
+            flags |= O_BINARY;
+#endif
+            auto const fd = ::open(path.string().c_str(), flags, 0600);
+            if (fd < 0)
+              elle::err("unable to open %s: %s", path, std::strerror(errno));
+            return fd;
+          }
+
+          void
+          read_at(int fd, int64_t offset, uint8_t* data, int64_t size)
+          {
+            if (::lseek(fd, offset, SEEK_SET) != offset)
+              elle::err("unable to seek journal: %s", std::strerror(errno));
+            while (size > 0)
+            {
+              auto const n = ::read(fd, data, size);
+              if (n <= 0)
+                elle::err("unable to read journal: %s",
+                          n ? std::strerror(errno) : "end of file");
+              data += n;
+              size -= n;
+            }
+          }
+
+          void
+          write_at(int fd, int64_t offset, uint8_t const* data, int64_t size)
+          {
+            if (::lseek(fd, offset, SEEK_SET) != offset)
+              elle::err("unable to seek journal: %s", std::strerror(errno));
+            while (size > 0)
+            {
+              auto const n = ::write(fd, data, size);
+              if (n < 0)
+                elle::err("unable to write journal: %s", std::strerror(errno));
+              data += n;
+              size -= n;
+            }
+          }
+
+          void
+          sync_file(int fd)
+          {
+#ifdef ELLE_WINDOWS
+            if (::_commit(fd))
+#else
+            if (::fsync(fd))
+#endif
+              elle::err("unable to sync journal: %s", std::strerror(errno));
+          }
+        }
+
+        /*-------------.
+        | Construction |
+        `-------------*/
+
+        Journal::Journal(fs::path root, bool read_only)
+          : _root(std::move(root))
+          , _read_only(read_only)
+          , _active(0)
+          , _sequence(0)
+          , _synced(0)
+          , _segment_size(
+            memo::getenv("ASYNC_JOURNAL_SEGMENT_SIZE", 4 * 1024 * 1024))
+          , _max_spares(memo::getenv("ASYNC_JOURNAL_SPARE_SEGMENTS", 2))
+          , _sync_delay(memo::getenv("ASYNC_JOURNAL_SYNC_DELAY", 10))
+          , _synced_signal()
+          , _sync_error()
+          , _syncs(0)
+          , _recycled_segments(0)
+        {
+          ELLE_TRACE_SCOPE("open journal in %s", this->_root);
+          this->_recover();
+          if (this->_read_only)
+            return;
+          fs::create_directories(this->_root);
+          this->_roll();
+          this->_migrate();
+          this->sync();
+          this->_sync_thread.reset(
+            new elle::reactor::Thread(
+              elle::sprintf("journal %s sync", this->_root),
+              [this] { this->_sync_loop(); }));
+        }
+
+        Journal::~Journal()
+        {
+          this->_sync_thread.reset();
+          for (auto& s: this->_segments)
+            if (s.second.fd >= 0)
+            {
+              if (s.second.dirty)
+                try
+                {
+                  sync_file(s.second.fd);
+                }
+                catch (elle::Error const& e)
+                {
+                  ELLE_WARN("%s", e);
+                }
+              ::close(s.second.fd);
+            }
+        }
+
+        fs::path
+        Journal::_segment_path(int id) const
+        {
+          return this->_root / elle::sprintf("segment.%s", id);
+        }
+
+        /*---------.
+        | Recovery |
+        `---------*/
+
+        void
+        Journal::_recover()
+        {
+          if (!fs::exists(this->_root))
+            return;
+          for (auto const& p: fs::directory_iterator(this->_root))
+          {
+            auto const name = p.path().filename().string();
+            if (is_index(name))
+              this->_locations[std::stoi(name)] =
+                Location{-1, 0, int64_t(fs::file_size(p.path()))};
+            else if (boost::starts_with(name, "segment."))
+              try
+              {
+                auto const id = std::stoi(name.substr(8));
+                this->_segments.emplace(
+                  id, Segment{p.path(), -1, 0, 0, 0, false});
+              }
+              catch (std::logic_error const&)
+              {
+                ELLE_WARN("ignore unexpected journal file %s", p.path());
+              }
+            else if (boost::starts_with(name, "spare."))
+              this->_spares.emplace_back(p.path());
+          }
+          for (auto& s: this->_segments)
+            this->_scan(s.first, s.second);
+          for (auto const& l: this->_locations)
+            if (l.second.segment >= 0)
+              ++this->_segments.at(l.second.segment).live;
+          ELLE_TRACE("recovered %s operations from %s segments",
+                     this->_locations.size(), this->_segments.size());
+        }
+
+        void
+        Journal::_scan(int id, Segment& segment)
+        {
+          static auto bench =
+            elle::Bench<>{"bench.async.journal.scan", 10000s};
+          auto bs = bench.scoped();
+          segment.fd = open_file(
+            segment.path, this->_read_only ? O_RDONLY : O_RDWR);
+          auto content = elle::Buffer(fs::file_size(segment.path));
+          read_at(segment.fd, 0, content.mutable_contents(), content.size());
+          auto pos = int64_t(0);
+          while (pos + header_size <= int64_t(content.size()))
+          {
+            auto const header = content.contents() + pos;
+            auto const size = int64_t(get32(header + 16));
+            // Stop at torn records and stale ones from a recycled segment.
+            if (get32(header) != magic ||
+                get32(header + 4) != uint32_t(id) ||
+                pos + header_size + size > int64_t(content.size()))
+              break;
+            auto const data =
+              elle::ConstWeakBuffer(header + header_size, size);
+            if (checksum(header, data) != get32(header + 20))
+              break;
+            auto const index = int(get32(header + 12));
+            auto const kind = get32(header + 8);
+            if (kind == operation)
+              this->_locations[index] = Location{id, pos + header_size, size};
+            else if (kind == tombstone)
+              this->_locations.erase(index);
+            else
+              break;
+            pos += header_size + size;
+          }
+          if (pos != int64_t(content.size()))
+            ELLE_TRACE("ignore %s trailing bytes in segment %s",
+                       content.size() - pos, id);
+          segment.size = pos;
+        }
+
+        void
+        Journal::_migrate()
+        {
+          auto files = std::vector<fs::path>{};
+          for (auto const& p: fs::directory_iterator(this->_root))
+            if (is_index(p.path().filename().string()))
+              files.emplace_back(p.path());
+          if (files.empty())
+            return;
+          ELLE_TRACE_SCOPE("migrate %s operations to segments", files.size());
+          for (auto const& l: std::map<int, Location>(this->_locations))
+            if (l.second.segment < 0)
+            {
+              auto const data = this->read(l.first);
+              this->_write(l.first, data);
+            }
+          this->sync();
+          for (auto const& p: files)
+            fs::remove(p);
+        }
+
+        /*-----------.
+        | Operations |
+        `-----------*/
+
+        void
+        Journal::write(int index, elle::ConstWeakBuffer data)
+        {
+          this->_write(index, data);
+          this->_wait_synced(this->_sequence);
+        }
+
+        void
+        Journal::_write(int index, elle::ConstWeakBuffer data)
+        {
+          ELLE_ASSERT(!this->_read_only);
+          ELLE_DEBUG("write operation %s (%s bytes)", index, data.size());
+          auto location = this->_append(operation, index, data);
+          auto it = this->_locations.find(index);
+          if (it != this->_locations.end())
+          {
+            this->_release(it->second);
+            it->second = location;
+          }
+          else
+            this->_locations.emplace(index, location);
+          ++this->_segments.at(location.segment).live;
+          if (this->_segments.at(this->_active).size >= this->_segment_size)
+            this->_roll();
+        }
+
+        void
+        Journal::remove(int index)
+        {
+          ELLE_ASSERT(!this->_read_only);
+          auto it = this->_locations.find(index);
+          if (it == this->_locations.end())
+            return;
+          ELLE_DEBUG("remove operation %s", index);
+          this->_append(tombstone, index, {});
+          this->_release(it->second);
+          this->_locations.erase(it);
+          if (this->_segments.at(this->_active).size >= this->_segment_size)
+            this->_roll();
+        }
+
+        elle::Buffer
+        Journal::read(int index) const
+        {
+          auto it = this->_locations.find(index);
+          if (it == this->_locations.end())
+            elle::err("no operation %s in journal %s", index, this->_root);
+          auto const& l = it->second;
+          auto res = elle::Buffer(l.size);
+          if (l.segment < 0)
+          {
+            auto const fd =
+              open_file(this->_root / std::to_string(index), O_RDONLY);
+            elle::SafeFinally close([fd] { ::close(fd); });
+            read_at(fd, 0, res.mutable_contents(), l.size);
+          }
+          else
+            read_at(this->_segments.at(l.segment).fd,
+                    l.offset, res.mutable_contents(), l.size);
+          return res;
+        }
+
+        bool
+        Journal::contains(int index) const
+        {
+          return this->_locations.find(index) != this->_locations.end();
+        }
+
+        int64_t
+        Journal::size(int index) const
+        {
+          auto it = this->_locations.find(index);
+          return it == this->_locations.end() ? 0 : it->second.size;
+        }
+
+        std::vector<int>
+        Journal::indexes() const
+        {
+          auto res = std::vector<int>{};
+          res.reserve(this->_locations.size());
+          for (auto const& l: this->_locations)
+            res.emplace_back(l.first);
+          return res;
+        }
+
+        auto
+        Journal::_append(int kind, int index, elle::ConstWeakBuffer data)
+          -> Location
+        {
+          auto& segment = this->_segments.at(this->_active);
+          auto record = elle::Buffer(header_size + data.size());
+          auto const header = record.mutable_contents();
+          put32(header, magic);
+          put32(header + 4, this->_active);
+          put32(header + 8, kind);
+          put32(header + 12, index);
+          put32(header + 16, data.size());
+          put32(header + 20, checksum(header, data));
+          if (data.size())
+            std::memcpy(header + header_size, data.contents(), data.size());
+          write_at(segment.fd, segment.size, record.contents(), record.size());
+          auto res = Location{
+            this->_active, segment.size + header_size, int64_t(data.size())};
+          segment.size += record.size();
+          segment.dirty = true;
+          ++this->_sequence;
+          this->_dirty.open();
+          return res;
+        }
+
+        void
+        Journal::_release(Location const& location)
+        {
+          if (location.segment < 0)
+            return;
+          auto& segment = this->_segments.at(location.segment);
+          if (!--segment.live)
+            segment.released = this->_sequence;
+        }
+
+        /*---------.
+        | Segments |
+        `---------*/
+
+        void
+        Journal::_roll()
+        {
+          auto const id = this->_segments.empty()
+            ? 1 : this->_segments.rbegin()->first + 1;
+          auto const path = this->_segment_path(id);
+          auto const recycled = !this->_spares.empty();
+          if (recycled)
+          {
+            // Leftover records are rejected on recovery as their segment
+            // number differs.
+            fs::rename(this->_spares.back(), path);
+            this->_spares.pop_back();
+            ++this->_recycled_segments;
+          }
+          ELLE_TRACE("roll to %ssegment %s", recycled ? "recycled " : "", id);
+          auto const fd = open_file(
+            path, recycled ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC);
+          this->_segments.emplace(id, Segment{path, fd, 0, 0, 0, false});
+          this->_active = id;
+        }
+
+        void
+        Journal::_reclaim()
+        {
+          // Records obsoleting a segment may only be relied upon once synced,
+          // and reclaiming oldest first ensures no tombstone outlives the
+          // operation it removes.
+          while (true)
+          {
+            auto it = this->_segments.begin();
+            if (it == this->_segments.end() ||
+                it->first == this->_active ||
+                it->second.live ||
+                it->second.released > this->_synced)
+              return;
+            ELLE_TRACE("reclaim segment %s", it->first);
+            ::close(it->second.fd);
+            if (signed(this->_spares.size()) < this->_max_spares)
+            {
+              auto spare = this->_root / elle::sprintf("spare.%s", it->first);
+              fs::rename(it->second.path, spare);
+              this->_spares.emplace_back(std::move(spare));
+            }
+            else
+              fs::remove(it->second.path);
+            this->_segments.erase(it);
+          }
+        }
+
+        /*-----.
+        | Sync |
+        `-----*/
+
+        void
+        Journal::_wait_synced(int64_t sequence)
+        {
+          if (!this->_sync_thread)
+          {
+            this->sync();
+            return;
+          }
+          while (this->_synced < sequence)
+          {
+            if (this->_sync_error)
+              std::rethrow_exception(this->_sync_error);
+            elle::reactor::wait(this->_synced_signal);
+          }
+        }
+
+        void
+        Journal::sync()
+        {
+          this->_dirty.close();
+          this->_sync();
+        }
+
+        void
+        Journal::_sync()
+        {
+          static auto bench =
+            elle::Bench<>{"bench.async.journal.sync", 10000s};
+          auto bs = bench.scoped();
+          elle::reactor::Lock lock(this->_sync_mutex);
+          auto const sequence = this->_sequence;
+          auto ids = std::vector<int>{};
+          auto fds = std::vector<int>{};
+          for (auto& s: this->_segments)
+            if (s.second.dirty)
+            {
+              ids.emplace_back(s.first);
+              fds.emplace_back(s.second.fd);
+              s.second.dirty = false;
+            }
+          if (!fds.empty())
+          {
+            ELLE_DEBUG("sync %s segments up to record %s",
+                       fds.size(), sequence);
+            try
+            {
+              elle::reactor::background(
+                [&fds]
+                {
+                  for (auto fd: fds)
+                    sync_file(fd);
+                });
+            }
+            catch (elle::Error const&)
+            {
+              for (auto id: ids)
+                this->_segments.at(id).dirty = true;
+              // Retry with the next batch, failing writers meanwhile.
+              this->_sync_error = std::current_exception();
+              this->_dirty.open();
+              this->_synced_signal.signal();
+              throw;
+            }
+            ++this->_syncs;
+          }
+          this->_synced = sequence;
+          this->_sync_error = nullptr;
+          this->_synced_signal.signal();
+          this->_reclaim();
+        }
+
+        void
+        Journal::_sync_loop()
+        {
+          while (true)
+          {
+            elle::reactor::wait(this->_dirty);
+            elle::reactor::sleep(this->_sync_delay);
+            try
+            {
+              this->sync();
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("unable to sync journal %s: %s", this->_root, e);
+            }
+          }
+        }
+
+        /*-----------.
+        | Monitoring |
+        `-----------*/
+
+        elle::json::Json
+        Journal::stats() const
+        {
+          auto size = int64_t(0);
+          for (auto const& s: this->_segments)
+            size += s.second.size;
+          return {
+            {"operations", this->_locations.size()},
+            {"segments", this->_segments.size()},
+            {"spare_segments", this->_spares.size()},
+            {"size", size},
+            {"syncs", this->_syncs},
+            {"recycled_segments", this->_recycled_segments},
+          };
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <map>
+
+#include <boost/filesystem.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+#include <elle/json/json.hh>
+
+#include <elle/reactor/Barrier.hh>
+#include <elle/reactor/Thread.hh>
+#include <elle/reactor/mutex.hh>
+#include <elle/reactor/signal.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        /// Append-only segmented journal of asynchronous operations.
+        ///
+        /// Operations are appended as records to the active segment, along
+        /// with tombstones for processed ones.  Rewriting an operation appends
+        /// a record with the same index superseding the previous one.
+        /// Segments are rolled once large enough, and reclaimed oldest first
+        /// once all their operations are gone, being kept as spares to be
+        /// reused by later segments.
+        ///
+        /// Records are synced to disk in batches by a background thread:
+        /// writes wait for the batch holding their record to be synced, so
+        /// concurrent writes share one fsync.  Recovery scans segments
+        /// sequentially, stopping at the first torn or stale record of each.
+        class Journal
+        {
+        /*-------------.
+        | Construction |
+        `-------------*/
+        public:
+          /// Open the journal in `root`, recovering operations.
+          ///
+          /// Operations from the one-file-per-operation format are migrated,
+          /// unless `read_only`.
+          Journal(boost::filesystem::path root, bool read_only = false);
+          ~Journal();
+          ELLE_ATTRIBUTE_R(boost::filesystem::path, root);
+          ELLE_ATTRIBUTE_R(bool, read_only);
+
+        /*-----------.
+        | Operations |
+        `-----------*/
+        public:
+          /// Append the operation at `index`, superseding any previous one,
+          /// and wait until it is synced to disk.
+          ///
+          /// @throw elle::Error if syncing fails.
+          void
+          write(int index, elle::ConstWeakBuffer data);
+          /// Mark the operation at `index` processed.
+          void
+          remove(int index);
+          /// The operation at `index`.
+          ///
+          /// @throw elle::Error if there is no such operation.
+          elle::Buffer
+          read(int index) const;
+          bool
+          contains(int index) const;
+          /// Size of the operation at `index`.
+          int64_t
+          size(int index) const;
+          /// Pending operation indexes, in order.
+          std::vector<int>
+          indexes() const;
+          /// Sync pending records to disk.
+          void
+          sync();
+
+        private:
+          struct Location
+          {
+            /// Segment, or -1 for an operation in its own file.
+            int segment;
+            int64_t offset;
+            int64_t size;
+          };
+          struct Segment
+          {
+            boost::filesystem::path path;
+            int fd;
+            /// Write offset.
+            int64_t size;
+            /// Number of operations whose latest record is in this segment.
+            int live;
+            /// Sequence of the record that obsoleted the last operation.
+            int64_t released;
+            bool dirty;
+          };
+          /// Append the operation at `index` without waiting for it to be
+          /// synced.
+          void
+          _write(int index, elle::ConstWeakBuffer data);
+          /// Wait until records up to `sequence` are synced.
+          void
+          _wait_synced(int64_t sequence);
+          void
+          _recover();
+          void
+          _scan(int id, Segment& segment);
+          void
+          _migrate();
+          Location
+          _append(int kind, int index, elle::ConstWeakBuffer data);
+          void
+          _release(Location const& location);
+          void
+          _roll();
+          void
+          _reclaim();
+          void
+          _sync();
+          void
+          _sync_loop();
+          boost::filesystem::path
+          _segment_path(int id) const;
+          ELLE_ATTRIBUTE((std::map<int, Segment>), segments);
+          ELLE_ATTRIBUTE((std::map<int, Location>), locations);
+          ELLE_ATTRIBUTE(int, active);
+          /// Sequence of the last appended record.
+          ELLE_ATTRIBUTE(int64_t, sequence);
+          /// Sequence up to which records are on disk.
+          ELLE_ATTRIBUTE(int64_t, synced);
+          ELLE_ATTRIBUTE(std::vector<boost::filesystem::path>, spares);
+          ELLE_ATTRIBUTE(int64_t, segment_size);
+          ELLE_ATTRIBUTE(int, max_spares);
+          ELLE_ATTRIBUTE(std::chrono::milliseconds, sync_delay);
+          ELLE_ATTRIBUTE(elle::reactor::Barrier, dirty);
+          /// Signaled after every sync attempt.
+          ELLE_ATTRIBUTE(elle::reactor::Signal, synced_signal);
+          /// Failure of the latest sync, if it failed.
+          ELLE_ATTRIBUTE(std::exception_ptr, sync_error);
+          ELLE_ATTRIBUTE(elle::reactor::Mutex, sync_mutex);
+          ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, sync_thread);
+
+        /*-----------.
+        | Monitoring |
+        `-----------*/
+        public:
+          ELLE_ATTRIBUTE_R(int64_t, syncs);
+          ELLE_ATTRIBUTE_R(int64_t, recycled_segments);
+          elle::json::Json
+          stats() const;
+        };
+      }
+    }
+  }
+}
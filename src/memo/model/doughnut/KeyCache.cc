@@ -0,0 +1,189 @@
+#include <memo/model/doughnut/KeyCache.hh>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#ifdef ELLE_WINDOWS
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <elle/err.hh>
+#include <elle/finally.hh>
+#include <elle/log.hh>
+#include <elle/serialization/binary.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.KeyCache");
+
+namespace bfs = boost::filesystem;
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace
+      {
+        using Entry = std::pair<int, elle::cryptography::rsa::PublicKey>;
+
+        /// Append `data`, prefixed with its size in little endian.
+        void
+        put(elle::Buffer& out, elle::Buffer const& data)
+        {
+          uint8_t size[4];
+          for (int i = 0; i < 4; ++i)
+            size[i] = (data.size() >> (8 * i)) & 0xff;
+          out.append(size, sizeof size);
+          out.append(data.contents(), data.size());
+        }
+
+        /// Read a record written by `put` at `offset`, if it is complete.
+        boost::optional<elle::ConstWeakBuffer>
+        get(elle::Buffer const& in, std::size_t& offset)
+        {
+          if (in.size() - offset < 4)
+            return boost::none;
+          auto size = std::size_t(0);
+          for (int i = 0; i < 4; ++i)
+            size |= std::size_t(in[offset + i]) << (8 * i);
+          if (in.size() - offset - 4 < size)
+            return boost::none;
+          auto res = elle::ConstWeakBuffer(in.contents() + offset + 4, size);
+          offset += 4 + size;
+          return res;
+        }
+
+        void
+        write_all(int fd, elle::Buffer const& data, bfs::path const& path)
+        {
+          auto p = data.contents();
+          auto size = data.size();
+          while (size > 0)
+          {
+            auto const n = ::write(fd, p, size);
+            if (n < 0)
+              elle::err("unable to write %s: %s", path, std::strerror(errno));
+            p += n;
+            size -= n;
+          }
+        }
+
+        void
+        sync(int fd, bfs::path const& path)
+        {
+#ifdef ELLE_WINDOWS
+          if (::_commit(fd))
+#else
+          if (::fsync(fd))
+#endif
+            elle::err("unable to sync %s: %s", path, std::strerror(errno));
+        }
+
+        int
+        open(bfs::path const& path, int flags)
+        {
+          auto const fd = ::open(path.string().c_str(), flags, 0600);
+          if (fd < 0)
+            elle::err("unable to open %s: %s", path, std::strerror(errno));
+          return fd;
+        }
+      }
+
+      elle::Buffer
+      key_cache_entry(KeyHash const& key)
+      {
+        auto res = elle::Buffer{};
+        put(res, elle::serialization::binary::serialize(
+              Entry{key.hash, *key.key}, false));
+        return res;
+      }
+
+      void
+      save_key_cache(bfs::path const& path,
+                     elle::Buffer const& epoch,
+                     KeyCache const& cache)
+      {
+        ELLE_DEBUG_SCOPE("save %s keys to %s", cache.size(), path);
+        auto data = elle::Buffer{};
+        put(data, epoch);
+        for (auto const& k: cache)
+        {
+          auto const entry = key_cache_entry(k);
+          data.append(entry.contents(), entry.size());
+        }
+        auto const tmp = bfs::path(path.string() + ".tmp");
+        bfs::create_directories(path.parent_path());
+        {
+          auto const fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC);
+          elle::SafeFinally close([fd] { ::close(fd); });
+          write_all(fd, data, tmp);
+          // Sync before renaming, lest a crash leaves an empty file.
+          sync(fd, tmp);
+        }
+        bfs::rename(tmp, path);
+#ifndef ELLE_WINDOWS
+        // Sync the directory for the rename to persist.
+        auto const dir = open(path.parent_path(), O_RDONLY);
+        elle::SafeFinally close([dir] { ::close(dir); });
+        sync(dir, path.parent_path());
+#endif
+      }
+
+      void
+      append_key_cache(bfs::path const& path, elle::Buffer const& entries)
+      {
+        ELLE_DEBUG_SCOPE("append %s bytes of keys to %s",
+                         entries.size(), path);
+        auto const fd = open(path, O_WRONLY | O_APPEND);
+        elle::SafeFinally close([fd] { ::close(fd); });
+        write_all(fd, entries, path);
+        sync(fd, path);
+      }
+
+      boost::optional<elle::Buffer>
+      load_key_cache(bfs::path const& path, KeyCache& cache)
+      {
+        if (!bfs::exists(path))
+          return boost::none;
+        try
+        {
+          auto data = elle::Buffer{};
+          {
+            bfs::ifstream is(path, std::ios::binary);
+            data = elle::Buffer(std::string(
+              std::istreambuf_iterator<char>(is),
+              std::istreambuf_iterator<char>()));
+          }
+          auto offset = std::size_t(0);
+          auto const epoch = get(data, offset);
+          if (!epoch)
+            elle::err("missing epoch");
+          while (auto entry = get(data, offset))
+          {
+            auto k = elle::serialization::binary::deserialize<Entry>(
+              elle::Buffer(entry->contents(), entry->size()), false);
+            cache.emplace(k.first, std::move(k.second));
+          }
+          // Entries are synced before their hash is handed out: a torn one
+          // was never used.
+          if (offset != data.size())
+            ELLE_WARN("ignore torn key cache entry in %s", path);
+          ELLE_DEBUG("load %s keys from %s", cache.size(), path);
+          return elle::Buffer(epoch->contents(), epoch->size());
+        }
+        catch (elle::Error const& e)
+        {
+          ELLE_WARN("ignore invalid key cache %s: %s", path, e);
+          cache.clear();
+          return boost::none;
+        }
+      }
+    }
+  }
+}
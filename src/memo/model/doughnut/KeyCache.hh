@@ -1,9 +1,16 @@
 #pragma once
 
+#include <unordered_map>
+
+#include <boost/filesystem/path.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index_container.hpp>
+#include <boost/optional.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/cryptography/rsa/PublicKey.hh>
 
 namespace memo
 {
@@ -43,6 +50,34 @@ namespace memo
             std::hash<elle::cryptography::rsa::PublicKey>>,
           bmi::hashed_unique<
             bmi::member<KeyHash, int, &KeyHash::hash>>>>;
+
+      /// Keys by hash, as exchanged by peers.
+      using KeyDictionary =
+        std::unordered_map<int, elle::cryptography::rsa::PublicKey>;
+
+      /// Save `cache` to `path`, tagged with the `epoch` of the dictionary
+      /// its hashes come from.
+      ///
+      /// Hashes are only meaningful to the node that assigned them: the epoch
+      /// is drawn when a node starts a new dictionary, so that hashes saved
+      /// from a dictionary that was since lost are never trusted.  The file
+      /// is the epoch followed by a log of entries; it is synced then
+      /// replaced atomically.
+      void
+      save_key_cache(boost::filesystem::path const& path,
+                     elle::Buffer const& epoch,
+                     KeyCache const& cache);
+      /// The entry of `key`, to append to a key cache file.
+      elle::Buffer
+      key_cache_entry(KeyHash const& key);
+      /// Append `entries` to the key cache saved at `path`, and sync it.
+      void
+      append_key_cache(boost::filesystem::path const& path,
+                       elle::Buffer const& entries);
+      /// Load the keys saved to `path` into `cache` and return their epoch,
+      /// if any.
+      boost::optional<elle::Buffer>
+      load_key_cache(boost::filesystem::path const& path, KeyCache& cache);
     }
   }
 }
@@ -308,6 +308,22 @@ namespace memo
         return res;
       }
 
+      std::pair<elle::Buffer, KeyDictionary>
+      Local::_key_dictionary(elle::Buffer const& epoch, int from)
+      {
+        static auto const batch = memo::getenv("KEY_PREFETCH", 256);
+        auto const& cache = this->doughnut().key_cache();
+        if (epoch != this->doughnut().key_epoch())
+          from = 0;
+        auto res = KeyDictionary{};
+        auto const end = std::min<int>(from + batch, cache.size());
+        for (auto h = std::max(from, 0); h < end; ++h)
+          res.emplace(h, *this->doughnut().resolve_key(h));
+        ELLE_DEBUG("%s: send %s keys from %s", this, res.size(), from);
+        return std::make_pair(elle::Buffer(this->doughnut().key_epoch()),
+                              std::move(res));
+      }
+
       /*-------.
       | Server |
       `-------*/
@@ -492,10 +508,69 @@ namespace memo
               elle::cryptography::Cipher::aes256,
               elle::cryptography::Mode::cbc);
             if (this->doughnut().encrypt_options().encrypt_rpc)
+            {
+              if (this->_doughnut.version() >= elle::Version(0, 7, 0))
+                this->_doughnut.dock().sessions().add(
+                  session::ticket(password),
+                  Dock::Session{connection._id, passport, password});
               rpcs._key.emplace(std::move(password));
+            }
+            this->_doughnut.dock().handshake(false);
             connection.ready()();
             return true;
           });
+        if (this->_doughnut.version() >= elle::Version(0, 7, 0))
+          rpcs.add(
+            "auth_resume",
+            [this, &connection, &rpcs](
+              Address id,
+              elle::Buffer const& ticket,
+              elle::Buffer const& nonce,
+              elle::Buffer const& proof)
+            {
+              ELLE_TRACE("%s: resume session of %f", this, id);
+              if (!this->doughnut().encrypt_options().encrypt_rpc)
+                elle::err("session resumption requires RPC encryption");
+              auto& sessions = this->_doughnut.dock().sessions();
+              // Check the proof before consuming the ticket, lest anyone
+              // replaying it burns it.
+              auto const known = sessions.find(ticket);
+              if (!known || known->session.id != id ||
+                  !session::verify(
+                    proof, known->session.secret, "resume", nonce))
+                elle::err<HandshakeFailed>("unknown session ticket");
+              auto entry = sessions.take(ticket);
+              ELLE_ASSERT(entry);
+              auto& session = entry->session;
+              auto const server_nonce = session::nonce();
+              auto password =
+                session::derive(session.secret, nonce, server_nonce);
+              connection._id = id;
+              this->_passports.erase(&rpcs);
+              this->_passports.insert(std::make_pair(&rpcs, session.passport));
+              rpcs._key.emplace(elle::Buffer(password));
+              sessions.add(
+                session::ticket(password),
+                Dock::Session{id, std::move(session.passport),
+                              std::move(password)},
+                entry->expiry);
+              this->_doughnut.dock().handshake(true);
+              connection.ready()();
+              return std::make_pair(
+                server_nonce,
+                session::proof(
+                  session.secret, "accept", nonce, server_nonce));
+            });
+        rpcs.add(
+          "aead",
+          [this, &rpcs] ()
+          {
+            this->_require_auth(rpcs, false);
+            // From now on, refuse requests that are not authenticated.
+            rpcs._aead = this->doughnut().encrypt_options().mode() ==
+              elle::cryptography::Mode::gcm;
+            return rpcs._aead;
+          });
         rpcs.add(
           "resolve_keys",
           [this](std::vector<int> const& ids)
@@ -505,6 +580,12 @@ namespace memo
         rpcs.add(
           "resolve_all_keys",
           [this]() { return this->_resolve_all_keys(); });
+        rpcs.add(
+          "key_dictionary",
+          [this] (elle::Buffer const& epoch, int from)
+          {
+            return this->_key_dictionary(epoch, from);
+          });
         if (!this->doughnut().encrypt_options().encrypt_rpc)
           connection.ready()();
       }
@@ -9,6 +9,7 @@
 #include <elle/reactor/network/utp-socket.hh>
 
 #include <memo/RPC.hh>
+#include <memo/model/doughnut/KeyCache.hh>
 #include <memo/model/doughnut/Peer.hh>
 #include <memo/model/doughnut/fwd.hh>
 #include <memo/model/doughnut/protocol.hh>
@@ -74,6 +75,10 @@ namespace memo
         _resolve_keys(std::vector<int> const& ids) override;
         std::unordered_map<int, elle::cryptography::rsa::PublicKey>
         _resolve_all_keys() override;
+        /// Our key hashes epoch, and a batch of keys from hash `from`, or from
+        /// the first one if `epoch` is not ours.
+        std::pair<elle::Buffer, KeyDictionary>
+        _key_dictionary(elle::Buffer const& epoch, int from);
 
       /*----.
       | RPC |
@@ -113,6 +118,10 @@ namespace memo
 
           void
           print(std::ostream&) const override;
+          /// Call procedure `name` on the connected peer.
+          template <typename R, typename ... Args>
+          R
+          call(std::string const& name, Args const& ... args);
 
         private:
           friend class doughnut::Local;
@@ -59,6 +59,16 @@ namespace memo
         }
         clear();
       }
+
+      template <typename R, typename ... Args>
+      R
+      Local::Connection::call(std::string const& name, Args const& ... args)
+      {
+        using Rpc = RPC<auto (Args const& ...) -> R>;
+        auto rpc = Rpc(name, this->_channels,
+                       this->_local.version(), this->_rpcs._key);
+        return rpc(args...);
+      }
     }
   }
 }
@@ -0,0 +1,109 @@
+#include <memo/model/doughnut/MerkleTree.hh>
+
+#include <cstring>
+
+#include <elle/assert.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        namespace
+        {
+          uint64_t
+          mix(uint64_t x)
+          {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+          }
+
+          uint64_t
+          digest(Address const& address, int version)
+          {
+            auto words = std::array<uint64_t, 4>{};
+            std::memcpy(
+              words.data(), address.value(), sizeof(Address::Value));
+            auto res = mix(uint64_t(uint32_t(version)));
+            for (auto w: words)
+              res = mix(res ^ w);
+            return res;
+          }
+        }
+
+        int constexpr MerkleTree::fanout;
+        int constexpr MerkleTree::depth;
+
+        MerkleTree::MerkleTree()
+          : _size(0)
+          , _levels()
+        {
+          auto width = 1;
+          for (auto& level: this->_levels)
+          {
+            level.resize(width, 0);
+            width *= fanout;
+          }
+        }
+
+        void
+        MerkleTree::add(Address const& address, int version)
+        {
+          this->_toggle(address, version);
+          ++this->_size;
+        }
+
+        void
+        MerkleTree::remove(Address const& address, int version)
+        {
+          ELLE_ASSERT_GT(this->_size, 0);
+          this->_toggle(address, version);
+          --this->_size;
+        }
+
+        void
+        MerkleTree::_toggle(Address const& address, int version)
+        {
+          auto const d = digest(address, version);
+          auto index = leaf(address);
+          for (int level = depth; level >= 0; --level)
+          {
+            this->_levels[level][index] ^= d;
+            index /= fanout;
+          }
+        }
+
+        uint64_t
+        MerkleTree::hash(int level, int index) const
+        {
+          return this->_levels.at(level).at(index);
+        }
+
+        std::vector<uint64_t>
+        MerkleTree::hashes(int level, std::vector<int> const& indexes) const
+        {
+          auto res = std::vector<uint64_t>{};
+          res.reserve(indexes.size());
+          for (auto i: indexes)
+            res.emplace_back(this->hash(level, i));
+          return res;
+        }
+
+        int
+        MerkleTree::leaf(Address const& address)
+        {
+          // Addresses are digests, their leading bits are evenly spread.
+          static_assert(fanout == 16 && depth == 3,
+                        "leaf prefix must match the tree shape");
+          auto const v = address.value();
+          return (int(v[0]) << 4) | (int(v[1]) >> 4);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <elle/attribute.hh>
+
+#include <memo/model/Address.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        /// Hashes of (address, version) entries by address range, for
+        /// replicas to find which ranges they disagree on.
+        ///
+        /// The address space is split by prefix into `fanout ^ depth` leaf
+        /// ranges.  Every node hashes the entries of its range as the xor of
+        /// their digests, so that adding or removing an entry only updates
+        /// the nodes on its path.  Two trees over the same entries are equal
+        /// node for node; comparing them top down only descends into ranges
+        /// that differ.
+        class MerkleTree
+        {
+        public:
+          /// Number of children of inner nodes.
+          static int constexpr fanout = 16;
+          /// Level of the leaves, the root being at level 0.
+          static int constexpr depth = 3;
+          MerkleTree();
+          /// Add the entry of `address` at `version`.
+          void
+          add(Address const& address, int version);
+          /// Remove the entry of `address` at `version`.
+          void
+          remove(Address const& address, int version);
+          /// Hash of the node at `index` of `level`.
+          uint64_t
+          hash(int level, int index) const;
+          /// Hashes of the nodes at `indexes` of `level`.
+          std::vector<uint64_t>
+          hashes(int level, std::vector<int> const& indexes) const;
+          /// Index of the leaf whose range holds `address`.
+          static
+          int
+          leaf(Address const& address);
+          /// Number of entries.
+          ELLE_ATTRIBUTE_R(int64_t, size);
+
+        private:
+          void
+          _toggle(Address const& address, int version);
+          ELLE_ATTRIBUTE((std::array<std::vector<uint64_t>, depth + 1>),
+                         levels);
+        };
+      }
+    }
+  }
+}
@@ -18,6 +18,7 @@
 #include <memo/model/doughnut/Doughnut.hh>
 #include <memo/model/doughnut/Local.hh>
 #include <memo/model/doughnut/Remote.hh>
+#include <memo/model/doughnut/SignatureCache.hh>
 #include <memo/model/doughnut/UB.hh>
 
 ELLE_LOG_COMPONENT("memo.model.doughnut.OKB");
@@ -314,6 +315,23 @@ namespace memo
                 && this->Super::operator ==(other));
       }
 
+      template <typename Block>
+      std::size_t
+      BaseOKB<Block>::footprint() const
+      {
+        return this->Super::footprint()
+          + this->_data_plain.size()
+          + this->_salt.size()
+          + OKBHeader::_signature.size();
+      }
+
+      template <typename Block>
+      elle::Buffer const&
+      BaseOKB<Block>::data_plain() const
+      {
+        return this->_data_plain;
+      }
+
       template <typename Block>
       elle::Buffer const&
       BaseOKB<Block>::data() const
@@ -337,7 +355,7 @@ namespace memo
       BaseOKB<Block>::data(std::function<void (elle::Buffer&)> transformation)
       {
         this->_decrypt_data();
-        transformation(this->_data_plain);
+        transformation(this->_data_plain.mutate());
         this->_data_changed = true;
         this->_validated = false;
       }
@@ -425,7 +443,7 @@ namespace memo
           ELLE_DEBUG_SCOPE("%s: data changed, seal", *this);
           ELLE_DUMP("%s: data: %s", *this, this->_data_plain);
           auto encrypted =
-            this->doughnut()->keys().K().seal(this->_data_plain);
+            this->doughnut()->keys().K().seal(this->_data_plain.get());
           ELLE_DUMP("%s: encrypted data: %s", *this, encrypted);
           this->Block::data(std::move(encrypted));
           this->_seal_okb(version);
@@ -479,7 +497,9 @@ namespace memo
         {
           ELLE_ASSERT(this->signature() != elle::Buffer());
           auto sign = this->_sign();
-          if (!this->_owner_key->verify(this->signature(), *sign))
+          if (!SignatureCache::instance().verify(
+                this->address(), this->_version, *this->_owner_key,
+                this->signature(), *sign))
           {
             ELLE_TRACE("invalid signature for version %s: %x",
               this->_version, this->signature());
@@ -533,7 +553,7 @@ namespace memo
           s.serialize("next_seal_version", this->_seal_version);
           if (this->_data.empty())
           {
-            s.serialize("data_plain", this->_data_plain);
+            this->_data_plain.serialize(s, "data_plain");
             this->_data_changed = true;
           }
         }
@@ -558,7 +578,7 @@ namespace memo
           s.serialize("salt", this->_salt);
           if (this->_data.empty())
           {
-            s.serialize("data_plain", this->_data_plain);
+            this->_data_plain.serialize(s, "data_plain");
             if (s.in())
               this->_data_changed = true;
           }
@@ -122,9 +122,14 @@ namespace memo
 
         bool
         operator ==(blocks::Block const& rhs) const override;
+        std::size_t
+        footprint() const override;
         ELLE_ATTRIBUTE_R(std::shared_ptr<elle::cryptography::rsa::PrivateKey>,
                          owner_private_key, protected);
-        ELLE_ATTRIBUTE_R(elle::Buffer, data_plain, protected);
+        ELLE_attribute_r(elle::Buffer, data_plain);
+      protected:
+        /// Shared with clones until either modifies it.
+        blocks::SharedBuffer _data_plain;
         ELLE_ATTRIBUTE(bool, data_decrypted, protected);
       protected:
         void
@@ -1,4 +1,6 @@
+#include <elle/finally.hh>
 #include <elle/log.hh>
+#include <elle/utils.hh>
 
 #include <memo/model/doughnut/Peer.hh>
 #include <memo/model/blocks/MutableBlock.hh>
@@ -18,6 +20,8 @@ namespace memo
       Peer::Peer(Doughnut& dht, Address id)
         : _doughnut(dht)
         , _id(std::move(id))
+        , _rtt()
+        , _fetching(0)
       {}
 
       Peer::~Peer()
@@ -43,7 +47,14 @@ namespace memo
                   boost::optional<int> local_version) const
       {
         ELLE_TRACE_SCOPE("%s: fetch %f", this, address);
-        auto res = this->_fetch(std::move(address), std::move(local_version));
+        auto& self = elle::unconst(*this);
+        ++self._fetching;
+        elle::SafeFinally done([&] { --self._fetching; });
+        auto const start = std::chrono::steady_clock::now();
+        auto res = this->_fetch(address, local_version);
+        auto const rtt = std::chrono::duration_cast<elle::Duration>(
+          std::chrono::steady_clock::now() - start);
+        self._rtt = self._rtt ? (*self._rtt * 7 + rtt) / 8 : rtt;
         if (local_version)
           if (auto mb = dynamic_cast<blocks::MutableBlock*>(res.get()))
             if (mb->version() == local_version.get())
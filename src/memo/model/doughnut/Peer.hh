@@ -60,6 +60,15 @@ namespace memo
         _fetch(Address address,
                boost::optional<int> local_version) const = 0;
 
+      /*--------.
+      | Latency |
+      `--------*/
+      public:
+        /// Smoothed round-trip time of successful fetches, if any.
+        ELLE_ATTRIBUTE_R(boost::optional<elle::Duration>, rtt);
+        /// Number of fetches in progress.
+        ELLE_ATTRIBUTE_R(int, fetching);
+
       /*-----.
       | Keys |
       `-----*/
@@ -246,35 +246,133 @@ namespace memo
       | Keys |
       `-----*/
 
+      boost::optional<boost::filesystem::path>
+      Remote::_keys_path() const
+      {
+        if (auto const& dir = this->doughnut().key_cache_path())
+          return *dir / "peers" / elle::sprintf("%x", this->id());
+        else
+          return boost::none;
+      }
+
+      bool
+      Remote::_fetch_keys(elle::Buffer const& epoch, int from)
+      {
+        using KeyDictionary_ =
+          auto (elle::Buffer const&, int) -> std::pair<elle::Buffer, KeyDictionary>;
+        auto res = this->make_rpc<KeyDictionary_>("key_dictionary")(epoch, from);
+        ELLE_DEBUG("%s: prefetched %s keys", this, res.second.size());
+        auto& cache = this->key_hash_cache();
+        if (this->_connection->key_hash_epoch() != res.first)
+        {
+          // The peer started a new dictionary, hashes we had are void.
+          cache.clear();
+          this->_connection->key_hash_epoch(res.first);
+        }
+        for (auto& k: res.second)
+          if (!elle::find(cache.get<1>(), k.first))
+            cache.emplace(k.first, std::move(k.second));
+        return res.first == epoch;
+      }
+
+      void
+      Remote::_sync_keys()
+      {
+        ELLE_TRACE_SCOPE("%s: synchronize key hashes", this);
+        auto saved = KeyCache{};
+        auto epoch = boost::optional<elle::Buffer>{};
+        if (auto path = this->_keys_path())
+          epoch = load_key_cache(*path, saved);
+        // Prefetch from the first hash we are missing.
+        auto from = 0;
+        while (elle::find(saved.get<1>(), from))
+          ++from;
+        try
+        {
+          if (this->_fetch_keys(epoch.value_or(elle::Buffer()), from))
+          {
+            ELLE_DEBUG("%s: reuse %s persisted keys", this, saved.size());
+            auto& cache = this->key_hash_cache();
+            for (auto const& k: saved)
+              if (!elle::find(cache.get<1>(), k.hash))
+                cache.emplace(k.hash, k.key);
+          }
+        }
+        catch (UnknownRPC const&)
+        {
+          ELLE_DEBUG("%s: peer does not share its key hashes epoch", this);
+          this->_connection->key_hash_epoch(elle::Buffer());
+        }
+      }
+
+      void
+      Remote::_save_keys()
+      {
+        auto const& epoch = this->_connection->key_hash_epoch();
+        auto const path = this->_keys_path();
+        if (!path || !epoch || epoch->empty())
+          return;
+        try
+        {
+          save_key_cache(*path, *epoch, this->key_hash_cache());
+        }
+        catch (std::exception const& e)
+        {
+          ELLE_WARN("%s: unable to persist keys: %s", this, e.what());
+        }
+      }
+
       std::vector<elle::cryptography::rsa::PublicKey>
       Remote::_resolve_keys(std::vector<int> const& ids)
       {
         static auto bench = elle::Bench<double>{"bench.remote_key_cache_hit", 1000s};
         {
-          auto missing = elle::make_vector_if
-            (ids,
-             [this](auto id)
-             {
-               return !elle::find(this->key_hash_cache().get<1>(), id);
-             });
+          auto const find_missing = [&]
+            {
+              return elle::make_vector_if(
+                ids,
+                [this](auto id)
+                {
+                  return !elle::find(this->key_hash_cache().get<1>(), id);
+                });
+            };
+          auto missing = find_missing();
           if (missing.empty())
             bench.add(1);
           else
           {
             bench.add(0);
-            ELLE_TRACE("%s: fetch %s keys by ids", this, missing.size());
-            using ResolveKeys =
-              auto (std::vector<int> const&)
-              -> std::vector<elle::cryptography::rsa::PublicKey>;
-            auto rpc = this->make_rpc<ResolveKeys>("resolve_keys");
-            auto missing_keys = rpc(missing);
-            if (missing_keys.size() != missing.size())
-              elle::err("resolve_keys for %s keys on %s gave %s replies",
-                        missing.size(), this, missing_keys.size());
-            auto id_it = missing.begin();
-            auto key_it = missing_keys.begin();
-            for (; id_it != missing.end(); ++id_it, ++key_it)
-              this->key_hash_cache().emplace(*id_it, std::move(*key_it));
+            if (!this->_connection->key_hash_epoch())
+            {
+              this->_sync_keys();
+              missing = find_missing();
+            }
+            auto const& epoch = this->_connection->key_hash_epoch();
+            if (!missing.empty() && epoch && !epoch->empty())
+            {
+              // New keys on the peer: prefetch the batch following the first
+              // one we miss.
+              this->_fetch_keys(
+                *epoch, *std::min_element(missing.begin(), missing.end()));
+              missing = find_missing();
+            }
+            if (!missing.empty())
+            {
+              ELLE_TRACE("%s: fetch %s keys by ids", this, missing.size());
+              using ResolveKeys =
+                auto (std::vector<int> const&)
+                -> std::vector<elle::cryptography::rsa::PublicKey>;
+              auto rpc = this->make_rpc<ResolveKeys>("resolve_keys");
+              auto missing_keys = rpc(missing);
+              if (missing_keys.size() != missing.size())
+                elle::err("resolve_keys for %s keys on %s gave %s replies",
+                          missing.size(), this, missing_keys.size());
+              auto id_it = missing.begin();
+              auto key_it = missing_keys.begin();
+              for (; id_it != missing.end(); ++id_it, ++key_it)
+                this->key_hash_cache().emplace(*id_it, std::move(*key_it));
+            }
+            this->_save_keys();
           }
         }
         return elle::make_vector(ids, [this] (auto id) {
@@ -131,6 +131,22 @@ namespace memo
         std::unordered_map<int, elle::cryptography::rsa::PublicKey>
         _resolve_all_keys() override;
         ELLE_attribute_rx(KeyCache, key_hash_cache);
+      private:
+        /// Fetch the peer key hashes epoch, along with a batch of keys from
+        /// `from`.  Add them to the cache and return whether the epoch is
+        /// `epoch`.
+        bool
+        _fetch_keys(elle::Buffer const& epoch, int from);
+        /// Load the keys persisted from this peer, if still valid, and
+        /// prefetch the next ones.
+        void
+        _sync_keys();
+        /// Persist the keys of this peer.
+        void
+        _save_keys();
+        /// Where keys of this peer are persisted, if anywhere.
+        boost::optional<boost::filesystem::path>
+        _keys_path() const;
       };
 
       template <typename F>
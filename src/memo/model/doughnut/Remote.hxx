@@ -150,6 +150,10 @@ namespace memo
         , _remote(remote)
       {
         this->template set_context<Remote*>(remote);
+        // Only encipher with a mode the peer agreed to.
+        this->mode(remote->_connection->aead() ?
+                   elle::cryptography::Mode::gcm :
+                   elle::cryptography::SecretKey::defaults::mode);
       }
 
       template <typename F>
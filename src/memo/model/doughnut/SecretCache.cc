@@ -0,0 +1,99 @@
+#include <memo/model/doughnut/SecretCache.hh>
+
+#include <elle/cryptography/hash.hh>
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.SecretCache");
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace
+      {
+        elle::Buffer
+        key_digest(Address const& address, elle::Buffer const& token)
+        {
+          auto buf = elle::Buffer{};
+          buf.append(address.value(), sizeof(Address::Value));
+          buf.append(token.contents(), token.size());
+          return elle::cryptography::hash(
+            buf, elle::cryptography::Oneway::sha256);
+        }
+      }
+
+      SecretCache::SecretCache(int capacity)
+        : _capacity(capacity)
+        , _hits(0)
+        , _misses(0)
+        , _entries()
+      {}
+
+      boost::optional<elle::Buffer>
+      SecretCache::find(Address const& address, elle::Buffer const& token)
+      {
+        if (this->_capacity <= 0 || token.empty())
+          return boost::none;
+        auto const digest = key_digest(address, token);
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        auto& index = this->_entries.get<0>();
+        auto it = index.find(digest);
+        if (it == index.end())
+        {
+          ++this->_misses;
+          return boost::none;
+        }
+        ELLE_DUMP("hit secret of %f", address);
+        ++this->_hits;
+        auto& lru = this->_entries.get<2>();
+        lru.relocate(lru.end(), this->_entries.project<2>(it));
+        return elle::Buffer(it->secret);
+      }
+
+      void
+      SecretCache::add(Address const& address,
+                       elle::Buffer const& token,
+                       elle::Buffer const& secret)
+      {
+        if (this->_capacity <= 0 || token.empty() || secret.empty())
+          return;
+        auto digest = key_digest(address, token);
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        auto& lru = this->_entries.get<2>();
+        lru.push_back(Entry{address, std::move(digest), elle::Buffer(secret)});
+        while (signed(lru.size()) > this->_capacity)
+          lru.pop_front();
+      }
+
+      void
+      SecretCache::invalidate(Address const& address)
+      {
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        this->_entries.get<1>().erase(address);
+      }
+
+      void
+      SecretCache::clear()
+      {
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        this->_entries.clear();
+      }
+
+      elle::json::Json
+      SecretCache::stats() const
+      {
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        auto const total = this->_hits + this->_misses;
+        return {
+          {"capacity", this->_capacity},
+          {"size", this->_entries.size()},
+          {"hits", this->_hits},
+          {"misses", this->_misses},
+          {"hit_rate", total ? double(this->_hits) / total : 0.},
+        };
+      }
+    }
+  }
+}
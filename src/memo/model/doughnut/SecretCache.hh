@@ -0,0 +1,83 @@
+#pragma once
+
+#include <mutex>
+
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/optional.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+#include <elle/json/json.hh>
+
+#include <memo/model/Address.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Cache of ACB secrets unwrapped from their tokens.
+      ///
+      /// Unwrapping a token is an RSA private key operation, repeated on
+      /// every read of a block.  Entries are keyed by a digest of the block
+      /// address and the token, so a new secret, which comes with new
+      /// tokens, is never served from the cache.  Entries of a block are
+      /// also dropped when its ACL or data is resealed.  Secrets of group
+      /// tokens are only looked up once the group key was fetched again, so
+      /// that members removed from a group stop reading its blocks even if
+      /// the block secret does not change.  The cache belongs to a
+      /// Doughnut, it only holds secrets its keys could unwrap.  Least
+      /// recently used entries are evicted beyond `MEMO_SECRET_CACHE_SIZE`,
+      /// 0 disabling the cache.
+      class SecretCache
+      {
+      public:
+        SecretCache(int capacity);
+        /// The secret unwrapped from `token` for block `address`, if any.
+        boost::optional<elle::Buffer>
+        find(Address const& address, elle::Buffer const& token);
+        /// Remember the secret unwrapped from `token` for block `address`.
+        void
+        add(Address const& address,
+            elle::Buffer const& token,
+            elle::Buffer const& secret);
+        /// Forget the secrets of block `address`.
+        void
+        invalidate(Address const& address);
+        /// Forget all secrets.
+        void
+        clear();
+        /// Capacity, size, hits, misses and hit rate.
+        elle::json::Json
+        stats() const;
+        ELLE_ATTRIBUTE_R(int, capacity);
+        ELLE_ATTRIBUTE_R(int64_t, hits);
+        ELLE_ATTRIBUTE_R(int64_t, misses);
+
+      private:
+        struct Entry
+        {
+          Address address;
+          elle::Buffer digest;
+          elle::Buffer secret;
+        };
+        using Entries = boost::multi_index::multi_index_container<
+          Entry,
+          boost::multi_index::indexed_by<
+            boost::multi_index::hashed_unique<
+              boost::multi_index::member<Entry, elle::Buffer, &Entry::digest>,
+              std::hash<elle::Buffer>>,
+            boost::multi_index::hashed_non_unique<
+              boost::multi_index::member<Entry, Address, &Entry::address>,
+              std::hash<Address>>,
+            boost::multi_index::sequenced<>>>;
+        ELLE_ATTRIBUTE(Entries, entries);
+        ELLE_ATTRIBUTE(std::mutex, mutex, mutable);
+      };
+    }
+  }
+}
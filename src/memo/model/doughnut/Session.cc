@@ -0,0 +1,93 @@
+#include <memo/model/doughnut/Session.hh>
+
+#include <elle/cryptography/hmac.hh>
+#include <elle/cryptography/random.hh>
+
+#include <memo/environ.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace session
+      {
+        namespace
+        {
+          elle::Buffer
+          message(std::string const& label,
+                  elle::Buffer const& client_nonce,
+                  elle::Buffer const& server_nonce)
+          {
+            auto res = elle::Buffer("memo.session." + label);
+            res.append(client_nonce.contents(), client_nonce.size());
+            res.append(server_nonce.contents(), server_nonce.size());
+            return res;
+          }
+
+          elle::Buffer
+          mac(elle::Buffer const& secret,
+              std::string const& label,
+              elle::Buffer const& client_nonce,
+              elle::Buffer const& server_nonce)
+          {
+            auto const input = message(label, client_nonce, server_nonce);
+            return elle::cryptography::hmac::sign(
+              input, secret.string(), elle::cryptography::Oneway::sha256);
+          }
+        }
+
+        elle::Duration
+        ttl()
+        {
+          static auto const res =
+            std::chrono::seconds(memo::getenv("SESSION_TICKET_TTL", 3600));
+          return res;
+        }
+
+        elle::Buffer
+        nonce()
+        {
+          return elle::cryptography::random::generate<elle::Buffer>(32);
+        }
+
+        elle::Buffer
+        ticket(elle::Buffer const& secret)
+        {
+          return mac(secret, "ticket", {}, {});
+        }
+
+        elle::Buffer
+        proof(elle::Buffer const& secret,
+              std::string const& label,
+              elle::Buffer const& client_nonce,
+              elle::Buffer const& server_nonce)
+        {
+          return mac(secret, label, client_nonce, server_nonce);
+        }
+
+        bool
+        verify(elle::Buffer const& proof,
+               elle::Buffer const& secret,
+               std::string const& label,
+               elle::Buffer const& client_nonce,
+               elle::Buffer const& server_nonce)
+        {
+          auto const input = message(label, client_nonce, server_nonce);
+          return elle::cryptography::hmac::verify(
+            proof, input, secret.string(),
+            elle::cryptography::Oneway::sha256);
+        }
+
+        elle::Buffer
+        derive(elle::Buffer const& secret,
+               elle::Buffer const& client_nonce,
+               elle::Buffer const& server_nonce)
+        {
+          return mac(secret, "key", client_nonce, server_nonce);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/Duration.hh>
+#include <elle/attribute.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Resumption of authenticated peer sessions.
+      ///
+      /// A full handshake verifies the peer passport, signs a challenge and
+      /// seals the session secret with RSA.  Once it succeeds, both ends keep
+      /// the secret for `MEMO_SESSION_TICKET_TTL` seconds, an hour by
+      /// default, 0 disabling resumption.  A reconnecting client presents the
+      /// ticket derived from the secret along with a nonce and a proof that
+      /// it holds the secret; the server answers with its own nonce and
+      /// proof, and both derive the new RPC key from the secret and the two
+      /// nonces with HMAC-SHA256.  Tickets are single use: the new key
+      /// yields the next ticket.  Resumed sessions keep the expiry of the
+      /// full handshake they descend from, so that passports are verified
+      /// again at least once per TTL however often sessions are resumed.
+      namespace session
+      {
+        /// How long secrets of past sessions are kept.
+        elle::Duration
+        ttl();
+        /// A fresh random nonce.
+        elle::Buffer
+        nonce();
+        /// The ticket identifying the session of `secret`.
+        elle::Buffer
+        ticket(elle::Buffer const& secret);
+        /// Proof that `secret` is held, bound to `label` and the nonces.
+        elle::Buffer
+        proof(elle::Buffer const& secret,
+              std::string const& label,
+              elle::Buffer const& client_nonce,
+              elle::Buffer const& server_nonce = {});
+        /// Whether `proof` is the proof of `secret` for `label` and the nonces.
+        bool
+        verify(elle::Buffer const& proof,
+               elle::Buffer const& secret,
+               std::string const& label,
+               elle::Buffer const& client_nonce,
+               elle::Buffer const& server_nonce = {});
+        /// The secret of the session resumed from `secret` with the nonces.
+        elle::Buffer
+        derive(elle::Buffer const& secret,
+               elle::Buffer const& client_nonce,
+               elle::Buffer const& server_nonce);
+
+        /// Sessions by key, forgotten once taken or expired.
+        template <typename Key, typename Session>
+        class Tickets
+        {
+        public:
+          /// A session and the time it expires at.
+          struct Entry
+          {
+            Session session;
+            elle::Time expiry;
+          };
+
+          Tickets()
+            : _ttl(session::ttl())
+            , _sessions()
+          {}
+
+          /// Remember `session` under `key` until `expiry`, by default
+          /// `ttl` from now.
+          void
+          add(Key key,
+              Session session,
+              boost::optional<elle::Time> expiry = boost::none)
+          {
+            if (this->_ttl == elle::Duration::zero())
+              return;
+            auto const now = elle::Clock::now();
+            for (auto it = this->_sessions.begin();
+                 it != this->_sessions.end();)
+              if (it->second.expiry <= now)
+                it = this->_sessions.erase(it);
+              else
+                ++it;
+            this->_sessions.erase(key);
+            auto const until = std::min(expiry.value_or(now + this->_ttl),
+                                        now + this->_ttl);
+            if (until <= now)
+              return;
+            this->_sessions.emplace(
+              std::move(key), Entry{std::move(session), until});
+          }
+
+          /// The session under `key`, if still valid, without forgetting it.
+          Entry const*
+          find(Key const& key) const
+          {
+            auto it = this->_sessions.find(key);
+            if (it == this->_sessions.end() ||
+                it->second.expiry <= elle::Clock::now())
+              return nullptr;
+            return &it->second;
+          }
+
+          /// Forget and return the session under `key`, if still valid.
+          boost::optional<Entry>
+          take(Key const& key)
+          {
+            auto it = this->_sessions.find(key);
+            if (it == this->_sessions.end())
+              return boost::none;
+            auto res = boost::optional<Entry>{};
+            if (elle::Clock::now() < it->second.expiry)
+              res.emplace(std::move(it->second));
+            this->_sessions.erase(it);
+            return res;
+          }
+
+          /// Forget all sessions.
+          void
+          clear()
+          {
+            this->_sessions.clear();
+          }
+
+          /// Number of sessions, including expired ones.
+          std::size_t
+          size() const
+          {
+            return this->_sessions.size();
+          }
+
+          ELLE_ATTRIBUTE_RW(elle::Duration, ttl);
+        private:
+          ELLE_ATTRIBUTE((std::unordered_map<Key, Entry>), sessions);
+        };
+      }
+    }
+  }
+}
@@ -0,0 +1,126 @@
+#include <memo/model/doughnut/SignatureCache.hh>
+
+#include <elle/cryptography/hash.hh>
+#include <elle/cryptography/rsa/der.hh>
+#include <elle/log.hh>
+
+#include <memo/environ.hh>
+#include <memo/model/doughnut/crypto.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.SignatureCache");
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace
+      {
+        elle::Buffer
+        key_digest(Address const& address,
+                   int version,
+                   elle::cryptography::rsa::PublicKey const& key,
+                   elle::ConstWeakBuffer const& signature,
+                   elle::ConstWeakBuffer const& data)
+        {
+          using elle::cryptography::Oneway;
+          auto const encoded =
+            elle::cryptography::rsa::publickey::der::encode(key);
+          auto const data_digest =
+            elle::cryptography::hash(data, Oneway::sha256);
+          auto buf = elle::Buffer{};
+          buf.append(address.value(), sizeof(Address::Value));
+          buf.append(&version, sizeof version);
+          // Length-prefix the variable parts so they cannot be shifted into
+          // one another.
+          for (auto const part: {elle::ConstWeakBuffer(encoded),
+                                 signature,
+                                 elle::ConstWeakBuffer(data_digest)})
+          {
+            auto const size = uint64_t(part.size());
+            buf.append(&size, sizeof size);
+            buf.append(part.contents(), part.size());
+          }
+          return elle::cryptography::hash(buf, Oneway::sha256);
+        }
+      }
+
+      SignatureCache::SignatureCache(int capacity)
+        : _capacity(capacity)
+        , _hits(0)
+        , _misses(0)
+        , _entries()
+      {}
+
+      SignatureCache&
+      SignatureCache::instance()
+      {
+        static SignatureCache res(
+          memo::getenv("SIGNATURE_CACHE_SIZE", 4096));
+        return res;
+      }
+
+      bool
+      SignatureCache::_verify(Address const& address,
+                              int version,
+                              elle::cryptography::rsa::PublicKey const& key,
+                              elle::ConstWeakBuffer const& signature,
+                              elle::ConstWeakBuffer const& data)
+      {
+        auto const check = [&]
+        {
+          auto res = false;
+          crypto_background([&] { res = key.verify(signature, data); });
+          return res;
+        };
+        if (this->_capacity <= 0)
+          return check();
+        auto digest = key_digest(address, version, key, signature, data);
+        {
+          auto lock = std::unique_lock<std::mutex>(this->_mutex);
+          auto& index = this->_entries.get<0>();
+          auto it = index.find(digest);
+          if (it != index.end())
+          {
+            ELLE_DUMP("hit signature of %f at version %s", address, version);
+            ++this->_hits;
+            auto& lru = this->_entries.get<1>();
+            lru.relocate(lru.end(), this->_entries.project<1>(it));
+            return true;
+          }
+          ++this->_misses;
+        }
+        if (!check())
+          return false;
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        auto& lru = this->_entries.get<1>();
+        lru.push_back(std::move(digest));
+        while (signed(lru.size()) > this->_capacity)
+          lru.pop_front();
+        return true;
+      }
+
+      void
+      SignatureCache::clear()
+      {
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        this->_entries.clear();
+      }
+
+      elle::json::Json
+      SignatureCache::stats() const
+      {
+        auto lock = std::unique_lock<std::mutex>(this->_mutex);
+        auto const total = this->_hits + this->_misses;
+        return {
+          {"capacity", this->_capacity},
+          {"size", this->_entries.size()},
+          {"hits", this->_hits},
+          {"misses", this->_misses},
+          {"hit_rate", total ? double(this->_hits) / total : 0.},
+        };
+      }
+    }
+  }
+}
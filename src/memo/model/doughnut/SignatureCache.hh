@@ -0,0 +1,86 @@
+#pragma once
+
+#include <mutex>
+
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+#include <elle/cryptography/rsa/PublicKey.hh>
+#include <elle/json/json.hh>
+
+#include <memo/model/Address.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Process-wide cache of successful block signature verifications.
+      ///
+      /// Entries are keyed by a digest of the block address and version, the
+      /// verifying key, the signature and the signed data, so that a hit
+      /// asserts exactly what the RSA verification would have.  Only the
+      /// cryptographic check is cached: whether the key is allowed to sign
+      /// (ACLs, admin keys, group key index) is still decided by the caller
+      /// on every validation, which keeps revoked keys from being accepted.
+      /// Failures are not cached.  Least recently used entries are evicted
+      /// beyond `MEMO_SIGNATURE_CACHE_SIZE`, 0 disabling the cache.
+      class SignatureCache
+      {
+      public:
+        SignatureCache(int capacity);
+        /// The process-wide cache.
+        static
+        SignatureCache&
+        instance();
+        /// Whether `signature` of `o` by `key` is valid, for version
+        /// `version` of block `address`.
+        ///
+        /// Like rsa::PublicKey::verify, `o` is serialized with the version
+        /// prefixed to the signature.
+        template <typename T>
+        bool
+        verify(Address const& address,
+               int version,
+               elle::cryptography::rsa::PublicKey const& key,
+               elle::Buffer const& signature,
+               T const& o);
+        /// Forget all verifications.
+        void
+        clear();
+        /// Capacity, size, hits, misses and hit rate.
+        elle::json::Json
+        stats() const;
+        ELLE_ATTRIBUTE_R(int, capacity);
+        ELLE_ATTRIBUTE_R(int64_t, hits);
+        ELLE_ATTRIBUTE_R(int64_t, misses);
+
+      private:
+        /// Whether raw `signature` of `data` by `key` is valid.
+        bool
+        _verify(Address const& address,
+                int version,
+                elle::cryptography::rsa::PublicKey const& key,
+                elle::ConstWeakBuffer const& signature,
+                elle::ConstWeakBuffer const& data);
+        using Entries = boost::multi_index::multi_index_container<
+          elle::Buffer,
+          boost::multi_index::indexed_by<
+            boost::multi_index::hashed_unique<
+              boost::multi_index::identity<elle::Buffer>,
+              std::hash<elle::Buffer>>,
+            boost::multi_index::sequenced<>>>;
+        ELLE_ATTRIBUTE(Entries, entries);
+        /// Verifications may run off the reactor thread.
+        ELLE_ATTRIBUTE(std::mutex, mutex, mutable);
+      };
+    }
+  }
+}
+
+#include <memo/model/doughnut/SignatureCache.hxx>
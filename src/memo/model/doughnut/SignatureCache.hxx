@@ -0,0 +1,31 @@
+#include <elle/IOStream.hh>
+#include <elle/serialization/binary.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      template <typename T>
+      bool
+      SignatureCache::verify(Address const& address,
+                             int version,
+                             elle::cryptography::rsa::PublicKey const& key,
+                             elle::Buffer const& signature,
+                             T const& o)
+      {
+        elle::IOStream input(signature.istreambuf());
+        auto const serialization_version =
+          elle::serialization::binary::deserialize<elle::Version>(
+            input, false);
+        auto const raw =
+          elle::Buffer(std::string{std::istreambuf_iterator<char>(input),
+                                   std::istreambuf_iterator<char>()});
+        auto const data = elle::serialization::binary::serialize(
+          o, serialization_version, false);
+        return this->_verify(address, version, key, raw, data);
+      }
+    }
+  }
+}
@@ -0,0 +1,148 @@
+#include <memo/model/doughnut/TreeHash.hh>
+
+#include <algorithm>
+#include <initializer_list>
+#include <thread>
+#include <vector>
+
+#include <elle/With.hh>
+#include <elle/bench.hh>
+#include <elle/err.hh>
+#include <elle/log.hh>
+#include <elle/print.hh>
+#include <elle/cryptography/hash.hh>
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/scheduler.hh>
+
+#include <memo/model/doughnut/crypto.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.TreeHash");
+
+using namespace std::literals;
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace
+      {
+        /// Domain separation between chunk and root digests, so that no
+        /// chunk digest can pass for a root and conversely.
+        enum class Tag : uint8_t
+        {
+          chunk = 0,
+          root = 1,
+        };
+
+        elle::Buffer
+        digest(Tag tag, std::initializer_list<elle::ConstWeakBuffer> parts)
+        {
+          auto const t = uint8_t(tag);
+          auto next = std::vector<elle::ConstWeakBuffer>{
+            elle::ConstWeakBuffer(&t, 1)};
+          next.insert(next.end(), parts.begin(), parts.end());
+          auto it = next.begin();
+          return elle::cryptography::hash(
+            [&]
+            {
+              return it == next.end() ?
+                elle::ConstWeakBuffer() : *it++;
+            },
+            elle::cryptography::Oneway::sha256);
+        }
+
+        bool
+        in_reactor()
+        {
+          auto const sched = elle::reactor::Scheduler::scheduler();
+          return sched && sched->current();
+        }
+      }
+
+      std::size_t constexpr TreeHash::chunk_size;
+      std::size_t constexpr TreeHash::threshold;
+
+      elle::Version const&
+      TreeHash::version()
+      {
+        static auto const res = elle::Version(0, 10, 0);
+        return res;
+      }
+
+      bool
+      TreeHash::applies(elle::Version const& version, std::size_t size)
+      {
+        return version >= TreeHash::version() && size > threshold;
+      }
+
+      TreeHash::TreeHash(elle::ConstWeakBuffer content)
+        : _leaves((content.size() + chunk_size - 1) / chunk_size)
+        , _size(content.size())
+      {
+        static auto bench = elle::Bench<>{"bench.chb.tree_hash", 10000s};
+        auto bs = bench.scoped();
+        auto const count = int(this->_leaves.size());
+        auto const hash_range = [&] (int first, int last)
+          {
+            for (auto i = first; i < last; ++i)
+              this->_leaves[i] = digest(
+                Tag::chunk,
+                {elle::ConstWeakBuffer(
+                  content.contents() + i * chunk_size, this->chunk(i))});
+          };
+        // Split chunks in a range per core, each hashed in the background.
+        auto const ranges = std::min(
+          count, std::max(1, int(std::thread::hardware_concurrency())));
+        ELLE_DEBUG("%s: hash %s chunks in %s ranges", this, count, ranges);
+        if (ranges <= 1 || !in_reactor())
+          hash_range(0, count);
+        else
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+          {
+            for (auto r = 0; r < ranges; ++r)
+            {
+              auto const first = count * r / ranges;
+              auto const last = count * (r + 1) / ranges;
+              s.run_background(
+                elle::print("{}: hash [{}, {})", this, first, last),
+                [&, first, last]
+                {
+                  crypto_background([&] { hash_range(first, last); });
+                });
+            }
+            elle::reactor::wait(s);
+          };
+      }
+
+      elle::Buffer
+      TreeHash::root(elle::ConstWeakBuffer prefix) const
+      {
+        auto size = elle::Buffer(8);
+        for (auto i = 0; i < 8; ++i)
+          size[i] = (this->_size >> (8 * (7 - i))) & 0xff;
+        auto leaves = elle::Buffer{};
+        for (auto const& l: this->_leaves)
+          leaves.append(l.contents(), l.size());
+        return digest(Tag::root, {prefix, size, leaves});
+      }
+
+      std::size_t
+      TreeHash::chunk(int index) const
+      {
+        if (index < 0 || index >= int(this->_leaves.size()))
+          elle::err("%s: no chunk %s", this, index);
+        return std::min<uint64_t>(chunk_size,
+                                  this->_size - uint64_t(index) * chunk_size);
+      }
+
+      void
+      TreeHash::print(std::ostream& out) const
+      {
+        elle::fprintf(out, "TreeHash(%s bytes, %s chunks)",
+                      this->_size, this->_leaves.size());
+      }
+    }
+  }
+}
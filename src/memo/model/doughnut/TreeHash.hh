@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include <elle/Buffer.hh>
+#include <elle/Printable.hh>
+#include <elle/Version.hh>
+#include <elle/attribute.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Tree hash of large CHB payloads.
+      ///
+      /// From compatibility version `version()`, the address of a CHB whose
+      /// payload exceeds `threshold` is not the SHA-256 of the whole
+      /// payload, but the SHA-256 of its salt and owner, its size and the
+      /// digest of each of its `chunk_size` chunks, and carries
+      /// `flags::tree_hash`.  Chunks are hashed in parallel on the crypto
+      /// background pool.
+      class TreeHash
+        : public elle::Printable
+      {
+      public:
+        /// Size of hashed chunks, fixed since it is part of addresses.
+        static std::size_t constexpr chunk_size = 256 * 1024;
+        /// Payloads up to this size are hashed in one pass.
+        static std::size_t constexpr threshold = 4 * chunk_size;
+        /// First compatibility version using tree hashes.
+        static
+        elle::Version const&
+        version();
+        /// Whether payloads of `size` bytes are tree hashed at `version`.
+        static
+        bool
+        applies(elle::Version const& version, std::size_t size);
+
+      public:
+        /// Hash the chunks of `content`.
+        TreeHash(elle::ConstWeakBuffer content);
+        /// Root digest, prefixed with the CHB salt and owner.
+        elle::Buffer
+        root(elle::ConstWeakBuffer prefix) const;
+        /// Number of bytes of the `index`th chunk.
+        std::size_t
+        chunk(int index) const;
+        /// Digest of every chunk, in order.
+        ELLE_ATTRIBUTE_R(std::vector<elle::Buffer>, leaves);
+        /// Payload size.
+        ELLE_ATTRIBUTE_R(uint64_t, size);
+
+      public:
+        void
+        print(std::ostream& out) const override;
+      };
+    }
+  }
+}
@@ -0,0 +1,629 @@
+#include <memo/model/doughnut/consensus/Erasure.hh>
+
+#include <boost/range/algorithm/count_if.hpp>
+
+#include <elle/algorithm.hh>
+#include <elle/log.hh>
+#include <elle/serialization/binary.hh>
+
+#include <elle/reactor/Scope.hh>
+#include <elle/reactor/for-each.hh>
+
+#include <memo/model/MissingBlock.hh>
+#include <memo/model/doughnut/CHB.hh>
+#include <memo/model/doughnut/Doughnut.hh>
+#include <memo/model/doughnut/Local.hh>
+#include <memo/model/doughnut/ValidationFailed.hh>
+#include <memo/serialization.hh>
+#include <memo/silo/Collision.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Erasure");
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        namespace
+        {
+          bool
+          same_encoding(FB const& a, FB const& b)
+          {
+            return a.data_fragments() == b.data_fragments()
+              && a.parity_fragments() == b.parity_fragments()
+              && a.size() == b.size()
+              && a.digests() == b.digests();
+          }
+
+          /// Whether `address` is stored as fragments.
+          bool
+          erasure_coded(Address const& address)
+          {
+            return !address.mutable_block() &&
+              address.has_flags(flags::erasure_coded);
+          }
+        }
+
+        Erasure::Erasure(std::unique_ptr<Consensus> backend,
+                         int data_fragments,
+                         int parity_fragments)
+          : StackedConsensus(std::move(backend))
+          , _codec(data_fragments, parity_fragments)
+          , _repair_queue()
+          , _repairing()
+          , _repair_thread(
+            new elle::reactor::Thread(elle::sprintf("%s repair", *this),
+                                      [this] { this->_repair_loop(); }))
+          , _degraded_reads(0)
+          , _repaired_fragments(0)
+        {
+          ELLE_TRACE_SCOPE("%s: create with %s+%s fragments",
+                           *this, data_fragments, parity_fragments);
+        }
+
+        Erasure::~Erasure()
+        {}
+
+        std::unique_ptr<Local>
+        Erasure::make_local(
+          boost::optional<int> port,
+          boost::optional<boost::asio::ip::address> listen_address,
+          std::unique_ptr<silo::Silo> storage)
+        {
+          return this->_backend->make_local(
+            std::move(port), std::move(listen_address), std::move(storage));
+        }
+
+        /*-------.
+        | Blocks |
+        `-------*/
+
+        void
+        Erasure::_store(std::unique_ptr<blocks::Block> block,
+                        StoreMode mode,
+                        std::unique_ptr<ConflictResolver> resolver)
+        {
+          auto chb = dynamic_cast<CHB*>(block.get());
+          if (!chb || !erasure_coded(chb->address()))
+          {
+            this->_backend->store(std::move(block), mode, std::move(resolver));
+            return;
+          }
+          auto const address = chb->address();
+          ELLE_TRACE_SCOPE("%s: store %f as %s+%s fragments", *this, address,
+                           this->_codec.data(), this->_codec.parity());
+          auto const payload = elle::serialization::binary::serialize(
+            static_cast<blocks::Block*>(chb), this->doughnut().version());
+          auto encoded = this->_codec.encode(payload);
+          auto digests = std::vector<elle::Buffer>{};
+          for (auto const& f: encoded)
+            digests.emplace_back(FB::digest(f));
+          auto fragments = Fragments{};
+          for (int i = 0; i < signed(encoded.size()); ++i)
+            fragments.emplace_back(
+              std::make_unique<FB>(this->doughnut(), address, chb->owner(), i,
+                                   this->_codec.data(), this->_codec.parity(),
+                                   payload.size(), digests,
+                                   std::move(encoded[i])));
+          auto const stored = this->_store_fragments(
+            address, std::move(fragments), {}, this->_codec.data());
+          if (stored < this->_codec.data())
+            elle::err("only %s fragments of %f stored, %s required",
+                      stored, address, this->_codec.data());
+          else if (stored < this->_codec.data() + this->_codec.parity())
+            ELLE_WARN("%s: only %s fragments of %f stored out of %s",
+                      *this, stored, address,
+                      this->_codec.data() + this->_codec.parity());
+        }
+
+        int
+        Erasure::_store_fragments(Address address,
+                                  Fragments fragments,
+                                  std::unordered_set<Address> const& exclude,
+                                  int required)
+        {
+          auto const count =
+            this->_codec.data() + this->_codec.parity() + exclude.size();
+          auto peers = std::vector<overlay::Overlay::Member>{};
+          auto ids = std::unordered_set<Address>{};
+          for (auto wpeer: this->doughnut().overlay()->allocate(address, count))
+            if (auto peer = wpeer.lock())
+              if (!elle::contains(exclude, peer->id()) &&
+                  ids.emplace(peer->id()).second)
+                peers.emplace_back(std::move(peer));
+          if (signed(peers.size()) < required)
+            elle::err("only %s peers available for insertion of %f, "
+                      "%s required", peers.size(), address, required);
+          // Two fragments on the same peer would be lost together: store
+          // fewer of them rather.
+          if (peers.size() < fragments.size())
+          {
+            ELLE_WARN("%s: only %s peers available for %s fragments of %f",
+                      *this, peers.size(), fragments.size(), address);
+            fragments.resize(peers.size());
+          }
+          auto indexes = std::vector<int>(fragments.size());
+          for (int i = 0; i < signed(indexes.size()); ++i)
+            indexes[i] = i;
+          int stored = 0;
+          elle::reactor::for_each_parallel(
+            indexes,
+            [&] (int i)
+            {
+              auto& peer = peers[i];
+              auto const& fragment = *fragments[i];
+              try
+              {
+                ELLE_DEBUG_SCOPE("store fragment %s on %s",
+                                 fragment.index(), peer);
+                peer->store(fragment, STORE_INSERT);
+                ++stored;
+              }
+              catch (silo::Collision const&)
+              {
+                // Fragment addresses do not depend on their content: only
+                // count the stored one if it actually is ours.
+                if (this->_stored(*peer, fragment))
+                {
+                  ELLE_DEBUG("fragment %s already stored on %s",
+                             fragment.index(), peer);
+                  ++stored;
+                }
+                else
+                  ELLE_WARN("%s: fragment %s of %f is taken by foreign "
+                            "content on %s",
+                            *this, fragment.index(), address, peer);
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_WARN("%s: unable to store fragment %s of %f on %s: %s",
+                          *this, fragment.index(), address, peer, e);
+              }
+            },
+            "store fragments");
+          return stored;
+        }
+
+        bool
+        Erasure::_stored(Peer& peer, FB const& fragment)
+        {
+          try
+          {
+            auto block = peer.fetch(fragment.address(), {});
+            auto fb = dynamic_cast<FB const*>(block.get());
+            return fb
+              && fb->chb() == fragment.chb()
+              && fb->index() == fragment.index()
+              && same_encoding(*fb, fragment)
+              && fb->data() == fragment.data();
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_TRACE("%s: unable to check fragment %s on %s: %s",
+                       *this, fragment.index(), peer, e);
+            return false;
+          }
+        }
+
+        std::unique_ptr<blocks::Block>
+        Erasure::_fetch(Address address, boost::optional<int> local_version)
+        {
+          if (!erasure_coded(address))
+            return this->_backend->fetch(address, std::move(local_version));
+          auto fragments =
+            Fragments(this->_codec.data() + this->_codec.parity());
+          auto const count = this->_gather(address, fragments);
+          if (count == 0)
+          {
+            // Legacy addresses whose flag byte happens to match.
+            ELLE_DEBUG("%s: no fragment for %f, fetch from backend",
+                       *this, address);
+            return this->_backend->fetch(address, std::move(local_version));
+          }
+          if (count < this->_codec.data())
+          {
+            ELLE_WARN("%s: only %s fragments of %f available, %s required",
+                      *this, count, address, this->_codec.data());
+            throw MissingBlock(address);
+          }
+          auto res = this->_decode(address, fragments);
+          if (boost::count_if(fragments, [] (std::unique_ptr<FB> const& f)
+                              { return !f; }))
+          {
+            ++this->_degraded_reads;
+            if (this->_repairing.emplace(address).second)
+              this->_repair_queue.put(address);
+          }
+          return res;
+        }
+
+        void
+        Erasure::_fetch(std::vector<AddressVersion> const& addresses,
+                        ReceiveBlock res)
+        {
+          auto plain = std::vector<AddressVersion>{};
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+          {
+            for (auto const& a: addresses)
+              if (!erasure_coded(a.first))
+                plain.emplace_back(a);
+              else
+                s.run_background(
+                  elle::sprintf("fetch %f", a.first),
+                  [this, a, &res]
+                  {
+                    try
+                    {
+                      res(a.first, this->_fetch(a.first, a.second), {});
+                    }
+                    catch (elle::Error const&)
+                    {
+                      res(a.first, {}, std::current_exception());
+                    }
+                  });
+            if (!plain.empty())
+              this->_backend->fetch(plain, res);
+            elle::reactor::wait(s);
+          };
+        }
+
+        void
+        Erasure::_fetch_fragments(Address address,
+                                  std::vector<int> const& indexes,
+                                  Fragments& fragments,
+                                  std::unordered_set<Address>* holders)
+        {
+          auto const version = this->doughnut().version();
+          auto addresses = std::vector<Address>{};
+          auto positions = std::unordered_map<Address, int>{};
+          for (auto i: indexes)
+          {
+            auto const a = FB::address(address, i, version);
+            addresses.emplace_back(a);
+            positions.emplace(a, i);
+          }
+          ELLE_DEBUG_SCOPE("%s: fetch %s fragments of %f",
+                           *this, indexes.size(), address);
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+          {
+            try
+            {
+              for (auto location:
+                     this->doughnut().overlay()->lookup(addresses, 1))
+                s.run_background(
+                  elle::sprintf("fetch %f", location.first),
+                  [&, location]
+                  {
+                    auto peer = location.second.lock();
+                    if (!peer)
+                      return;
+                    try
+                    {
+                      auto block = peer->fetch(location.first, {});
+                      auto fb = dynamic_cast<FB*>(block.get());
+                      if (!fb || fb->chb() != address)
+                      {
+                        ELLE_WARN("%s: %f is not a fragment of %f",
+                                  *this, location.first, address);
+                        return;
+                      }
+                      if (auto v = fb->validate(this->doughnut(), false)); else
+                      {
+                        ELLE_WARN("%s: invalid fragment %f from %s: %s",
+                                  *this, location.first, peer, v.reason());
+                        return;
+                      }
+                      block.release();
+                      fragments[positions.at(location.first)].reset(fb);
+                      if (holders)
+                        holders->emplace(peer->id());
+                    }
+                    catch (MissingBlock const&)
+                    {
+                      ELLE_DEBUG("fragment %f missing on %s",
+                                 location.first, peer);
+                    }
+                    catch (elle::Error const& e)
+                    {
+                      ELLE_TRACE("fetching fragment %f from %s failed: %s",
+                                 location.first, peer, e);
+                    }
+                  });
+            }
+            catch (MissingBlock const&)
+            {}
+            elle::reactor::wait(s);
+          };
+        }
+
+        int
+        Erasure::_filter(Address address, Fragments& fragments)
+        {
+          auto reference = static_cast<FB const*>(nullptr);
+          int best = 0;
+          for (auto const& f: fragments)
+            if (f)
+            {
+              auto const votes = boost::count_if(
+                fragments,
+                [&] (std::unique_ptr<FB> const& o)
+                {
+                  return o && same_encoding(*f, *o);
+                });
+              if (votes > best)
+              {
+                best = votes;
+                reference = f.get();
+              }
+            }
+          if (!reference)
+            return 0;
+          if (reference->data_fragments() != this->_codec.data() ||
+              reference->parity_fragments() != this->_codec.parity())
+          {
+            ELLE_WARN("%s: %f is encoded as %s+%s fragments, expected %s+%s",
+                      *this, address,
+                      reference->data_fragments(),
+                      reference->parity_fragments(),
+                      this->_codec.data(), this->_codec.parity());
+            for (auto& f: fragments)
+              f.reset();
+            return 0;
+          }
+          if (best != boost::count_if(
+                fragments, [] (std::unique_ptr<FB> const& f) { return bool(f); }))
+          {
+            ELLE_WARN("%s: dropping inconsistent fragments of %f",
+                      *this, address);
+            // The reference agrees with itself and is thus kept.
+            for (auto& f: fragments)
+              if (f && !same_encoding(*f, *reference))
+                f.reset();
+          }
+          return best;
+        }
+
+        int
+        Erasure::_gather(Address address, Fragments& fragments)
+        {
+          auto const data = this->_codec.data();
+          auto const total = data + this->_codec.parity();
+          // Data fragments come first as they need no decoding, parity ones
+          // are only requested to replace missing ones.
+          auto wanted = std::vector<int>{};
+          int next = 0;
+          for (; next < data; ++next)
+            wanted.emplace_back(next);
+          while (true)
+          {
+            this->_fetch_fragments(address, wanted, fragments);
+            auto const count = this->_filter(address, fragments);
+            if (count >= data || next >= total)
+              return count;
+            wanted.clear();
+            for (; next < total && signed(wanted.size()) < data - count; ++next)
+              wanted.emplace_back(next);
+          }
+        }
+
+        std::unique_ptr<blocks::Block>
+        Erasure::_decode(Address address, Fragments const& fragments)
+        {
+          auto reference = static_cast<FB const*>(nullptr);
+          auto parts = ReedSolomon::Fragments(fragments.size());
+          for (int i = 0; i < signed(fragments.size()); ++i)
+            if (auto const& f = fragments[i])
+            {
+              reference = f.get();
+              parts[i].emplace(f->data());
+            }
+          ELLE_ASSERT(reference);
+          auto const payload = this->_codec.decode(parts, reference->size());
+          elle::serialization::Context context;
+          context.set<Doughnut*>(&this->doughnut());
+          context.set<elle::Version>(
+            elle_serialization_version(this->doughnut().version()));
+          auto res = elle::serialization::binary::deserialize<
+            std::unique_ptr<blocks::Block>>(payload, true, context);
+          if (!dynamic_cast<CHB*>(res.get()) ||
+              !equal_unflagged(res->address(), address))
+            throw ValidationFailed(
+              elle::sprintf("fragments of %f decode to %f", address, res));
+          if (auto v = res->validate(this->doughnut(), false)); else
+            throw ValidationFailed(v.reason());
+          return res;
+        }
+
+        void
+        Erasure::_remove(Address address, blocks::RemoveSignature rs)
+        {
+          if (!erasure_coded(address))
+          {
+            this->_backend->remove(address, std::move(rs));
+            return;
+          }
+          auto const version = this->doughnut().version();
+          auto addresses = std::vector<Address>{};
+          for (int i = 0; i < this->_codec.data() + this->_codec.parity(); ++i)
+            addresses.emplace_back(FB::address(address, i, version));
+          int removed = 0;
+          elle::With<elle::reactor::Scope>() << [&] (elle::reactor::Scope& s)
+          {
+            try
+            {
+              for (auto location:
+                     this->doughnut().overlay()->lookup(addresses, 1))
+                s.run_background(
+                  elle::sprintf("remove %f", location.first),
+                  [&, location]
+                  {
+                    if (auto peer = location.second.lock())
+                      try
+                      {
+                        peer->remove(location.first, rs);
+                        ++removed;
+                      }
+                      catch (MissingBlock const&)
+                      {}
+                  });
+            }
+            catch (MissingBlock const&)
+            {}
+            elle::reactor::wait(s);
+          };
+          ELLE_DEBUG("%s: removed %s fragments of %f", *this, removed, address);
+          if (!removed)
+            this->_backend->remove(address, std::move(rs));
+        }
+
+        /*-------.
+        | Repair |
+        `-------*/
+
+        int
+        Erasure::repair(Address address)
+        {
+          ELLE_TRACE_SCOPE("%s: repair %f", *this, address);
+          auto const data = this->_codec.data();
+          auto const total = data + this->_codec.parity();
+          auto fragments = Fragments(total);
+          auto holders = std::unordered_set<Address>{};
+          auto indexes = std::vector<int>(total);
+          for (int i = 0; i < total; ++i)
+            indexes[i] = i;
+          this->_fetch_fragments(address, indexes, fragments, &holders);
+          auto const count = this->_filter(address, fragments);
+          if (count == total)
+            return 0;
+          if (count < data)
+            elle::err("unable to repair %f: only %s fragments out of %s "
+                      "required", address, count, data);
+          auto missing = std::vector<int>{};
+          auto parts = ReedSolomon::Fragments(total);
+          auto reference = static_cast<FB const*>(nullptr);
+          for (int i = 0; i < total; ++i)
+            if (auto const& f = fragments[i])
+            {
+              parts[i].emplace(f->data());
+              reference = f.get();
+            }
+            else
+              missing.emplace_back(i);
+          ELLE_DEBUG("rebuild %s missing fragments", missing.size());
+          auto rebuilt = this->_codec.reconstruct(parts, missing);
+          auto repaired = Fragments{};
+          for (int i = 0; i < signed(missing.size()); ++i)
+            repaired.emplace_back(
+              std::make_unique<FB>(this->doughnut(), address,
+                                   reference->owner(), missing[i],
+                                   data, this->_codec.parity(),
+                                   reference->size(), reference->digests(),
+                                   std::move(rebuilt[i])));
+          auto const stored =
+            this->_store_fragments(address, std::move(repaired), holders, 1);
+          this->_repaired_fragments += stored;
+          return stored;
+        }
+
+        void
+        Erasure::_repair_loop()
+        {
+          while (true)
+          {
+            auto const address = this->_repair_queue.get();
+            try
+            {
+              this->repair(address);
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("%s: unable to repair %f: %s", *this, address, e);
+            }
+            this->_repairing.erase(address);
+          }
+        }
+
+        /*-----------.
+        | Monitoring |
+        `-----------*/
+
+        elle::json::Json
+        Erasure::redundancy()
+        {
+          auto const data = this->_codec.data();
+          auto const parity = this->_codec.parity();
+          return {
+            { "desired_factor", static_cast<float>(data + parity) / data },
+            { "type", "erasure" },
+            { "data_fragments", data },
+            { "parity_fragments", parity },
+            { "backend", this->_backend->redundancy() },
+          };
+        }
+
+        elle::json::Json
+        Erasure::stats()
+        {
+          auto res = this->_backend->stats();
+          res["erasure"] = {
+            {"data_fragments", this->_codec.data()},
+            {"parity_fragments", this->_codec.parity()},
+            {"degraded_reads", this->_degraded_reads},
+            {"repaired_fragments", this->_repaired_fragments},
+          };
+          return res;
+        }
+
+        /*--------------.
+        | Configuration |
+        `--------------*/
+
+        Erasure::Configuration::Configuration(
+          std::unique_ptr<consensus::Configuration> backend,
+          int data_fragments,
+          int parity_fragments)
+          : consensus::Configuration()
+          , _backend(std::move(backend))
+          , _data_fragments(data_fragments)
+          , _parity_fragments(parity_fragments)
+        {}
+
+        Erasure::Configuration::Configuration(Configuration const& other)
+          : consensus::Configuration(other)
+          , _backend(other._backend ? other._backend->clone() : nullptr)
+          , _data_fragments(other._data_fragments)
+          , _parity_fragments(other._parity_fragments)
+        {}
+
+        std::unique_ptr<Consensus>
+        Erasure::Configuration::make(model::doughnut::Doughnut& dht)
+        {
+          return std::make_unique<Erasure>(this->_backend->make(dht),
+                                           this->_data_fragments,
+                                           this->_parity_fragments);
+        }
+
+        Erasure::Configuration::Configuration(
+          elle::serialization::SerializerIn& s)
+        {
+          this->serialize(s);
+        }
+
+        void
+        Erasure::Configuration::serialize(elle::serialization::Serializer& s)
+        {
+          consensus::Configuration::serialize(s);
+          s.serialize("backend", this->_backend);
+          s.serialize("data-fragments", this->_data_fragments);
+          s.serialize("parity-fragments", this->_parity_fragments);
+        }
+
+        static const elle::serialization::Hierarchy<Configuration>::
+        Register<Erasure::Configuration> _register_Configuration("erasure");
+      }
+    }
+  }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <unordered_set>
+
+#include <elle/reactor/Channel.hh>
+#include <elle/reactor/Thread.hh>
+
+#include <memo/model/doughnut/Consensus.hh>
+#include <memo/model/doughnut/FB.hh>
+#include <memo/model/doughnut/consensus/ReedSolomon.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        /// Erasure-coded storage of immutable blocks.
+        ///
+        /// CHBs are serialized and split into `data + parity` Reed-Solomon
+        /// fragments, each stored as an FB on a distinct peer, so any `data`
+        /// fragments are enough to read the block back.  Such CHBs carry the
+        /// `flags::erasure_coded` address flag, every other block goes
+        /// through the backend consensus.
+        class Erasure
+          : public StackedConsensus
+        {
+        public:
+          Erasure(std::unique_ptr<Consensus> backend,
+                  int data_fragments,
+                  int parity_fragments);
+          ~Erasure() override;
+          std::unique_ptr<Local>
+          make_local(boost::optional<int> port,
+                     boost::optional<boost::asio::ip::address> listen_address,
+                     std::unique_ptr<silo::Silo> storage) override;
+          ELLE_ATTRIBUTE_R(ReedSolomon, codec);
+
+        /*-------.
+        | Blocks |
+        `-------*/
+        protected:
+          void
+          _store(std::unique_ptr<blocks::Block> block,
+                 StoreMode mode,
+                 std::unique_ptr<ConflictResolver> resolver) override;
+          std::unique_ptr<blocks::Block>
+          _fetch(Address address, boost::optional<int> local_version) override;
+          void
+          _fetch(std::vector<AddressVersion> const& addresses,
+                 ReceiveBlock res) override;
+          void
+          _remove(Address address, blocks::RemoveSignature rs) override;
+        private:
+          using Fragments = std::vector<std::unique_ptr<FB>>;
+          /// Fetch fragments at `indexes`, recording peers holding them.
+          void
+          _fetch_fragments(Address address,
+                           std::vector<int> const& indexes,
+                           Fragments& fragments,
+                           std::unordered_set<Address>* holders = nullptr);
+          /// Drop fragments disagreeing with the majority.
+          ///
+          /// @return the number of remaining fragments.
+          int
+          _filter(Address address, Fragments& fragments);
+          /// Fetch data fragments, then parity ones as needed.
+          ///
+          /// @return the number of valid fragments.
+          int
+          _gather(Address address, Fragments& fragments);
+          std::unique_ptr<blocks::Block>
+          _decode(Address address, Fragments const& fragments);
+          /// Store fragments on distinct peers not in `exclude`, at most one
+          /// per peer.
+          ///
+          /// @throws elle::Error if fewer than `required` peers are available.
+          /// @return the number of stored fragments.
+          int
+          _store_fragments(Address address,
+                           Fragments fragments,
+                           std::unordered_set<Address> const& exclude,
+                           int required);
+          /// Whether `peer` holds `fragment` already.
+          bool
+          _stored(Peer& peer, FB const& fragment);
+
+        /*-------.
+        | Repair |
+        `-------*/
+        public:
+          /// Rebuild and store the missing fragments of `address`.
+          ///
+          /// @return the number of rebuilt fragments.
+          int
+          repair(Address address);
+        private:
+          void
+          _repair_loop();
+          /// Addresses read with missing fragments, pending repair.
+          ELLE_ATTRIBUTE(elle::reactor::Channel<Address>, repair_queue);
+          ELLE_ATTRIBUTE(std::unordered_set<Address>, repairing);
+          ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, repair_thread);
+          ELLE_ATTRIBUTE_R(int, degraded_reads);
+          ELLE_ATTRIBUTE_R(int, repaired_fragments);
+
+        /*-----------.
+        | Monitoring |
+        `-----------*/
+        public:
+          elle::json::Json
+          redundancy() override;
+          elle::json::Json
+          stats() override;
+
+        /*--------------.
+        | Configuration |
+        `--------------*/
+        public:
+          /// Erasure coding must be agreed on by every member of the network,
+          /// hence a network consensus wrapping the actual one.
+          class Configuration
+            : public consensus::Configuration
+          {
+          public:
+            using Self = memo::model::doughnut::consensus::Erasure::Configuration;
+            using Super = consensus::Configuration;
+          public:
+            Configuration(std::unique_ptr<consensus::Configuration> backend,
+                          int data_fragments,
+                          int parity_fragments);
+            Configuration(Configuration const& other);
+            ELLE_CLONABLE();
+            std::unique_ptr<Consensus>
+            make(model::doughnut::Doughnut& dht) override;
+            ELLE_ATTRIBUTE_RX(std::unique_ptr<consensus::Configuration>,
+                              backend);
+            ELLE_ATTRIBUTE_RW(int, data_fragments);
+            ELLE_ATTRIBUTE_RW(int, parity_fragments);
+          public:
+            Configuration(elle::serialization::SerializerIn& s);
+            void
+            serialize(elle::serialization::Serializer& s) override;
+          };
+        };
+      }
+    }
+  }
+}
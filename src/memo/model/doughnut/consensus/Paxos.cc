@@ -1,5 +1,6 @@
 #include <memo/model/doughnut/consensus/Paxos.hh>
 
+#include <cstring>
 #include <functional>
 #include <utility>
 
@@ -23,7 +24,9 @@
 #include <elle/das/serializer.hh>
 
 #include <elle/reactor/Backoff.hh>
+#include <elle/reactor/Scope.hh>
 #include <elle/reactor/for-each.hh>
+#include <elle/reactor/semaphore.hh>
 
 #include <memo/RPC.hh>
 
@@ -37,6 +40,7 @@
 #include <memo/model/blocks/ImmutableBlock.hh>
 #include <memo/model/doughnut/OKB.hh>
 #include <memo/model/doughnut/ValidationFailed.hh>
+#include <memo/silo/Collision.hh>
 #include <memo/silo/MissingKey.hh>
 
 ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Paxos");
@@ -82,6 +86,149 @@ namespace memo
           }
         }
 
+        /*------.
+        | Delta |
+        `------*/
+
+        namespace
+        {
+          /// Granularity at which the target is matched against the base.
+          auto constexpr delta_block = 16;
+
+          void
+          delta_put(elle::Buffer& out, uint64_t value)
+          {
+            do
+            {
+              auto byte = uint8_t(value & 0x7f);
+              value >>= 7;
+              if (value)
+                byte |= 0x80;
+              out.append(&byte, 1);
+            }
+            while (value);
+          }
+
+          uint64_t
+          delta_get(elle::ConstWeakBuffer delta, std::size_t& pos)
+          {
+            auto res = uint64_t(0);
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+              if (pos >= delta.size())
+                elle::err("truncated delta");
+              auto const byte = delta[pos++];
+              res |= uint64_t(byte & 0x7f) << shift;
+              if (!(byte & 0x80))
+                return res;
+            }
+            elle::err("invalid delta integer");
+          }
+
+          uint64_t
+          delta_hash(uint8_t const* data)
+          {
+            auto res = uint64_t(0xcbf29ce484222325);
+            for (int i = 0; i < delta_block; ++i)
+              res = (res ^ data[i]) * 0x100000001b3;
+            return res;
+          }
+
+          elle::Buffer
+          delta_digest(elle::ConstWeakBuffer data)
+          {
+            return elle::cryptography::hash(
+              data, elle::cryptography::Oneway::sha256);
+          }
+
+          /// Checksum of a serialized block in a bulk transfer.
+          elle::Buffer
+          transfer_digest(elle::ConstWeakBuffer data)
+          {
+            return elle::cryptography::hash(
+              data, elle::cryptography::Oneway::sha256);
+          }
+        }
+
+        // Every operation starts with `length << 1 | literal`, followed by the
+        // base offset for copies or the bytes for literals.
+        elle::Buffer
+        delta_encode(elle::ConstWeakBuffer base, elle::ConstWeakBuffer target)
+        {
+          auto index = std::unordered_map<uint64_t, std::size_t>{};
+          for (auto i = 0u; i + delta_block <= base.size(); i += delta_block)
+            index.emplace(delta_hash(base.contents() + i), i);
+          auto res = elle::Buffer{};
+          auto literal = std::size_t(0);
+          auto const flush = [&] (std::size_t end)
+            {
+              if (end > literal)
+              {
+                delta_put(res, (end - literal) << 1 | 1);
+                res.append(target.contents() + literal, end - literal);
+              }
+            };
+          auto i = std::size_t(0);
+          while (i + delta_block <= target.size())
+          {
+            auto it = index.find(delta_hash(target.contents() + i));
+            if (it == index.end() ||
+                std::memcmp(base.contents() + it->second,
+                            target.contents() + i, delta_block))
+            {
+              ++i;
+              continue;
+            }
+            auto from = it->second;
+            auto to = i;
+            while (to > literal && from > 0 && base[from - 1] == target[to - 1])
+              --from, --to;
+            auto length = i - to + delta_block;
+            while (from + length < base.size() &&
+                   to + length < target.size() &&
+                   base[from + length] == target[to + length])
+              ++length;
+            flush(to);
+            delta_put(res, length << 1);
+            delta_put(res, from);
+            i = literal = to + length;
+          }
+          flush(target.size());
+          return res;
+        }
+
+        elle::Buffer
+        delta_apply(elle::ConstWeakBuffer base, elle::ConstWeakBuffer delta)
+        {
+          auto const max = base.size() + delta.size();
+          auto res = elle::Buffer{};
+          auto pos = std::size_t(0);
+          while (pos < delta.size())
+          {
+            auto const op = delta_get(delta, pos);
+            auto const length = op >> 1;
+            // Bound the output before allocating it: a few bytes of copies
+            // could otherwise expand to any size.
+            if (length > max - res.size())
+              elle::err("delta expands past %s bytes", max);
+            if (op & 1)
+            {
+              if (length > delta.size() - pos)
+                elle::err("delta literal overflows");
+              res.append(delta.contents() + pos, length);
+              pos += length;
+            }
+            else
+            {
+              auto const from = delta_get(delta, pos);
+              if (from > base.size() || length > base.size() - from)
+                elle::err("delta copy overflows base");
+              res.append(base.contents() + from, length);
+            }
+          }
+          return res;
+        }
+
         BlockOrPaxos::BlockOrPaxos(blocks::Block& b)
           : block(&b, [] (blocks::Block*) {})
           , paxos()
@@ -93,18 +240,25 @@ namespace memo
 
 
         Paxos::LocalPeer::BlockRepartition::BlockRepartition(
-          Address a, bool immutable, PaxosServer::Quorum q)
+          Address a,
+          bool immutable,
+          PaxosServer::Quorum q,
+          int version,
+          bool tracked)
           : address(a)
           , immutable(immutable)
           , quorum(std::move(q))
+          , version(version)
+          , tracked(tracked)
         {}
 
         bool
         Paxos::LocalPeer::BlockRepartition::operator ==(
           BlockRepartition const& rhs) const
         {
-          return std::tie(this->address, this->immutable, this->quorum)
-            == std::tie(rhs.address, rhs.immutable, rhs.quorum);
+          return std::tie(this->address, this->immutable, this->quorum,
+                          this->version)
+            == std::tie(rhs.address, rhs.immutable, rhs.quorum, rhs.version);
         }
 
         int
@@ -160,6 +314,36 @@ namespace memo
           , _rebalance_auto_expand(rebalance_auto_expand)
           , _rebalance_inspect(rebalance_inspect)
           , _node_timeout(node_timeout)
+          , _delta(memo::getenv("PAXOS_DELTA", true))
+          , _delta_bases()
+          , _delta_bases_size(memo::getenv("PAXOS_DELTA_CACHE_SIZE", 100))
+          , _delta_accepts(0)
+          , _delta_fallbacks(0)
+          , _delta_bytes_saved(0)
+          , _anti_entropy_interval(
+            [] () -> elle::DurationOpt
+            {
+              auto const interval =
+                memo::getenv("PAXOS_ANTI_ENTROPY_INTERVAL", 300);
+              if (interval > 0)
+                return std::chrono::seconds(interval);
+              else
+                return boost::none;
+            }())
+          , _anti_entropy_rounds(0)
+          , _anti_entropy_compared(0)
+          , _anti_entropy_differing(0)
+          , _anti_entropy_repaired(0)
+          , _transfer_batch(
+            std::max(memo::getenv("PAXOS_TRANSFER_BATCH", 64), 1))
+          , _transfer_window(
+            std::max(memo::getenv("PAXOS_TRANSFER_WINDOW", 4), 1))
+          , _transfer_batches(0)
+          , _transferred_blocks(0)
+          , _transferred_bytes(0)
+          , _transfer_rejected(0)
+          , _full_redundancies(0)
+          , _full_redundancy_time()
         {}
 
         /*--------.
@@ -218,6 +402,7 @@ namespace memo
             , _address(address)
             , _local_version(local_version)
             , _insert(insert)
+            , _paxos(nullptr)
           {
             if (!this->_member.lock())
               ELLE_ABORT("invalid paxos peer: %s", member);
@@ -251,16 +436,7 @@ namespace memo
           Paxos::PaxosClient::Proposal
           accept(Paxos::PaxosClient::Quorum const& q,
                  Paxos::PaxosClient::Proposal const& p,
-                 Paxos::Value const& value) override
-          {
-            BENCH("accept");
-            auto member = this->_lock_member();
-            return translate_exceptions("accept",
-              [&]
-              {
-                return member->accept(q, this->_address, p, value);
-              });
-          }
+                 Paxos::Value const& value) override;
 
           void
           confirm(Paxos::PaxosClient::Quorum const& q,
@@ -301,6 +477,8 @@ namespace memo
           ELLE_ATTRIBUTE(boost::optional<int>, local_version);
           ELLE_ATTRIBUTE(bool, insert);
           ELLE_ATTRIBUTE_R(boost::optional<bool>, missing);
+          /// Consensus to send deltas on behalf of, if any.
+          ELLE_ATTRIBUTE_RW(Paxos*, paxos);
         };
 
         /*--------.
@@ -461,6 +639,7 @@ namespace memo
                       ELLE_ASSERT(state.proposal);
                       // FIXME: steal ownership instead of cloning
                       ELLE_DEBUG("received new block");
+                      Details::_delta_base(self, *state.value);
                       auto res = std::dynamic_pointer_cast<blocks::MutableBlock>(
                         (*state.value)->clone());
                       if (state.proposal->version != res->version())
@@ -485,37 +664,14 @@ namespace memo
                 }
                 else
                 {
-                  static bool const balance =
-                    !elle::os::getenv("INFINIT_DISABLE_BALANCED_TRANSFERS", false);
-                  if (balance && peers.size() > 1)
-                  {
-                    elle::shuffle(peers);
-                    boost::sort(
-                      peers,
-                      [&self] (auto const& p1, auto const& p2)
-                      {
-                        return
-                          self._transfers[p1->id()] < self._transfers[p2->id()];
-                      });
-                  }
-                  ELLE_DUMP("%s: will try peers in that order: %s", self, peers);
-                  for (auto const& peer: peers)
-                  {
-                    try
-                    {
-                      self._transfers[peer->id()]++;
-                      elle::SafeFinally at_end([&] { self._transfers[peer->id()]--;});
-                      if (auto member = static_cast<PaxosPeer&>(*peer).member().lock())
-                        return member->fetch(address, local_version);
-                      else
-                        ELLE_WARN("%s: peer was deleted while storing", self);
-                    }
-                    catch (elle::Error const& e)
+                  auto members = MemberGenerator(
+                    [&] (MemberGenerator::yielder yield)
                     {
-                      ELLE_TRACE("error fetching from %s: %s", *peer, e.what());
-                    }
-                  }
-                  throw  MissingBlock(address);
+                      for (auto const& peer: peers)
+                        yield(static_cast<PaxosPeer&>(*peer).member().lock());
+                    });
+                  return self.fetch_from_members(
+                    members, address, local_version);
                 }
               }
               catch (Paxos::PaxosServer::WrongQuorum const& e)
@@ -588,8 +744,99 @@ namespace memo
               }
             }
           }
+
+          /// Send `value` to `peer`, as a delta against the latest chosen
+          /// value we know of when possible.
+          static
+          PaxosClient::Proposal
+          _accept(Paxos& self,
+                  Paxos::Peer& peer,
+                  PaxosClient::Quorum const& q,
+                  Address address,
+                  PaxosClient::Proposal const& p,
+                  Value const& value)
+          {
+            auto const local = self.doughnut().local();
+            if (self._delta &&
+                !(local && dynamic_cast<doughnut::Local*>(&peer) == local.get()) &&
+                value.is<std::shared_ptr<blocks::Block>>())
+            {
+              auto const& block = value.get<std::shared_ptr<blocks::Block>>();
+              auto const mb = dynamic_cast<blocks::MutableBlock*>(block.get());
+              auto const base = elle::find(self._delta_bases, address);
+              if (mb && base && base->version < mb->version())
+              {
+                if (!base->data)
+                {
+                  base->data = elle::serialization::binary::serialize(
+                    base->block.get(), self.doughnut().version());
+                  base->digest = delta_digest(*base->data);
+                }
+                auto const target = elle::serialization::binary::serialize(
+                  block.get(), self.doughnut().version());
+                auto const delta = delta_encode(*base->data, target);
+                if (delta.size() < target.size() &&
+                    target.size() <= base->data->size() + delta.size())
+                {
+                  auto const version = base->version;
+                  auto const digest = elle::Buffer(*base->digest);
+                  ELLE_DEBUG("send %f as %s bytes delta against version %s",
+                             address, delta.size(), version);
+                  if (auto res = peer.accept_delta(
+                        q, address, p, version, digest, delta))
+                  {
+                    ++self._delta_accepts;
+                    self._delta_bytes_saved += target.size() - delta.size();
+                    return *res;
+                  }
+                  ELLE_DEBUG("%f base version %s is stale, send full value",
+                             address, version);
+                  ++self._delta_fallbacks;
+                }
+              }
+            }
+            return peer.accept(q, address, p, value);
+          }
+
+          /// Remember `block` as chosen, for later updates to be sent as
+          /// deltas against it.  This is on the read path, so nothing is
+          /// serialized until such an update.
+          static
+          void
+          _delta_base(Paxos& self, std::shared_ptr<blocks::Block> const& block)
+          {
+            auto const mb = dynamic_cast<blocks::MutableBlock*>(block.get());
+            if (!self._delta || !mb)
+              return;
+            auto& bases = self._delta_bases;
+            bases.erase(block->address());
+            // Clone, payloads being shared, as callers may reseal `block`.
+            bases.get<1>().push_back(DeltaBase{
+                block->address(), mb->version(),
+                std::shared_ptr<blocks::Block>(block->clone()), {}, {}});
+            while (signed(bases.size()) > self._delta_bases_size)
+              bases.get<1>().pop_front();
+          }
         };
 
+        Paxos::PaxosClient::Proposal
+        PaxosPeer::accept(Paxos::PaxosClient::Quorum const& q,
+                          Paxos::PaxosClient::Proposal const& p,
+                          Paxos::Value const& value)
+        {
+          BENCH("accept");
+          auto member = this->_lock_member();
+          return translate_exceptions("accept",
+            [&]
+            {
+              if (this->_paxos)
+                return Paxos::Details::_accept(
+                  *this->_paxos, *member, q, this->_address, p, value);
+              else
+                return member->accept(q, this->_address, p, value);
+            });
+        }
+
         /*-----.
         | Peer |
         `-----*/
@@ -598,6 +845,41 @@ namespace memo
           : Super(dht, id)
         {}
 
+        bool
+        Paxos::Peer::subscribe(Versions const&)
+        {
+          return false;
+        }
+
+        void
+        Paxos::Peer::unsubscribe(std::vector<Address> const&)
+        {}
+
+        boost::optional<std::vector<uint64_t>>
+        Paxos::Peer::merkle_hashes(Address, int, std::vector<int> const&)
+        {
+          return boost::none;
+        }
+
+        boost::optional<Paxos::Versions>
+        Paxos::Peer::merkle_entries(Address, std::vector<int> const&)
+        {
+          return boost::none;
+        }
+
+        boost::optional<std::vector<Address>>
+        Paxos::Peer::store_batch(std::vector<elle::Buffer> const&,
+                                 std::vector<elle::Buffer> const&)
+        {
+          return boost::none;
+        }
+
+        bool
+        Paxos::Peer::confirm_batch(BlockQuorums const&)
+        {
+          return false;
+        }
+
         /*-----------.
         | RemotePeer |
         `-----------*/
@@ -636,6 +918,38 @@ namespace memo
           return accept(peers, address, p, value);
         }
 
+        boost::optional<Paxos::PaxosClient::Proposal>
+        Paxos::RemotePeer::accept_delta(PaxosServer::Quorum const& peers,
+                                        Address address,
+                                        Paxos::PaxosClient::Proposal const& p,
+                                        int base_version,
+                                        elle::Buffer const& base_digest,
+                                        elle::Buffer const& delta)
+        {
+          if (this->_delta_unsupported)
+            return boost::none;
+          using AcceptDelta =
+            auto (PaxosServer::Quorum peers,
+                  Address,
+                  Paxos::PaxosClient::Proposal const&,
+                  int,
+                  elle::Buffer const&,
+                  elle::Buffer const&)
+            -> boost::optional<Paxos::PaxosClient::Proposal>;
+          auto accept = this->make_rpc<AcceptDelta>("accept_delta");
+          accept.set_context<Doughnut*>(&this->_doughnut);
+          try
+          {
+            return accept(peers, address, p, base_version, base_digest, delta);
+          }
+          catch (UnknownRPC const&)
+          {
+            ELLE_TRACE("%s: peer does not support delta accepts", this);
+            this->_delta_unsupported = true;
+            return boost::none;
+          }
+        }
+
         void
         Paxos::RemotePeer::confirm(PaxosServer::Quorum const& peers,
                                    Address address,
@@ -704,6 +1018,185 @@ namespace memo
             });
         }
 
+        bool
+        Paxos::RemotePeer::subscribe(Versions const& versions)
+        {
+          if (this->_subscribe_unsupported || !this->connection())
+            return false;
+          ELLE_TRACE_SCOPE("%s: subscribe to %s addresses",
+                           this, versions.size());
+          auto const dht = &this->doughnut();
+          auto const invalidated = [dht] (Address address,
+                                          boost::optional<int> version)
+            {
+              if (auto paxos =
+                  StackedConsensus::find<Paxos>(dht->consensus().get()))
+                paxos->invalidated()(address, version);
+            };
+          // The connection may outlive this peer.
+          auto const weak = std::weak_ptr<model::doughnut::Peer>(
+            this->shared_from_this());
+          this->connection()->rpc_server().add(
+            "paxos_invalidate",
+            [weak, invalidated] (Invalidations const& invalidations)
+            {
+              auto const self =
+                std::dynamic_pointer_cast<RemotePeer>(weak.lock());
+              if (!self)
+                return;
+              ELLE_TRACE_SCOPE("%s: %s addresses invalidated",
+                               self, invalidations.size());
+              for (auto const& i: invalidations)
+              {
+                self->_subscribed.erase(i.first);
+                invalidated(i.first, i.second);
+              }
+            });
+          // Subscriptions are bound to the connection.
+          if (!this->_subscribed_disconnection.connected())
+            this->_subscribed_disconnection = this->disconnected().connect(
+              [this, invalidated]
+              {
+                auto subscribed = std::move(this->_subscribed);
+                this->_subscribed.clear();
+                for (auto const& a: subscribed)
+                  invalidated(a, boost::none);
+              });
+          auto subscribe = this->make_rpc<void (Versions const&)>(
+            "paxos_subscribe");
+          try
+          {
+            subscribe(versions);
+          }
+          catch (UnknownRPC const&)
+          {
+            ELLE_TRACE("%s: peer does not support subscriptions", this);
+            this->_subscribe_unsupported = true;
+            return false;
+          }
+          for (auto const& v: versions)
+            this->_subscribed.emplace(v.first);
+          return true;
+        }
+
+        void
+        Paxos::RemotePeer::unsubscribe(std::vector<Address> const& addresses)
+        {
+          auto unsubscribed = std::vector<Address>{};
+          for (auto const& a: addresses)
+            if (this->_subscribed.erase(a))
+              unsubscribed.emplace_back(a);
+          if (unsubscribed.empty())
+            return;
+          ELLE_TRACE_SCOPE("%s: unsubscribe from %s addresses",
+                           this, unsubscribed.size());
+          auto unsubscribe =
+            this->make_rpc<void (std::vector<Address> const&)>(
+              "paxos_unsubscribe");
+          unsubscribe(unsubscribed);
+        }
+
+        boost::optional<std::vector<uint64_t>>
+        Paxos::RemotePeer::merkle_hashes(Address node,
+                                         int level,
+                                         std::vector<int> const& indexes)
+        {
+          if (this->_merkle_unsupported)
+            return boost::none;
+          return translate_exceptions("paxos_merkle_hashes",
+            [&] () -> boost::optional<std::vector<uint64_t>>
+            {
+              using Hashes = auto (Address, int, std::vector<int> const&)
+                -> std::vector<uint64_t>;
+              auto hashes = this->make_rpc<Hashes>("paxos_merkle_hashes");
+              try
+              {
+                return hashes(node, level, indexes);
+              }
+              catch (UnknownRPC const&)
+              {
+                ELLE_TRACE("%s: peer does not support anti-entropy", this);
+                this->_merkle_unsupported = true;
+                return boost::none;
+              }
+            });
+        }
+
+        boost::optional<Paxos::Versions>
+        Paxos::RemotePeer::merkle_entries(Address node,
+                                          std::vector<int> const& leaves)
+        {
+          if (this->_merkle_unsupported)
+            return boost::none;
+          return translate_exceptions("paxos_merkle_entries",
+            [&] () -> boost::optional<Versions>
+            {
+              using Entries =
+                auto (Address, std::vector<int> const&) -> Versions;
+              auto entries = this->make_rpc<Entries>("paxos_merkle_entries");
+              try
+              {
+                return entries(node, leaves);
+              }
+              catch (UnknownRPC const&)
+              {
+                ELLE_TRACE("%s: peer does not support anti-entropy", this);
+                this->_merkle_unsupported = true;
+                return boost::none;
+              }
+            });
+        }
+
+        boost::optional<std::vector<Address>>
+        Paxos::RemotePeer::store_batch(std::vector<elle::Buffer> const& blocks,
+                                       std::vector<elle::Buffer> const& digests)
+        {
+          if (this->_batch_unsupported)
+            return boost::none;
+          return translate_exceptions("paxos_store_batch",
+            [&] () -> boost::optional<std::vector<Address>>
+            {
+              using StoreBatch = auto (std::vector<elle::Buffer> const&,
+                                       std::vector<elle::Buffer> const&)
+                -> std::vector<Address>;
+              auto store = this->make_rpc<StoreBatch>("paxos_store_batch");
+              try
+              {
+                return store(blocks, digests);
+              }
+              catch (UnknownRPC const&)
+              {
+                ELLE_TRACE("%s: peer does not support bulk transfers", this);
+                this->_batch_unsupported = true;
+                return boost::none;
+              }
+            });
+        }
+
+        bool
+        Paxos::RemotePeer::confirm_batch(BlockQuorums const& quorums)
+        {
+          if (this->_batch_unsupported)
+            return false;
+          return translate_exceptions("paxos_confirm_batch",
+            [&]
+            {
+              auto confirm = this->make_rpc<void (BlockQuorums const&)>(
+                "paxos_confirm_batch");
+              try
+              {
+                confirm(quorums);
+                return true;
+              }
+              catch (UnknownRPC const&)
+              {
+                ELLE_TRACE("%s: peer does not support bulk transfers", this);
+                this->_batch_unsupported = true;
+                return false;
+              }
+            });
+        }
+
 
         /*----------.
         | LocalPeer |
@@ -721,6 +1214,10 @@ namespace memo
           for (auto& t: this->_evict_threads)
             if (t)
               t->terminate_now();
+          if (this->_notify_thread)
+            this->_notify_thread->terminate_now();
+          if (this->_anti_entropy_thread)
+            this->_anti_entropy_thread->terminate_now();
         }
         catch (...)
         {
@@ -782,6 +1279,11 @@ namespace memo
                     ELLE_ERR("disk rebalancer inspector exited: %s", e);
                   }
                 }));
+          if (this->_paxos.anti_entropy_interval() && this->_factor > 1)
+            this->_anti_entropy_thread.reset(
+              new elle::reactor::Thread(
+                elle::sprintf("%s: anti-entropy", this),
+                [this] { this->_anti_entropy_loop(); }));
         }
 
         void
@@ -792,6 +1294,8 @@ namespace memo
           this->_rebalance_inspector.reset();
           this->_rebalance_thread.terminate_now();
           this->_evict_threads.clear();
+          this->_notify_thread.reset();
+          this->_anti_entropy_thread.reset();
           Super::_cleanup();
         }
 
@@ -839,7 +1343,9 @@ namespace memo
                         wpeer.reset();
                     };
                   }
-                  this->_cache(address, true, q);
+                  // Owners may differ from the quorum the block was stored
+                  // with, keep it out of anti-entropy.
+                  this->_cache(address, true, q, 0, false);
                   if (signed(q.size()) < this->_factor)
                   {
                     ELLE_DUMP("schedule %f for rebalancing after load",
@@ -919,7 +1425,8 @@ namespace memo
                                       Paxos::LocalPeer::Decision decision)
         {
           auto const& quorum = decision.paxos.current_quorum();
-          this->_cache(address, false, quorum);
+          this->_cache(
+            address, false, quorum, decision.paxos.current_version());
           if (this->_rebalance_auto_expand &&
               decision.paxos.current_value() &&
               signed(quorum.size()) < this->_factor)
@@ -952,17 +1459,30 @@ namespace memo
         }
 
         void
-        Paxos::LocalPeer::_cache(Address address, bool immutable, Quorum quorum)
+        Paxos::LocalPeer::_cache(Address address,
+                                 bool immutable,
+                                 Quorum quorum,
+                                 int version,
+                                 bool tracked)
+        {
+          this->_uncache(address);
+          auto ir = this->_quorums.emplace(
+            address, immutable, quorum, version, tracked);
+          for (auto const& n: quorum)
+            this->_node_blocks.emplace(n, address);
+          this->_merkle_update(*ir.first, true);
+        }
+
+        void
+        Paxos::LocalPeer::_uncache(Address address)
         {
           if (auto repartition = elle::find(this->_quorums, address))
           {
+            this->_merkle_update(*repartition, false);
             for (auto const& n: repartition->quorum)
               this->_node_blocks.erase(NodeBlock(n, address));
             this->_quorums.erase(repartition);
           }
-          this->_quorums.emplace(address, immutable, quorum);
-          for (auto const& n: quorum)
-            this->_node_blocks.emplace(n, address);
         }
 
         void
@@ -971,7 +1491,16 @@ namespace memo
           this->_nodes.emplace(id);
           this->_node_timeouts.erase(id);
           if (this->_rebalance_auto_expand)
+          {
+            auto& transfer = this->_transfers[id];
+            if (!transfer)
+              transfer = std::make_shared<Transfer>(
+                Transfer{elle::Clock::now(), {}});
+            else
+              // The node may have come back with an empty disk.
+              transfer->acknowledged.clear();
             this->_rebalancable.emplace(id, true);
+          }
         }
 
         void
@@ -1014,6 +1543,7 @@ namespace memo
           ELLE_LOG_COMPONENT(
             "memo.model.doughnut.consensus.Paxos.rebalance");
           ELLE_TRACE_SCOPE("%s: evict node %f", this, lost_id);
+          this->_transfers.erase(lost_id);
           auto range = elle::equal_range(
             this->_node_blocks.get<by_node>(), lost_id);
           // The addresses of the blocks that the disappeared host kept.
@@ -1074,7 +1604,7 @@ namespace memo
               auto q = it->quorum;
               if (q.erase(lost_id))
               {
-                this->_cache(addr, true, q);
+                this->_cache(addr, true, q, 0, it->tracked);
                 if (signed(q.size()) < this->_factor)
                 {
                   ELLE_DUMP("schedule %f for rebalancing after eviction",
@@ -1163,10 +1693,15 @@ namespace memo
                   targets.emplace(r);
               }
               if (targets.empty())
+              {
+                this->_transfers.erase(address);
                 continue;
+              }
               ELLE_TRACE_SCOPE(
                 "%s: rebalance %s blocks to newly discovered peer %f",
                 this, targets.size(), address);
+              this->_transfer(address, targets);
+              auto complete = true;
               for (auto target: targets)
               {
                 if (!elle::find(this->_nodes, address) ||
@@ -1174,6 +1709,7 @@ namespace memo
                 {
                   ELLE_TRACE("%s: peer %f disappeared, stop rebalancing to it",
                              this, address);
+                  complete = false;
                   break;
                 }
                 try
@@ -1239,8 +1775,20 @@ namespace memo
                 catch (elle::Error const& e)
                 {
                   ELLE_WARN("rebalancing of %f failed: %s", target.address, e);
+                  complete = false;
                 }
               }
+              if (complete)
+                if (auto transfer = elle::find(this->_transfers, address))
+                {
+                  auto const time = elle::Clock::now() -
+                    transfer->second->discovered;
+                  ELLE_TRACE("%s: %f reached full redundancy in %s",
+                             this, address, time);
+                  ++this->_paxos._full_redundancies;
+                  this->_paxos._full_redundancy_time = time;
+                  this->_transfers.erase(transfer);
+                }
             }
           }
         }
@@ -1358,6 +1906,59 @@ namespace memo
           return res;
         }
 
+        boost::optional<Paxos::PaxosClient::Proposal>
+        Paxos::LocalPeer::accept_delta(PaxosServer::Quorum const& peers,
+                                       Address address,
+                                       Paxos::PaxosClient::Proposal const& p,
+                                       int base_version,
+                                       elle::Buffer const& base_digest,
+                                       elle::Buffer const& delta)
+        {
+          ELLE_TRACE_SCOPE("%s: accept delta at %f: %s against version %s",
+                           *this, address, p, base_version);
+          auto base = std::shared_ptr<blocks::Block>{};
+          try
+          {
+            if (auto current = this->_load_paxos(address)->paxos.current_value())
+              if (current->value.template is<std::shared_ptr<blocks::Block>>())
+                base = current->value.template get<
+                  std::shared_ptr<blocks::Block>>();
+          }
+          catch (MissingBlock const&)
+          {}
+          auto const mb = dynamic_cast<blocks::MutableBlock*>(base.get());
+          if (!mb || mb->version() != base_version)
+          {
+            ELLE_DEBUG("chosen version %s differs from base",
+                       mb ? mb->version() : -1);
+            return boost::none;
+          }
+          auto const data = elle::serialization::binary::serialize(
+            base.get(), this->doughnut().version());
+          if (delta_digest(data) != base_digest)
+          {
+            ELLE_DEBUG("chosen value differs from base");
+            return boost::none;
+          }
+          auto block = std::shared_ptr<blocks::Block>{};
+          try
+          {
+            elle::serialization::Context context;
+            context.set<Doughnut*>(&this->doughnut());
+            context.set<elle::Version>(
+              elle_serialization_version(this->doughnut().version()));
+            block = elle::serialization::binary::deserialize<
+              std::unique_ptr<blocks::Block>>(
+                delta_apply(data, delta), true, context);
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("%s: invalid delta for %f: %s", this, address, e);
+            return boost::none;
+          }
+          return this->accept(peers, address, p, block);
+        }
+
         void
         Paxos::LocalPeer::confirm(PaxosServer::Quorum const& peers,
                                   Address address,
@@ -1381,6 +1982,7 @@ namespace memo
             auto& decision = *block.paxos;
             bool had_value = bool(decision.paxos.current_value());
             decision.paxos.confirm(peers, p);
+            auto const version = decision.paxos.current_version();
             ELLE_DEBUG("store confirmed paxos")
             {
               auto data = BlockOrPaxos(&decision);
@@ -1393,6 +1995,12 @@ namespace memo
               }();
               this->storage()->set(address, ser, true, true);
             }
+            if (auto chosen = decision.paxos.current_value())
+              if (chosen->value.template is<std::shared_ptr<blocks::Block>>())
+                if (auto mb = dynamic_cast<blocks::MutableBlock*>(
+                      chosen->value.template get<
+                        std::shared_ptr<blocks::Block>>().get()))
+                  this->_notify(address, mb->version());
             if (auto quorum = [&] () -> boost::optional<Quorum>
               {
                 if (!had_value)
@@ -1413,7 +2021,7 @@ namespace memo
                   this->_remove(address);
               else
               {
-                this->_cache(address, false, *quorum);
+                this->_cache(address, false, *quorum, version);
                 if (this->_rebalance_auto_expand &&
                     decision.paxos.current_value() &&
                     signed(quorum->size()) < this->_factor)
@@ -1424,6 +2032,9 @@ namespace memo
                 }
               }
             }
+            else
+              this->_cache(address, false,
+                           decision.paxos.current_quorum(), version);
           }
           else
           {
@@ -1474,6 +2085,9 @@ namespace memo
             decision->paxos.propose(q, p);
             decision->paxos.accept(q, p, q);
             decision->paxos.confirm(q, p);
+            this->_cache(block->address(), false,
+                         decision->paxos.current_quorum(),
+                         decision->paxos.current_version());
             auto data = BlockOrPaxos(decision.get());
             this->storage()->set(
               block->address(),
@@ -1512,6 +2126,19 @@ namespace memo
                this->_require_auth(rpcs, true);
                return this->accept(std::move(q), a, p, value);
              });
+          rpcs.add(
+            "accept_delta",
+            [this, &rpcs](PaxosServer::Quorum q,
+                          Address a,
+                          Paxos::PaxosClient::Proposal const& p,
+                          int base_version,
+                          elle::Buffer const& base_digest,
+                          elle::Buffer const& delta)
+            {
+              this->_require_auth(rpcs, true);
+              return this->accept_delta(
+                std::move(q), a, p, base_version, base_digest, delta);
+            });
           rpcs.add(
             "confirm",
             [this](PaxosServer::Quorum q, Address a,
@@ -1543,27 +2170,83 @@ namespace memo
               return this->propagate(
                 std::move(q), std::move(block), std::move(p));
             });
-        }
-
-        std::unique_ptr<blocks::Block>
-        Paxos::LocalPeer::_fetch(Address address,
-                                 boost::optional<int> local_version) const
-        {
-          elle::serialization::Context context;
-          context.set<Doughnut*>(&this->doughnut());
-          context.set<elle::Version>(
-            elle_serialization_version(this->doughnut().version()));
-          auto data =
-            elle::serialization::binary::deserialize<BlockOrPaxos>(
-              this->storage()->get(address), true, context);
-          if (!data.block)
-          {
-            ELLE_TRACE("%s: plain fetch called on mutable block", *this);
-            elle::err("plain fetch called on mutable block %f", address);
-          }
-          return std::unique_ptr<blocks::Block>(data.block.release());
-        }
-
+          rpcs.add(
+            "paxos_subscribe",
+            [this, &rpcs, &connection] (Versions const& versions)
+            {
+              this->_require_auth(rpcs, false);
+              auto current = std::vector<Address>{};
+              auto outdated = Invalidations{};
+              for (auto const& v: versions)
+                if (auto newer = this->_newer(v.first, v.second))
+                  outdated.emplace(v.first, newer);
+                else
+                  current.emplace_back(v.first);
+              this->_subscribe(connection, current, true);
+              if (!outdated.empty())
+                this->_notify(connection, std::move(outdated));
+            });
+          rpcs.add(
+            "paxos_unsubscribe",
+            [this, &rpcs, &connection] (std::vector<Address> const& addresses)
+            {
+              this->_require_auth(rpcs, false);
+              this->_subscribe(connection, addresses, false);
+            });
+          rpcs.add(
+            "paxos_merkle_hashes",
+            [this, &rpcs] (Address node,
+                           int level,
+                           std::vector<int> const& indexes)
+            {
+              this->_require_auth(rpcs, true);
+              this->_merkle_require();
+              return *this->merkle_hashes(node, level, indexes);
+            });
+          rpcs.add(
+            "paxos_merkle_entries",
+            [this, &rpcs] (Address node, std::vector<int> const& leaves)
+            {
+              this->_require_auth(rpcs, true);
+              this->_merkle_require();
+              return *this->merkle_entries(node, leaves);
+            });
+          rpcs.add(
+            "paxos_store_batch",
+            [this, &rpcs] (std::vector<elle::Buffer> const& blocks,
+                           std::vector<elle::Buffer> const& digests)
+            {
+              this->_require_auth(rpcs, true);
+              return *this->store_batch(blocks, digests);
+            });
+          rpcs.add(
+            "paxos_confirm_batch",
+            [this, &rpcs] (BlockQuorums const& quorums)
+            {
+              this->_require_auth(rpcs, true);
+              this->confirm_batch(quorums);
+            });
+        }
+
+        std::unique_ptr<blocks::Block>
+        Paxos::LocalPeer::_fetch(Address address,
+                                 boost::optional<int> local_version) const
+        {
+          elle::serialization::Context context;
+          context.set<Doughnut*>(&this->doughnut());
+          context.set<elle::Version>(
+            elle_serialization_version(this->doughnut().version()));
+          auto data =
+            elle::serialization::binary::deserialize<BlockOrPaxos>(
+              this->storage()->get(address), true, context);
+          if (!data.block)
+          {
+            ELLE_TRACE("%s: plain fetch called on mutable block", *this);
+            elle::err("plain fetch called on mutable block %f", address);
+          }
+          return std::unique_ptr<blocks::Block>(data.block.release());
+        }
+
         void
         Paxos::LocalPeer::store(blocks::Block const& block, StoreMode mode)
         {
@@ -1612,6 +2295,8 @@ namespace memo
                                mode == STORE_INSERT,
                                mode == STORE_UPDATE);
           this->on_store()(block);
+          // Let subscribers that found it missing know.
+          this->_notify(block.address(), 0);
         }
 
         void
@@ -1667,9 +2352,795 @@ namespace memo
           {
             throw MissingBlock(k.key());
           }
-          this->_node_blocks.get<by_block>().erase(address);
+          this->_uncache(address);
           this->on_remove()(address);
           this->_addresses.erase(address);
+          this->_notify(address, boost::none);
+        }
+
+        bool
+        Paxos::LocalPeer::subscribe(Versions const& versions)
+        {
+          for (auto const& v: versions)
+            if (auto newer = this->_newer(v.first, v.second))
+              this->_paxos.invalidated()(v.first, newer);
+            else
+              this->_local_subscriptions.emplace(v.first);
+          return true;
+        }
+
+        void
+        Paxos::LocalPeer::unsubscribe(std::vector<Address> const& addresses)
+        {
+          for (auto const& a: addresses)
+            this->_local_subscriptions.erase(a);
+        }
+
+        void
+        Paxos::LocalPeer::_subscribe(Connection& connection,
+                                     std::vector<Address> const& addresses,
+                                     bool subscribe)
+        {
+          auto peer = std::find_if(
+            this->peers().begin(), this->peers().end(),
+            [&] (std::shared_ptr<Connection> const& c)
+            {
+              return c.get() == &connection;
+            });
+          if (peer == this->peers().end())
+            return;
+          ELLE_TRACE_SCOPE("%s: %s %s to %s addresses",
+                           this, connection,
+                           subscribe ? "subscribe" : "unsubscribe",
+                           addresses.size());
+          for (auto const& a: addresses)
+          {
+            auto it = this->_subscriptions.find(a);
+            if (it == this->_subscriptions.end())
+            {
+              if (subscribe)
+                this->_subscriptions[a].emplace_back(*peer);
+              continue;
+            }
+            auto& subscribers = it->second;
+            subscribers.erase(
+              std::remove_if(
+                subscribers.begin(), subscribers.end(),
+                [&] (std::weak_ptr<Connection> const& c)
+                {
+                  auto const locked = c.lock();
+                  return !locked || locked.get() == &connection;
+                }),
+              subscribers.end());
+            if (subscribe)
+              subscribers.emplace_back(*peer);
+            else if (subscribers.empty())
+              this->_subscriptions.erase(it);
+          }
+        }
+
+        boost::optional<int>
+        Paxos::LocalPeer::_newer(Address address, int version)
+        {
+          // Immutable blocks only change upon removal, which is notified.
+          if (version == 0)
+            return boost::none;
+          auto const repartition = elle::find(this->_quorums, address);
+          // Subscribers missing the block need only know it exists.
+          if (version < 0)
+            return repartition ?
+              boost::optional<int>(repartition->version) : boost::none;
+          // Quorum changes bump the Paxos version too, only load the decision
+          // if it may hold a newer block.
+          if (!repartition || repartition->version <= version)
+            return boost::none;
+          try
+          {
+            auto const decision = this->_load_paxos(address);
+            if (auto chosen = decision->paxos.current_value())
+              if (chosen->value.template is<std::shared_ptr<blocks::Block>>())
+                if (auto mb = dynamic_cast<blocks::MutableBlock*>(
+                      chosen->value.template get<
+                        std::shared_ptr<blocks::Block>>().get()))
+                  if (mb->version() > version)
+                    return mb->version();
+          }
+          catch (MissingBlock const&)
+          {
+            // Removed meanwhile, which is notified.
+          }
+          return boost::none;
+        }
+
+        void
+        Paxos::LocalPeer::_notify(Address address,
+                                  boost::optional<int> version)
+        {
+          if (this->_local_subscriptions.erase(address))
+            this->_paxos.invalidated()(address, version);
+          auto it = this->_subscriptions.find(address);
+          if (it == this->_subscriptions.end())
+            return;
+          ELLE_DEBUG("%s: notify %s subscribers of %f version %s",
+                     this, it->second.size(), address, version);
+          for (auto const& c: it->second)
+            if (auto connection = c.lock())
+            {
+              auto& n = this->_notifications[connection.get()];
+              n.connection = c;
+              n.invalidations[address] = version;
+            }
+          this->_subscriptions.erase(it);
+          this->_notify_start();
+        }
+
+        void
+        Paxos::LocalPeer::_notify(Connection& connection,
+                                  Invalidations invalidations)
+        {
+          auto peer = std::find_if(
+            this->peers().begin(), this->peers().end(),
+            [&] (std::shared_ptr<Connection> const& c)
+            {
+              return c.get() == &connection;
+            });
+          if (peer == this->peers().end())
+            return;
+          ELLE_DEBUG("%s: notify %s of %s outdated addresses",
+                     this, connection, invalidations.size());
+          auto& n = this->_notifications[&connection];
+          n.connection = *peer;
+          for (auto& i: invalidations)
+            n.invalidations[i.first] = i.second;
+          this->_notify_start();
+        }
+
+        void
+        Paxos::LocalPeer::_notify_start()
+        {
+          if (this->_notifications.empty() || this->_cleaning_up)
+            return;
+          if (!this->_notify_thread)
+            this->_notify_thread.reset(
+              new elle::reactor::Thread(
+                elle::sprintf("%s: notify", this),
+                [this] { this->_notify_loop(); }));
+          this->_notify_barrier.open();
+        }
+
+        void
+        Paxos::LocalPeer::_notify_loop()
+        {
+          while (true)
+          {
+            elle::reactor::wait(this->_notify_barrier);
+            auto notifications = std::move(this->_notifications);
+            this->_notifications.clear();
+            this->_notify_barrier.close();
+            elle::reactor::for_each_parallel(
+              notifications,
+              [&] (std::pair<Connection* const, Notification>& n)
+              {
+                if (auto c = n.second.connection.lock())
+                  try
+                  {
+                    c->call<void>("paxos_invalidate",
+                                  n.second.invalidations);
+                  }
+                  catch (elle::Error const& e)
+                  {
+                    ELLE_TRACE("%s: unable to notify %s: %s", this, c, e);
+                  }
+              },
+              elle::print("{}: notify", this));
+          }
+        }
+
+        /*-------------.
+        | Anti-entropy |
+        `-------------*/
+
+        void
+        Paxos::LocalPeer::_merkle_update(BlockRepartition const& repartition,
+                                         bool add)
+        {
+          if (!repartition.tracked)
+            return;
+          for (auto const& node: repartition.quorum)
+          {
+            if (node == this->id())
+              continue;
+            auto& tree = this->_merkle_trees[node];
+            if (add)
+              tree.add(repartition.address, repartition.version);
+            else
+            {
+              tree.remove(repartition.address, repartition.version);
+              if (tree.size() == 0)
+                this->_merkle_trees.erase(node);
+            }
+          }
+        }
+
+        boost::optional<std::vector<uint64_t>>
+        Paxos::LocalPeer::merkle_hashes(Address node,
+                                        int level,
+                                        std::vector<int> const& indexes)
+        {
+          if (level < 0 || level > MerkleTree::depth)
+            elle::err("invalid tree level: %s", level);
+          auto width = 1;
+          for (int i = 0; i < level; ++i)
+            width *= MerkleTree::fanout;
+          for (auto i: indexes)
+            if (i < 0 || i >= width)
+              elle::err("invalid index at tree level %s: %s", level, i);
+          if (auto tree = elle::find(this->_merkle_trees, node))
+            return tree->second.hashes(level, indexes);
+          else
+            return std::vector<uint64_t>(indexes.size(), 0);
+        }
+
+        boost::optional<Paxos::Versions>
+        Paxos::LocalPeer::merkle_entries(Address node,
+                                         std::vector<int> const& leaves)
+        {
+          return this->_merkle_entries(
+            node, std::unordered_set<int>(leaves.begin(), leaves.end()));
+        }
+
+        Paxos::Versions
+        Paxos::LocalPeer::_merkle_entries(
+          Address node, std::unordered_set<int> const& leaves) const
+        {
+          auto res = Versions{};
+          for (auto const& nb:
+                 elle::equal_range(this->_node_blocks.get<by_node>(), node))
+            if (elle::contains(leaves, MerkleTree::leaf(nb.block)))
+            {
+              auto const repartition =
+                ELLE_ENFORCE(elle::find(this->_quorums, nb.block));
+              if (repartition->tracked)
+                res.emplace(nb.block, repartition->version);
+            }
+          return res;
+        }
+
+        void
+        Paxos::LocalPeer::_merkle_build()
+        {
+          ELLE_LOG_COMPONENT(
+            "memo.model.doughnut.consensus.Paxos.rebalance");
+          ELLE_TRACE_SCOPE("%s: build anti-entropy trees", this);
+          for (auto const& address: this->storage()->list())
+          {
+            try
+            {
+              // Loading a decision registers its quorum.
+              auto const loaded = elle::contains(this->_addresses, address);
+              if (this->_load(address).paxos && !loaded)
+                this->_addresses.erase(address);
+            }
+            catch (MissingBlock const&)
+            {}
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("%s: unable to load %f: %s", this, address, e);
+            }
+            elle::reactor::yield();
+          }
+          this->_merkle_ready = true;
+        }
+
+        void
+        Paxos::LocalPeer::_merkle_require()
+        {
+          if (this->_merkle_ready)
+            return;
+          // Build the trees in the background, the peer retries next round.
+          if (!this->_cleaning_up &&
+              (!this->_anti_entropy_thread ||
+               this->_anti_entropy_thread->done()))
+            this->_anti_entropy_thread.reset(
+              new elle::reactor::Thread(
+                elle::sprintf("%s: anti-entropy", this),
+                [this] { this->_anti_entropy_loop(); }));
+          elle::err("anti-entropy trees are not built yet");
+        }
+
+        int
+        Paxos::LocalPeer::anti_entropy()
+        {
+          if (!this->_merkle_ready)
+            this->_merkle_build();
+          ++this->_paxos._anti_entropy_rounds;
+          auto const nodes = elle::make_vector(
+            this->_merkle_trees,
+            [] (std::pair<Address const, MerkleTree> const& tree)
+            {
+              return tree.first;
+            });
+          auto res = 0;
+          for (auto const& node: nodes)
+            try
+            {
+              res += this->anti_entropy(node);
+            }
+            catch (elle::Error const& e)
+            {
+              // Notably, the node may not have built its trees yet.
+              ELLE_TRACE("%s: unable to compare blocks with %f: %s",
+                         this, node, e);
+            }
+          return res;
+        }
+
+        int
+        Paxos::LocalPeer::anti_entropy(Address node)
+        {
+          ELLE_LOG_COMPONENT(
+            "memo.model.doughnut.consensus.Paxos.rebalance");
+          auto const peer = [&] () -> std::shared_ptr<Paxos::Peer>
+            {
+              try
+              {
+                return to_paxos_peer(
+                  this->doughnut().overlay()->lookup_node(node));
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_TRACE("%s: unable to reach %f: %s", this, node, e);
+                return nullptr;
+              }
+            }();
+          if (!peer)
+            return 0;
+          ELLE_TRACE_SCOPE("%s: compare blocks shared with %f", this, node);
+          // Descend from the root into the nodes whose hashes differ, down to
+          // the leaf ranges.
+          auto leaves = std::unordered_set<int>{};
+          auto indexes = std::vector<int>{0};
+          for (int level = 0; !indexes.empty(); ++level)
+          {
+            auto const remote = peer->merkle_hashes(this->id(), level, indexes);
+            if (!remote)
+              return 0;
+            if (remote->size() != indexes.size())
+              elle::err("%s returned %s hashes instead of %s",
+                        peer, remote->size(), indexes.size());
+            this->_paxos._anti_entropy_compared += indexes.size();
+            // The tree may have changed, or disappeared, during the call.
+            auto const local = this->merkle_hashes(node, level, indexes);
+            auto next = std::vector<int>{};
+            for (auto i = 0u; i < indexes.size(); ++i)
+              if ((*local)[i] != (*remote)[i])
+              {
+                if (level == MerkleTree::depth)
+                  leaves.emplace(indexes[i]);
+                else
+                  for (int c = 0; c < MerkleTree::fanout; ++c)
+                    next.emplace_back(indexes[i] * MerkleTree::fanout + c);
+              }
+            indexes = std::move(next);
+          }
+          if (leaves.empty())
+          {
+            ELLE_DEBUG("all blocks are in sync");
+            return 0;
+          }
+          ELLE_DEBUG("%s address ranges differ", leaves.size());
+          this->_paxos._anti_entropy_differing += leaves.size();
+          auto const remote =
+            peer->merkle_entries(this->id(), elle::make_vector(leaves));
+          if (!remote)
+            return 0;
+          // Only push what the peer lacks or lags behind on, it takes care of
+          // the converse.
+          auto res = 0;
+          for (auto const& entry: this->_merkle_entries(node, leaves))
+          {
+            auto it = remote->find(entry.first);
+            if (it != remote->end() && it->second >= entry.second)
+              continue;
+            try
+            {
+              if (this->_merkle_repair(*peer, entry.first))
+                ++res;
+            }
+            catch (MissingBlock const&)
+            {
+              ELLE_TRACE("block %f was deleted while repairing", entry.first);
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_TRACE("unable to repair %f on %f: %s", entry.first, node, e);
+            }
+          }
+          this->_paxos._anti_entropy_repaired += res;
+          return res;
+        }
+
+        bool
+        Paxos::LocalPeer::_merkle_repair(Paxos::Peer& peer, Address address)
+        {
+          ELLE_LOG_COMPONENT(
+            "memo.model.doughnut.consensus.Paxos.rebalance");
+          auto block = this->_load(address);
+          auto const quorum = block.paxos
+            ? block.paxos->paxos.current_quorum()
+            : ELLE_ENFORCE(elle::find(this->_quorums, address))->quorum;
+          // The rest of the quorum, whose members must still hold the block
+          // lest it be a removal we missed.  Without any, the peer lacking the
+          // block is as likely to be right as we are.
+          auto const others = [&]
+            {
+              auto res = quorum;
+              res.erase(peer.id());
+              res.erase(this->id());
+              return res;
+            }();
+          if (others.empty())
+          {
+            ELLE_TRACE("%s: no other member of the quorum of %f, don't repair",
+                       this, address);
+            return false;
+          }
+          auto vouched = 0;
+          auto latest = boost::optional<PaxosClient::Accepted>{};
+          for (auto const& member:
+                 this->doughnut().overlay()->lookup_nodes(others))
+            if (auto other = to_paxos_peer(member))
+              try
+              {
+                if (block.paxos)
+                {
+                  auto accepted = other->get(quorum, address, boost::none);
+                  if (!accepted ||
+                      !accepted->value.template is<
+                        std::shared_ptr<blocks::Block>>())
+                    throw MissingBlock(address);
+                  if (!latest || latest->proposal < accepted->proposal)
+                    latest = std::move(accepted);
+                }
+                else
+                  other->fetch(address, boost::none);
+                ++vouched;
+              }
+              catch (MissingBlock const&)
+              {
+                ELLE_TRACE("%s: %f is missing from %f, don't repair",
+                           this, address, other);
+                return false;
+              }
+          if (!vouched)
+          {
+            ELLE_TRACE("%s: no other member of the quorum of %f is reachable, "
+                       "don't repair", this, address);
+            return false;
+          }
+          if (block.paxos)
+          {
+            ELLE_TRACE_SCOPE("%s: propagate %f to %f", this, address, peer);
+            peer.propagate(
+              quorum,
+              latest->value.template get<std::shared_ptr<blocks::Block>>(),
+              latest->proposal);
+          }
+          else
+          {
+            ELLE_TRACE_SCOPE("%s: send %f to %f", this, address, peer);
+            try
+            {
+              peer.store(*block.block, STORE_INSERT);
+            }
+            catch (silo::Collision const&)
+            {
+              ELLE_DEBUG("%f already holds %f", peer, address);
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_TRACE("%s: unable to store %f on %f: %s",
+                         this, address, peer, e);
+              return false;
+            }
+            peer.confirm(quorum, address, PaxosClient::Proposal());
+          }
+          return true;
+        }
+
+        void
+        Paxos::LocalPeer::_anti_entropy_loop()
+        {
+          ELLE_LOG_COMPONENT(
+            "memo.model.doughnut.consensus.Paxos.rebalance");
+          try
+          {
+            this->_merkle_build();
+          }
+          catch (elle::Error const& e)
+          {
+            ELLE_WARN("%s: unable to build anti-entropy trees: %s", this, e);
+          }
+          // Only answer peers if anti-entropy is disabled here.
+          if (!this->_paxos.anti_entropy_interval())
+            return;
+          while (true)
+          {
+            elle::reactor::sleep(*this->_paxos.anti_entropy_interval());
+            ELLE_TRACE_SCOPE("%s: anti-entropy round", this);
+            try
+            {
+              if (auto repaired = this->anti_entropy())
+                ELLE_TRACE("repaired %s blocks", repaired);
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("%s: anti-entropy round failed: %s", this, e);
+            }
+          }
+        }
+
+        /*----------.
+        | Transfers |
+        `----------*/
+
+        boost::optional<std::vector<Address>>
+        Paxos::LocalPeer::store_batch(std::vector<elle::Buffer> const& blocks,
+                                      std::vector<elle::Buffer> const& digests)
+        {
+          ELLE_TRACE_SCOPE("%s: store batch of %s blocks", this, blocks.size());
+          if (blocks.size() != digests.size())
+            elle::err("got %s digests for %s blocks",
+                      digests.size(), blocks.size());
+          auto const context = [&]
+            {
+              auto res = elle::serialization::Context{};
+              res.set<Doughnut*>(&this->doughnut());
+              res.set<elle::Version>(
+                elle_serialization_version(this->doughnut().version()));
+              return res;
+            }();
+          auto res = std::vector<Address>{};
+          for (auto i = 0u; i < blocks.size(); ++i)
+          {
+            if (transfer_digest(blocks[i]) != digests[i])
+            {
+              ELLE_WARN("%s: skip corrupted block in batch", this);
+              continue;
+            }
+            try
+            {
+              auto stored =
+                elle::serialization::binary::deserialize<BlockOrPaxos>(
+                  blocks[i], true, context);
+              if (!stored.block ||
+                  !dynamic_cast<blocks::ImmutableBlock*>(stored.block.get()))
+              {
+                ELLE_WARN("%s: skip mutable block in batch", this);
+                continue;
+              }
+              auto const address = stored.block->address();
+              if (auto v = stored.block->validate(this->doughnut(), true));
+              else
+              {
+                ELLE_WARN("%s: skip invalid block %f in batch: %s",
+                          this, address, v.reason());
+                continue;
+              }
+              try
+              {
+                this->storage()->set(address, blocks[i], true, false);
+                this->on_store()(*stored.block);
+              }
+              catch (silo::Collision const&)
+              {
+                ELLE_DEBUG("%f is already stored", address);
+              }
+              res.emplace_back(address);
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_WARN("%s: skip unreadable block in batch: %s", this, e);
+            }
+          }
+          return res;
+        }
+
+        bool
+        Paxos::LocalPeer::confirm_batch(BlockQuorums const& quorums)
+        {
+          ELLE_TRACE_SCOPE("%s: confirm batch of %s blocks",
+                           this, quorums.size());
+          for (auto const& q: quorums)
+            try
+            {
+              this->confirm(q.second, q.first, PaxosClient::Proposal());
+            }
+            catch (MissingBlock const&)
+            {
+              ELLE_TRACE("%s: %f is missing, don't confirm it", this, q.first);
+            }
+          return true;
+        }
+
+        void
+        Paxos::LocalPeer::_transfer(Address node, Repartitions& targets)
+        {
+          ELLE_LOG_COMPONENT(
+            "memo.model.doughnut.consensus.Paxos.rebalance");
+          auto& paxos = this->_paxos;
+          auto blocks = std::vector<Address>{};
+          for (auto const& target: targets)
+            if (target.immutable)
+              blocks.emplace_back(target.address);
+          if (blocks.empty())
+            return;
+          auto const peer = [&] () -> std::shared_ptr<Paxos::Peer>
+            {
+              try
+              {
+                return to_paxos_peer(
+                  this->doughnut().overlay()->lookup_node(node));
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_TRACE("%s: unable to reach %f: %s", this, node, e);
+                return nullptr;
+              }
+            }();
+          if (!peer)
+            return;
+          auto const transfer = [&]
+            {
+              auto& res = this->_transfers[node];
+              if (!res)
+                res = std::make_shared<Transfer>(
+                  Transfer{elle::Clock::now(), {}});
+              return res;
+            }();
+          // Skip the blocks the node acknowledged, and forget the ones whose
+          // quorum was committed since.
+          auto stored = std::vector<Address>{};
+          auto missing = std::vector<Address>{};
+          auto acknowledged = std::unordered_set<Address>{};
+          for (auto const& address: blocks)
+            if (elle::contains(transfer->acknowledged, address))
+            {
+              stored.emplace_back(address);
+              acknowledged.emplace(address);
+            }
+            else
+              missing.emplace_back(address);
+          transfer->acknowledged = std::move(acknowledged);
+          ELLE_TRACE_SCOPE("%s: transfer %s blocks to %f, %s already stored",
+                           this, missing.size(), node, stored.size());
+          auto batches = std::vector<std::vector<Address>>{};
+          for (auto it = missing.begin(); it != missing.end();)
+          {
+            auto const end = it + std::min<std::ptrdiff_t>(
+              paxos.transfer_batch(), missing.end() - it);
+            batches.emplace_back(it, end);
+            it = end;
+          }
+          auto unsupported = false;
+          auto window = elle::reactor::Semaphore(paxos.transfer_window());
+          elle::With<elle::reactor::Scope>() <<
+            [&] (elle::reactor::Scope& scope)
+            {
+              for (auto& batch: batches)
+              {
+                while (!window.acquire())
+                  elle::reactor::wait(window);
+                if (unsupported)
+                {
+                  window.release();
+                  break;
+                }
+                // Read the batch while the previous ones are in flight.
+                auto data = std::make_shared<std::vector<elle::Buffer>>();
+                auto digests = std::vector<elle::Buffer>{};
+                for (auto const& address: batch)
+                  try
+                  {
+                    data->emplace_back(this->storage()->get(address));
+                    digests.emplace_back(transfer_digest(data->back()));
+                  }
+                  catch (silo::MissingKey const&)
+                  {
+                    ELLE_DEBUG("%f was deleted in the meantime", address);
+                  }
+                scope.run_background(
+                  elle::print("{}: transfer to {}", this, node),
+                  [&, data, digests = std::move(digests)]
+                  {
+                    elle::SafeFinally release([&] { window.release(); });
+                    try
+                    {
+                      if (auto acked = peer->store_batch(*data, digests))
+                      {
+                        ++paxos._transfer_batches;
+                        paxos._transferred_blocks += acked->size();
+                        paxos._transfer_rejected += data->size() - acked->size();
+                        for (auto const& d: *data)
+                          paxos._transferred_bytes += d.size();
+                        stored.insert(stored.end(), acked->begin(), acked->end());
+                        transfer->acknowledged.insert(
+                          acked->begin(), acked->end());
+                      }
+                      else
+                        unsupported = true;
+                    }
+                    catch (elle::Error const& e)
+                    {
+                      ELLE_TRACE("batch transfer to %f failed: %s", node, e);
+                    }
+                  });
+              }
+              elle::reactor::wait(scope);
+            };
+          if (unsupported)
+            return;
+          this->_transfer_commit(node, stored);
+          auto const transferred =
+            std::unordered_set<Address>(stored.begin(), stored.end());
+          for (auto it = targets.begin(); it != targets.end();)
+            if (elle::contains(transferred, it->address))
+              it = targets.erase(it);
+            else
+              ++it;
+          for (auto const& address: stored)
+            this->_rebalanced(address);
+        }
+
+        void
+        Paxos::LocalPeer::_transfer_commit(Address node,
+                                           std::vector<Address> const& blocks)
+        {
+          ELLE_LOG_COMPONENT(
+            "memo.model.doughnut.consensus.Paxos.rebalance");
+          ELLE_TRACE_SCOPE("%s: commit quorums of %s blocks transferred to %f",
+                           this, blocks.size(), node);
+          // Batches of new quorums, by member.
+          auto commits = std::unordered_map<Address, std::vector<BlockQuorums>>{};
+          for (auto const& address: blocks)
+            if (auto repartition = elle::find(this->_quorums, address))
+            {
+              auto quorum = repartition->quorum;
+              quorum.insert(node);
+              for (auto const& member: quorum)
+              {
+                auto& batches = commits[member];
+                if (batches.empty() ||
+                    signed(batches.back().size()) >=
+                    this->_paxos.transfer_batch())
+                  batches.emplace_back();
+                batches.back().emplace(address, quorum);
+              }
+            }
+          elle::reactor::for_each_parallel(
+            commits,
+            [&] (std::pair<Address const, std::vector<BlockQuorums>>& commit)
+            {
+              try
+              {
+                auto const peer = commit.first == this->id()
+                  ? nullptr
+                  : to_paxos_peer(
+                    this->doughnut().overlay()->lookup_node(commit.first));
+                for (auto const& batch: commit.second)
+                  if (!peer)
+                    this->confirm_batch(batch);
+                  else if (!peer->confirm_batch(batch))
+                    for (auto const& q: batch)
+                      peer->confirm(q.second, q.first, PaxosClient::Proposal());
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_TRACE("unable to commit quorums on %f: %s",
+                           commit.first, e);
+              }
+            },
+            elle::print("{}: commit transfer", this));
         }
 
         static
@@ -1744,6 +3215,7 @@ namespace memo
                 peers.emplace_back(
                   std::make_unique<PaxosPeer>(
                     wpeer, b->address(), boost::none, mode == STORE_INSERT));
+                peers.back()->paxos(this);
               }
               else
                 ELLE_WARN("%s: peer was deleted while storing", this);
@@ -1785,6 +3257,7 @@ namespace memo
                     {
                       auto block =
                         chosen->get<std::shared_ptr<blocks::Block>>();
+                      Details::_delta_base(*this, block);
                       if (auto* mb = dynamic_cast<blocks::MutableBlock*>(block.get()))
                         mb->seal_version(chosen.proposal().version + 1);
                       if (auto* mb = dynamic_cast<blocks::MutableBlock*>(b.get()))
@@ -1796,7 +3269,10 @@ namespace memo
                     }
                   }
                   else
+                  {
+                    Details::_delta_base(*this, b);
                     break;
+                  }
                 }
               }
               catch (PaxosServer::WrongQuorum const& e)
@@ -1806,7 +3282,10 @@ namespace memo
                   this->doughnut(), e.expected(), b->address());
                 peers_id.clear();
                 for (auto const& peer: peers)
+                {
                   peers_id.insert(static_cast<PaxosPeer&>(*peer).id());
+                  peer->paxos(this);
+                }
                 continue;
               }
               break;
@@ -1897,6 +3376,98 @@ namespace memo
             *this, address, std::move(peers), local_version);
         }
 
+        /*--------------.
+        | Subscriptions |
+        `--------------*/
+
+        namespace
+        {
+          using Owners = std::unordered_map<
+            Address,
+            std::pair<std::shared_ptr<Paxos::Peer>, std::vector<Address>>>;
+
+          Owners
+          owners(Paxos& paxos, std::vector<Address> const& addresses)
+          {
+            auto res = Owners{};
+            try
+            {
+              for (auto r: paxos.doughnut().overlay()->lookup(
+                     addresses, paxos.factor()))
+                if (auto peer =
+                    std::dynamic_pointer_cast<Paxos::Peer>(r.second.lock()))
+                {
+                  auto& owner = res[peer->id()];
+                  owner.first = std::move(peer);
+                  owner.second.emplace_back(r.first);
+                }
+            }
+            catch (elle::Error const& e)
+            {
+              ELLE_TRACE("%s: unable to lookup owners: %s", paxos, e);
+            }
+            return res;
+          }
+        }
+
+        std::vector<Address>
+        Paxos::subscribe(Versions const& versions)
+        {
+          ELLE_TRACE_SCOPE("%s: subscribe to %s addresses",
+                           this, versions.size());
+          auto peers = owners(
+            *this,
+            elle::make_vector(versions,
+                              [] (Versions::value_type const& v)
+                              {
+                                return v.first;
+                              }));
+          auto subscribed = std::unordered_set<Address>{};
+          elle::reactor::for_each_parallel(
+            peers,
+            [&] (Owners::value_type& owner)
+            {
+              auto owned = Versions{};
+              for (auto const& a: owner.second.second)
+                owned.emplace(a, versions.at(a));
+              try
+              {
+                if (owner.second.first->subscribe(owned))
+                  for (auto const& a: owner.second.second)
+                    subscribed.emplace(a);
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_TRACE("%s: unable to subscribe on %f: %s",
+                           this, owner.first, e);
+              }
+            },
+            elle::print("{}: subscribe", this));
+          return {subscribed.begin(), subscribed.end()};
+        }
+
+        void
+        Paxos::unsubscribe(std::vector<Address> const& addresses)
+        {
+          ELLE_TRACE_SCOPE("%s: unsubscribe from %s addresses",
+                           this, addresses.size());
+          elle::reactor::for_each_parallel(
+            owners(*this, addresses),
+            [&] (Owners::value_type& owner)
+            {
+              try
+              {
+                owner.second.first->unsubscribe(owner.second.second);
+              }
+              catch (elle::Error const& e)
+              {
+                ELLE_TRACE("%s: unable to unsubscribe on %f: %s",
+                           this, owner.first, e);
+              }
+            },
+            elle::print("{}: unsubscribe", this));
+        }
+
         auto
         Paxos::_client(Address const& address)
           -> PaxosClient
@@ -2230,6 +3801,31 @@ namespace memo
           return {
             {"type", "paxos"},
             {"node_timeout", elle::sprintf("%s", this->node_timeout())},
+            {"delta", {
+                {"enabled", this->_delta},
+                {"accepts", this->_delta_accepts},
+                {"fallbacks", this->_delta_fallbacks},
+                {"bytes_saved", this->_delta_bytes_saved},
+              }},
+            {"hedged_fetches", this->hedged_fetches()},
+            {"transfer", {
+                {"batch", this->_transfer_batch},
+                {"window", this->_transfer_window},
+                {"batches", this->_transfer_batches},
+                {"blocks", this->_transferred_blocks},
+                {"bytes", this->_transferred_bytes},
+                {"rejected", this->_transfer_rejected},
+                {"full_redundancies", this->_full_redundancies},
+                {"time_to_full_redundancy",
+                 elle::sprintf("%s", this->_full_redundancy_time)},
+              }},
+            {"anti_entropy", {
+                {"interval", elle::sprintf("%s", this->_anti_entropy_interval)},
+                {"rounds", this->_anti_entropy_rounds},
+                {"compared", this->_anti_entropy_compared},
+                {"differing", this->_anti_entropy_differing},
+                {"repaired", this->_anti_entropy_repaired},
+              }},
           };
         }
 
@@ -4,6 +4,7 @@
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
 
 #include <elle/Error.hh>
 #include <elle/athena/paxos/Client.hh>
@@ -13,6 +14,7 @@
 
 #include <memo/model/doughnut/Consensus.hh>
 #include <memo/model/doughnut/Local.hh>
+#include <memo/model/doughnut/MerkleTree.hh>
 #include <memo/model/doughnut/Remote.hh>
 
 namespace memo
@@ -35,7 +37,18 @@ namespace memo
         ELLE_DAS_SYMBOL(node);
         ELLE_DAS_SYMBOL(node_timeout);
 
+        /// Encode `target` as copies from `base` and literal insertions.
+        elle::Buffer
+        delta_encode(elle::ConstWeakBuffer base, elle::ConstWeakBuffer target);
+        /// Decode `delta` against `base`.
+        ///
+        /// @throws elle::Error if `delta` is invalid or expands past
+        ///         `base.size() + delta.size()` bytes.
+        elle::Buffer
+        delta_apply(elle::ConstWeakBuffer base, elle::ConstWeakBuffer delta);
+
         struct BlockOrPaxos;
+        class PaxosPeer;
 
         class Paxos
           : public Consensus
@@ -71,6 +84,8 @@ namespace memo
           ELLE_ATTRIBUTE_R(bool, rebalance_auto_expand);
           ELLE_ATTRIBUTE_R(bool, rebalance_inspect);
           ELLE_ATTRIBUTE_R(Duration, node_timeout);
+          /// Whether to send mutable block updates as deltas.
+          ELLE_ATTRIBUTE_R(bool, delta);
 
         /*-------.
         | Blocks |
@@ -126,6 +141,13 @@ namespace memo
             = std::pair<boost::optional<PaxosClient::Accepted>,
                         std::shared_ptr<elle::Error>>;
           using GetMultiResult = std::unordered_map<Address, AcceptedOrError>;
+          /// New versions of blocks, none if removed.
+          using Invalidations
+            = std::unordered_map<Address, boost::optional<int>>;
+          /// Versions of blocks, 0 for immutable ones.
+          using Versions = std::unordered_map<Address, int>;
+          using BlockQuorums =
+            std::unordered_map<Address, PaxosServer::Quorum>;
 
         /*------------.
         | Paxos::Peer |
@@ -149,6 +171,20 @@ namespace memo
                    Address address,
                    PaxosClient::Proposal const& p,
                    Value const& value) = 0;
+            /// Accept a value given as a binary delta against the chosen
+            /// value at `base_version`, whose serialization hashes to
+            /// `base_digest`.
+            ///
+            /// @return none if the chosen value differs from the base, in
+            ///         which case the full value must be sent.
+            virtual
+            boost::optional<PaxosClient::Proposal>
+            accept_delta(PaxosServer::Quorum const& peers,
+                         Address address,
+                         PaxosClient::Proposal const& p,
+                         int base_version,
+                         elle::Buffer const& base_digest,
+                         elle::Buffer const& delta) = 0;
             virtual
             void
             confirm(PaxosServer::Quorum const& peers,
@@ -167,6 +203,49 @@ namespace memo
             propagate(PaxosServer::Quorum  q,
                       std::shared_ptr<blocks::Block> block,
                       PaxosClient::Proposal p) = 0;
+            /// Get notified of changes to `versions` addresses through
+            /// Paxos::invalidated, once per subscription.  Addresses already
+            /// past the given version, -1 for missing blocks, are notified
+            /// right away.
+            ///
+            /// @return whether the peer supports subscriptions.
+            virtual
+            bool
+            subscribe(Versions const& versions);
+            virtual
+            void
+            unsubscribe(std::vector<Address> const& addresses);
+            /// Hashes of the nodes at `indexes` of `level` of the tree of
+            /// blocks this peer shares a quorum with `node` on.
+            ///
+            /// @return none if the peer does not support anti-entropy.
+            virtual
+            boost::optional<std::vector<uint64_t>>
+            merkle_hashes(Address node,
+                          int level,
+                          std::vector<int> const& indexes);
+            /// Versions of the blocks this peer shares a quorum with `node`
+            /// on, in the `leaves` ranges.
+            ///
+            /// @return none if the peer does not support anti-entropy.
+            virtual
+            boost::optional<Versions>
+            merkle_entries(Address node, std::vector<int> const& leaves);
+            /// Store serialized immutable blocks in bulk, each checked
+            /// against its digest.
+            ///
+            /// @return the addresses now held, none if the peer does not
+            ///         support bulk transfers.
+            virtual
+            boost::optional<std::vector<Address>>
+            store_batch(std::vector<elle::Buffer> const& blocks,
+                        std::vector<elle::Buffer> const& digests);
+            /// Record the quorums of immutable blocks in bulk.
+            ///
+            /// @return whether the peer supports bulk transfers.
+            virtual
+            bool
+            confirm_batch(BlockQuorums const& quorums);
           };
 
         /*------------------.
@@ -184,6 +263,10 @@ namespace memo
               : doughnut::Peer(dht, connection->location().id())
               , Peer(dht, connection->location().id())
               , Super(dht, std::move(connection))
+              , _delta_unsupported(false)
+              , _subscribe_unsupported(false)
+              , _merkle_unsupported(false)
+              , _batch_unsupported(false)
             {}
             PaxosServer::Response
             propose(PaxosServer::Quorum const& peers,
@@ -195,6 +278,13 @@ namespace memo
                    Address address,
                    PaxosClient::Proposal const& p,
                    Value const& value) override;
+            boost::optional<PaxosClient::Proposal>
+            accept_delta(PaxosServer::Quorum const& peers,
+                         Address address,
+                         PaxosClient::Proposal const& p,
+                         int base_version,
+                         elle::Buffer const& base_digest,
+                         elle::Buffer const& delta) override;
             void
             confirm(PaxosServer::Quorum const& peers,
                     Address address,
@@ -211,6 +301,35 @@ namespace memo
                       PaxosClient::Proposal p) override;
             void
             store(blocks::Block const& block, StoreMode mode) override;
+            bool
+            subscribe(Versions const& versions) override;
+            void
+            unsubscribe(std::vector<Address> const& addresses) override;
+            boost::optional<std::vector<uint64_t>>
+            merkle_hashes(Address node,
+                          int level,
+                          std::vector<int> const& indexes) override;
+            boost::optional<Versions>
+            merkle_entries(Address node,
+                           std::vector<int> const& leaves) override;
+            boost::optional<std::vector<Address>>
+            store_batch(std::vector<elle::Buffer> const& blocks,
+                        std::vector<elle::Buffer> const& digests) override;
+            bool
+            confirm_batch(BlockQuorums const& quorums) override;
+          private:
+            /// Whether the peer predates delta accepts.
+            ELLE_ATTRIBUTE(bool, delta_unsupported);
+            /// Whether the peer predates subscriptions.
+            ELLE_ATTRIBUTE(bool, subscribe_unsupported);
+            /// Whether the peer predates anti-entropy.
+            ELLE_ATTRIBUTE(bool, merkle_unsupported);
+            /// Whether the peer predates bulk transfers.
+            ELLE_ATTRIBUTE(bool, batch_unsupported);
+            /// Addresses subscribed to, invalidated upon disconnection.
+            ELLE_ATTRIBUTE(std::unordered_set<Address>, subscribed);
+            ELLE_ATTRIBUTE(boost::signals2::scoped_connection,
+                           subscribed_disconnection);
           };
 
         /*-----------------.
@@ -273,6 +392,13 @@ namespace memo
                    Address address,
                    PaxosClient::Proposal const& p,
                    Value const& value) override;
+            boost::optional<PaxosClient::Proposal>
+            accept_delta(PaxosServer::Quorum const& peers,
+                         Address address,
+                         PaxosClient::Proposal const& p,
+                         int base_version,
+                         elle::Buffer const& base_digest,
+                         elle::Buffer const& delta) override;
             void
             confirm(PaxosServer::Quorum const& peers,
                     Address address,
@@ -292,6 +418,22 @@ namespace memo
             store(blocks::Block const& block, StoreMode mode) override;
             void
             remove(Address address, blocks::RemoveSignature rs) override;
+            bool
+            subscribe(Versions const& versions) override;
+            void
+            unsubscribe(std::vector<Address> const& addresses) override;
+            boost::optional<std::vector<uint64_t>>
+            merkle_hashes(Address node,
+                          int level,
+                          std::vector<int> const& indexes) override;
+            boost::optional<Versions>
+            merkle_entries(Address node,
+                           std::vector<int> const& leaves) override;
+            boost::optional<std::vector<Address>>
+            store_batch(std::vector<elle::Buffer> const& blocks,
+                        std::vector<elle::Buffer> const& digests) override;
+            bool
+            confirm_batch(BlockQuorums const& quorums) override;
             struct Decision
             {
               Decision(PaxosServer paxos);
@@ -345,7 +487,13 @@ namespace memo
             std::shared_ptr<Decision>
             _load_paxos(Address address, Decision decision);
             void
-            _cache(Address address, bool immutable, Quorum quorum);
+            _cache(Address address,
+                   bool immutable,
+                   Quorum quorum,
+                   int version = 0,
+                   bool tracked = true);
+            void
+            _uncache(Address address);
             void
             _discovered(Address id);
             void
@@ -373,10 +521,17 @@ namespace memo
             {
               BlockRepartition(Address address,
                                bool immubable,
-                               PaxosServer::Quorum quorum);
+                               PaxosServer::Quorum quorum,
+                               int version,
+                               bool tracked);
               Address address;
               bool immutable;
               PaxosServer::Quorum quorum;
+              /// Paxos version, 0 for immutable blocks.
+              int version;
+              /// Whether the quorum was stored or confirmed, as opposed to
+              /// looked up, and thus tracked by anti-entropy.
+              bool tracked;
               int
               replication_factor() const;
               struct HashByAddress;
@@ -436,10 +591,195 @@ namespace memo
             using NodeTimeouts =
               std::unordered_map<Address, elle::reactor::AsioTimer>;
             ELLE_ATTRIBUTE_R(NodeTimeouts, node_timeouts);
+
+          /*--------------.
+          | Subscriptions |
+          `--------------*/
+          private:
+            void
+            _subscribe(Connection& connection,
+                       std::vector<Address> const& addresses,
+                       bool subscribe);
+            /// The version of the mutable block at `address`, if stored here
+            /// and newer than `version`.  Any stored block is newer than -1.
+            boost::optional<int>
+            _newer(Address address, int version);
+            /// Notify subscribers `address` changed to `version`.
+            void
+            _notify(Address address, boost::optional<int> version);
+            /// Notify `connection` of `invalidations` only.
+            void
+            _notify(Connection& connection, Invalidations invalidations);
+            void
+            _notify_start();
+            void
+            _notify_loop();
+            using Subscriptions = std::unordered_map<
+              Address, std::vector<std::weak_ptr<Connection>>>;
+            ELLE_ATTRIBUTE(Subscriptions, subscriptions);
+            /// Subscriptions from this node.
+            ELLE_ATTRIBUTE(std::unordered_set<Address>, local_subscriptions);
+            struct Notification
+            {
+              std::weak_ptr<Connection> connection;
+              Invalidations invalidations;
+            };
+            /// Pending notifications, by connection.
+            ELLE_ATTRIBUTE((std::unordered_map<Connection*, Notification>),
+                           notifications);
+            ELLE_ATTRIBUTE(elle::reactor::Barrier, notify_barrier);
+            ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr, notify_thread);
+
+          /*-------------.
+          | Anti-entropy |
+          `-------------*/
+          public:
+            /// Compare the blocks shared with every other quorum member and
+            /// repair the ones they lack or hold an older version of.
+            ///
+            /// @return the number of blocks repaired.
+            int
+            anti_entropy();
+            /// Compare and repair the blocks shared with `node`.
+            int
+            anti_entropy(Address node);
+          private:
+            /// Register the quorums of every stored block in the trees.
+            void
+            _merkle_build();
+            /// Throw unless the trees are built, starting to build them.
+            void
+            _merkle_require();
+            void
+            _merkle_update(BlockRepartition const& repartition, bool add);
+            /// Versions of the blocks shared with `node` in `leaves`.
+            Versions
+            _merkle_entries(Address node,
+                            std::unordered_set<int> const& leaves) const;
+            /// Push `address` to `peer`, which lacks it or lags behind, if
+            /// another member of its quorum vouches for it.
+            ///
+            /// @return whether the peer was repaired.
+            bool
+            _merkle_repair(Paxos::Peer& peer, Address address);
+            void
+            _anti_entropy_loop();
+            /// Trees of the blocks shared with each other node.
+            ELLE_ATTRIBUTE_R((std::unordered_map<Address, MerkleTree>),
+                             merkle_trees);
+            /// Whether the trees hold every stored block.
+            ELLE_ATTRIBUTE_R(bool, merkle_ready);
+            ELLE_ATTRIBUTE(elle::reactor::Thread::unique_ptr,
+                           anti_entropy_thread);
+
+          /*----------.
+          | Transfers |
+          `----------*/
+          private:
+            using Repartitions =
+              std::unordered_set<BlockRepartition,
+                                 BlockRepartition::HashByAddress>;
+            /// Stream the immutable blocks of `targets` to the newly
+            /// discovered `node` in batches, then commit their quorums in
+            /// batches.  Transferred blocks are removed from `targets`.
+            void
+            _transfer(Address node, Repartitions& targets);
+            /// Send the quorums of `blocks`, extended with `node`, to their
+            /// members.
+            void
+            _transfer_commit(Address node, std::vector<Address> const& blocks);
+            struct Transfer
+            {
+              elle::Time discovered;
+              /// Blocks the node acknowledged since it was last discovered,
+              /// whose quorums may remain to be committed.
+              std::unordered_set<Address> acknowledged;
+            };
+            /// Transfers to newly discovered nodes, until they hold their
+            /// share of blocks.
+            ELLE_ATTRIBUTE((std::unordered_map<Address,
+                                               std::shared_ptr<Transfer>>),
+                           transfers);
+          };
+
+        /*------.
+        | Delta |
+        `------*/
+        private:
+          /// Latest chosen value of a mutable block.
+          ///
+          /// It is only serialized, as on peers, and hashed once an update
+          /// is actually sent against it.
+          struct DeltaBase
+          {
+            Address address;
+            int version;
+            std::shared_ptr<blocks::Block> block;
+            mutable boost::optional<elle::Buffer> data;
+            mutable boost::optional<elle::Buffer> digest;
           };
+          using DeltaBases = bmi::multi_index_container<
+            DeltaBase,
+            bmi::indexed_by<
+              bmi::hashed_unique<
+                bmi::member<DeltaBase, Address, &DeltaBase::address>>,
+              bmi::sequenced<>>>;
+          ELLE_ATTRIBUTE(DeltaBases, delta_bases);
+          ELLE_ATTRIBUTE(int, delta_bases_size);
+          ELLE_ATTRIBUTE_R(int64_t, delta_accepts);
+          ELLE_ATTRIBUTE_R(int64_t, delta_fallbacks);
+          ELLE_ATTRIBUTE_R(int64_t, delta_bytes_saved);
 
-          using Transfers = std::unordered_map<Address, int>;
-          ELLE_ATTRIBUTE(Transfers, transfers);
+        /*-------------.
+        | Anti-entropy |
+        `-------------*/
+        public:
+          /// Delay between anti-entropy rounds, none if disabled.
+          ELLE_ATTRIBUTE_R(elle::DurationOpt, anti_entropy_interval);
+          ELLE_ATTRIBUTE_R(int64_t, anti_entropy_rounds);
+          /// Tree nodes compared with peers.
+          ELLE_ATTRIBUTE_R(int64_t, anti_entropy_compared);
+          /// Leaf ranges found to differ.
+          ELLE_ATTRIBUTE_R(int64_t, anti_entropy_differing);
+          ELLE_ATTRIBUTE_R(int64_t, anti_entropy_repaired);
+
+        /*----------.
+        | Transfers |
+        `----------*/
+        public:
+          /// Number of blocks per bulk transfer batch.
+          ELLE_ATTRIBUTE_R(int, transfer_batch);
+          /// Number of batches in flight.
+          ELLE_ATTRIBUTE_R(int, transfer_window);
+          ELLE_ATTRIBUTE_R(int64_t, transfer_batches);
+          ELLE_ATTRIBUTE_R(int64_t, transferred_blocks);
+          ELLE_ATTRIBUTE_R(int64_t, transferred_bytes);
+          /// Blocks the receiver refused, left to individual transfers.
+          ELLE_ATTRIBUTE_R(int64_t, transfer_rejected);
+          /// Number of new nodes brought to full redundancy.
+          ELLE_ATTRIBUTE_R(int64_t, full_redundancies);
+          /// Delay between the discovery of the last new node and its
+          /// holding all the blocks it should.
+          ELLE_ATTRIBUTE_R(boost::optional<elle::Duration>,
+                           full_redundancy_time);
+
+        /*--------------.
+        | Subscriptions |
+        `--------------*/
+        public:
+          /// Ask the owners of `versions` addresses to notify their changes
+          /// past the given versions.
+          ///
+          /// @return the addresses at least one owner will notify changes of.
+          std::vector<Address>
+          subscribe(Versions const& versions);
+          void
+          unsubscribe(std::vector<Address> const& addresses);
+          /// Emitted when a subscribed block changes, with its new version or
+          /// none if unknown.
+          ELLE_ATTRIBUTE_RX(
+            boost::signals2::signal<void (Address, boost::optional<int>)>,
+            invalidated);
 
         /*-----.
         | Stat |
@@ -489,6 +829,7 @@ namespace memo
         private:
           struct Details;
           friend struct Details;
+          friend class PaxosPeer;
         };
 
         struct BlockOrPaxos
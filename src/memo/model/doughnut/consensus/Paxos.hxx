@@ -30,6 +30,7 @@ namespace memo
           , _rebalanced()
           , _rebalance_thread(elle::sprintf("%s: rebalance", this),
                               [this] () { this->_rebalance(); })
+          , _merkle_ready(false)
         {}
 
         static constexpr auto default_node_timeout = 10min;
@@ -0,0 +1,389 @@
+#include <memo/model/doughnut/consensus/ReedSolomon.hh>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined __x86_64__ || defined __i386__
+# include <immintrin.h>
+# define MEMO_REED_SOLOMON_X86 1
+#endif
+
+#include <elle/assert.hh>
+#include <elle/bench.hh>
+#include <elle/err.hh>
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.ReedSolomon");
+
+using namespace std::literals;
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        namespace
+        {
+          /*---------.
+          | GF(2^8)  |
+          `---------*/
+
+          struct Field
+          {
+            Field()
+            {
+              // Generator 2 over x^8 + x^4 + x^3 + x^2 + 1.
+              int x = 1;
+              for (int i = 0; i < 255; ++i)
+              {
+                this->exp[i] = this->exp[i + 255] = x;
+                this->log[x] = i;
+                x <<= 1;
+                if (x & 0x100)
+                  x ^= 0x11d;
+              }
+              this->log[0] = 0;
+            }
+
+            uint8_t
+            mul(uint8_t a, uint8_t b) const
+            {
+              if (!a || !b)
+                return 0;
+              return this->exp[this->log[a] + this->log[b]];
+            }
+
+            uint8_t
+            inv(uint8_t a) const
+            {
+              ELLE_ASSERT(a);
+              return this->exp[255 - this->log[a]];
+            }
+
+            uint8_t exp[510];
+            int log[256];
+          };
+
+          Field const&
+          field()
+          {
+            static auto const res = Field();
+            return res;
+          }
+
+          /*---------.
+          | Kernels  |
+          `---------*/
+
+          // Multiplying a region by a constant is done with two 16 entries
+          // tables, one for each nibble of the source bytes, which maps
+          // directly onto byte shuffles.
+          using MulAdd = void (*)(uint8_t const* low,
+                                  uint8_t const* high,
+                                  uint8_t const* src,
+                                  uint8_t* dst,
+                                  std::size_t size);
+
+          void
+          mul_add_scalar(uint8_t const* low,
+                         uint8_t const* high,
+                         uint8_t const* src,
+                         uint8_t* dst,
+                         std::size_t size)
+          {
+            for (std::size_t i = 0; i < size; ++i)
+              dst[i] ^= low[src[i] & 0x0f] ^ high[src[i] >> 4];
+          }
+
+#ifdef MEMO_REED_SOLOMON_X86
+          __attribute__((target("ssse3")))
+          void
+          mul_add_ssse3(uint8_t const* low,
+                        uint8_t const* high,
+                        uint8_t const* src,
+                        uint8_t* dst,
+                        std::size_t size)
+          {
+            auto const tl = _mm_loadu_si128((__m128i const*)low);
+            auto const th = _mm_loadu_si128((__m128i const*)high);
+            auto const mask = _mm_set1_epi8(0x0f);
+            std::size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+            {
+              auto const s = _mm_loadu_si128((__m128i const*)(src + i));
+              auto const l = _mm_shuffle_epi8(tl, _mm_and_si128(s, mask));
+              auto const h = _mm_shuffle_epi8(
+                th, _mm_and_si128(_mm_srli_epi64(s, 4), mask));
+              auto const d = _mm_loadu_si128((__m128i const*)(dst + i));
+              _mm_storeu_si128((__m128i*)(dst + i),
+                               _mm_xor_si128(d, _mm_xor_si128(l, h)));
+            }
+            mul_add_scalar(low, high, src + i, dst + i, size - i);
+          }
+
+          __attribute__((target("avx2")))
+          void
+          mul_add_avx2(uint8_t const* low,
+                       uint8_t const* high,
+                       uint8_t const* src,
+                       uint8_t* dst,
+                       std::size_t size)
+          {
+            auto const tl = _mm256_broadcastsi128_si256(
+              _mm_loadu_si128((__m128i const*)low));
+            auto const th = _mm256_broadcastsi128_si256(
+              _mm_loadu_si128((__m128i const*)high));
+            auto const mask = _mm256_set1_epi8(0x0f);
+            std::size_t i = 0;
+            for (; i + 32 <= size; i += 32)
+            {
+              auto const s = _mm256_loadu_si256((__m256i const*)(src + i));
+              auto const l = _mm256_shuffle_epi8(tl, _mm256_and_si256(s, mask));
+              auto const h = _mm256_shuffle_epi8(
+                th, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask));
+              auto const d = _mm256_loadu_si256((__m256i const*)(dst + i));
+              _mm256_storeu_si256((__m256i*)(dst + i),
+                                  _mm256_xor_si256(d, _mm256_xor_si256(l, h)));
+            }
+            mul_add_scalar(low, high, src + i, dst + i, size - i);
+          }
+#endif
+
+          MulAdd
+          select_mul_add()
+          {
+#ifdef MEMO_REED_SOLOMON_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+              ELLE_TRACE("use AVX2 codec");
+              return &mul_add_avx2;
+            }
+            if (__builtin_cpu_supports("ssse3"))
+            {
+              ELLE_TRACE("use SSSE3 codec");
+              return &mul_add_ssse3;
+            }
+#endif
+            ELLE_TRACE("use scalar codec");
+            return &mul_add_scalar;
+          }
+
+          /// dst ^= c * src
+          void
+          mul_add(uint8_t c, uint8_t const* src, uint8_t* dst, std::size_t size)
+          {
+            static auto const impl = select_mul_add();
+            if (!c)
+              return;
+            auto const& gf = field();
+            uint8_t low[16];
+            uint8_t high[16];
+            for (int x = 0; x < 16; ++x)
+            {
+              low[x] = gf.mul(c, x);
+              high[x] = gf.mul(c, x << 4);
+            }
+            impl(low, high, src, dst, size);
+          }
+
+          /// Gauss-Jordan inversion of the `n x n` matrix `m`.
+          std::vector<uint8_t>
+          invert(std::vector<uint8_t> m, int n)
+          {
+            auto const& gf = field();
+            auto res = std::vector<uint8_t>(n * n, 0);
+            for (int i = 0; i < n; ++i)
+              res[i * n + i] = 1;
+            for (int col = 0; col < n; ++col)
+            {
+              int pivot = col;
+              while (pivot < n && !m[pivot * n + col])
+                ++pivot;
+              if (pivot == n)
+                elle::err("singular erasure decoding matrix");
+              if (pivot != col)
+                for (int j = 0; j < n; ++j)
+                {
+                  std::swap(m[pivot * n + j], m[col * n + j]);
+                  std::swap(res[pivot * n + j], res[col * n + j]);
+                }
+              auto const scale = gf.inv(m[col * n + col]);
+              for (int j = 0; j < n; ++j)
+              {
+                m[col * n + j] = gf.mul(m[col * n + j], scale);
+                res[col * n + j] = gf.mul(res[col * n + j], scale);
+              }
+              for (int row = 0; row < n; ++row)
+                if (row != col)
+                  if (auto const f = m[row * n + col])
+                    for (int j = 0; j < n; ++j)
+                    {
+                      m[row * n + j] ^= gf.mul(f, m[col * n + j]);
+                      res[row * n + j] ^= gf.mul(f, res[col * n + j]);
+                    }
+            }
+            return res;
+          }
+        }
+
+        /*-------------.
+        | Construction |
+        `-------------*/
+
+        ReedSolomon::ReedSolomon(int data, int parity)
+          : _data(data)
+          , _parity(parity)
+          , _matrix((data + parity) * data, 0)
+        {
+          if (data < 1 || parity < 0)
+            elle::err("invalid erasure coding %s+%s", data, parity);
+          if (data + parity > 256)
+            elle::err("erasure coding %s+%s exceeds 256 fragments",
+                      data, parity);
+          auto const& gf = field();
+          for (int i = 0; i < data; ++i)
+            this->_matrix[i * data + i] = 1;
+          // Cauchy rows 1 / (x_i + y_j), with x_i = data + i and y_j = j
+          // never equal.
+          for (int i = 0; i < parity; ++i)
+            for (int j = 0; j < data; ++j)
+              this->_matrix[(data + i) * data + j] = gf.inv((data + i) ^ j);
+        }
+
+        std::size_t
+        ReedSolomon::fragment_size(std::size_t size) const
+        {
+          return std::max<std::size_t>(1, (size + this->_data - 1) / this->_data);
+        }
+
+        /*---------.
+        | Encoding |
+        `---------*/
+
+        std::vector<elle::Buffer>
+        ReedSolomon::encode(elle::ConstWeakBuffer payload) const
+        {
+          static auto bench = elle::Bench<>{"bench.erasure.encode", 10000s};
+          auto bs = bench.scoped();
+          auto const size = this->fragment_size(payload.size());
+          auto res = std::vector<elle::Buffer>{};
+          res.reserve(this->_data + this->_parity);
+          for (int i = 0; i < this->_data; ++i)
+          {
+            auto const start = std::min(payload.size(), i * size);
+            auto const count = std::min(payload.size() - start, size);
+            auto fragment = elle::Buffer(size);
+            if (count)
+              std::memcpy(fragment.mutable_contents(),
+                          payload.contents() + start, count);
+            std::memset(fragment.mutable_contents() + count, 0, size - count);
+            res.emplace_back(std::move(fragment));
+          }
+          for (int i = 0; i < this->_parity; ++i)
+          {
+            auto fragment = elle::Buffer(size);
+            std::memset(fragment.mutable_contents(), 0, size);
+            for (int j = 0; j < this->_data; ++j)
+              mul_add(this->_matrix[(this->_data + i) * this->_data + j],
+                      res[j].contents(), fragment.mutable_contents(), size);
+            res.emplace_back(std::move(fragment));
+          }
+          return res;
+        }
+
+        /*---------.
+        | Decoding |
+        `---------*/
+
+        elle::Buffer
+        ReedSolomon::decode(Fragments const& fragments, std::size_t size) const
+        {
+          static auto bench = elle::Bench<>{"bench.erasure.decode", 10000s};
+          auto bs = bench.scoped();
+          auto const data = this->_data;
+          if (signed(fragments.size()) != data + this->_parity)
+            elle::err("expected %s fragments, got %s",
+                      data + this->_parity, fragments.size());
+          // Pick the first available fragments, data ones coming first need
+          // no computation.
+          auto rows = std::vector<int>{};
+          for (int i = 0; i < signed(fragments.size()) && signed(rows.size()) < data; ++i)
+            if (fragments[i])
+              rows.emplace_back(i);
+          if (signed(rows.size()) < data)
+            elle::err("only %s fragments out of %s required", rows.size(), data);
+          auto const fsize = fragments[rows[0]]->size();
+          for (auto r: rows)
+            if (fragments[r]->size() != fsize)
+              elle::err("fragment %s has size %s, expected %s",
+                        r, fragments[r]->size(), fsize);
+          if (fsize * data < size)
+            elle::err("fragments of size %s cannot hold %s bytes", fsize, size);
+          auto res = elle::Buffer(fsize * data);
+          auto missing = std::vector<int>{};
+          for (int j = 0; j < data; ++j)
+            if (fragments[j])
+              std::memcpy(res.mutable_contents() + j * fsize,
+                          fragments[j]->contents(), fsize);
+            else
+              missing.emplace_back(j);
+          if (!missing.empty())
+          {
+            ELLE_DEBUG("rebuild %s missing data fragments", missing.size());
+            auto sub = std::vector<uint8_t>(data * data);
+            for (int r = 0; r < data; ++r)
+              std::memcpy(&sub[r * data], &this->_matrix[rows[r] * data], data);
+            auto const inverse = invert(std::move(sub), data);
+            for (auto j: missing)
+            {
+              auto out = res.mutable_contents() + j * fsize;
+              std::memset(out, 0, fsize);
+              for (int r = 0; r < data; ++r)
+                mul_add(inverse[j * data + r],
+                        fragments[rows[r]]->contents(), out, fsize);
+            }
+          }
+          res.size(size);
+          return res;
+        }
+
+        std::vector<elle::Buffer>
+        ReedSolomon::reconstruct(Fragments const& fragments,
+                                 std::vector<int> const& indexes) const
+        {
+          auto fsize = std::size_t(0);
+          for (auto const& f: fragments)
+            if (f)
+            {
+              fsize = f->size();
+              break;
+            }
+          auto const data = this->decode(fragments, fsize * this->_data);
+          auto res = std::vector<elle::Buffer>{};
+          for (auto i: indexes)
+          {
+            if (i < 0 || i >= this->_data + this->_parity)
+              elle::err("invalid fragment index %s", i);
+            if (i < this->_data)
+              res.emplace_back(data.contents() + i * fsize, fsize);
+            else
+            {
+              auto fragment = elle::Buffer(fsize);
+              std::memset(fragment.mutable_contents(), 0, fsize);
+              for (int j = 0; j < this->_data; ++j)
+                mul_add(this->_matrix[i * this->_data + j],
+                        data.contents() + j * fsize,
+                        fragment.mutable_contents(), fsize);
+              res.emplace_back(std::move(fragment));
+            }
+          }
+          return res;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <elle/Buffer.hh>
+#include <elle/attribute.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace consensus
+      {
+        /// Systematic Reed-Solomon erasure code over GF(2^8).
+        ///
+        /// A payload is split in `data` fragments, to which `parity`
+        /// fragments are appended.  Any `data` fragments out of the
+        /// `data + parity` are enough to recover the payload.
+        class ReedSolomon
+        {
+        public:
+          /// Fragments indexed by position, missing ones being unset.
+          using Fragments = std::vector<boost::optional<elle::Buffer>>;
+          ReedSolomon(int data, int parity);
+          ELLE_ATTRIBUTE_R(int, data);
+          ELLE_ATTRIBUTE_R(int, parity);
+          /// Size of every fragment of a `size` bytes payload.
+          std::size_t
+          fragment_size(std::size_t size) const;
+          /// The `data + parity` fragments of `payload`.
+          std::vector<elle::Buffer>
+          encode(elle::ConstWeakBuffer payload) const;
+          /// The `size` bytes payload, from at least `data` fragments.
+          elle::Buffer
+          decode(Fragments const& fragments, std::size_t size) const;
+          /// The fragments at `indexes`, from at least `data` fragments.
+          std::vector<elle::Buffer>
+          reconstruct(Fragments const& fragments,
+                      std::vector<int> const& indexes) const;
+        private:
+          /// The `(data + parity) x data` encoding matrix, identity on top of
+          /// a Cauchy matrix so any square subset of its rows is invertible.
+          ELLE_ATTRIBUTE(std::vector<uint8_t>, matrix);
+        };
+      }
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#include <memo/model/doughnut/crypto.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <elle/With.hh>
+#include <elle/reactor/lockable.hh>
+#include <elle/reactor/scheduler.hh>
+#include <elle/reactor/semaphore.hh>
+#include <elle/reactor/Thread.hh>
+
+#include <memo/environ.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      namespace
+      {
+        int
+        budget()
+        {
+          static auto const res = memo::getenv(
+            "CRYPTO_THREADS",
+            std::max(1, int(std::thread::hardware_concurrency())));
+          return res;
+        }
+
+        std::atomic<int64_t> background_runs(0);
+        std::atomic<int64_t> inline_runs(0);
+      }
+
+      void
+      crypto_background(std::function<void ()> const& action)
+      {
+        auto const sched = elle::reactor::Scheduler::scheduler();
+        if (budget() <= 0 || !sched || !sched->current())
+        {
+          ++inline_runs;
+          action();
+          return;
+        }
+        static elle::reactor::Semaphore slots(budget());
+        elle::reactor::Lock lock(slots);
+        ++background_runs;
+        // `action` lives on our stack, we cannot unwind while it runs.
+        elle::With<elle::reactor::Thread::NonInterruptible>() << [&]
+        {
+          elle::reactor::background(action);
+        };
+      }
+
+      elle::json::Json
+      crypto_stats()
+      {
+        return {
+          {"budget", budget()},
+          {"background", background_runs.load()},
+          {"inline", inline_runs.load()},
+        };
+      }
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+
+#include <elle/json/json.hh>
+
+namespace memo
+{
+  namespace model
+  {
+    namespace doughnut
+    {
+      /// Run the CPU bound cryptographic `action` in the scheduler background
+      /// pool, yielding until it completes.
+      ///
+      /// At most `MEMO_CRYPTO_THREADS` actions run at once, the number of
+      /// cores by default; further callers wait for a slot.  Outside of a
+      /// reactor thread, or with a budget of 0, `action` runs inline.  As
+      /// with elle::reactor::background, `action` must not touch reactor
+      /// state.
+      void
+      crypto_background(std::function<void ()> const& action);
+      /// Budget, actions run in background and inline.
+      elle::json::Json
+      crypto_stats();
+    }
+  }
+}
@@ -1,11 +1,16 @@
 #include <memo/silo/Crypt.hh>
 
-#include <elle/cryptography/SecretKey.hh>
+#include <cstring>
+
+#include <elle/bench.hh>
+#include <elle/cryptography/hmac.hh>
 #include <elle/factory.hh>
 #include <elle/from-string.hh>
 
 #include <memo/model/Address.hh>
 
+using namespace std::literals;
+
 namespace memo
 {
   namespace silo
@@ -23,16 +28,74 @@ namespace memo
       }
     }
 
+    namespace
+    {
+      /// Version of the stored values layout.
+      ///
+      /// 1: magic, version, then AES-256-GCM nonce, code and tag, the
+      /// header and the block address being authenticated along.
+      uint8_t const version = 1;
+      char const magic[] = "mcrypt";
+      auto const header_size = sizeof (magic) - 1 + sizeof (version);
+
+      /// Data authenticated along a value: its header and address, so that
+      /// a value cannot be moved to another address.
+      elle::Buffer
+      aad(Key const& k)
+      {
+        auto res = elle::Buffer();
+        res.capacity(header_size + sizeof (Key::Value));
+        res.append(magic, sizeof (magic) - 1);
+        res.append(&version, sizeof (version));
+        res.append(k.value(), sizeof (Key::Value));
+        return res;
+      }
+
+      /// HKDF salt, distinguishing these keys from other uses of the
+      /// password.
+      std::string const hkdf_salt = "memo.silo.crypt";
+
+      /// HKDF-Expand for a single SHA-256 block: `info` and the block
+      /// counter, authenticated with the pseudo-random key.
+      elle::Buffer
+      expand(std::string const& prk, elle::ConstWeakBuffer info)
+      {
+        auto input = elle::Buffer(info);
+        input.append("\x01", 1);
+        return elle::cryptography::hmac::sign(
+          input, prk, elle::cryptography::Oneway::sha256);
+      }
+    }
+
     Crypt::Crypt(std::unique_ptr<Silo> backend,
                  std::string const& password,
                  bool salt)
       : _backend(std::move(backend))
       , _password(password)
       , _salt(salt)
-    {}
+      // HKDF-Extract.
+      , _master(elle::cryptography::hmac::sign(
+                  elle::ConstWeakBuffer(password),
+                  hkdf_salt,
+                  elle::cryptography::Oneway::sha256).string())
+    {
+      if (!salt)
+        this->_key.emplace(expand(this->_master, {}));
+    }
 
-    auto
+    elle::Buffer
     Crypt::_secret_key(Key const& k) const
+    {
+      if (this->_key)
+        return *this->_key;
+      else
+        return expand(
+          this->_master,
+          elle::ConstWeakBuffer(k.value(), sizeof(Key::Value)));
+    }
+
+    auto
+    Crypt::_legacy_key(Key const& k) const
       -> SecretKey
     {
       return _salt ? _password + elle::sprintf("%x", k) : _password;
@@ -41,14 +104,43 @@ namespace memo
     elle::Buffer
     Crypt::_get(Key k) const
     {
-      auto const enc = this->_backend->get(k);
-      return _secret_key(k).decipher(enc);
+      static auto bench = elle::Bench<>{"bench.crypt.get", 10000s};
+      auto bs = bench.scoped();
+      auto res = this->_backend->get(k);
+      if (res.size() >= header_size &&
+          std::memcmp(res.contents(), magic, sizeof (magic) - 1) == 0)
+      {
+        auto const v = res[sizeof (magic) - 1];
+        if (v != version)
+          elle::err("unknown encryption version %s for %f", int(v), k);
+        auto const key = this->_secret_key(k);
+        auto const data = aad(k);
+        return elle::cryptography::secretkey::open(
+          key,
+          data,
+          elle::ConstWeakBuffer(res.contents() + header_size,
+                                res.size() - header_size));
+      }
+      else
+        this->_legacy_key(k).decipher_in_place(res);
+      return res;
     }
 
     int
     Crypt::_set(Key k, elle::Buffer const& value, bool insert, bool update)
     {
-      return this->_backend->set(k, _secret_key(k).encipher(value), insert, update);
+      static auto bench = elle::Bench<>{"bench.crypt.set", 10000s};
+      auto bs = bench.scoped();
+      auto const key = this->_secret_key(k);
+      auto const data = aad(k);
+      auto const code =
+        elle::cryptography::secretkey::seal(key, data, value);
+      auto res = elle::Buffer();
+      res.capacity(header_size + code.size());
+      res.append(magic, sizeof (magic) - 1);
+      res.append(&version, sizeof (version));
+      res.append(code.contents(), code.size());
+      return this->_backend->set(k, res, insert, update);
     }
 
     int
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <boost/optional.hpp>
+
 #include <elle/cryptography/Cipher.hh>
+#include <elle/cryptography/SecretKey.hh>
 
 #include <memo/silo/Silo.hh>
 
@@ -8,6 +11,14 @@ namespace memo
 {
   namespace silo
   {
+    /// Encrypt blocks before handing them to a backend.
+    ///
+    /// Blocks are sealed with AES-GCM under a key derived with HKDF-SHA256
+    /// from the password, once per silo and, if salted, expanded per
+    /// address.  The key goes to the cipher as is, and the block address is
+    /// authenticated along the value.  Stored values start with a versioned
+    /// header; values without one were written by former versions and are
+    /// deciphered with the legacy password-based key.
     class Crypt
       : public Silo
     {
@@ -30,14 +41,21 @@ namespace memo
       _list() override;
 
       using SecretKey = elle::cryptography::SecretKey;
-      /// The secret key corresponding to @a k.
-      SecretKey
+      /// The AES-256 key corresponding to @a k.
+      elle::Buffer
       _secret_key(Key const& k) const;
+      /// The secret key of @a k for values written before the header.
+      SecretKey
+      _legacy_key(Key const& k) const;
 
     private:
       std::unique_ptr<Silo> _backend;
       std::string _password;
       bool _salt;
+      /// The pseudo-random key extracted from the password.
+      std::string _master;
+      /// The key of every block, if unsalted.
+      boost::optional<elle::Buffer> _key;
     };
 
     struct CryptSiloConfig
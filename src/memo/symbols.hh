@@ -6,6 +6,7 @@ namespace memo
 {
   namespace symbols
   {
+    ELLE_DAS_SYMBOL(aead);
     ELLE_DAS_SYMBOL(address);
     ELLE_DAS_SYMBOL(addresses);
     ELLE_DAS_SYMBOL(avatar_path);
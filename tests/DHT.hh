@@ -291,7 +291,8 @@ public:
       dht::connect_timeout = elle::defaulted(elle::Duration{5s}),
       dht::soft_fail_timeout = elle::defaulted(elle::Duration{20s}),
       dht::soft_fail_running = elle::defaulted(false),
-      dht::resign_on_shutdown = false
+      dht::resign_on_shutdown = false,
+      dht::key_cache_path = boost::optional<boost::filesystem::path>()
       ).call([this] (bool paxos,
                      elle::cryptography::rsa::KeyPair keys,
                      boost::optional<elle::cryptography::rsa::KeyPair> owner,
@@ -310,7 +311,8 @@ public:
                      elle::Defaulted<elle::Duration> connect_timeout,
                      elle::Defaulted<elle::Duration> soft_fail_timeout,
                      elle::Defaulted<bool> soft_fail_running,
-                     bool resign_on_shutdown)
+                     bool resign_on_shutdown,
+                     boost::optional<boost::filesystem::path> key_cache_path)
              {
                this->init(paxos,
                           keys,
@@ -330,7 +332,8 @@ public:
                           connect_timeout,
                           soft_fail_timeout,
                           soft_fail_running,
-                          resign_on_shutdown);
+                          resign_on_shutdown,
+                          std::move(key_cache_path));
               }, std::forward<Args>(args)...);
   }
 
@@ -382,7 +385,8 @@ private:
        elle::Defaulted<elle::Duration> connect_timeout,
        elle::Defaulted<elle::Duration> soft_fail_timeout,
        elle::Defaulted<bool> soft_fail_running,
-       bool resign_on_shutdown)
+       bool resign_on_shutdown,
+       boost::optional<boost::filesystem::path> key_cache_path)
   {
     auto keys =
       std::make_shared<elle::cryptography::rsa::KeyPair>(std::move(keys_));
@@ -438,7 +442,8 @@ private:
         dht::connect_timeout = connect_timeout,
         dht::soft_fail_timeout = soft_fail_timeout,
         dht::soft_fail_running = soft_fail_running,
-        dht::resign_on_shutdown = resign_on_shutdown);
+        dht::resign_on_shutdown = resign_on_shutdown,
+        dht::key_cache_path = key_cache_path);
     else
       this->dht = std::make_shared<dht::Doughnut>(
         dht::name = user_name,
@@ -455,7 +460,8 @@ private:
         dht::connect_timeout = connect_timeout,
         dht::soft_fail_timeout = soft_fail_timeout,
         dht::soft_fail_running = soft_fail_running,
-        dht::resign_on_shutdown = resign_on_shutdown);
+        dht::resign_on_shutdown = resign_on_shutdown,
+        dht::key_cache_path = key_cache_path);
   }
 };
 
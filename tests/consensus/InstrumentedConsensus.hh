@@ -3,6 +3,7 @@
 #include <boost/signals2.hpp>
 
 #include <memo/model/MissingBlock.hh>
+#include <memo/model/blocks/MutableBlock.hh>
 #include <memo/model/doughnut/Consensus.hh>
 
 class InstrumentedConsensus
@@ -35,14 +36,19 @@ protected:
   {}
 
   std::unique_ptr<memo::model::blocks::Block>
-  _fetch(Address addr, boost::optional<int>) override
+  _fetch(Address addr, boost::optional<int> local_version) override
   {
+    this->_fetched(addr);
     auto it = this->_blocks.find(addr);
     if (it == this->_blocks.end())
       throw memo::model::MissingBlock(addr);
     else
     {
-      this->_fetched(addr);
+      if (local_version)
+        if (auto mb = dynamic_cast<memo::model::blocks::MutableBlock*>(
+              it->second.get()))
+          if (mb->version() == *local_version)
+            return nullptr;
       return it->second->clone();
     }
   }
@@ -1,10 +1,16 @@
+#include <boost/filesystem/fstream.hpp>
+
 #include <elle/filesystem/TemporaryDirectory.hh>
+#include <elle/finally.hh>
 #include <elle/log.hh>
 #include <elle/memory.hh>
 #include <elle/test.hh>
 
+#include <elle/os/environ.hh>
+
 #include <elle/cryptography/rsa/KeyPair.hh>
 
+#include <elle/reactor/Barrier.hh>
 #include <elle/reactor/scheduler.hh>
 #include <elle/reactor/semaphore.hh>
 #include <elle/reactor/signal.hh>
@@ -12,7 +18,9 @@
 #include <memo/model/doughnut/Async.hh>
 #include <memo/model/doughnut/Consensus.hh>
 #include <memo/model/doughnut/Doughnut.hh>
+#include <memo/model/doughnut/Journal.hh>
 #include <memo/model/doughnut/Passport.hh>
+#include <memo/environ.hh>
 
 ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Async.test");
 
@@ -89,6 +97,46 @@ public:
   }
 };
 
+class ConcurrentConsensus
+  : public dht::consensus::Consensus
+{
+public:
+  ConcurrentConsensus(memo::model::doughnut::Doughnut& dht)
+    : dht::consensus::Consensus(dht)
+  {}
+
+  void
+  _store(std::unique_ptr<memo::model::blocks::Block> block,
+         memo::model::StoreMode,
+         std::unique_ptr<memo::model::ConflictResolver>) override
+  {
+    ++this->in_flight;
+    this->max_in_flight = std::max(this->max_in_flight, this->in_flight);
+    elle::reactor::wait(this->open);
+    --this->in_flight;
+    this->values[block->address()].emplace_back(block->data().string());
+    this->_stored.signal();
+  }
+
+  std::unique_ptr<memo::model::blocks::Block>
+  _fetch(memo::model::Address, boost::optional<int>) override
+  {
+    elle::unreachable();
+  }
+
+  void
+  _remove(memo::model::Address, memo::model::blocks::RemoveSignature) override
+  {
+    elle::unreachable();
+  }
+
+  elle::reactor::Barrier open;
+  int in_flight = 0;
+  int max_in_flight = 0;
+  std::unordered_map<memo::model::Address, std::vector<std::string>> values;
+  ELLE_ATTRIBUTE_RX(elle::reactor::Signal, stored);
+};
+
 class DummyDoughnut
   : public dht::Doughnut
 {
@@ -176,9 +224,116 @@ ELLE_TEST_SCHEDULED(fetch_disk_queued_multiple)
   }
 }
 
+// Check operations on distinct addresses are processed concurrently, in order
+// for each address.
+ELLE_TEST_SCHEDULED(concurrent)
+{
+  DummyDoughnut dht;
+  auto const addresses = std::vector<memo::model::Address>{
+    memo::model::Address::random(0), // FIXME
+    memo::model::Address::random(0), // FIXME
+    memo::model::Address::random(0), // FIXME
+  };
+  auto ccu = std::make_unique<ConcurrentConsensus>(dht);
+  auto& cc = *ccu;
+  auto&& async = dht::consensus::Async(std::move(ccu), {});
+  for (auto const& a: addresses)
+    async.store(std::make_unique<memo::model::blocks::Block>(
+                  a, elle::Buffer("v1", 2)),
+                memo::model::STORE_INSERT, nullptr);
+  for (auto const& a: addresses)
+    async.store(std::make_unique<memo::model::blocks::Block>(
+                  a, elle::Buffer("v2", 2)),
+                memo::model::STORE_UPDATE, nullptr);
+  // Each address is processed, none twice at once.
+  while (cc.in_flight < 3)
+    elle::reactor::yield();
+  // Operations in flight are not processed yet.
+  BOOST_TEST(async.stats()["async"]["in_flight"] == 3);
+  BOOST_TEST(async.stats()["async"]["processed"] == 0);
+  cc.open.open();
+  auto count = [&]
+    {
+      auto res = 0u;
+      for (auto const& s: cc.values)
+        res += s.second.size();
+      return res;
+    };
+  while (count() < 6)
+    elle::reactor::wait(cc.stored());
+  BOOST_TEST(cc.max_in_flight == 3);
+  for (auto const& a: addresses)
+    BOOST_TEST(cc.values[a] == (std::vector<std::string>{"v1", "v2"}));
+  while (async.completed_op_count() < 6)
+    elle::reactor::yield();
+  BOOST_TEST(async.stats()["async"]["processed"] == 6);
+}
+
+ELLE_TEST_SCHEDULED(journal)
+{
+  namespace fs = boost::filesystem;
+  auto const d = elle::filesystem::TemporaryDirectory{};
+  // Fit two operations per segment.
+  memo::setenv("ASYNC_JOURNAL_SEGMENT_SIZE", 64);
+  elle::SafeFinally restore_env(
+    [] { elle::os::unsetenv("MEMO_ASYNC_JOURNAL_SEGMENT_SIZE"); });
+  auto const payload = [] (int i)
+    {
+      return elle::sprintf("operation %04d", i);
+    };
+  auto const expected = [] (std::vector<int> indexes) { return indexes; };
+  {
+    auto&& journal = dht::consensus::Journal(d.path());
+    for (int i = 1; i <= 6; ++i)
+      journal.write(i, payload(i));
+    for (int i = 1; i <= 4; ++i)
+      journal.remove(i);
+    journal.sync();
+    BOOST_TEST(journal.stats()["spare_segments"] == 2);
+    ELLE_LOG("supersede operation")
+      journal.write(5, payload(50));
+    journal.write(7, payload(7));
+    BOOST_TEST(journal.recycled_segments() == 1);
+    BOOST_TEST(journal.indexes() == expected({5, 6, 7}));
+    BOOST_TEST(journal.read(5).string() == payload(50));
+  }
+  ELLE_LOG("tear the last record and add a legacy operation")
+  {
+    auto last = fs::path{};
+    for (auto const& p: fs::directory_iterator(d.path()))
+      if (p.path().filename().string().find("segment.") == 0 &&
+          (last.empty() || std::stoi(p.path().extension().string().substr(1)) >
+           std::stoi(last.extension().string().substr(1))))
+        last = p.path();
+    {
+      fs::ofstream f(last, std::ios::binary | std::ios::app);
+      f << "MJNL torn";
+    }
+    fs::ofstream f(d.path() / "8", std::ios::binary);
+    f << payload(8);
+  }
+  ELLE_LOG("reopen read only")
+  {
+    auto&& journal = dht::consensus::Journal(d.path(), true);
+    BOOST_TEST(journal.indexes() == expected({5, 6, 7, 8}));
+    BOOST_TEST(journal.read(8).string() == payload(8));
+  }
+  ELLE_LOG("reopen")
+  {
+    auto&& journal = dht::consensus::Journal(d.path());
+    BOOST_TEST(journal.indexes() == expected({5, 6, 7, 8}));
+    BOOST_TEST(!fs::exists(d.path() / "8"));
+    for (int i: {6, 7, 8})
+      BOOST_TEST(journal.read(i).string() == payload(i));
+    BOOST_TEST(journal.read(5).string() == payload(50));
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
   suite.add(BOOST_TEST_CASE(fetch_disk_queued), 0, 10);
   suite.add(BOOST_TEST_CASE(fetch_disk_queued_multiple), 0, 10);
+  suite.add(BOOST_TEST_CASE(concurrent), 0, 10);
+  suite.add(BOOST_TEST_CASE(journal), 0, 10);
 }
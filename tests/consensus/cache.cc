@@ -85,9 +85,177 @@ ELLE_TEST_SCHEDULED(disk)
   }
 }
 
+ELLE_TEST_SCHEDULED(disk_mutable)
+{
+  elle::filesystem::TemporaryDirectory tmp;
+  DummyDoughnut doughnut;
+  std::unique_ptr<memo::model::blocks::Block> okb;
+  ELLE_LOG("create and fetch OKB")
+  {
+    auto instrument = std::make_unique<InstrumentedConsensus>(doughnut);
+    okb = doughnut.make_block<memo::model::blocks::MutableBlock>(
+      elle::Buffer("data", 4));
+    okb->seal(1);
+    instrument->add(*okb);
+    dht::consensus::Cache cache(
+      std::move(instrument), boost::optional<int>(), elle::DurationOpt(),
+      elle::DurationOpt(), tmp.path());
+    BOOST_CHECK_EQUAL(cache.fetch(okb->address())->data(), "data");
+  }
+  BOOST_TEST(boost::filesystem::exists(tmp.path() / "index"));
+  ELLE_LOG("reload OKB from disk cache")
+  {
+    auto instrument = std::make_unique<InstrumentedConsensus>(doughnut);
+    auto& i = *instrument;
+    i.add(*okb);
+    dht::consensus::Cache cache(
+      std::move(instrument), boost::optional<int>(), elle::DurationOpt(),
+      elle::DurationOpt(), tmp.path());
+    auto fetched = 0;
+    i.fetched().connect([&] (memo::model::Address const&) { ++fetched; });
+    ELLE_LOG("check version on first use")
+      BOOST_CHECK_EQUAL(cache.fetch(okb->address())->data(), "data");
+    BOOST_TEST(fetched == 1);
+    BOOST_TEST(cache.disk_revalidations() == 1);
+    ELLE_LOG("use validated disk cache")
+    {
+      cache.clear();
+      BOOST_CHECK_EQUAL(cache.fetch(okb->address())->data(), "data");
+    }
+    BOOST_TEST(fetched == 1);
+  }
+}
+
+ELLE_TEST_SCHEDULED(shared)
+{
+  auto&& r = Recipe{};
+  auto okb = r.dht.make_block<memo::model::blocks::MutableBlock>(
+    elle::Buffer("data", 4));
+  okb->seal(1);
+  r.instrument.add(*okb);
+  r.cache.fetch(okb->address());
+  auto a = r.cache.fetch(okb->address());
+  auto b = r.cache.fetch(okb->address());
+  // Hits share the cached payload ...
+  BOOST_TEST(a->data().contents() == b->data().contents());
+  // ... until modified.
+  dynamic_cast<memo::model::blocks::MutableBlock&>(*a).data(
+    [] (elle::Buffer& data) { data.append("!", 1); });
+  BOOST_TEST(a->data() == "data!");
+  BOOST_TEST(b->data() == "data");
+  BOOST_TEST(r.cache.fetch(okb->address())->data() == "data");
+}
+
+ELLE_TEST_SCHEDULED(admission)
+{
+  auto const budget = 64 * 1024;
+  auto&& r = Recipe(budget);
+  auto make = [&]
+    {
+      auto b = r.dht.make_block<memo::model::blocks::MutableBlock>(
+        elle::Buffer(std::string(4096, 'x')));
+      b->seal(1);
+      r.instrument.add(*b);
+      return b;
+    };
+  auto hot = make();
+  ELLE_LOG("fetch hot block")
+    for (int i = 0; i < 6; ++i)
+      r.cache.fetch(hot->address());
+  BOOST_TEST(r.cache.hits() == 5);
+  ELLE_LOG("scan blocks")
+    for (int i = 0; i < 50; ++i)
+      r.cache.fetch(make()->address());
+  auto const stats = r.cache.stats()["cache"];
+  BOOST_TEST(stats["evictions"]["admission"].get<int>() > 0);
+  BOOST_TEST(stats["bytes"]["window"].get<int>() +
+             stats["bytes"]["probation"].get<int>() +
+             stats["bytes"]["protected"].get<int>() <= budget);
+  ELLE_LOG("fetch hot block")
+    r.cache.fetch(hot->address());
+  BOOST_TEST(r.cache.hits() == 6);
+}
+
+ELLE_TEST_SCHEDULED(prefetch)
+{
+  auto&& r = Recipe{};
+  auto addresses = std::vector<memo::model::Address>{};
+  for (int i = 0; i < 3; ++i)
+  {
+    auto okb = r.dht.make_block<memo::model::blocks::MutableBlock>(
+      elle::Buffer("data", 4));
+    okb->seal(1);
+    r.instrument.add(*okb);
+    addresses.push_back(okb->address());
+  }
+  auto fetched = std::unordered_map<memo::model::Address, int>{};
+  r.instrument.fetched().connect(
+    [&] (memo::model::Address const& addr) { ++fetched[addr]; });
+  r.cache.prefetch({addresses[0], addresses[1], addresses[2], addresses[1]});
+  ELLE_LOG("fetch while prefetching")
+    BOOST_CHECK_EQUAL(r.cache.fetch(addresses[0])->data(), "data");
+  while (r.cache.prefetched() + r.cache.prefetch_failures() < 2)
+    elle::reactor::yield();
+  BOOST_TEST(r.cache.prefetched() == 2);
+  BOOST_TEST(r.cache.prefetch_skips() == 2);
+  ELLE_LOG("fetch prefetched blocks")
+    for (auto const& a: addresses)
+      BOOST_CHECK_EQUAL(r.cache.fetch(a)->data(), "data");
+  for (auto const& a: addresses)
+    BOOST_TEST(fetched[a] == 1);
+}
+
+ELLE_TEST_SCHEDULED(negative)
+{
+  auto&& r = Recipe{};
+  auto fetched = 0;
+  r.instrument.fetched().connect(
+    [&] (memo::model::Address const&) { ++fetched; });
+  auto chb = r.dht.make_block<memo::model::blocks::ImmutableBlock>(
+    elle::Buffer("data", 4));
+  ELLE_LOG("remember missing block")
+  {
+    BOOST_CHECK_THROW(r.cache.fetch(chb->address()),
+                      memo::model::MissingBlock);
+    BOOST_CHECK_THROW(r.cache.fetch(chb->address()),
+                      memo::model::MissingBlock);
+    BOOST_TEST(fetched == 1);
+    BOOST_TEST(r.cache.negative_hits() == 1);
+  }
+  ELLE_LOG("remember missing block in multifetch")
+  {
+    auto missing = 0;
+    r.cache.fetch(
+      {{chb->address(), boost::none}},
+      [&] (memo::model::Address,
+           std::unique_ptr<memo::model::blocks::Block> b,
+           std::exception_ptr e)
+      {
+        BOOST_TEST(!b);
+        BOOST_TEST(bool(e));
+        ++missing;
+      });
+    BOOST_TEST(missing == 1);
+    BOOST_TEST(fetched == 1);
+    BOOST_TEST(r.cache.negative_hits() == 2);
+  }
+  ELLE_LOG("forget missing block on store")
+  {
+    r.instrument.add(*chb);
+    r.cache.store(chb->clone(), memo::model::STORE_INSERT, nullptr);
+    BOOST_CHECK_EQUAL(r.cache.fetch(chb->address())->data(), "data");
+    BOOST_TEST(fetched == 2);
+  }
+}
+
 ELLE_TEST_SUITE()
 {
   auto& suite = boost::unit_test::framework::master_test_suite();
   suite.add(BOOST_TEST_CASE(memory), 0, valgrind(1));
   suite.add(BOOST_TEST_CASE(disk), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(disk_mutable), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(shared), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(admission), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(prefetch), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(negative), 0, valgrind(1));
 }
@@ -0,0 +1,87 @@
+#include <elle/Error.hh>
+#include <elle/test.hh>
+
+#include <memo/model/doughnut/consensus/ReedSolomon.hh>
+
+ELLE_LOG_COMPONENT("memo.model.doughnut.consensus.Erasure.test");
+
+using memo::model::doughnut::consensus::ReedSolomon;
+
+namespace
+{
+  elle::Buffer
+  payload(std::size_t size)
+  {
+    auto res = elle::Buffer(size);
+    for (std::size_t i = 0; i < size; ++i)
+      res[i] = (i * 7 + size) % 251;
+    return res;
+  }
+
+  ReedSolomon::Fragments
+  available(std::vector<elle::Buffer> const& fragments)
+  {
+    auto res = ReedSolomon::Fragments{};
+    for (auto const& f: fragments)
+      res.emplace_back(f);
+    return res;
+  }
+}
+
+static
+void
+round_trip()
+{
+  for (auto size: {0, 1, 3, 4, 1000, 65537})
+  {
+    auto const codec = ReedSolomon(4, 2);
+    auto const data = payload(size);
+    auto const fragments = codec.encode(data);
+    BOOST_TEST(fragments.size() == 6u);
+    for (auto const& f: fragments)
+      BOOST_TEST(f.size() == codec.fragment_size(size));
+    BOOST_TEST(codec.decode(available(fragments), size) == data);
+  }
+}
+
+static
+void
+missing_fragments()
+{
+  auto const codec = ReedSolomon(4, 2);
+  auto const data = payload(10000);
+  auto const fragments = codec.encode(data);
+  // Every combination of two missing fragments.
+  for (int i = 0; i < 6; ++i)
+    for (int j = i + 1; j < 6; ++j)
+    {
+      auto partial = available(fragments);
+      partial[i].reset();
+      partial[j].reset();
+      BOOST_TEST(codec.decode(partial, data.size()) == data);
+      auto const rebuilt = codec.reconstruct(partial, {i, j});
+      BOOST_TEST(rebuilt[0] == fragments[i]);
+      BOOST_TEST(rebuilt[1] == fragments[j]);
+    }
+  auto partial = available(fragments);
+  for (int i = 0; i < 3; ++i)
+    partial[i].reset();
+  BOOST_CHECK_THROW(codec.decode(partial, data.size()), elle::Error);
+}
+
+static
+void
+invalid()
+{
+  BOOST_CHECK_THROW(ReedSolomon(0, 2), elle::Error);
+  BOOST_CHECK_THROW(ReedSolomon(200, 57), elle::Error);
+  BOOST_CHECK_NO_THROW(ReedSolomon(200, 56));
+}
+
+ELLE_TEST_SUITE()
+{
+  auto& suite = boost::unit_test::framework::master_test_suite();
+  suite.add(BOOST_TEST_CASE(round_trip), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(missing_fragments), 0, valgrind(1));
+  suite.add(BOOST_TEST_CASE(invalid), 0, valgrind(1));
+}
@@ -1,5 +1,7 @@
+#include <limits>
 #include <memory>
 
+#include <boost/filesystem/fstream.hpp>
 #include <boost/range/algorithm/count_if.hpp>
 #include <boost/signals2/connection.hpp>
 
@@ -19,19 +21,26 @@
 #include <memo/model/Conflict.hh>
 #include <memo/model/MissingBlock.hh>
 #include <memo/model/MonitoringServer.hh>
+#include <memo/model/Object.hh>
 #include <memo/model/blocks/ACLBlock.hh>
 #include <memo/model/blocks/ImmutableBlock.hh>
 #include <memo/model/blocks/MutableBlock.hh>
 #include <memo/model/doughnut/ACB.hh>
+#include <memo/model/doughnut/CHB.hh>
 #include <memo/model/doughnut/Cache.hh>
+#include <memo/model/doughnut/Compression.hh>
 #include <memo/model/doughnut/Doughnut.hh>
 #include <memo/model/doughnut/Group.hh>
 #include <memo/model/doughnut/Local.hh>
 #include <memo/model/doughnut/NB.hh>
 #include <memo/model/doughnut/Remote.hh>
+#include <memo/model/doughnut/SignatureCache.hh>
+#include <memo/model/doughnut/TreeHash.hh>
 #include <memo/model/doughnut/UB.hh>
 #include <memo/model/doughnut/User.hh>
 #include <memo/model/doughnut/ValidationFailed.hh>
+#include <memo/model/doughnut/crypto.hh>
+#include <memo/model/doughnut/consensus/Erasure.hh>
 #include <memo/model/doughnut/consensus/Paxos.hh>
 #include <memo/overlay/Stonehenge.hh>
 #include <memo/silo/Memory.hh>
@@ -877,6 +886,76 @@ ELLE_TEST_SCHEDULED(cache, (bool, paxos))
   }
 }
 
+ELLE_TEST_SCHEDULED(cache_push_invalidation)
+{
+  elle::os::setenv("MEMO_CACHE_PUSH_INVALIDATION", "1");
+  // Missing blocks must be invalidated well before they expire.
+  elle::os::setenv("MEMO_CACHE_NEGATIVE_TTL", "3600000");
+  elle::SafeFinally unset(
+    []
+    {
+      elle::os::unsetenv("MEMO_CACHE_PUSH_INVALIDATION");
+      elle::os::unsetenv("MEMO_CACHE_NEGATIVE_TTL");
+    });
+  DHTs dhts(true, with_cache = true);
+  auto& cache_b =
+    dynamic_cast<dht::consensus::Cache&>(*dhts.dht_b->consensus());
+  BOOST_TEST(cache_b.stats()["cache"]["push_invalidation"].get<bool>());
+  auto block = dhts.dht_a->make_block<blocks::MutableBlock>();
+  block->data(elle::Buffer("before"));
+  ELLE_LOG("store block")
+    dhts.dht_a->seal_and_insert(*block);
+  ELLE_LOG("cache block on b")
+    BOOST_CHECK_EQUAL(dhts.dht_b->fetch(block->address())->data(), "before");
+  ELLE_LOG("wait for subscription")
+    while (cache_b.stats()["cache"]["subscribed"].get<int>() == 0)
+      elle::reactor::sleep(10ms);
+  ELLE_LOG("update block")
+  {
+    block->data(elle::Buffer("after"));
+    dhts.dht_a->seal_and_update(*block);
+  }
+  ELLE_LOG("wait for invalidation")
+    while (cache_b.invalidations() == 0)
+      elle::reactor::sleep(10ms);
+  BOOST_CHECK_EQUAL(dhts.dht_b->fetch(block->address())->data(), "after");
+  ELLE_LOG("subscribe at an outdated version")
+  {
+    auto& paxos = *dht::consensus::StackedConsensus::find<Paxos>(
+      dhts.dht_b->consensus().get());
+    auto notified = boost::optional<int>{};
+    boost::signals2::scoped_connection c = paxos.invalidated().connect(
+      [&] (memo::model::Address a, boost::optional<int> version)
+      {
+        if (a == block->address())
+          notified = version;
+      });
+    paxos.subscribe({{block->address(), block->version() - 1}});
+    while (!notified)
+      elle::reactor::sleep(10ms);
+    BOOST_TEST(*notified == block->version());
+  }
+  ELLE_LOG("insert a block known to be missing")
+  {
+    auto missing = dhts.dht_a->make_block<blocks::MutableBlock>();
+    missing->data(elle::Buffer("missing"));
+    BOOST_CHECK_THROW(dhts.dht_b->fetch(missing->address()),
+                      memo::model::MissingBlock);
+    dhts.dht_a->seal_and_insert(*missing);
+    while (true)
+      try
+      {
+        BOOST_TEST(dhts.dht_b->fetch(missing->address())->data() ==
+                   "missing");
+        break;
+      }
+      catch (memo::model::MissingBlock const&)
+      {
+        elle::reactor::sleep(10ms);
+      }
+  }
+}
+
 static std::unique_ptr<blocks::Block>
 cycle(dht::Doughnut& dht,
       std::unique_ptr<blocks::Block> b)
@@ -1077,12 +1156,14 @@ public:
     , _confirm_barrier()
     , _confirm_bypass(false)
     , _store_barrier()
+    , _fetch_barrier()
   {
     this->_all_barrier.open();
     this->_propose_barrier.open();
     this->_accept_barrier.open();
     this->_confirm_barrier.open();
     this->_store_barrier.open();
+    this->_fetch_barrier.open();
   }
 
   virtual
@@ -1093,6 +1174,15 @@ public:
     Super::store(block, mode);
   }
 
+  std::unique_ptr<blocks::Block>
+  _fetch(Address address, boost::optional<int> local_version) const override
+  {
+    auto& self = elle::unconst(*this);
+    self._fetching(address);
+    elle::reactor::wait(self._fetch_barrier);
+    return Super::_fetch(address, local_version);
+  }
+
   Paxos::PaxosServer::Response
   propose(PaxosServer::Quorum const& peers,
           Address address,
@@ -1160,6 +1250,8 @@ public:
   ELLE_ATTRIBUTE_RX(Hook, confirmed);
   ELLE_ATTRIBUTE_RX(boost::signals2::signal<void()>, evict);
   ELLE_ATTRIBUTE_RX(elle::reactor::Barrier, store_barrier);
+  ELLE_ATTRIBUTE_RX(elle::reactor::Barrier, fetch_barrier);
+  ELLE_ATTRIBUTE_RX(boost::signals2::signal<void(Address)>, fetching);
 };
 
 static constexpr
@@ -2153,6 +2245,85 @@ namespace rebalancing
     elle::reactor::wait(waiter);
     BOOST_CHECK_NO_THROW(local_d.storage()->get(block->address()));
   }
+
+  ELLE_TEST_SCHEDULED(bulk_transfer)
+  {
+    elle::os::setenv("MEMO_PAXOS_TRANSFER_BATCH", "4");
+    elle::SafeFinally unset(
+      [] { elle::os::unsetenv("MEMO_PAXOS_TRANSFER_BATCH"); });
+    auto dht_a = DHT(dht::consensus_builder = instrument(3, false));
+    auto& local_a = dynamic_cast<Local&>(*dht_a.dht->local());
+    auto addresses = std::vector<memo::model::Address>{};
+    ELLE_LOG("write blocks to quorum of 1")
+      for (int i = 0; i < 10; ++i)
+      {
+        auto b = make_block(dht_a, true, elle::sprintf("bulk_transfer %s", i));
+        addresses.emplace_back(b->address());
+        dht_a.dht->insert(std::move(b));
+      }
+    local_a.rebalance_auto_expand(true);
+    auto rebalanced = 0;
+    elle::reactor::Barrier done;
+    boost::signals2::scoped_connection c = local_a.rebalanced().connect(
+      [&] (memo::model::Address)
+      {
+        if (++rebalanced == signed(addresses.size()))
+          done.open();
+      });
+    memo::silo::Memory::Blocks storage_b;
+    auto dht_b = DHT(dht::consensus_builder = instrument(3, false),
+                     storage = std::make_unique<Memory>(storage_b));
+    ELLE_LOG("connect second DHT")
+      dht_b.overlay->connect(*dht_a.overlay);
+    elle::reactor::wait(done);
+    for (auto const& a: addresses)
+    {
+      BOOST_TEST(storage_b.count(a) == 1);
+      BOOST_CHECK_EQUAL(size(dht_a.overlay->lookup(a, 3)), 2u);
+    }
+    auto& paxos = dynamic_cast<dht::consensus::Paxos&>(*dht_a.dht->consensus());
+    BOOST_TEST(paxos.transfer_batches() == 3);
+    BOOST_TEST(paxos.transferred_blocks() == 10);
+    BOOST_TEST(paxos.full_redundancies() == 1);
+    BOOST_TEST(bool(paxos.full_redundancy_time()));
+  }
+
+  ELLE_TEST_SCHEDULED(anti_entropy, (bool, immutable))
+  {
+    auto const id_b = memo::model::Address::random();
+    auto dht_a = DHT(dht::consensus_builder = instrument(3, false));
+    auto& local_a = dynamic_cast<Local&>(*dht_a.dht->local());
+    // The third member vouches for the block the second one lost.
+    auto dht_c = DHT(dht::consensus_builder = instrument(3, false));
+    dht_c.overlay->connect(*dht_a.overlay);
+    auto const address = [&]
+      {
+        auto dht_b = DHT(id = id_b,
+                         dht::consensus_builder = instrument(3, false));
+        dht_b.overlay->connect(*dht_a.overlay);
+        dht_b.overlay->connect(*dht_c.overlay);
+        ELLE_LOG_SCOPE("write block to quorum of 3");
+        auto b = make_block(dht_a, immutable, "anti_entropy");
+        auto res = b->address();
+        dht_a.dht->insert(std::move(b));
+        return res;
+      }();
+    ELLE_LOG("restart second DHT with an empty disk");
+    memo::silo::Memory::Blocks storage_b;
+    auto dht_b = DHT(id = id_b,
+                     dht::consensus_builder = instrument(3, false),
+                     storage = std::make_unique<Memory>(storage_b));
+    auto& local_b = dynamic_cast<Local&>(*dht_b.dht->local());
+    dht_b.overlay->connect(*dht_a.overlay);
+    dht_b.overlay->connect(*dht_c.overlay);
+    BOOST_TEST(local_b.anti_entropy() == 0);
+    BOOST_TEST(storage_b.empty());
+    BOOST_TEST(local_a.anti_entropy() == 1);
+    BOOST_TEST(storage_b.count(address) == 1);
+    auto& paxos = dynamic_cast<dht::consensus::Paxos&>(*dht_a.dht->consensus());
+    BOOST_TEST(paxos.anti_entropy_differing() == 1);
+    BOOST_TEST(paxos.anti_entropy_repaired() == 1);
+  }
 }
 
 ELLE_TEST_SCHEDULED(CHB_unavailable)
@@ -2177,6 +2348,162 @@ ELLE_TEST_SCHEDULED(CHB_unavailable)
   BOOST_TEST(size(a->overlay->lookup(block->address(), 3)) == 3u);
 }
 
+ELLE_TEST_SCHEDULED(hedged_fetch)
+{
+  auto a = make_dht(0);
+  auto b = make_dht(1);
+  b->overlay->connect(*a->overlay);
+  auto c = make_dht(2);
+  c->overlay->connect(*a->overlay);
+  c->overlay->connect(*b->overlay);
+  auto block = a->dht->make_block<blocks::ImmutableBlock>(
+    elle::Buffer("hedged_fetch"));
+  a->dht->seal_and_insert(*block);
+  auto locals = std::vector<Local*>{
+    &dynamic_cast<Local&>(*a->dht->local()),
+    &dynamic_cast<Local&>(*b->dht->local()),
+    &dynamic_cast<Local&>(*c->dht->local()),
+  };
+  auto asked = 0;
+  elle::reactor::Barrier all_asked;
+  for (auto* local: locals)
+  {
+    local->fetch_barrier().close();
+    local->fetching().connect(
+      [&] (Address)
+      {
+        if (++asked == 3)
+          all_asked.open();
+      });
+  }
+  elle::SafeFinally open([&]
+    {
+      for (auto* local: locals)
+        local->fetch_barrier().open();
+    });
+  // Only answer once every owner was asked, one at a time.
+  elle::reactor::Thread answer(
+    "answer",
+    [&]
+    {
+      elle::reactor::wait(all_asked);
+      locals[2]->fetch_barrier().open();
+    });
+  BOOST_CHECK_EQUAL(a->dht->fetch(block->address())->data(), block->data());
+  BOOST_TEST(asked == 3);
+  BOOST_TEST(a->dht->consensus()->hedged_fetches() == 2);
+}
+
+ELLE_TEST_SCHEDULED(erasure)
+{
+  auto erasure = [] (dht::Doughnut& dht)
+    -> std::unique_ptr<dht::consensus::Consensus>
+    {
+      return std::make_unique<dht::consensus::Erasure>(
+        std::make_unique<Paxos>(dht::consensus::doughnut = dht,
+                                dht::consensus::replication_factor = 3),
+        4, 2);
+    };
+  auto servers = std::vector<std::unique_ptr<DHT>>{};
+  auto client = DHT(storage = nullptr, dht::consensus_builder = erasure);
+  auto add_server = [&]
+    {
+      servers.emplace_back(
+        std::make_unique<DHT>(dht::consensus_builder = erasure));
+      for (auto& s: servers)
+        servers.back()->overlay->connect(*s->overlay);
+      client.overlay->connect(*servers.back()->overlay);
+    };
+  for (int i = 0; i < 6; ++i)
+    add_server();
+  auto& consensus = *dht::consensus::StackedConsensus::find<
+    dht::consensus::Erasure>(client.dht->consensus().get());
+  auto block = client.dht->make_block<blocks::ImmutableBlock>(
+    elle::Buffer("erasure coded"));
+  BOOST_TEST(block->address().has_flags(memo::model::flags::erasure_coded));
+  ELLE_LOG("store block")
+    client.dht->seal_and_insert(*block);
+  for (auto& s: servers)
+    BOOST_TEST(s->overlay->blocks().size() == 1u);
+  BOOST_TEST(client.dht->fetch(block->address())->data() == block->data());
+  ELLE_LOG("lose two fragments and repair")
+  {
+    client.overlay->disconnect(*servers[0]->overlay);
+    client.overlay->disconnect(*servers[1]->overlay);
+    add_server();
+    add_server();
+    BOOST_TEST(consensus.repair(block->address()) == 2);
+    BOOST_TEST(servers[6]->overlay->blocks().size() == 1u);
+    BOOST_TEST(servers[7]->overlay->blocks().size() == 1u);
+    BOOST_TEST(consensus.repair(block->address()) == 0);
+  }
+  ELLE_LOG("fetch from data and parity fragments")
+  {
+    client.overlay->disconnect(*servers[2]->overlay);
+    client.overlay->disconnect(*servers[3]->overlay);
+    BOOST_TEST(client.dht->fetch(block->address())->data() == block->data());
+  }
+  ELLE_LOG("fail to fetch with too few fragments")
+  {
+    client.overlay->disconnect(*servers[4]->overlay);
+    BOOST_CHECK_THROW(client.dht->fetch(block->address()),
+                      memo::model::MissingBlock);
+  }
+  ELLE_LOG("refuse to store on fewer peers than data fragments")
+  {
+    auto other = client.dht->make_block<blocks::ImmutableBlock>(
+      elle::Buffer("too few peers"));
+    BOOST_CHECK_THROW(client.dht->seal_and_insert(*other), elle::Error);
+  }
+}
+
+ELLE_TEST_SCHEDULED(delta)
+{
+  DHTs dhts(true);
+  auto& paxos = dynamic_cast<Paxos&>(*dhts.dht_a->consensus());
+  auto block = dhts.dht_a->make_block<blocks::ACLBlock>();
+  block->data(elle::Buffer("delta"));
+  ELLE_LOG("store ACB")
+    dhts.dht_a->seal_and_insert(*block);
+  BOOST_TEST(paxos.delta_accepts() == 0);
+  ELLE_LOG("add ACB read permissions")
+  {
+    block->set_permissions(dht::User(dhts.keys_b->K(), ""), true, false);
+    dhts.dht_a->seal_and_update(*block);
+  }
+  // The local peer is always sent the full value.
+  BOOST_TEST(paxos.delta_accepts() == 2);
+  BOOST_TEST(paxos.delta_fallbacks() == 0);
+  BOOST_TEST(paxos.delta_bytes_saved() > 0);
+  ELLE_LOG("fetch ACB")
+  {
+    auto fetched = dhts.dht_b->fetch(block->address());
+    BOOST_CHECK_EQUAL(fetched->data(), "delta");
+  }
+  auto const stats = paxos.stats();
+  BOOST_TEST(stats["delta"]["accepts"].get<int>() == 2);
+  ELLE_LOG("round trip deltas")
+  {
+    auto const base = elle::Buffer("0123456789abcdefghijklmnopqrstuvwxyz");
+    auto const target =
+      elle::Buffer("0123456789abcdefghij-klmnopqrstuvwxyz!");
+    auto const delta = dht::consensus::delta_encode(base, target);
+    BOOST_TEST(dht::consensus::delta_apply(base, delta) == target);
+  }
+  ELLE_LOG("reject deltas expanding past their bound")
+  {
+    auto const base = elle::Buffer("0123456789abcdef");
+    // Each two-byte op copies the whole base.
+    auto delta = elle::Buffer{};
+    for (auto i = 0; i < 64; ++i)
+    {
+      uint8_t const op[] = {uint8_t(base.size() << 1), 0};
+      delta.append(op, sizeof op);
+    }
+    BOOST_CHECK_THROW(dht::consensus::delta_apply(base, delta), elle::Error);
+  }
+}
+
 // Since we use Locals, blocks dont go through serialization and thus
 // are fetched already decoded
 static void no_cheating(dht::Doughnut* d, std::unique_ptr<blocks::Block>& b)
@@ -2296,6 +2623,64 @@ ELLE_TEST_SCHEDULED(admin_keys)
     false, false), elle::Error);
 }
 
+ELLE_TEST_SCHEDULED(signature_cache)
+{
+  auto& cache = dht::SignatureCache::instance();
+  cache.clear();
+  auto dht = DHT();
+  auto b = dht.dht->make_block<blocks::ACLBlock>();
+  b->data(std::string("foo"));
+  dht.dht->seal_and_insert(*b);
+  auto const hits = cache.hits();
+  auto const misses = cache.misses();
+  // Fresh copies of the same block are verified from the cache.
+  for (int i = 0; i < 2; ++i)
+  {
+    auto copy = cycle(*dht.dht, b->clone());
+    BOOST_CHECK(bool(copy->validate(*dht.dht, false)));
+  }
+  BOOST_CHECK_GE(cache.hits(), hits + 2);
+  BOOST_CHECK_EQUAL(cache.misses(), misses);
+  // Other data is verified anew.
+  dynamic_cast<blocks::MutableBlock&>(*b).data(std::string("bar"));
+  dht.dht->seal_and_update(*b);
+  BOOST_CHECK_GT(cache.misses(), misses);
+  auto const stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats["hits"].get<int64_t>(), cache.hits());
+  BOOST_CHECK_GT(stats["hit_rate"].get<double>(), 0);
+}
+
+ELLE_TEST_SCHEDULED(parallel_validation)
+{
+  auto dht = DHT();
+  auto addrs = std::vector<memo::model::Model::AddressVersion>{};
+  for (int i = 0; i < 8; ++i)
+  {
+    auto b = dht.dht->make_block<blocks::ACLBlock>();
+    b->data(elle::sprintf("block %s", i));
+    dht.dht->seal_and_insert(*b);
+    addrs.emplace_back(b->address(), boost::none);
+  }
+  dht::SignatureCache::instance().clear();
+  auto const background =
+    dht::crypto_stats()["background"].get<int64_t>();
+  auto fetched = 0;
+  dht.dht->multifetch(
+    addrs,
+    [&] (memo::model::Address,
+         std::unique_ptr<blocks::Block> b,
+         std::exception_ptr ex)
+    {
+      BOOST_CHECK(!ex);
+      BOOST_CHECK(b);
+      if (b)
+        ++fetched;
+    });
+  BOOST_CHECK_EQUAL(fetched, 8);
+  BOOST_CHECK_GE(dht::crypto_stats()["background"].get<int64_t>(),
+                 background + 8);
+}
+
 ELLE_TEST_SCHEDULED(disabled_crypto)
 {
   auto const key = elle::cryptography::rsa::keypair::generate(key_size());
@@ -2314,6 +2699,460 @@ ELLE_TEST_SCHEDULED(disabled_crypto)
   BOOST_CHECK_EQUAL(bic->data(), "canard");
 }
 
+ELLE_TEST_SCHEDULED(aead)
+{
+  for (auto aead: {false, true})
+  {
+    ELLE_LOG_SCOPE("authenticated encryption: %s", aead);
+    auto const key = elle::cryptography::rsa::keypair::generate(key_size());
+    auto const eopts = dht::EncryptOptions{true, true, true, aead};
+    auto dhts = DHTs(true, encrypt_options = eopts,
+                     keys_a = key, keys_b = key, keys_c = key);
+    BOOST_CHECK_EQUAL(dhts.dht_a->encrypt_options().mode(),
+                      aead ?
+                      elle::cryptography::Mode::gcm :
+                      elle::cryptography::Mode::cbc);
+    auto b =
+      dhts.dht_a->make_block<blocks::ACLBlock>(elle::Buffer("canard", 6));
+    auto baddr = b->address();
+    dhts.dht_a->insert(std::move(b));
+    auto bc = dhts.dht_b->fetch(baddr);
+    BOOST_CHECK_EQUAL(bc->data(), "canard");
+  }
+}
+
+ELLE_TEST_SCHEDULED(secret_cache)
+{
+  DHTs dhts(true);
+  auto& secrets = dhts.dht_b->secret_cache();
+  auto block = dhts.dht_a->make_block<blocks::ACLBlock>();
+  block->data(elle::Buffer("canard"));
+  block->set_permissions(dht::User(dhts.keys_b->K(), ""), true, false);
+  ELLE_LOG("owner: store ACB")
+    dhts.dht_a->seal_and_insert(*block);
+  auto const read = [&] (std::string const& expected, int hits, int misses)
+    {
+      auto const hits_before = secrets.hits();
+      auto const misses_before = secrets.misses();
+      auto fetched = dhts.dht_b->fetch(block->address());
+      BOOST_TEST(fetched->data() == expected);
+      BOOST_TEST(secrets.hits() - hits_before == hits);
+      BOOST_TEST(secrets.misses() - misses_before == misses);
+    };
+  ELLE_LOG("other: first read unwraps the secret")
+    read("canard", 0, 1);
+  ELLE_LOG("other: next reads hit the cache")
+  {
+    read("canard", 1, 0);
+    read("canard", 1, 0);
+  }
+  ELLE_LOG("owner: update data, rotating the secret")
+  {
+    block->data(elle::Buffer("coin"));
+    dhts.dht_a->seal_and_update(*block);
+  }
+  ELLE_LOG("other: the new token misses")
+  {
+    read("coin", 0, 1);
+    read("coin", 1, 0);
+  }
+  ELLE_LOG("owner: reads are primed by the seal")
+  {
+    auto const hits = dhts.dht_a->secret_cache().hits();
+    auto fetched = dhts.dht_a->fetch(block->address());
+    BOOST_TEST(fetched->data() == "coin");
+    BOOST_TEST(dhts.dht_a->secret_cache().hits() == hits + 1);
+  }
+  ELLE_LOG("owner: ACL change drops the block secrets")
+  {
+    auto const size = dhts.dht_a->secret_cache().stats()["size"].get<int>();
+    block->set_permissions(dht::User(dhts.keys_b->K(), ""), true, true);
+    dhts.dht_a->seal_and_update(*block);
+    BOOST_TEST(dhts.dht_a->secret_cache().stats()["size"].get<int>() ==
+               size - 1);
+  }
+  ELLE_LOG("group: members removed from the group stop reading")
+  {
+    dht::Group g(*dhts.dht_a, "g");
+    g.create();
+    g.add_member(dht::User(dhts.keys_b->K(), "bob"));
+    auto shared = dhts.dht_a->make_block<blocks::ACLBlock>();
+    shared->data(elle::Buffer("oie"));
+    shared->set_permissions(dht::User(g.public_control_key(), "@g"),
+                            true, false);
+    dhts.dht_a->seal_and_insert(*shared);
+    BOOST_TEST(dhts.dht_b->fetch(shared->address())->data() == "oie");
+    auto const hits = secrets.hits();
+    BOOST_TEST(dhts.dht_b->fetch(shared->address())->data() == "oie");
+    BOOST_TEST(secrets.hits() == hits + 1);
+    g.remove_member(dht::User(dhts.keys_b->K(), "bob"));
+    BOOST_CHECK_THROW(dhts.dht_b->fetch(shared->address())->data(),
+                      dht::ValidationFailed);
+  }
+}
+
+ELLE_TEST_SCHEDULED(session_resumption)
+{
+  auto dht_a = DHT(id = special_id(10));
+  auto dht_b = DHT(id = special_id(11), storage = nullptr);
+  auto const handshakes = [] (DHT& dht, std::string const& kind)
+    {
+      return dht.dht->dock().handshake_stats()[kind].get<int>();
+    };
+  auto peer = dht_b.dht->dock().make_peer(
+    memo::model::NodeLocation(dht_a.dht->id(),
+                              dht_a.dht->local()->server_endpoints()))
+    .lock();
+  auto& remote = dynamic_cast<dht::Remote&>(*peer);
+  auto const address = memo::model::Address::random(
+    memo::model::flags::immutable_block);
+  ELLE_LOG("connect: full handshake")
+  {
+    remote.connect();
+    BOOST_CHECK_THROW(remote.fetch(address, {}), memo::model::MissingBlock);
+    BOOST_TEST(handshakes(dht_b, "full") == 1);
+    BOOST_TEST(handshakes(dht_a, "full") == 1);
+    BOOST_TEST(handshakes(dht_b, "tickets") == 1);
+    BOOST_TEST(handshakes(dht_a, "sessions") == 1);
+  }
+  ELLE_LOG("reconnect: resume the session")
+  {
+    remote.reconnect();
+    remote.connect();
+    BOOST_CHECK_THROW(remote.fetch(address, {}), memo::model::MissingBlock);
+    BOOST_TEST(handshakes(dht_b, "full") == 1);
+    BOOST_TEST(handshakes(dht_b, "resumed") == 1);
+    BOOST_TEST(handshakes(dht_a, "resumed") == 1);
+  }
+  ELLE_LOG("server forgot the session: fall back to a full handshake")
+  {
+    dht_a.dht->dock().sessions().clear();
+    remote.reconnect();
+    remote.connect();
+    BOOST_CHECK_THROW(remote.fetch(address, {}), memo::model::MissingBlock);
+    BOOST_TEST(handshakes(dht_b, "full") == 2);
+    BOOST_TEST(handshakes(dht_b, "resumed") == 1);
+  }
+  ELLE_LOG("resumed sessions keep the expiry of the full handshake")
+  {
+    auto tickets = dht::session::Tickets<int, int>{};
+    auto const expiry = elle::Clock::now() + 60s;
+    tickets.add(0, 0, expiry);
+    // Looking a ticket up does not consume it.
+    BOOST_TEST(tickets.find(0));
+    BOOST_TEST(tickets.find(0));
+    auto const entry = tickets.take(0);
+    BOOST_TEST(!tickets.find(0));
+    tickets.add(1, 1, entry->expiry);
+    BOOST_TEST(tickets.find(1)->expiry == expiry);
+  }
+}
+
+ELLE_TEST_SCHEDULED(key_cache)
+{
+  auto const dir = elle::filesystem::TemporaryDirectory{};
+  auto const key = []
+    {
+      return std::make_shared<elle::cryptography::rsa::PublicKey>(
+        elle::cryptography::rsa::keypair::generate(key_size()).K());
+    };
+  auto const k0 = key();
+  auto const k1 = key();
+  auto const k2 = key();
+  auto epoch = elle::Buffer{};
+  ELLE_LOG("assign key hashes")
+  {
+    auto dht = DHT(dht::key_cache_path = dir.path() / "server");
+    BOOST_TEST(dht.dht->ensure_key(k0) == 0);
+    BOOST_TEST(dht.dht->ensure_key(k1) == 1);
+    BOOST_TEST(dht.dht->ensure_key(k0) == 0);
+    epoch = elle::Buffer(dht.dht->key_epoch());
+  }
+  ELLE_LOG("restart after a torn append: hashes are kept")
+  {
+    {
+      boost::filesystem::ofstream f(dir.path() / "server" / "local",
+                                    std::ios::binary | std::ios::app);
+      f.write("\x40\0", 2);
+    }
+    auto dht = DHT(dht::key_cache_path = dir.path() / "server");
+    BOOST_TEST(dht.dht->key_epoch() == epoch);
+    BOOST_TEST(*dht.dht->resolve_key(1) == *k1);
+    BOOST_TEST(dht.dht->ensure_key(k1) == 1);
+    BOOST_TEST(dht.dht->ensure_key(k2) == 2);
+  }
+  ELLE_LOG("client: prefetch and persist the server hashes")
+  {
+    auto server = DHT(dht::key_cache_path = dir.path() / "server");
+    auto client = DHT(dht::key_cache_path = dir.path() / "client",
+                      storage = nullptr);
+    client.overlay->connect(*server.overlay);
+    auto block = server.dht->make_block<blocks::ACLBlock>();
+    block->data(elle::Buffer("canard"));
+    block->set_permissions(dht::User(*k2, ""), true, false);
+    server.dht->seal_and_insert(*block);
+    BOOST_TEST(client.dht->fetch(block->address())->data() == "canard");
+    auto saved = dht::KeyCache{};
+    auto const saved_epoch = dht::load_key_cache(
+      dir.path() / "client" / "peers" /
+      elle::sprintf("%x", server.dht->id()), saved);
+    BOOST_TEST(saved_epoch.value_or(elle::Buffer()) == epoch);
+    BOOST_TEST(saved.size() == server.dht->key_cache().size());
+  }
+  ELLE_LOG("lost dictionary: new epoch")
+  {
+    boost::filesystem::remove_all(dir.path() / "server");
+    auto dht = DHT(dht::key_cache_path = dir.path() / "server");
+    BOOST_TEST(dht.dht->key_epoch() != epoch);
+    BOOST_TEST(dht.dht->key_cache().size() == 0);
+  }
+}
+
+ELLE_TEST_SCHEDULED(objects)
+{
+  DHTs dhts(true);
+  auto const payload = std::string("0123456789abcdefghijklmnopqrstuvwxyz");
+  auto address = memo::model::Address{};
+  ELLE_LOG("write object in 4-byte chunks, 3 per index")
+  {
+    memo::model::ObjectWriter writer(*dhts.dht_a, Address::null, 4, 2, 3);
+    for (auto i = 0u; i < payload.size(); i += 7)
+      writer.write(elle::ConstWeakBuffer(
+                     payload.data() + i, std::min<int>(7, payload.size() - i)));
+    BOOST_TEST(writer.size() == payload.size());
+    address = writer.close();
+    BOOST_CHECK_THROW(writer.write(elle::ConstWeakBuffer("x", 1)),
+                      elle::Error);
+  }
+  ELLE_LOG("read object")
+  {
+    auto const reader = memo::model::ObjectReader(*dhts.dht_b, address, 2);
+    BOOST_TEST(reader.size() == payload.size());
+    BOOST_TEST(reader.chunks().size() == 9);
+    BOOST_TEST(reader.read() == payload);
+    BOOST_TEST(reader.read(5, 10) == payload.substr(5, 10));
+    BOOST_TEST(reader.read(34) == "yz");
+    BOOST_TEST(reader.read(34, 10) == "yz");
+    BOOST_TEST(reader.read(36).size() == 0);
+    BOOST_CHECK_THROW(reader.read(37), elle::Error);
+    auto pieces = std::vector<std::string>{};
+    reader.read([&] (elle::ConstWeakBuffer data)
+                {
+                  pieces.emplace_back(data.string());
+                },
+                3, 7);
+    BOOST_TEST(pieces == (std::vector<std::string>{"3", "4567", "89"}));
+  }
+  ELLE_LOG("insert and read through the model")
+  {
+    auto const a = dhts.dht_a->insert_object(elle::Buffer(payload));
+    BOOST_TEST(dhts.dht_b->read_object(a) == payload);
+    BOOST_TEST(dhts.dht_b->read_object(a, 30, 3) == "uvw");
+    auto const empty = dhts.dht_a->insert_object(elle::Buffer());
+    BOOST_TEST(dhts.dht_b->read_object(empty).size() == 0);
+  }
+  ELLE_LOG("read past the end with a huge length")
+  {
+    auto const a = dhts.dht_a->insert_object(elle::Buffer(payload));
+    auto const huge = std::numeric_limits<int64_t>::max();
+    BOOST_TEST(dhts.dht_b->read_object(a, 30, huge) == "uvwxyz");
+  }
+  ELLE_LOG("write through the model piecewise")
+  {
+    auto const session = dhts.dht_a->begin_object();
+    BOOST_TEST(dhts.dht_a->append_object(session, elle::Buffer("0123456789"))
+               == 10);
+    BOOST_TEST(dhts.dht_a->append_object(
+                 session, elle::Buffer(payload.substr(10))) == payload.size());
+    auto const a = dhts.dht_a->commit_object(session);
+    BOOST_TEST(dhts.dht_b->read_object(a) == payload);
+    BOOST_CHECK_THROW(
+      dhts.dht_a->append_object(session, elle::Buffer("x")), elle::Error);
+    BOOST_CHECK_THROW(dhts.dht_a->commit_object(session), elle::Error);
+  }
+  ELLE_LOG("reading a plain block fails")
+  {
+    auto const plain =
+      dhts.dht_a->insert_immutable_block(elle::Buffer("canard"));
+    BOOST_CHECK_THROW(dhts.dht_b->read_object(plain), elle::Error);
+  }
+}
+
+ELLE_TEST_SCHEDULED(compression)
+{
+  namespace compression = memo::model::doughnut::compression;
+  using Codec = compression::Codec;
+  auto text = elle::Buffer{};
+  for (auto i = 0; i < 256; ++i)
+  {
+    auto const line =
+      elle::sprintf("line %s of a very compressible text\n", i);
+    text.append(line.data(), line.size());
+  }
+  auto noise = elle::Buffer(text.size());
+  {
+    auto byte = std::uniform_int_distribution<int>(0, 255);
+    for (auto& c: noise)
+      c = byte(elle::random_engine());
+  }
+  ELLE_LOG("entropy")
+  {
+    BOOST_TEST(compression::entropy(std::string(4096, 'a')) == 0);
+    BOOST_TEST(compression::entropy(text) < 6);
+    BOOST_TEST(compression::entropy(noise) > 7.5);
+  }
+  ELLE_LOG("pack compressible payloads")
+  {
+    auto const packed = compression::pack(text);
+    BOOST_TEST(compression::codec(packed) == Codec::deflate);
+    BOOST_TEST(packed.size() < text.size() / 2);
+    BOOST_TEST(compression::unpack(packed) == text);
+  }
+  ELLE_LOG("store incompressible and small payloads as is")
+  {
+    for (auto const& data:
+           {noise, elle::Buffer("canard"), elle::Buffer()})
+    {
+      auto const packed = compression::pack(data);
+      BOOST_TEST(compression::codec(packed) == Codec::none);
+      BOOST_TEST(packed.size() == data.size() + 1);
+      BOOST_TEST(compression::unpack(packed) == data);
+    }
+  }
+  ELLE_LOG("reject corrupted payloads")
+  {
+    auto packed = compression::pack(text);
+    auto const empty = elle::Buffer();
+    BOOST_CHECK_THROW(compression::unpack(empty), elle::Error);
+    auto const unknown = elle::Buffer("\x07", 1);
+    BOOST_CHECK_THROW(compression::unpack(unknown), elle::Error);
+    packed[2] ^= 0x40;
+    BOOST_CHECK_THROW(compression::unpack(packed), elle::Error);
+    BOOST_CHECK_THROW(compression::unpack(
+                        elle::ConstWeakBuffer(packed.contents(), 3)),
+                      elle::Error);
+  }
+  auto const packing = compression::version();
+  auto const previous = elle::Version(0, 9, 0);
+  ELLE_LOG("pack from its version")
+  {
+    BOOST_TEST(compression::packed(packing));
+    BOOST_TEST(!compression::packed(previous));
+    BOOST_TEST(memo::serialization_tag::dependencies.count(packing) == 1);
+  }
+  ELLE_LOG("blocks round trip")
+  {
+    auto stored = std::vector<memo::silo::Memory::Blocks>(3);
+    auto dhts = DHTs(true,
+                     storage_a = std::make_unique<Memory>(stored[0]),
+                     storage_b = std::make_unique<Memory>(stored[1]),
+                     storage_c = std::make_unique<Memory>(stored[2]),
+                     version_a = packing,
+                     version_b = packing,
+                     version_c = packing);
+    auto chb = dhts.dht_a->make_block<blocks::ImmutableBlock>(text);
+    BOOST_TEST(dynamic_cast<dht::CHB&>(*chb).packed());
+    auto const chb_address = chb->address();
+    dhts.dht_a->seal_and_insert(*chb);
+    auto copies = 0;
+    for (auto const& s: stored)
+    {
+      auto const it = s.find(chb_address);
+      if (it == s.end())
+        continue;
+      ++copies;
+      BOOST_TEST(it->second.size() < text.size() / 2);
+    }
+    BOOST_TEST(copies > 0);
+    auto fetched = dhts.dht_b->fetch(chb_address);
+    BOOST_TEST(dynamic_cast<dht::CHB&>(*fetched).packed());
+    BOOST_TEST(fetched->data() == text);
+    auto acb = dhts.dht_a->make_block<blocks::ACLBlock>(text);
+    dhts.dht_a->seal_and_insert(*acb);
+    BOOST_TEST(dhts.dht_b->fetch(acb->address())->data() == text);
+  }
+  ELLE_LOG("blocks written unpacked are read unpacked")
+  {
+    auto dhts = DHTs(true,
+                     version_a = previous,
+                     version_b = packing,
+                     version_c = packing);
+    auto chb = dhts.dht_a->make_block<blocks::ImmutableBlock>(text);
+    BOOST_TEST(!dynamic_cast<dht::CHB&>(*chb).packed());
+    auto const chb_address = chb->address();
+    dhts.dht_a->seal_and_insert(*chb);
+    for (auto const& d: {dhts.dht_b, dhts.dht_c})
+    {
+      auto fetched = d->fetch(chb_address);
+      BOOST_TEST(!dynamic_cast<dht::CHB&>(*fetched).packed());
+      BOOST_TEST(fetched->data() == text);
+    }
+  }
+}
+
+ELLE_TEST_SCHEDULED(tree_hash)
+{
+  using memo::model::doughnut::TreeHash;
+  namespace flags = memo::model::flags;
+  auto const size = 3 * TreeHash::chunk_size + 1000;
+  // Incompressible, lest packing shrinks it below the threshold.
+  auto payload = elle::Buffer(size);
+  {
+    auto byte = std::uniform_int_distribution<int>(0, 255);
+    for (auto& c: payload)
+      c = byte(elle::random_engine());
+  }
+  auto const tree = TreeHash(payload);
+  ELLE_LOG("hash chunks")
+  {
+    BOOST_TEST(tree.size() == size);
+    BOOST_TEST(tree.leaves().size() == 4);
+    BOOST_TEST(tree.chunk(0) == TreeHash::chunk_size);
+    BOOST_TEST(tree.chunk(3) == 1000);
+    BOOST_CHECK_THROW(tree.chunk(4), elle::Error);
+  }
+  ELLE_LOG("root depends on the prefix and every chunk")
+  {
+    auto const salt = elle::Buffer("salt");
+    auto const pepper = elle::Buffer("pepper");
+    BOOST_TEST(TreeHash(payload).root(salt) == tree.root(salt));
+    BOOST_TEST(tree.root(salt) != tree.root(pepper));
+    auto tampered = payload;
+    tampered[3 * TreeHash::chunk_size + 10] ^= 1;
+    BOOST_TEST(TreeHash(tampered).root(salt) != tree.root(salt));
+  }
+  ELLE_LOG("tree hash only large payloads from its version")
+  {
+    BOOST_TEST(!TreeHash::applies(elle::Version(0, 9, 0), size));
+    BOOST_TEST(TreeHash::applies(TreeHash::version(), size));
+    BOOST_TEST(!TreeHash::applies(TreeHash::version(), TreeHash::threshold));
+  }
+  ELLE_LOG("tree hashed blocks validate")
+  {
+    auto const v = TreeHash::version();
+    auto dhts = DHTs(true, version_a = v, version_b = v, version_c = v);
+    auto chb = dhts.dht_a->make_block<blocks::ImmutableBlock>(payload);
+    auto const address = chb->address();
+    BOOST_TEST(address.has_flags(flags::tree_hash));
+    dhts.dht_a->seal_and_insert(*chb);
+    BOOST_TEST(dhts.dht_b->fetch(address)->data() == payload);
+  }
+  ELLE_LOG("flat addressed blocks still validate")
+  {
+    auto const v = TreeHash::version();
+    auto dhts = DHTs(true,
+                     version_a = elle::Version(0, 9, 0),
+                     version_b = v,
+                     version_c = v);
+    auto chb = dhts.dht_a->make_block<blocks::ImmutableBlock>(payload);
+    auto const address = chb->address();
+    BOOST_TEST(!address.has_flags(flags::tree_hash));
+    dhts.dht_a->seal_and_insert(*chb);
+    BOOST_TEST(dhts.dht_b->fetch(address)->data() == payload);
+    BOOST_TEST(dhts.dht_c->fetch(address)->data() == payload);
+  }
+}
+
 ELLE_TEST_SCHEDULED(tombstones)
 {
   auto dht_a = make_dht(0);
@@ -2436,8 +3275,21 @@ ELLE_TEST_SUITE()
     TEST(serialize_ACB_remove);
   }
   paxos->add(BOOST_TEST_CASE(CHB_unavailable), 0, valgrind(3));
+  paxos->add(BOOST_TEST_CASE(hedged_fetch), 0, valgrind(10));
+  paxos->add(BOOST_TEST_CASE(erasure), 0, valgrind(3));
+  paxos->add(BOOST_TEST_CASE(delta), 0, valgrind(3));
+  paxos->add(BOOST_TEST_CASE(cache_push_invalidation), 0, valgrind(3));
 #undef TEST
   suite.add(BOOST_TEST_CASE(admin_keys), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(signature_cache), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(parallel_validation), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(aead), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(secret_cache), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(session_resumption), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(key_cache), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(objects), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(compression), 0, valgrind(3));
+  suite.add(BOOST_TEST_CASE(tree_hash), 0, valgrind(3));
   suite.add(BOOST_TEST_CASE(disabled_crypto), 0, valgrind(3));
   {
     paxos->add(ELLE_TEST_CASE(&tests_paxos::wrong_quorum, "wrong_quorum"));
@@ -2503,6 +3355,13 @@ ELLE_TEST_SUITE()
       auto peeking_node = &rebalancing::peeking_node;
       rebalancing->add(BOOST_TEST_CASE(peeking_node), 0, valgrind(3));
     }
+    rebalancing->add(BOOST_TEST_CASE(bulk_transfer), 0, valgrind(3));
+    {
+      auto anti_entropy_CHB = [] () { anti_entropy(true); };
+      auto anti_entropy_OKB = [] () { anti_entropy(false); };
+      rebalancing->add(BOOST_TEST_CASE(anti_entropy_CHB), 0, valgrind(3));
+      rebalancing->add(BOOST_TEST_CASE(anti_entropy_OKB), 0, valgrind(3));
+    }
     {
       auto evict_chain = BOOST_TEST_SUITE("evict_chain");
       rebalancing->add(evict_chain);
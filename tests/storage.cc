@@ -2,7 +2,10 @@
 #include <elle/serialization/json.hh>
 #include <elle/test.hh>
 
+#include <elle/cryptography/SecretKey.hh>
+
 #include <memo/silo/Collision.hh>
+#include <memo/silo/Crypt.hh>
 #include <memo/silo/Filesystem.hh>
 #include <memo/silo/Memory.hh>
 #include <memo/silo/MissingKey.hh>
@@ -118,6 +121,66 @@ filesystem_large_capacity()
   tests_capacity(storage, size);
 }
 
+static
+void
+encrypted()
+{
+  for (auto salt: {false, true})
+  {
+    auto blocks = memo::silo::Memory::Blocks{};
+    memo::silo::Crypt storage(
+      std::make_unique<memo::silo::Memory>(blocks), "secret", salt);
+    tests(storage);
+    auto const k = memo::silo::Key::random();
+    auto const data = elle::Buffer("the grey");
+    storage.set(k, data);
+    // Stored enciphered, with a header.
+    BOOST_CHECK_NE(blocks.at(k), data);
+    BOOST_CHECK_EQUAL(blocks.at(k).string().substr(0, 6), "mcrypt");
+    BOOST_CHECK_EQUAL(storage.get(k), data);
+    // Values written before the header remain readable.
+    auto const legacy = memo::silo::Key::random();
+    blocks[legacy] = elle::cryptography::SecretKey(
+      salt ? "secret" + elle::sprintf("%x", legacy) : std::string("secret"))
+      .encipher(data);
+    BOOST_CHECK_EQUAL(storage.get(legacy), data);
+    // Values are bound to their address.
+    auto const moved = memo::silo::Key::random();
+    blocks[moved] = elle::Buffer(blocks.at(k));
+    BOOST_CHECK_THROW(storage.get(moved), elle::Error);
+    // Tampering is detected.
+    auto& stored = blocks.at(k);
+    stored[stored.size() - 1] ^= 1;
+    BOOST_CHECK_THROW(storage.get(k), elle::Error);
+  }
+}
+
+static
+void
+encrypted_throughput()
+{
+  memo::silo::Crypt storage(
+    std::make_unique<memo::silo::Memory>(), "secret");
+  auto const data = elle::Buffer(std::string(1 << 16, 'x'));
+  auto keys = std::vector<memo::silo::Key>{};
+  for (int i = 0; i < 256; ++i)
+    keys.emplace_back(memo::silo::Key::random());
+  auto const start = std::chrono::steady_clock::now();
+  for (auto const& k: keys)
+    storage.set(k, data);
+  auto const written = std::chrono::steady_clock::now();
+  for (auto const& k: keys)
+    BOOST_CHECK_EQUAL(storage.get(k).size(), data.size());
+  auto const read = std::chrono::steady_clock::now();
+  auto const mib = keys.size() * data.size() / double(1 << 20);
+  auto rate = [&] (auto duration)
+    {
+      return mib / std::chrono::duration<double>(duration).count();
+    };
+  ELLE_LOG("set: %.1f MiB/s, get: %.1f MiB/s",
+           rate(written - start), rate(read - written));
+}
+
 extern const std::string zero_five_four_s3_storage_reduced;
 extern const std::string zero_five_four_s3_storage_default;
 
@@ -158,6 +221,8 @@ ELLE_TEST_SUITE()
   suite.add(BOOST_TEST_CASE(filesystem_small_capacity));
   suite.add(BOOST_TEST_CASE(filesystem_large_capacity));
   suite.add(BOOST_TEST_CASE(memory));
+  suite.add(BOOST_TEST_CASE(encrypted));
+  suite.add(BOOST_TEST_CASE(encrypted_throughput));
   suite.add(BOOST_TEST_CASE(s3_storage_class_backward_reduced));
   suite.add(BOOST_TEST_CASE(s3_storage_class_backward_default));
 }